@@ -26,6 +26,13 @@ typedef enum _EXIB_DEC_Error
     EXIB_DEC_ERR_StringExpected    = 9, // A string was expected.
     EXIB_DEC_ERR_InvalidArrayIndex = 10, // Array index out of bounds.
     EXIB_DEC_ERR_FieldNotFound     = 11, // Named field not found.
+    EXIB_DEC_ERR_BlobExpected      = 12, // A blob was expected.
+    EXIB_DEC_ERR_InvalidBlob       = 13, // Blob index is out of bounds, or its entry is invalid.
+    EXIB_DEC_ERR_OutOfMemory       = 14, // A compressed blob couldn't be decompressed for lack of memory.
+    EXIB_DEC_ERR_UnknownDictionary = 15, // Datum uses a dictionary that isn't one of the `dictionaries` option.
+    EXIB_DEC_ERR_ValueExpected     = 16, // A field with a value type was expected.
+    EXIB_DEC_ERR_PackedArray       = 17, // Elements of a packed array can only be read with EXIB_DEC_ArrayDecodeInto.
+    EXIB_DEC_ERR_InvalidPacking    = 18, // Packed array is malformed.
 } EXIB_DEC_Error;
 
 /** Opaque decoder context handle. */
@@ -75,18 +82,45 @@ typedef struct _EXIB_DEC_FieldValue
 #define EXIB_DEC_INVALID_FIELD   ((EXIB_DEC_Field)NULL)
 #define EXIB_DEC_INVALID_STRING  ((EXIB_DEC_TString)NULL)
 
+/** How the decoder treats the header checksum. */
+typedef enum _EXIB_DEC_ChecksumMode
+{
+    EXIB_DEC_CHECKSUM_REQUIRED   = 0, // Verify the checksum, reject datums encoded without one.
+    EXIB_DEC_CHECKSUM_IF_PRESENT = 1, // Verify the checksum, unless the datum was encoded without one.
+    EXIB_DEC_CHECKSUM_NONE       = 2, // Never verify the checksum. Only for trusted transports.
+} EXIB_DEC_ChecksumMode;
+
 /**
  * Decoder options.
  */
 typedef struct _EXIB_DEC_Options
 {
-
+    EXIB_DEC_ChecksumMode checksumMode; // The header and bounds are validated either way. (Default: EXIB_DEC_CHECKSUM_REQUIRED)
+    int checksumThreads; // Number of threads that verify the checksum of large datums. 1 verifies on the calling thread. (Default: 1)
+    size_t parallelChecksumSize; // Datums of at least this many bytes are verified with `checksumThreads`. (Default: 64 MiB)
+    const EXIB_Dictionary* const* dictionaries; // Dictionaries that datums may use, found by their ID. Must outlive the context. (Default: NULL)
+    int dictionaryCount; // Number of entries in `dictionaries`. (Default: 0)
 } EXIB_DEC_Options;
 
+/** Struct member that EXIB_DEC_Bind fills from the field with the same name. */
+typedef struct _EXIB_DEC_Binding
+{
+    const char* name; // Name of the field.
+    EXIB_Type type; // Type of the member. Fields of other integer and float types are converted to it.
+    size_t offset; // Offset of the member within the struct, from offsetof.
+    EXIB_Value defaultValue; // Written to the member if the field is missing, or its value doesn't fit.
+} EXIB_DEC_Binding;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+    /**
+     * Get the default decoder options.
+     * @param options Pointer to struct that will receive the default options.
+     */
+    void EXIB_DEC_GetDefaultOptions(EXIB_DEC_Options* options);
+
     /**
      * Create a decoder context without a buffer associated.
      * Use EXIB_DEC_ResetContext to assign a decode buffer.
@@ -175,6 +209,16 @@ extern "C" {
      */
     EXIB_Type EXIB_DEC_FieldGet(EXIB_DEC_Context* ctx, EXIB_DEC_Field field, EXIB_DEC_FieldValue* valueOut);
 
+    /**
+     * Overwrite the value of a field in the decode buffer, which must be writable,
+     * and update the checksum in the header to match. See EXIB_ENC_PatchValue.
+     * @param ctx Decoder context.
+     * @param field Decoder field, of a value type.
+     * @param value New value, of the field's type.
+     * @return 0 on success, 1 on error.
+     */
+    int EXIB_DEC_PatchField(EXIB_DEC_Context* ctx, EXIB_DEC_Field field, EXIB_Value value);
+
     /**
      * Check if the given field is one of the primitive types.
      * @param field Decoder field.
@@ -263,6 +307,16 @@ extern "C" {
         return array->object.objectPrefix.arrayString;
     }
 
+    /**
+     * Check if the elements of an array are packed, see EXIB_ArrayPacking.
+     * @param array Decoder array.
+     * @return 1 if the array is packed, 0 otherwise.
+     */
+    static inline int EXIB_DEC_ArrayIsPacked(EXIB_DEC_Array* array)
+    {
+        return array->object.objectPrefix.packing != EXIB_PACKING_NONE;
+    }
+
     /**
      * Get the stride (distance between the beginning of each element) of an array.
      * @param array Decoder array.
@@ -300,6 +354,16 @@ extern "C" {
      */
     EXIB_Value* EXIB_DEC_ArrayLocateElement(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, size_t i);
 
+    /**
+     * Copy the elements of an array of values into a buffer, unpacking them if the array is packed.
+     * @param ctx Decoder context.
+     * @param array Decoder array of values.
+     * @param out Buffer to receive the elements, of the array's element type.
+     * @param capacity Number of elements `out` holds, at least EXIB_DEC_ArrayGetLength.
+     * @return EXIB_DEC_ERR_Success or decoder error if one is encountered.
+     */
+    EXIB_DEC_Error EXIB_DEC_ArrayDecodeInto(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, void* out, size_t capacity);
+
     /**
      * Get the next field within an object.
      * Useful for iterating through all of an object's fields.
@@ -331,6 +395,41 @@ extern "C" {
                                        EXIB_DEC_Object* parent,
                                        const char* name,
                                        EXIB_DEC_Object* objectOut);
+
+    /**
+     * Fill a struct from the fields of an object, in a single pass over the object.
+     * Every member bound by the table gets its default value first. A field then overwrites
+     * its member if its value can be converted to the member's type without going out of range.
+     * Integers, floats and doubles convert to each other, with floats truncated towards zero.
+     * Fields are matched fastest if the table lists them in the order they were encoded in.
+     * @param ctx Decoder context.
+     * @param object Object, or NULL to use root object.
+     * @param table Bindings of the members to fill.
+     * @param count Number of bindings in `table`.
+     * @param dst Struct to fill.
+     * @return Number of fields that were bound to a member, or -1 if the object is invalid.
+     */
+    int EXIB_DEC_Bind(EXIB_DEC_Context* ctx,
+                      EXIB_DEC_Object* object,
+                      const EXIB_DEC_Binding* table,
+                      size_t count,
+                      void* dst);
+
+    /**
+     * Get the data of a blob field, without copying it.
+     * Compressed blobs are decompressed the first time they're accessed, and kept
+     * in the context until it's reset or freed.
+     * @param ctx Decoder context.
+     * @param field Blob-typed field.
+     * @param dataOut Receives a pointer to the blob data within the decode buffer, or within
+     *                the context if it was compressed. Aligned to EXIB_BLOB_ALIGNMENT.
+     * @param sizeOut Receives the size of the blob in bytes.
+     * @return EXIB_DEC_ERR_Success or decoder error if one is encountered.
+     */
+    EXIB_DEC_Error EXIB_DEC_GetBlob(EXIB_DEC_Context* ctx,
+                                    EXIB_DEC_Field field,
+                                    const void** dataOut,
+                                    size_t* sizeOut);
 #ifdef __cplusplus
 }
 #endif
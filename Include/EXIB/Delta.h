@@ -0,0 +1,79 @@
+#ifndef _EXIB_DELTA_H
+#define _EXIB_DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "EXIB.h"
+
+/*
+ * A patch turns one datum (the base) into the next, by listing the byte ranges of
+ * the next datum that differ from the base at the same offset. Ranges start and end
+ * on field or array element boundaries, so a datum whose layout didn't change only
+ * sends the values that did. Everything else is copied from the base.
+ */
+
+#define EXIB_DELTA_MAGIC 0x44425845 // "EXBD"
+
+/**
+ * Header of a patch, followed by `rangeCount` ranges. Each range is the distance
+ * from the end of the previous one (or the start of the datum) and its length,
+ * both as LEB128 varints, followed by the bytes of the next datum.
+ */
+typedef struct _EXIB_DeltaHeader
+{
+    uint32_t magic;        // EXIB_DELTA_MAGIC
+    uint32_t baseSize;     // Size of the base datum.
+    uint32_t baseChecksum; // Checksum of the base datum, so the patch isn't applied to another one.
+    uint32_t nextSize;     // Size of the next datum, which the output buffer must hold.
+    uint32_t nextChecksum; // Checksum of the next datum, written to its header.
+    uint32_t rangeCount;   // Number of ranges.
+} EXIB_DeltaHeader;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * Calculate the maximum size of a patch to a datum.
+     * @param next Datum the patch results in.
+     * @return Size a patch buffer needs, so EXIB_DELTA_Encode can't run out of space.
+     */
+    size_t EXIB_DELTA_Bound(const EXIB_Header* next);
+
+    /**
+     * Encode the difference between two datums as a patch.
+     * The checksums aren't verified, only carried into the patch.
+     * @param base Datum the receiver already has.
+     * @param next Datum to send.
+     * @param patch Buffer to receive the patch.
+     * @param capacity Size of the patch buffer, see EXIB_DELTA_Bound.
+     * @return Size of the patch, or 0 if a datum is malformed or the patch doesn't fit.
+     */
+    size_t EXIB_DELTA_Encode(const EXIB_Header* base,
+                             const EXIB_Header* next,
+                             void* patch,
+                             size_t capacity);
+
+    /**
+     * Apply a patch to a datum. The checksum of the result is verified against the one
+     * in the patch before anything is written. The checksum of the base is patched in
+     * O(patch) time if the size didn't change, the base has a checksum, and the patch has
+     * at most one range per 4 KiB of the datum. Otherwise the whole result is checksummed.
+     * @param base Datum the patch was encoded against.
+     * @param patch Patch from EXIB_DELTA_Encode.
+     * @param patchSize Size of the patch.
+     * @param out Buffer to receive the next datum. May be the base itself, to patch it in place.
+     * @param capacity Size of the output buffer, at least nextSize of the patch header.
+     * @return 0 on success, 1 if the patch is malformed, doesn't fit, or doesn't belong to the base.
+     */
+    int EXIB_DELTA_Apply(const EXIB_Header* base,
+                         const void* patch,
+                         size_t patchSize,
+                         void* out,
+                         size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
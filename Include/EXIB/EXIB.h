@@ -21,7 +21,9 @@ typedef uint16_t exib_string_t; // String table relative offset.
 enum EXIB_HeaderFlag
 {
     // Set if an extended header is present.
-    EXIB_HEADER_EXT = (1 << 7)
+    EXIB_HEADER_EXT = (1 << 7),
+    // Set if the checksum wasn't calculated, in which case the checksum field is 0.
+    EXIB_HEADER_NO_CHECKSUM = (1 << 6)
 };
 
 typedef struct _EXIB_Header
@@ -39,6 +41,8 @@ typedef struct _EXIB_Header
 typedef struct _EXIB_ExtHeader
 {
     exib_offset_t blobOffset; // File offset of blob table, 0 if none exists.
+    uint16_t      blobSize;   // Number of entries in blob table.
+    uint16_t      dictionary; // ID of the dictionary that names come from, 0 if none is used.
 } EXIB_ExtHeader;
 
 // Prefix before a field in an object.
@@ -62,8 +66,8 @@ typedef union _EXIB_ObjectPrefix
         uint8_t arrayType   : 4;
         // 1 if the array is a string.
         uint8_t arrayString : 1;
-        // Reserved for future use.
-        uint8_t reserved    : 2;
+        // EXIB_ArrayPacking of an array of integers, 0 for anything else.
+        uint8_t packing     : 2;
         // If 0, followed by 16-bit size. If 1, followed by 32 bit size.
         uint8_t size        : 1;
     };
@@ -89,6 +93,18 @@ typedef struct _EXIB_BlobEntry
     uint8_t  data[];
 } EXIB_BlobEntry;
 
+enum EXIB_BlobFlag
+{
+    // Set if the data is compressed, in the LZ4 block format.
+    EXIB_BLOB_COMPRESSED = (1 << 0)
+};
+
+// Maximum number of blobs in a datum, since blob fields store an 8-bit index.
+#define EXIB_MAX_BLOBS 256
+
+// Alignment of the blob table and each of its entries, so blob data can be used in place.
+#define EXIB_BLOB_ALIGNMENT 8
+
 // Blob directory. Used to quickly find an entry from an index.
 typedef struct _EXIB_BlobDirectory
 {
@@ -96,6 +112,27 @@ typedef struct _EXIB_BlobDirectory
     uint32_t offsets[]; // Blob table relative offset of each entry.
 } EXIB_BlobDirectory;
 
+// Packing of an array of integers, stored in the `packing` bits of its object prefix.
+typedef enum _EXIB_ArrayPacking
+{
+    EXIB_PACKING_NONE   = 0, // Elements are stored as they are.
+    EXIB_PACKING_VARINT = 1, // Zigzag-encoded LEB128 varints.
+    EXIB_PACKING_BITS   = 2, // Offsets from a frame of reference, bit-packed at a fixed width.
+    EXIB_PACKING_RLE    = 3  // Runs of equal elements, each a varint length and a zigzag varint.
+} EXIB_ArrayPacking;
+
+// Header in front of the data of a packed array.
+typedef struct _EXIB_PackedArray
+{
+    uint32_t elements;  // Number of elements.
+    uint8_t  delta;     // 1 if each element was replaced by its difference to the previous one before packing.
+    uint8_t  bitWidth;  // EXIB_PACKING_BITS only. Bits per offset, up to the width of the element type.
+    uint16_t reserved;  // Reserved for future use.
+    uint64_t reference; // EXIB_PACKING_BITS only. Frame of reference the offsets are added to.
+    uint64_t base;      // Delta encoding only. First element, which isn't packed. The differences of the others add up from it.
+    uint8_t  data[];
+} EXIB_PackedArray;
+
 #ifdef __GNUC__
     #define EXIB_PACKED __attribute__((packed))
 #else
@@ -173,6 +210,13 @@ typedef void  (*exib_free_t)(void* p);
  */
 #define EXIB_MINIMUM (sizeof(EXIB_Header) + 4)
 
+/**
+ * Immutable list of names shared by encoders and decoders, see EXIB_CreateDictionary.
+ * Its names take up the first string offsets, and only names that aren't in it
+ * are stored in the string table of a datum, after them.
+ */
+typedef struct _EXIB_Dictionary EXIB_Dictionary;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -195,6 +239,43 @@ extern "C" {
      */
     uint32_t EXIB_CRC32C(uint32_t crc, const void* buffer, size_t size);
 
+    /**
+     * Combine the checksums of two consecutive buffers into the checksum of both.
+     * @param crc1 Checksum of the first buffer.
+     * @param crc2 Checksum of the second buffer, calculated with an initial value of 0.
+     * @param length2 Size of the second buffer.
+     * @return CRC32C checksum of the first buffer followed by the second.
+     */
+    uint32_t EXIB_CRC32C_Combine(uint32_t crc1, uint32_t crc2, size_t length2);
+
+    /**
+     * Update the CRC32C checksum of a buffer after some of its bytes changed,
+     * in O(length + log size) time instead of checksumming the whole buffer again.
+     * @param crc Checksum of the buffer before the change, calculated with an initial value of 0.
+     * @param size Size of the buffer.
+     * @param offset Offset of the bytes that changed.
+     * @param oldData Bytes before the change.
+     * @param newData Bytes after the change.
+     * @param length Number of bytes that changed.
+     * @return Checksum of the buffer after the change, or `crc` if the bytes aren't within the buffer.
+     */
+    uint32_t EXIB_CRC32C_Patch(uint32_t crc, size_t size, size_t offset, const void* oldData, const void* newData, size_t length);
+
+    /**
+     * Calculate the CRC32C checksum of a buffer on several threads.
+     * The buffer is split into one segment per thread, whose checksums are combined.
+     * Buffers too small to split into segments of at least 256 KiB use fewer threads.
+     * The threads are started and joined on every call, since there's no context to keep
+     * them in, so this only pays off for buffers of several MiB. EXIB_ENC_EncodeParallel
+     * keeps its workers in the encoder context instead.
+     * @param crc Initial value (Set to 0 unless you have a good reason not to).
+     * @param buffer Buffer to calculate checksum for.
+     * @param size Size of buffer.
+     * @param threads Number of threads, including the calling thread. At most 64 are used.
+     * @return CRC32C checksum, the same as EXIB_CRC32C.
+     */
+    uint32_t EXIB_CRC32C_Parallel(uint32_t crc, const void* buffer, size_t size, int threads);
+
     /**
      * Validate an EXIB header.
      * @param header Header to validate.
@@ -203,6 +284,48 @@ extern "C" {
      */
     int EXIB_CheckHeader(const EXIB_Header* header, size_t bufferSize);
 
+    /**
+     * Validate the fields of an EXIB header, without verifying the checksum.
+     * @param header Header to validate.
+     * @param bufferSize Size of the buffer containing the header.
+     * @return 0 on success, 1 on error.
+     */
+    int EXIB_CheckHeaderFields(const EXIB_Header* header, size_t bufferSize);
+
+    /**
+     * Validate an EXIB header, verifying the checksum on several threads.
+     * @param header Header to validate.
+     * @param bufferSize Size of the buffer containing the header.
+     * @param threads Number of threads, see EXIB_CRC32C_Parallel.
+     * @return 0 on success, 1 on error.
+     */
+    int EXIB_CheckHeaderParallel(const EXIB_Header* header, size_t bufferSize, int threads);
+
+    /**
+     * Create a dictionary of names. It is never changed afterwards, so any number of
+     * encoder and decoder contexts may use it at the same time, on any thread.
+     * Encoders and decoders must agree on the names of an ID, so a dictionary whose
+     * names change needs a new ID.
+     * @param id ID written to datums encoded with the dictionary, from 1 to 65535.
+     * @param names Names, in the order they're laid out. Duplicates are only added once.
+     * @param count Number of names.
+     * @return Pointer to dictionary, or NULL if the ID is 0, a name is longer than
+     *         255 characters, or the names don't fit into a string table.
+     */
+    EXIB_Dictionary* EXIB_CreateDictionary(uint16_t id, const char* const* names, size_t count);
+
+    /**
+     * Free a dictionary. No context may use it anymore.
+     * @param dictionary Dictionary to free.
+     */
+    void EXIB_FreeDictionary(EXIB_Dictionary* dictionary);
+
+    /** Get the ID of a dictionary. */
+    uint16_t EXIB_GetDictionaryId(const EXIB_Dictionary* dictionary);
+
+    /** Get the number of distinct names in a dictionary. */
+    size_t EXIB_GetDictionarySize(const EXIB_Dictionary* dictionary);
+
     /**
      * Specify the memory allocation functions to be used by the library.
      * WARNING: Invalidates all existing contexts and allocations!
@@ -12,6 +12,9 @@
 #include "EncoderTypes.h"
 #include "EncoderArray.h"
 #include "EncoderString.h"
+#include "EncoderBlob.h"
+#include "EncoderStream.h"
+#include "EncoderStruct.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +39,17 @@ extern "C" {
      */
     void EXIB_ENC_FreeContext(EXIB_ENC_Context* ctx);
 
+    /**
+     * Clear the datum so the context can encode the next one.
+     * Pools, the encode buffer and the string cache keep their memory,
+     * so a context that is reset and refilled the same way stops allocating.
+     * All fields, objects and arrays of the old datum become invalid.
+     * @param ctx Encoder context.
+     * @param keepStrings If 1, names stay interned with their string table offsets.
+     *                    Otherwise the string table starts out empty again.
+     */
+    void EXIB_ENC_ResetContext(EXIB_ENC_Context* ctx, int keepStrings);
+
     /**
      * Get the last reported encoder error.
      * @param ctx Encoder context.
@@ -45,12 +59,92 @@ extern "C" {
 
     /**
      * Encode the datum and return a pointer the beginning within the
-     * internal encoder buffer.
+     * internal encoder buffer. The buffer grows to fit the datum if necessary.
      * @param ctx
-     * @return Pointer to EXIB header within encoder buffer.
+     * @return Pointer to EXIB header within encoder buffer, or NULL if an error occurred.
      */
     EXIB_Header* EXIB_ENC_Encode(EXIB_ENC_Context* ctx);
 
+    /**
+     * Encode the datum into a caller-provided buffer.
+     * @param ctx Encoder context.
+     * @param buffer Buffer that will receive the datum.
+     * @param capacity Size of buffer in bytes.
+     * @return Pointer to EXIB header within `buffer`, or NULL if it is too small.
+     */
+    EXIB_Header* EXIB_ENC_EncodeInto(EXIB_ENC_Context* ctx, void* buffer, size_t capacity);
+
+    /**
+     * Encode the datum into the internal encoder buffer on several threads.
+     * Once the datum is laid out, its subtrees, arrays and blobs are split into
+     * ranges of about equal size, which are written and checksummed in parallel.
+     * Produces the same datum as EXIB_ENC_Encode, which small datums fall back to.
+     * Worker threads are started by the first call that needs them, and wait in
+     * the context for the next one until EXIB_ENC_FreeContext.
+     * The tree must not be changed while it's being encoded.
+     * @param ctx Encoder context.
+     * @param threads Number of threads, including the calling one.
+     * @return Pointer to EXIB header within encoder buffer, or NULL if an error occurred.
+     */
+    EXIB_Header* EXIB_ENC_EncodeParallel(EXIB_ENC_Context* ctx, int threads);
+
+    /**
+     * Encode the datum in chunks, passing each one to `writeFn` as soon as it's full.
+     * Only a single chunk is held in memory, regardless of the size of the datum.
+     * The checksum is written last, by seeking back to the header. If `seekFn` is
+     * NULL, the datum is encoded twice instead, once to calculate the checksum.
+     * With the noChecksum option, it is always written in a single pass.
+     * @param ctx Encoder context.
+     * @param writeFn Callback that receives the encoded data in order.
+     * @param seekFn Callback that moves the sink to a datum offset. May be NULL.
+     * @param user Pointer passed to the callbacks.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_EncodeToSink(EXIB_ENC_Context* ctx, EXIB_ENC_WriteFn writeFn, EXIB_ENC_SeekFn seekFn, void* user);
+
+    /**
+     * Encode the datum as a list of segments, ready for writev or sendmsg.
+     * Only the structural parts of the datum (headers, names, padding, small arrays and
+     * the string table) are written to the encoder buffer. Large arrays of values are
+     * referenced where they are, so they must stay valid until the segments have been sent.
+     * Segments are valid until the next encode or reset.
+     * @param ctx Encoder context.
+     * @param out Array that receives the segments, in datum order.
+     * @param count Number of entries in `out` on input, number of segments on output.
+     *              If `out` is too small, receives the number of entries needed.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_EncodeIOV(EXIB_ENC_Context* ctx, struct iovec* out, int* count);
+
+    /**
+     * Encode the datum to a file descriptor, starting at its current position.
+     * Files that can't seek, such as pipes, are handled like a sink without `seekFn`.
+     * @param ctx Encoder context.
+     * @param fd File descriptor opened for writing, without O_APPEND.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_EncodeToFD(EXIB_ENC_Context* ctx, int fd);
+
+    /**
+     * Overwrite a value in an encoded datum, and update its checksum to match.
+     * Only the bytes of the value are checksummed, so this is cheap no matter how
+     * large the datum is. The value keeps its type, so it must be one that fits.
+     * @param header Header of the datum.
+     * @param value Pointer to the value within the datum, as returned by EXIB_DEC_FieldGet.
+     * @param type Type of the value.
+     * @param newValue New value, of the same type.
+     * @return 0 on success, 1 if the type isn't a value type or the value isn't within the datum.
+     */
+    int EXIB_ENC_PatchValue(EXIB_Header* header, void* value, EXIB_Type type, EXIB_Value newValue);
+
+    /**
+     * Calculate the exact size of the encoded datum without encoding it.
+     * @param ctx Encoder context.
+     * @return Size of the datum in bytes, including header, padding and string table,
+     *         or 0 if an array holds a field that isn't one of its elements.
+     */
+    size_t EXIB_ENC_MeasureSize(EXIB_ENC_Context* ctx);
+
     /**
      * Add a child object to another object.
      * @param ctx Encoder context.
@@ -75,6 +169,40 @@ extern "C" {
                                       const char* name,
                                       EXIB_Type type);
 
+    /**
+     * Intern a name, so fields can be added with it without hashing it or looking it up.
+     * The handle stays valid for the lifetime of the context, across resets.
+     * Interning the same name twice returns the same handle.
+     * @param ctx Encoder context.
+     * @param name Name to intern.
+     * @return Handle of the name, or EXIB_ENC_NO_NAME if an error occurred.
+     */
+    EXIB_ENC_Name EXIB_ENC_InternName(EXIB_ENC_Context* ctx, const char* name);
+
+    /**
+     * Add a child object named by an interned name.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Handle of name. If EXIB_ENC_NO_NAME, object is left unnamed.
+     * @return Pointer to newly-added object, or NULL if an error occurred.
+     */
+    EXIB_ENC_Object* EXIB_ENC_AddObjectInterned(EXIB_ENC_Context* ctx,
+                                                EXIB_ENC_Object* parent,
+                                                EXIB_ENC_Name name);
+
+    /**
+     * Add a field named by an interned name.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Handle of name. If EXIB_ENC_NO_NAME, field is left unnamed.
+     * @param type Type of field.
+     * @return Pointer to newly-added field, or NULL if an error occurred.
+     */
+    EXIB_ENC_Field* EXIB_ENC_AddFieldInterned(EXIB_ENC_Context* ctx,
+                                              EXIB_ENC_Object* parent,
+                                              EXIB_ENC_Name name,
+                                              EXIB_Type type);
+
     /**
      * Get the name of a field.
      * @param field Encoder field.
@@ -21,6 +21,19 @@ extern "C" {
                                       const char* name,
                                       EXIB_Type elementType);
 
+    /**
+     * Add an array named by an interned name.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Handle of name. If EXIB_ENC_NO_NAME, array is left unnamed.
+     * @param elementType Type of elements.
+     * @return Pointer to newly-added array, or NULL if an error occurred.
+     */
+    EXIB_ENC_Array* EXIB_ENC_AddArrayInterned(EXIB_ENC_Context* ctx,
+                                              EXIB_ENC_Object* parent,
+                                              EXIB_ENC_Name name,
+                                              EXIB_Type elementType);
+
     /**
      * Reserve space in an array for at least `newCapacity` elements.
      * Does nothing for arrays of objects or arrays.
@@ -39,6 +52,7 @@ extern "C" {
     /**
      * Get a pointer to the array's internal buffer.
      * This pointer is invalidated if the array is resized.
+     * For arrays with external elements, this is the caller's pointer.
      * @param array Encoder array.
      * @return Pointer to array data, or NULL if the array contains objects or other arrays.
      */
@@ -61,6 +75,54 @@ extern "C" {
      */
     void* EXIB_ENC_ArrayAppend(EXIB_ENC_Array* array, EXIB_Value value);
 
+    /**
+     * Append `count` elements to the end of the array with a single copy.
+     * Only works on arrays of values.
+     * @param array Encoder array.
+     * @param data Pointer to elements, of the array's element type.
+     * @param count Number of elements.
+     * @return Pointer to the first appended element, or NULL if the array failed to expand.
+     */
+    void* EXIB_ENC_ArrayAppendN(EXIB_ENC_Array* array, const void* data, size_t count);
+
+    /**
+     * Replace the contents of the array with a copy of `count` elements.
+     * Only works on arrays of values.
+     * @param array Encoder array.
+     * @param data Pointer to elements, of the array's element type.
+     * @param count Number of elements.
+     * @return 0 on success, 1 on failure, which leaves the array unchanged.
+     */
+    int EXIB_ENC_ArrayAssign(EXIB_ENC_Array* array, const void* data, size_t count);
+
+    /**
+     * Make the array reference caller-owned elements instead of its own buffer.
+     * The elements are not copied until the datum is encoded, when they are copied
+     * straight into place; sinks receive them without any copy at all.
+     * Changing the array through the other functions copies the elements into
+     * the context first, which releases them.
+     * @param array Encoder array of values.
+     * @param data Pointer to elements, of the array's element type. Must stay valid until released.
+     * @param count Number of elements.
+     * @param releaseFn Called with `data` once the array no longer references it: when the
+     *                  array is changed, given other external elements, or when the context is
+     *                  reset or freed. May be NULL.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_ArraySetExternal(EXIB_ENC_Array* array, const void* data, size_t count, EXIB_ENC_ReleaseFn releaseFn);
+
+    /**
+     * Store the elements of an array of integers packed, see EXIB_ArrayPacking.
+     * Packing runs each time the datum is encoded. If it doesn't make the elements
+     * smaller, they are stored as they are. Packed arrays are read with EXIB_DEC_ArrayDecodeInto.
+     * @param array Encoder array of integers.
+     * @param packing Packing to use, or EXIB_PACKING_NONE to store the elements as they are.
+     * @param delta 1 to pack the difference of each element to the previous one, which suits
+     *              timestamps, counters and other slowly changing series.
+     * @return 0 on success, 1 if the array isn't an array of integers.
+     */
+    int EXIB_ENC_ArraySetPacking(EXIB_ENC_Array* array, EXIB_ArrayPacking packing, int delta);
+
     /**
      * Create a new object and add it to the end of the array.
      * @param ctx Encoder context.
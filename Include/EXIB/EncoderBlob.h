@@ -0,0 +1,72 @@
+#ifndef _EXIB_ENCODER_BLOB_H
+#define _EXIB_ENCODER_BLOB_H
+
+#include "EXIB.h"
+#include "EncoderTypes.h"
+
+/*
+ * Blobs are stored out of line in the blob table at the end of the datum.
+ * Their fields only hold the 8-bit index of the blob table entry, so objects
+ * stay compact to traverse no matter how large the blobs are.
+ * Blobs can be compressed, which the decoder undoes the first time they're accessed.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * Add a blob of binary data to an object. The data is copied into the context.
+     * It's compressed if it has at least `blobCompressThreshold` bytes, see EXIB_ENC_Options.
+     * A datum holds at most EXIB_MAX_BLOBS blobs.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Name of blob. If NULL, blob is left unnamed.
+     * @param data Blob data.
+     * @param size Size of data in bytes.
+     * @return Pointer to newly-added field, or NULL if an error occurred.
+     */
+    EXIB_ENC_Field* EXIB_ENC_AddBlob(EXIB_ENC_Context* ctx,
+                                     EXIB_ENC_Object* parent,
+                                     const char* name,
+                                     const void* data,
+                                     size_t size);
+
+    /**
+     * Add a blob of binary data to an object, and choose whether it's compressed.
+     * Blobs that don't get any smaller are stored as they are.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Name of blob. If NULL, blob is left unnamed.
+     * @param data Blob data.
+     * @param size Size of data in bytes.
+     * @param mode How to store the blob.
+     * @return Pointer to newly-added field, or NULL if an error occurred.
+     */
+    EXIB_ENC_Field* EXIB_ENC_AddBlobWithMode(EXIB_ENC_Context* ctx,
+                                             EXIB_ENC_Object* parent,
+                                             const char* name,
+                                             const void* data,
+                                             size_t size,
+                                             EXIB_ENC_BlobMode mode);
+
+    /**
+     * Add a blob named by an interned name.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Handle of name. If EXIB_ENC_NO_NAME, blob is left unnamed.
+     * @param data Blob data.
+     * @param size Size of data in bytes.
+     * @return Pointer to newly-added field, or NULL if an error occurred.
+     */
+    EXIB_ENC_Field* EXIB_ENC_AddBlobInterned(EXIB_ENC_Context* ctx,
+                                             EXIB_ENC_Object* parent,
+                                             EXIB_ENC_Name name,
+                                             const void* data,
+                                             size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
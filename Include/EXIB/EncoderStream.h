@@ -0,0 +1,156 @@
+#ifndef _EXIB_ENCODER_STREAM_H
+#define _EXIB_ENCODER_STREAM_H
+
+#include "EXIB.h"
+#include "EncoderTypes.h"
+
+/*
+ * The stream writer emits fields straight into the encode buffer as they are
+ * written, without building a tree of EXIB_ENC_Fields first. The resulting
+ * datum is identical to what the tree encoder produces for the same fields.
+ * Names share the string cache of the context.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * Begin writing a new datum. Opens the root object, which is named after
+     * the `datumName` encoder option. Fields added with EXIB_ENC_AddField and
+     * friends are not part of a streamed datum.
+     * @param ctx Encoder context.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_BeginStream(EXIB_ENC_Context* ctx);
+
+    /**
+     * Close the root object and finish the datum.
+     * All other objects and arrays must have been ended.
+     * @param ctx Encoder context.
+     * @return Pointer to EXIB header within encoder buffer, or NULL if an error occurred.
+     */
+    EXIB_Header* EXIB_ENC_EndStream(EXIB_ENC_Context* ctx);
+
+    /**
+     * Open an object within the current object or array of objects.
+     * @param ctx Encoder context.
+     * @param name Name of object. Must be NULL within arrays.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_BeginObject(EXIB_ENC_Context* ctx, const char* name);
+
+    /**
+     * Close the current object.
+     * @param ctx Encoder context.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_EndObject(EXIB_ENC_Context* ctx);
+
+    /**
+     * Open an array of objects or an array of arrays.
+     * Arrays of values are written in one go with EXIB_ENC_WriteArray.
+     * @param ctx Encoder context.
+     * @param name Name of array. Must be NULL within arrays.
+     * @param elementType EXIB_TYPE_OBJECT or EXIB_TYPE_ARRAY.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_BeginArray(EXIB_ENC_Context* ctx, const char* name, EXIB_Type elementType);
+
+    /**
+     * Close the current array.
+     * @param ctx Encoder context.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_EndArray(EXIB_ENC_Context* ctx);
+
+    /**
+     * Write a value to the current object.
+     * @param ctx Encoder context.
+     * @param name Name of field. If NULL, field is left unnamed.
+     * @param type Type of field, must be an integer or floating point type.
+     * @param value Value of field.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_WriteValue(EXIB_ENC_Context* ctx, const char* name, EXIB_Type type, EXIB_Value value);
+
+    /**
+     * Write an array of values to the current object or array of arrays.
+     * @param ctx Encoder context.
+     * @param name Name of array. Must be NULL within arrays.
+     * @param elementType Type of elements.
+     * @param data Pointer to elements.
+     * @param count Number of elements.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_WriteArray(EXIB_ENC_Context* ctx,
+                            const char* name,
+                            EXIB_Type elementType,
+                            const void* data,
+                            size_t count);
+
+    /**
+     * Write a null-terminated string to the current object or array of arrays.
+     * @param ctx Encoder context.
+     * @param name Name of string. Must be NULL within arrays.
+     * @param charType Type of character (May be any integral type).
+     * @param str String to write.
+     * @return 0 on success, 1 on failure.
+     */
+    int EXIB_ENC_WriteString(EXIB_ENC_Context* ctx, const char* name, EXIB_Type charType, const void* str);
+
+    static inline int EXIB_ENC_WriteInt8(EXIB_ENC_Context* ctx, const char* name, int8_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_INT8, (EXIB_Value){ .int8 = value });
+    }
+
+    static inline int EXIB_ENC_WriteUInt8(EXIB_ENC_Context* ctx, const char* name, uint8_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_UINT8, (EXIB_Value){ .uint8 = value });
+    }
+
+    static inline int EXIB_ENC_WriteInt16(EXIB_ENC_Context* ctx, const char* name, int16_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_INT16, (EXIB_Value){ .int16 = value });
+    }
+
+    static inline int EXIB_ENC_WriteUInt16(EXIB_ENC_Context* ctx, const char* name, uint16_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_UINT16, (EXIB_Value){ .uint16 = value });
+    }
+
+    static inline int EXIB_ENC_WriteInt32(EXIB_ENC_Context* ctx, const char* name, int32_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_INT32, (EXIB_Value){ .int32 = value });
+    }
+
+    static inline int EXIB_ENC_WriteUInt32(EXIB_ENC_Context* ctx, const char* name, uint32_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_UINT32, (EXIB_Value){ .uint32 = value });
+    }
+
+    static inline int EXIB_ENC_WriteInt64(EXIB_ENC_Context* ctx, const char* name, int64_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_INT64, (EXIB_Value){ .int64 = value });
+    }
+
+    static inline int EXIB_ENC_WriteUInt64(EXIB_ENC_Context* ctx, const char* name, uint64_t value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_UINT64, (EXIB_Value){ .uint64 = value });
+    }
+
+    static inline int EXIB_ENC_WriteFloat(EXIB_ENC_Context* ctx, const char* name, float value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_FLOAT, (EXIB_Value){ .float32 = value });
+    }
+
+    static inline int EXIB_ENC_WriteDouble(EXIB_ENC_Context* ctx, const char* name, double value)
+    {
+        return EXIB_ENC_WriteValue(ctx, name, EXIB_TYPE_DOUBLE, (EXIB_Value){ .float64 = value });
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,6 +23,21 @@ extern "C" {
                                         EXIB_Type charType,
                                         void* str);
 
+    /**
+     * Add a string named by an interned name.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Handle of name. If EXIB_ENC_NO_NAME, string is left unnamed.
+     * @param charType Type of character (May be any integral type).
+     * @param str Data to initialize string with (Can be NULL to leave string empty).
+     * @return Pointer to newly-added string, or NULL if an error occurred.
+     */
+    EXIB_ENC_String* EXIB_ENC_AddStringInterned(EXIB_ENC_Context* ctx,
+                                                EXIB_ENC_Object* parent,
+                                                EXIB_ENC_Name name,
+                                                EXIB_Type charType,
+                                                void* str);
+
 
 
 #ifdef __cplusplus
@@ -0,0 +1,65 @@
+#ifndef _EXIB_ENCODER_STRUCT_H
+#define _EXIB_ENCODER_STRUCT_H
+
+#include <stddef.h>
+#include "EXIB.h"
+#include "EncoderTypes.h"
+
+/*
+ * Structs are encoded from a table that describes where their members are,
+ * instead of adding a field per member. The table is compiled once per context,
+ * and the members are copied out of the struct when the datum is encoded. Their
+ * names are added to the string table in the order the members are written, so
+ * the result is the same as adding every member as a field, object or array,
+ * in table order.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /** Member of a struct, for EXIB_ENC_AddStruct. */
+    typedef struct _EXIB_ENC_Binding
+    {
+        const char* name;        // Name of the field. If NULL, field is left unnamed.
+        EXIB_Type   type;        // Type of the member, EXIB_TYPE_OBJECT for a nested struct or EXIB_TYPE_ARRAY for a fixed-size array.
+        size_t      offset;      // Offset of the member in the struct.
+        EXIB_Type   elementType; // Arrays only. Type of the elements, EXIB_TYPE_OBJECT for an array of structs.
+        size_t      count;       // Arrays only. Number of elements.
+        size_t      stride;      // Arrays of structs only. Size of an element.
+        const struct _EXIB_ENC_Binding* members; // Nested structs and arrays of structs only. Table of the nested struct.
+        size_t      memberCount;
+    } EXIB_ENC_Binding;
+
+    /**
+     * Add an object whose fields are the members of a struct.
+     * The table must outlive the context, since its compiled form is cached by address.
+     * The struct is read when the datum is encoded, so it must stay valid until then.
+     * More fields can be added to the object, and are encoded after the members.
+     * @param ctx Encoder context.
+     * @param parent Pointer to parent object. If NULL, uses root as parent.
+     * @param name Name of object. If NULL, object is left unnamed.
+     * @param table Members of the struct, in the order they're encoded in.
+     * @param count Number of members.
+     * @param src Struct to encode.
+     * @return Pointer to newly-added object, or NULL if an error occurred.
+     */
+    EXIB_ENC_Object* EXIB_ENC_AddStruct(EXIB_ENC_Context* ctx,
+                                        EXIB_ENC_Object* parent,
+                                        const char* name,
+                                        const EXIB_ENC_Binding* table,
+                                        size_t count,
+                                        const void* src);
+
+    /**
+     * Point an object added with EXIB_ENC_AddStruct at another struct with the same table.
+     * @param object Object added with EXIB_ENC_AddStruct.
+     * @param src Struct to encode.
+     */
+    void EXIB_ENC_StructSetData(EXIB_ENC_Object* object, const void* src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
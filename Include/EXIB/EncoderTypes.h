@@ -3,12 +3,31 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "EXIB.h"
+
+#ifdef WIN32
+    // Windows has no sys/uio.h, this matches the POSIX layout.
+    struct iovec
+    {
+        void*  iov_base;
+        size_t iov_len;
+    };
+#else
+    #include <sys/uio.h>
+#endif
 
 typedef enum
 {
     EXIB_ENC_ERR_Success = 0,
     EXIB_ENC_ERR_StringTableFull = 1,
-    EXIB_ENC_ERR_OutOfBounds = 2
+    EXIB_ENC_ERR_OutOfBounds = 2,
+    EXIB_ENC_ERR_BufferTooSmall = 3,
+    EXIB_ENC_ERR_OutOfMemory = 4,
+    EXIB_ENC_ERR_StreamState = 5,
+    EXIB_ENC_ERR_SinkFailed = 6,
+    EXIB_ENC_ERR_BlobTableFull = 7,
+    EXIB_ENC_ERR_InvalidBinding = 8,
+    EXIB_ENC_ERR_InvalidElement = 9
 } EXIB_ENC_Error;
 
 typedef struct _EXIB_ENC_Context EXIB_ENC_Context;
@@ -17,15 +36,50 @@ typedef struct _EXIB_ENC_Array   EXIB_ENC_Array;
 typedef struct _EXIB_ENC_Field   EXIB_ENC_Field;
 typedef struct _EXIB_ENC_String  EXIB_ENC_String;
 
+/** Handle of a name interned with EXIB_ENC_InternName. */
+typedef uint32_t EXIB_ENC_Name;
+
+/** Handle that leaves a field unnamed, also returned if a name can't be interned. */
+#define EXIB_ENC_NO_NAME ((EXIB_ENC_Name)UINT32_MAX)
+
+/** How a blob is stored in the blob table. */
+typedef enum
+{
+    EXIB_ENC_BLOB_AUTO = 0,    // Compressed if it has at least `blobCompressThreshold` bytes.
+    EXIB_ENC_BLOB_STORE = 1,   // Stored as it is, for data that's compressed already.
+    EXIB_ENC_BLOB_COMPRESS = 2 // Compressed regardless of its size.
+} EXIB_ENC_BlobMode;
+
+/**
+ * Sink callback that receives the next `size` bytes of the datum.
+ * @return 0 on success, non-zero to abort encoding.
+ */
+typedef int (*EXIB_ENC_WriteFn)(void* user, const void* data, size_t size);
+
+/**
+ * Sink callback that moves the write position to `offset` bytes from the start of the datum.
+ * @return 0 on success, non-zero to abort encoding.
+ */
+typedef int (*EXIB_ENC_SeekFn)(void* user, size_t offset);
+
+/**
+ * Callback that gives external array elements back to their owner,
+ * once the encoder no longer references them.
+ */
+typedef void (*EXIB_ENC_ReleaseFn)(void* data);
+
 /*
  * Encoder options.
  */
 typedef struct _EXIB_ENC_Options
 {
-    int bufferSize; // Initial size of encode buffer in bytes. (Default: 65536)
+    int bufferSize; // Initial size of encode buffer in bytes, grows as needed. 0 defers allocation to the first encode. (Default: 0)
     int stringCacheCapacity; // Initial capacity of string cache. (Default: 128)
     int arrayCapacity; // Initial array allocation size. (Default: 32)
     const char* datumName; // Name of the datum/root object. (Unnamed by default)
+    size_t blobCompressThreshold; // Blobs of at least this many bytes are compressed, see EXIB_ENC_BlobMode. 0 only compresses those that ask for it. (Default: 0)
+    int noChecksum; // If 1, the checksum isn't calculated and the header is flagged with EXIB_HEADER_NO_CHECKSUM. Only for trusted transports. (Default: 0)
+    const EXIB_Dictionary* dictionary; // Names found in it aren't written to the string table. Must outlive the context. (Default: NULL)
 } EXIB_ENC_Options;
 
 #endif
\ No newline at end of file
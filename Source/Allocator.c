@@ -4,116 +4,348 @@
 #include "AllocatorInternal.h"
 
 #ifdef EXIB_NO_LIBC_MALLOC
-static exib_malloc_t EXIB_AllocFn  = NULL;
+static exib_malloc_t EXIB_MallocFn = NULL;
 static exib_free_t   EXIB_FreeFn   = NULL;
 #else
 static exib_malloc_t EXIB_MallocFn = malloc;
 static exib_free_t   EXIB_FreeFn   = free;
 #endif
 
-// Expand the pool by one block.
-EXIB_MemoryBlock* EXIB_PoolExpand(EXIB_MemoryPool* pool)
+static inline uint8_t* EXIB_BlockObjects(EXIB_MemoryBlock* block)
 {
-    EXIB_MemoryBlock* block = EXIB_Alloc(sizeof(EXIB_MemoryBlock));
-    size_t blockSize = pool->objectSize * OBJECTS_PER_BLOCK;
+    return (uint8_t*)(block + 1);
+}
 
-    if (!block)
-        return NULL;
+static void EXIB_PoolMakeAvailable(EXIB_MemoryPool* pool, EXIB_MemoryBlock* block)
+{
+    block->prevAvailable = NULL;
+    block->nextAvailable = pool->available;
+    if (pool->available)
+        pool->available->prevAvailable = block;
+    pool->available = block;
+}
 
-    memset(block->freeMap, 0xFF, sizeof(block->freeMap));
-    block->block = EXIB_Alloc(blockSize);
+static void EXIB_PoolMakeUnavailable(EXIB_MemoryPool* pool, EXIB_MemoryBlock* block)
+{
+    if (block->prevAvailable)
+        block->prevAvailable->nextAvailable = block->nextAvailable;
+    else
+        pool->available = block->nextAvailable;
 
-    if (!block->block)
+    if (block->nextAvailable)
+        block->nextAvailable->prevAvailable = block->prevAvailable;
+}
+
+// Find the index of the first block at an address above `ptr`.
+static size_t EXIB_PoolBlockIndex(EXIB_MemoryPool* pool, const void* ptr)
+{
+    size_t left = 0;
+    size_t right = pool->blockCount;
+
+    while (left < right)
     {
-        EXIB_Free(block);
-        return NULL;
+        size_t mid = (left + right) / 2;
+
+        if ((uintptr_t)pool->blocks[mid] <= (uintptr_t)ptr)
+            left = mid + 1;
+        else
+            right = mid;
     }
 
-    memset(block->block, 0, blockSize);
-    block->totalObjects = OBJECTS_PER_BLOCK;
-    block->freeObjects  = OBJECTS_PER_BLOCK;
+    return left;
+}
 
-    if (pool->blockList)
-        block->next = pool->blockList;
-    else
-        block->next = NULL;
+// Expand the pool by one block.
+static EXIB_MemoryBlock* EXIB_PoolExpand(EXIB_MemoryPool* pool)
+{
+    size_t objects = pool->blockObjects;
+    EXIB_MemoryBlock* block;
+    size_t index;
+
+    if (pool->blockCount == pool->blockCapacity)
+    {
+        size_t capacity = pool->blockCapacity ? pool->blockCapacity * 2 : 8;
+        EXIB_MemoryBlock** blocks = EXIB_Alloc(capacity * sizeof(EXIB_MemoryBlock*));
+        if (!blocks)
+            return NULL;
+
+        if (pool->blocks)
+        {
+            memcpy(blocks, pool->blocks, pool->blockCount * sizeof(EXIB_MemoryBlock*));
+            EXIB_Free(pool->blocks);
+        }
+        pool->blocks = blocks;
+        pool->blockCapacity = capacity;
+    }
+
+    // Objects are handed out in order, so the block doesn't need to be initialized.
+    block = EXIB_Alloc(sizeof(EXIB_MemoryBlock) + objects * pool->objectSize);
+    if (!block)
+        return NULL;
 
-    pool->blockList = block;
+    block->totalObjects = objects;
+    block->freeObjects  = objects;
+    block->usedObjects  = 0;
+    block->freeList     = NULL;
+
+    index = EXIB_PoolBlockIndex(pool, block);
+    memmove(&pool->blocks[index + 1], &pool->blocks[index], (pool->blockCount - index) * sizeof(EXIB_MemoryBlock*));
+    pool->blocks[index] = block;
+    ++pool->blockCount;
+
+    if (objects * 2 * pool->objectSize <= EXIB_POOL_MAX_BLOCK)
+        pool->blockObjects = objects * 2;
+
+    EXIB_PoolMakeAvailable(pool, block);
     return block;
 }
 
 int EXIB_InitializePool(EXIB_MemoryPool* pool, size_t objectSize)
 {
-    pool->objectSize = objectSize;
-    pool->blockList  = NULL;
-    return EXIB_PoolExpand(pool) != NULL;
+    // Free objects must be able to hold a properly aligned pointer.
+    objectSize = (objectSize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+
+    memset(pool, 0, sizeof(EXIB_MemoryPool));
+    pool->objectSize   = objectSize;
+    pool->blockObjects = EXIB_POOL_MIN_BLOCK;
+
+    // Blocks are allocated on first use.
+    return 0;
 }
 
 void EXIB_DestroyPool(EXIB_MemoryPool* pool)
 {
-    EXIB_MemoryBlock* block = pool->blockList;
+    for (size_t i = 0; i < pool->blockCount; ++i)
+        EXIB_Free(pool->blocks[i]);
 
-    while (block != NULL)
+    if (pool->blocks)
+        EXIB_Free(pool->blocks);
+
+    EXIB_InitializePool(pool, pool->objectSize);
+}
+
+void* EXIB_PoolAlloc(EXIB_MemoryPool* pool)
+{
+    EXIB_MemoryBlock* block = pool->available;
+    void* ptr;
+
+    if (!block)
     {
-        EXIB_MemoryBlock* next = block->next;
-        EXIB_Free(block->block);
-        EXIB_Free(block);
-        block = next;
+        block = EXIB_PoolExpand(pool);
+        if (!block)
+            return NULL;
+    }
+
+    if (block->freeList)
+    {
+        ptr = block->freeList;
+        block->freeList = *(void**)ptr;
+    }
+    else
+        ptr = EXIB_BlockObjects(block) + (block->usedObjects++ * pool->objectSize);
+
+    if (block == pool->spare)
+        pool->spare = NULL;
+
+    if (--block->freeObjects == 0)
+        EXIB_PoolMakeUnavailable(pool, block);
+
+    return ptr;
+}
+
+// Return an empty block to the system.
+static void EXIB_PoolRelease(EXIB_MemoryPool* pool, EXIB_MemoryBlock* block, size_t index)
+{
+    EXIB_PoolMakeUnavailable(pool, block);
+    memmove(&pool->blocks[index], &pool->blocks[index + 1], (pool->blockCount - index - 1) * sizeof(EXIB_MemoryBlock*));
+    --pool->blockCount;
+    EXIB_Free(block);
+}
+
+void EXIB_PoolFree(EXIB_MemoryPool* pool, void* ptr)
+{
+    size_t index;
+    EXIB_MemoryBlock* block;
+
+    if (!ptr)
+        return;
+
+    index = EXIB_PoolBlockIndex(pool, ptr);
+    block = pool->blocks[index - 1];
+
+    *(void**)ptr = block->freeList;
+    block->freeList = ptr;
+
+    if (++block->freeObjects == 1)
+        EXIB_PoolMakeAvailable(pool, block);
+
+    if (block->freeObjects < block->totalObjects)
+        return;
+
+    // Keep the largest empty block, so alternating allocations and frees don't hit malloc every time.
+    if (!pool->spare)
+    {
+        pool->spare = block;
+        return;
+    }
+
+    if (block->totalObjects > pool->spare->totalObjects)
+    {
+        EXIB_MemoryBlock* spare = pool->spare;
+        pool->spare = block;
+        block = spare;
+        index = EXIB_PoolBlockIndex(pool, block);
     }
+
+    EXIB_PoolRelease(pool, block, index - 1);
 }
 
-int EXIB_BlockAllocIndex(EXIB_MemoryBlock* block)
+void EXIB_PoolReset(EXIB_MemoryPool* pool)
 {
-    // TODO: Make block search faster.
-    for (int i = 0; i < BITMAP_SIZE; ++i)
+    pool->available = NULL;
+    pool->spare = NULL;
+
+    for (size_t i = 0; i < pool->blockCount; ++i)
     {
-        bitmap_t e = block->freeMap[i];
-#if SIZE_MAX == UINT32_MAX
-        int bit = __builtin_ffsll((int)e) - 1;
-#else
-        int bit = __builtin_ffsll((long long)e) - 1;
-#endif
-        if (bit >= 0)
-        {
-            --block->freeObjects;
-#if SIZE_MAX == UINT32_MAX
-            block->freeMap[i] ^= (1ULL << bit);
-#else
-            block->freeMap[i] ^= (1UL << bit);
-#endif
-            return (i * BITMAP_ELEMENT_BITS) + bit;
-        }
+        EXIB_MemoryBlock* block = pool->blocks[i];
+
+        block->freeObjects = block->totalObjects;
+        block->usedObjects = 0;
+        block->freeList    = NULL;
+        EXIB_PoolMakeAvailable(pool, block);
     }
+}
 
-    return -1;
+void EXIB_InitializeArena(EXIB_Arena* arena)
+{
+    // Blocks are allocated on first use.
+    arena->blockList = NULL;
+    arena->current   = NULL;
+    arena->blockSize = EXIB_ARENA_MIN_BLOCK;
 }
 
-void* EXIB_PoolAlloc(EXIB_MemoryPool* pool)
+void EXIB_DestroyArena(EXIB_Arena* arena)
 {
-    EXIB_MemoryBlock* block = pool->blockList;
-    int index;
+    EXIB_ArenaBlock* block = arena->blockList;
 
     while (block != NULL)
     {
-        if (block->freeObjects > 0)
-            break;
-        block = block->next;
+        EXIB_ArenaBlock* next = block->next;
+        EXIB_Free(block);
+        block = next;
+    }
+
+    EXIB_InitializeArena(arena);
+}
+
+// Get the address `size` bytes can be allocated at within a block, or NULL if they don't fit.
+static uint8_t* EXIB_ArenaFit(EXIB_ArenaBlock* block, size_t used, size_t size, size_t alignment)
+{
+    uint8_t* data = (uint8_t*)(block + 1);
+    uintptr_t p = ((uintptr_t)(data + used) + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+
+    if (p - (uintptr_t)data > block->size || size > block->size - (p - (uintptr_t)data))
+        return NULL;
+
+    return (uint8_t*)p;
+}
+
+void* EXIB_ArenaAlloc(EXIB_Arena* arena, size_t size, size_t alignment)
+{
+    EXIB_ArenaBlock* block = arena->current;
+    uint8_t* p;
+
+    if (block && (p = EXIB_ArenaFit(block, block->used, size, alignment)))
+    {
+        block->used = (p + size) - (uint8_t*)(block + 1);
+        return p;
     }
 
-    if (block == NULL)
+    // Move on to the next block, which is left over from before the last reset.
+    block = block ? block->next : arena->blockList;
+    if (!block || !(p = EXIB_ArenaFit(block, 0, size, alignment)))
     {
-        block = EXIB_PoolExpand(pool);
+        size_t blockSize = arena->blockSize;
+
+        // Oversized allocations get a block of their own, without affecting the growth of regular blocks.
+        if (size + alignment > blockSize)
+            blockSize = size + alignment;
+        else if (arena->blockSize < EXIB_ARENA_MAX_BLOCK)
+            arena->blockSize *= 2;
+
+        block = EXIB_Alloc(sizeof(EXIB_ArenaBlock) + blockSize);
         if (!block)
             return NULL;
+        block->size = blockSize;
+
+        // Insert after the current block, so blocks stay in the order they are used in.
+        if (arena->current)
+        {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            block->next = arena->blockList;
+            arena->blockList = block;
+        }
+
+        p = EXIB_ArenaFit(block, 0, size, alignment);
     }
 
-    index = EXIB_BlockAllocIndex(block);
-    return block->block + (pool->objectSize * index);
+    arena->current = block;
+    block->used = (p + size) - (uint8_t*)(block + 1);
+    return p;
 }
 
-void EXIB_PoolFree(EXIB_MemoryPool* pool, void* ptr)
+void* EXIB_ArenaRealloc(EXIB_Arena* arena, void* ptr, size_t oldSize, size_t newSize, size_t alignment)
 {
-    // TODO: Implement EXIB_PoolFree
+    EXIB_ArenaBlock* block = arena->current;
+    uint8_t* data;
+    void* p;
+
+    if (!ptr)
+        return EXIB_ArenaAlloc(arena, newSize, alignment);
+
+    // The last allocation can simply be extended if there's room, or give back what it doesn't need.
+    data = (uint8_t*)(block + 1);
+    if ((uint8_t*)ptr + oldSize == data + block->used)
+    {
+        if (newSize <= oldSize)
+        {
+            block->used -= oldSize - newSize;
+            return ptr;
+        }
+
+        if (newSize - oldSize <= block->size - block->used)
+        {
+            block->used += newSize - oldSize;
+            return ptr;
+        }
+    }
+
+    // Anything else shrinks in place.
+    if (newSize <= oldSize)
+        return ptr;
+
+    p = EXIB_ArenaAlloc(arena, newSize, alignment);
+    if (p)
+        memcpy(p, ptr, oldSize);
+    return p;
+}
+
+void EXIB_ArenaReset(EXIB_Arena* arena)
+{
+    // Other blocks are marked as empty when they are moved on to.
+    arena->current = arena->blockList;
+    if (arena->current)
+        arena->current->used = 0;
+}
+
+void EXIB_SetAllocator(exib_malloc_t mallocFn, exib_free_t freeFn)
+{
+    EXIB_MallocFn = mallocFn;
+    EXIB_FreeFn = freeFn;
 }
 
 void* EXIB_Alloc(size_t n)
@@ -132,8 +364,14 @@ void EXIB_Free(void* ptr)
 
 void* EXIB_Calloc(size_t objectSize, size_t objectCount)
 {
+    // Guard against the size overflowing.
+    if (objectCount != 0 && objectSize > SIZE_MAX / objectCount)
+        return NULL;
+
     size_t size = objectSize * objectCount;
     void* p = EXIB_Alloc(size);
+    if (!p)
+        return NULL;
     return memset(p, 0, size);
 }
 
@@ -4,31 +4,72 @@
 #include <stdint.h>
 #include <stddef.h>
 
-typedef size_t bitmap_t;
-
-#define OBJECTS_PER_BLOCK 768
-#define BITMAP_ELEMENT_BITS ((int)sizeof(bitmap_t) * 8)
-#define BITMAP_SIZE (OBJECTS_PER_BLOCK / BITMAP_ELEMENT_BITS)
-
+// Block of a memory pool, followed by its objects.
 typedef struct _EXIB_MemoryBlock
 {
-    void* block;
     size_t totalObjects;
     size_t freeObjects;
-    bitmap_t freeMap[BITMAP_SIZE];
-    struct _EXIB_MemoryBlock* next;
+    size_t usedObjects; // Objects past this index have never been allocated.
+    void*  freeList;    // Freed objects, each one holding a pointer to the next.
+    struct _EXIB_MemoryBlock* nextAvailable; // List of blocks with free objects.
+    struct _EXIB_MemoryBlock* prevAvailable;
 } EXIB_MemoryBlock;
 
+/*
+ * Pool of fixed-size objects. Allocation and free are O(1), apart from
+ * finding the block of a freed object, which is a binary search over
+ * the blocks. Blocks grow geometrically, so there are only a few of them.
+ * Blocks that become empty are returned, except for one spare.
+ */
 typedef struct _EXIB_MemoryPool
 {
     size_t objectSize; // Size of objects that will be allocated.
-    EXIB_MemoryBlock* blockList; // Forward list of memory blocks.
+    size_t blockObjects; // Number of objects in the next block.
+    EXIB_MemoryBlock** blocks; // All blocks, sorted by address.
+    size_t blockCount;
+    size_t blockCapacity;
+    EXIB_MemoryBlock* available; // First block with free objects.
+    EXIB_MemoryBlock* spare; // Empty block that is kept around, NULL if there is none.
 } EXIB_MemoryPool;
 
+#define EXIB_POOL_MIN_BLOCK 32 // Number of objects in the first block.
+#define EXIB_POOL_MAX_BLOCK (1024 * 1024) // Maximum size of a block in bytes.
+
 int   EXIB_InitializePool(EXIB_MemoryPool* pool, size_t objectSize);
 void  EXIB_DestroyPool(EXIB_MemoryPool* pool);
 void* EXIB_PoolAlloc(EXIB_MemoryPool* pool);
 void  EXIB_PoolFree(EXIB_MemoryPool* pool, void* ptr);
+void  EXIB_PoolReset(EXIB_MemoryPool* pool); // Free all objects, but keep the memory for reuse.
+
+// Block of an arena, followed by its data.
+typedef struct _EXIB_ArenaBlock
+{
+    struct _EXIB_ArenaBlock* next;
+    size_t size; // Size of data in bytes.
+    size_t used; // Number of bytes allocated from data.
+} EXIB_ArenaBlock;
+
+/*
+ * Bump pointer allocator. Allocations can't be freed one by one,
+ * only all at once by resetting or destroying the arena. A reset
+ * keeps the blocks around, so refilling an arena the same way
+ * doesn't allocate any more memory.
+ */
+typedef struct _EXIB_Arena
+{
+    EXIB_ArenaBlock* blockList; // Forward list of blocks, in order of use.
+    EXIB_ArenaBlock* current; // Block that allocations are taken from.
+    size_t blockSize; // Size of the next block, grows geometrically.
+} EXIB_Arena;
+
+#define EXIB_ARENA_MIN_BLOCK (16 * 1024)
+#define EXIB_ARENA_MAX_BLOCK (1024 * 1024)
+
+void  EXIB_InitializeArena(EXIB_Arena* arena);
+void  EXIB_DestroyArena(EXIB_Arena* arena);
+void* EXIB_ArenaAlloc(EXIB_Arena* arena, size_t size, size_t alignment);
+void* EXIB_ArenaRealloc(EXIB_Arena* arena, void* ptr, size_t oldSize, size_t newSize, size_t alignment); // Grows or shrinks in place if `ptr` was the last allocation.
+void  EXIB_ArenaReset(EXIB_Arena* arena); // Free all allocations in O(1), keeping the blocks for reuse.
 
 void* EXIB_Calloc(size_t objectSize, size_t objectCount);
 
@@ -0,0 +1,540 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <EXIB/EXIB.h>
+#include "CRC32CInternal.h"
+#include "ThreadInternal.h"
+
+/*
+ * EXIB_CRC32C picks the fastest implementation the CPU supports on its first call:
+ *
+ * - SSE 4.2 or ARMv8 CRC32 instructions, on three interleaved streams so that the
+ *   latency of the instruction is hidden. The three CRCs are combined by shifting
+ *   them over the length of the streams that follow, with precomputed operators.
+ *   This is the approach of Mark Adler's crc32c.c.
+ * - Slicing-by-8, which handles eight bytes per step with eight tables.
+ *
+ * All of them are bit-identical to the byte-wise table loop.
+ *
+ * EXIB_CRC32C_Parallel splits large buffers into one segment per thread, and
+ * combines the CRCs of the segments the same way, with an operator built for
+ * the length of each segment.
+ */
+
+#define EXIB_CRC32C_POLY 0x82F63B78
+
+#define EXIB_CRC32C_MAX_THREADS 64
+#define EXIB_CRC32C_MIN_SEGMENT (256 * 1024) // Smallest segment checksummed by its own thread.
+
+// Stream lengths of the interleaved hardware loop, must be powers of 2.
+#define EXIB_CRC32C_LONG  8192
+#define EXIB_CRC32C_SHORT 256
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <nmmintrin.h>
+
+    #define EXIB_CRC32C_HARDWARE
+    #define EXIB_CRC32C_TARGET __attribute__((target("sse4.2")))
+    #define EXIB_CRC32C_U8(crc, value)  _mm_crc32_u8(crc, value)
+    #define EXIB_CRC32C_U64(crc, value) ((uint32_t)_mm_crc32_u64(crc, value))
+#elif defined(__aarch64__)
+    #include <arm_acle.h>
+
+    #if defined(__linux__)
+        #include <sys/auxv.h>
+        #include <asm/hwcap.h>
+    #endif
+
+    #define EXIB_CRC32C_HARDWARE
+    #if defined(__clang__)
+        #define EXIB_CRC32C_TARGET __attribute__((target("crc")))
+    #else
+        #define EXIB_CRC32C_TARGET __attribute__((target("+crc")))
+    #endif
+    #define EXIB_CRC32C_U8(crc, value)  __crc32cb(crc, value)
+    #define EXIB_CRC32C_U64(crc, value) __crc32cd(crc, value)
+#endif
+
+/*
+ * CRC32C table and algorithm from https://web.mit.edu/freebsd/head/sys/libkern/crc32.c
+ * The other seven slicing tables are generated from the first one.
+ */
+
+static uint32_t s_CRC32C[8][256] = { {
+    0x00000000L, 0xF26B8303L, 0xE13B70F7L, 0x1350F3F4L,
+    0xC79A971FL, 0x35F1141CL, 0x26A1E7E8L, 0xD4CA64EBL,
+    0x8AD958CFL, 0x78B2DBCCL, 0x6BE22838L, 0x9989AB3BL,
+    0x4D43CFD0L, 0xBF284CD3L, 0xAC78BF27L, 0x5E133C24L,
+    0x105EC76FL, 0xE235446CL, 0xF165B798L, 0x030E349BL,
+    0xD7C45070L, 0x25AFD373L, 0x36FF2087L, 0xC494A384L,
+    0x9A879FA0L, 0x68EC1CA3L, 0x7BBCEF57L, 0x89D76C54L,
+    0x5D1D08BFL, 0xAF768BBCL, 0xBC267848L, 0x4E4DFB4BL,
+    0x20BD8EDEL, 0xD2D60DDDL, 0xC186FE29L, 0x33ED7D2AL,
+    0xE72719C1L, 0x154C9AC2L, 0x061C6936L, 0xF477EA35L,
+    0xAA64D611L, 0x580F5512L, 0x4B5FA6E6L, 0xB93425E5L,
+    0x6DFE410EL, 0x9F95C20DL, 0x8CC531F9L, 0x7EAEB2FAL,
+    0x30E349B1L, 0xC288CAB2L, 0xD1D83946L, 0x23B3BA45L,
+    0xF779DEAEL, 0x05125DADL, 0x1642AE59L, 0xE4292D5AL,
+    0xBA3A117EL, 0x4851927DL, 0x5B016189L, 0xA96AE28AL,
+    0x7DA08661L, 0x8FCB0562L, 0x9C9BF696L, 0x6EF07595L,
+    0x417B1DBCL, 0xB3109EBFL, 0xA0406D4BL, 0x522BEE48L,
+    0x86E18AA3L, 0x748A09A0L, 0x67DAFA54L, 0x95B17957L,
+    0xCBA24573L, 0x39C9C670L, 0x2A993584L, 0xD8F2B687L,
+    0x0C38D26CL, 0xFE53516FL, 0xED03A29BL, 0x1F682198L,
+    0x5125DAD3L, 0xA34E59D0L, 0xB01EAA24L, 0x42752927L,
+    0x96BF4DCCL, 0x64D4CECFL, 0x77843D3BL, 0x85EFBE38L,
+    0xDBFC821CL, 0x2997011FL, 0x3AC7F2EBL, 0xC8AC71E8L,
+    0x1C661503L, 0xEE0D9600L, 0xFD5D65F4L, 0x0F36E6F7L,
+    0x61C69362L, 0x93AD1061L, 0x80FDE395L, 0x72966096L,
+    0xA65C047DL, 0x5437877EL, 0x4767748AL, 0xB50CF789L,
+    0xEB1FCBADL, 0x197448AEL, 0x0A24BB5AL, 0xF84F3859L,
+    0x2C855CB2L, 0xDEEEDFB1L, 0xCDBE2C45L, 0x3FD5AF46L,
+    0x7198540DL, 0x83F3D70EL, 0x90A324FAL, 0x62C8A7F9L,
+    0xB602C312L, 0x44694011L, 0x5739B3E5L, 0xA55230E6L,
+    0xFB410CC2L, 0x092A8FC1L, 0x1A7A7C35L, 0xE811FF36L,
+    0x3CDB9BDDL, 0xCEB018DEL, 0xDDE0EB2AL, 0x2F8B6829L,
+    0x82F63B78L, 0x709DB87BL, 0x63CD4B8FL, 0x91A6C88CL,
+    0x456CAC67L, 0xB7072F64L, 0xA457DC90L, 0x563C5F93L,
+    0x082F63B7L, 0xFA44E0B4L, 0xE9141340L, 0x1B7F9043L,
+    0xCFB5F4A8L, 0x3DDE77ABL, 0x2E8E845FL, 0xDCE5075CL,
+    0x92A8FC17L, 0x60C37F14L, 0x73938CE0L, 0x81F80FE3L,
+    0x55326B08L, 0xA759E80BL, 0xB4091BFFL, 0x466298FCL,
+    0x1871A4D8L, 0xEA1A27DBL, 0xF94AD42FL, 0x0B21572CL,
+    0xDFEB33C7L, 0x2D80B0C4L, 0x3ED04330L, 0xCCBBC033L,
+    0xA24BB5A6L, 0x502036A5L, 0x4370C551L, 0xB11B4652L,
+    0x65D122B9L, 0x97BAA1BAL, 0x84EA524EL, 0x7681D14DL,
+    0x2892ED69L, 0xDAF96E6AL, 0xC9A99D9EL, 0x3BC21E9DL,
+    0xEF087A76L, 0x1D63F975L, 0x0E330A81L, 0xFC588982L,
+    0xB21572C9L, 0x407EF1CAL, 0x532E023EL, 0xA145813DL,
+    0x758FE5D6L, 0x87E466D5L, 0x94B49521L, 0x66DF1622L,
+    0x38CC2A06L, 0xCAA7A905L, 0xD9F75AF1L, 0x2B9CD9F2L,
+    0xFF56BD19L, 0x0D3D3E1AL, 0x1E6DCDEEL, 0xEC064EEDL,
+    0xC38D26C4L, 0x31E6A5C7L, 0x22B65633L, 0xD0DDD530L,
+    0x0417B1DBL, 0xF67C32D8L, 0xE52CC12CL, 0x1747422FL,
+    0x49547E0BL, 0xBB3FFD08L, 0xA86F0EFCL, 0x5A048DFFL,
+    0x8ECEE914L, 0x7CA56A17L, 0x6FF599E3L, 0x9D9E1AE0L,
+    0xD3D3E1ABL, 0x21B862A8L, 0x32E8915CL, 0xC083125FL,
+    0x144976B4L, 0xE622F5B7L, 0xF5720643L, 0x07198540L,
+    0x590AB964L, 0xAB613A67L, 0xB831C993L, 0x4A5A4A90L,
+    0x9E902E7BL, 0x6CFBAD78L, 0x7FAB5E8CL, 0x8DC0DD8FL,
+    0xE330A81AL, 0x115B2B19L, 0x020BD8EDL, 0xF0605BEEL,
+    0x24AA3F05L, 0xD6C1BC06L, 0xC5914FF2L, 0x37FACCF1L,
+    0x69E9F0D5L, 0x9B8273D6L, 0x88D28022L, 0x7AB90321L,
+    0xAE7367CAL, 0x5C18E4C9L, 0x4F48173DL, 0xBD23943EL,
+    0xF36E6F75L, 0x0105EC76L, 0x12551F82L, 0xE03E9C81L,
+    0x34F4F86AL, 0xC69F7B69L, 0xD5CF889DL, 0x27A40B9EL,
+    0x79B737BAL, 0x8BDCB4B9L, 0x988C474DL, 0x6AE7C44EL,
+    0xBE2DA0A5L, 0x4C4623A6L, 0x5F16D052L, 0xAD7D5351L
+} };
+
+// Operators that shift a CRC over a stream of zeros, one table per byte of the CRC.
+static uint32_t s_CRC32CLong[4][256];
+static uint32_t s_CRC32CShort[4][256];
+
+static uint32_t EXIB_CRC32C_Dispatch(uint32_t crc, const void* buffer, size_t size);
+
+static atomic_int s_CRC32CState = 0; // 0 = not initialized, 1 = initializing, 2 = ready.
+static _Atomic(EXIB_CRC32CFn) s_CRC32CFn = EXIB_CRC32C_Dispatch;
+
+// Multiply a 32x32 GF(2) matrix with a vector.
+static uint32_t EXIB_GF2MatrixTimes(const uint32_t* matrix, uint32_t vector)
+{
+    uint32_t sum = 0;
+
+    while (vector)
+    {
+        if (vector & 1)
+            sum ^= *matrix;
+        vector >>= 1;
+        matrix++;
+    }
+
+    return sum;
+}
+
+static void EXIB_GF2MatrixSquare(uint32_t* square, const uint32_t* matrix)
+{
+    for (int n = 0; n < 32; n++)
+        square[n] = EXIB_GF2MatrixTimes(matrix, matrix[n]);
+}
+
+// Build the operator that appends a single zero bit to a CRC.
+static void EXIB_CRC32C_BitOperator(uint32_t* op)
+{
+    uint32_t row = 1;
+
+    op[0] = EXIB_CRC32C_POLY;
+    for (int n = 1; n < 32; n++)
+    {
+        op[n] = row;
+        row <<= 1;
+    }
+}
+
+/**
+ * Build the operator that appends `length` zero bytes to a CRC.
+ * @param op Receives the 32x32 matrix.
+ * @param length Number of zero bytes, must be a power of 2.
+ */
+static void EXIB_CRC32C_ZerosOperator(uint32_t* op, size_t length)
+{
+    uint32_t odd[32];
+
+    // Two, then four zero bits.
+    EXIB_CRC32C_BitOperator(odd);
+    EXIB_GF2MatrixSquare(op, odd);
+    EXIB_GF2MatrixSquare(odd, op);
+
+    // Keep squaring, each step doubles the number of zeros, starting at a byte.
+    do
+    {
+        EXIB_GF2MatrixSquare(op, odd);
+        length >>= 1;
+        if (length == 0)
+            return;
+
+        EXIB_GF2MatrixSquare(odd, op);
+        length >>= 1;
+    } while (length);
+
+    memcpy(op, odd, sizeof(odd));
+}
+
+static void EXIB_CRC32C_ZerosTable(uint32_t table[4][256], size_t length)
+{
+    uint32_t op[32];
+
+    EXIB_CRC32C_ZerosOperator(op, length);
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        table[0][n] = EXIB_GF2MatrixTimes(op, n);
+        table[1][n] = EXIB_GF2MatrixTimes(op, n << 8);
+        table[2][n] = EXIB_GF2MatrixTimes(op, n << 16);
+        table[3][n] = EXIB_GF2MatrixTimes(op, n << 24);
+    }
+}
+
+static inline uint32_t EXIB_CRC32C_Shift(uint32_t table[4][256], uint32_t crc)
+{
+    return table[0][crc & 0xFF]
+        ^ table[1][(crc >> 8) & 0xFF]
+        ^ table[2][(crc >> 16) & 0xFF]
+        ^ table[3][crc >> 24];
+}
+
+uint32_t EXIB_CRC32C_Bytewise(uint32_t crc, const void* buffer, size_t size)
+{
+    const uint8_t* p = buffer;
+
+    crc = ~crc;
+
+    while (size--)
+        crc = s_CRC32C[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+uint32_t EXIB_CRC32C_Sliced(uint32_t crc, const void* buffer, size_t size)
+{
+    const uint8_t* p = buffer;
+
+    crc = ~crc;
+
+    // Bytes are combined explicitly, so this works regardless of endianness and alignment.
+    while (size >= 8)
+    {
+        uint32_t low = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+
+        crc = s_CRC32C[7][low & 0xFF]
+            ^ s_CRC32C[6][(low >> 8) & 0xFF]
+            ^ s_CRC32C[5][(low >> 16) & 0xFF]
+            ^ s_CRC32C[4][low >> 24]
+            ^ s_CRC32C[3][p[4]]
+            ^ s_CRC32C[2][p[5]]
+            ^ s_CRC32C[1][p[6]]
+            ^ s_CRC32C[0][p[7]];
+
+        p += 8;
+        size -= 8;
+    }
+
+    while (size--)
+        crc = s_CRC32C[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+#ifdef EXIB_CRC32C_HARDWARE
+
+static inline uint64_t EXIB_CRC32C_Load(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+EXIB_CRC32C_TARGET
+uint32_t EXIB_CRC32C_Hardware(uint32_t crc, const void* buffer, size_t size)
+{
+    const uint8_t* p = buffer;
+    const uint8_t* end;
+    uint32_t crc0 = ~crc;
+    uint32_t crc1;
+    uint32_t crc2;
+
+    // Align to 8 bytes.
+    while (size && ((uintptr_t)p & 7))
+    {
+        crc0 = EXIB_CRC32C_U8(crc0, *p++);
+        size--;
+    }
+
+    // Three streams at once, first long ones, then short ones for what's left.
+    while (size >= 3 * EXIB_CRC32C_LONG)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end = p + EXIB_CRC32C_LONG;
+        do
+        {
+            crc0 = EXIB_CRC32C_U64(crc0, EXIB_CRC32C_Load(p));
+            crc1 = EXIB_CRC32C_U64(crc1, EXIB_CRC32C_Load(p + EXIB_CRC32C_LONG));
+            crc2 = EXIB_CRC32C_U64(crc2, EXIB_CRC32C_Load(p + 2 * EXIB_CRC32C_LONG));
+            p += 8;
+        } while (p < end);
+
+        crc0 = EXIB_CRC32C_Shift(s_CRC32CLong, crc0) ^ crc1;
+        crc0 = EXIB_CRC32C_Shift(s_CRC32CLong, crc0) ^ crc2;
+        p += 2 * EXIB_CRC32C_LONG;
+        size -= 3 * EXIB_CRC32C_LONG;
+    }
+
+    while (size >= 3 * EXIB_CRC32C_SHORT)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end = p + EXIB_CRC32C_SHORT;
+        do
+        {
+            crc0 = EXIB_CRC32C_U64(crc0, EXIB_CRC32C_Load(p));
+            crc1 = EXIB_CRC32C_U64(crc1, EXIB_CRC32C_Load(p + EXIB_CRC32C_SHORT));
+            crc2 = EXIB_CRC32C_U64(crc2, EXIB_CRC32C_Load(p + 2 * EXIB_CRC32C_SHORT));
+            p += 8;
+        } while (p < end);
+
+        crc0 = EXIB_CRC32C_Shift(s_CRC32CShort, crc0) ^ crc1;
+        crc0 = EXIB_CRC32C_Shift(s_CRC32CShort, crc0) ^ crc2;
+        p += 2 * EXIB_CRC32C_SHORT;
+        size -= 3 * EXIB_CRC32C_SHORT;
+    }
+
+    while (size >= 8)
+    {
+        crc0 = EXIB_CRC32C_U64(crc0, EXIB_CRC32C_Load(p));
+        p += 8;
+        size -= 8;
+    }
+
+    while (size--)
+        crc0 = EXIB_CRC32C_U8(crc0, *p++);
+
+    return ~crc0;
+}
+
+int EXIB_CRC32C_HardwareSupported()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(__APPLE__)
+    // Every ARMv8 Apple CPU has the CRC32 instructions.
+    return 1;
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return 0;
+#endif
+}
+
+#else
+
+uint32_t EXIB_CRC32C_Hardware(uint32_t crc, const void* buffer, size_t size)
+{
+    return EXIB_CRC32C_Sliced(crc, buffer, size);
+}
+
+int EXIB_CRC32C_HardwareSupported()
+{
+    return 0;
+}
+
+#endif
+
+void EXIB_CRC32C_Initialize()
+{
+    int expected = 0;
+
+    if (!atomic_compare_exchange_strong(&s_CRC32CState, &expected, 1))
+    {
+        // Some other thread got here first, wait for it to finish.
+        while (atomic_load(&s_CRC32CState) != 2)
+            EXIB_ThreadYield();
+        return;
+    }
+
+    // Each table continues the CRC of the previous one by another zero byte.
+    for (int n = 0; n < 256; n++)
+    {
+        uint32_t crc = s_CRC32C[0][n];
+        for (int k = 1; k < 8; k++)
+        {
+            crc = s_CRC32C[0][crc & 0xFF] ^ (crc >> 8);
+            s_CRC32C[k][n] = crc;
+        }
+    }
+
+    EXIB_CRC32C_ZerosTable(s_CRC32CLong, EXIB_CRC32C_LONG);
+    EXIB_CRC32C_ZerosTable(s_CRC32CShort, EXIB_CRC32C_SHORT);
+
+    atomic_store(&s_CRC32CFn, EXIB_CRC32C_HardwareSupported() ? EXIB_CRC32C_Hardware : EXIB_CRC32C_Sliced);
+    atomic_store(&s_CRC32CState, 2);
+}
+
+// Only called until the tables are ready.
+static uint32_t EXIB_CRC32C_Dispatch(uint32_t crc, const void* buffer, size_t size)
+{
+    EXIB_CRC32C_Initialize();
+    return atomic_load(&s_CRC32CFn)(crc, buffer, size);
+}
+
+uint32_t EXIB_CRC32C(uint32_t crc, const void* buffer, size_t size)
+{
+    return atomic_load_explicit(&s_CRC32CFn, memory_order_acquire)(crc, buffer, size);
+}
+
+// Multiply two polynomials modulo the CRC polynomial, in the reflected bit order of the CRC.
+static uint32_t EXIB_CRC32C_MultModP(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+
+    for (uint32_t m = UINT32_C(1) << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+            product ^= b;
+        b = (b & 1) ? (b >> 1) ^ EXIB_CRC32C_POLY : b >> 1;
+    }
+
+    return product;
+}
+
+/**
+ * Shift a CRC over `length` zero bytes, by multiplying it with x^(8 * length) modulo the polynomial.
+ * The power is built by repeated squaring, so this takes O(log length) multiplications.
+ */
+static uint32_t EXIB_CRC32C_ShiftZeros(uint32_t crc, size_t length)
+{
+    uint32_t power = UINT32_C(1) << 23; // x^8
+
+    while (length)
+    {
+        if (length & 1)
+            crc = EXIB_CRC32C_MultModP(power, crc);
+        length >>= 1;
+        if (length)
+            power = EXIB_CRC32C_MultModP(power, power);
+    }
+
+    return crc;
+}
+
+uint32_t EXIB_CRC32C_Combine(uint32_t crc1, uint32_t crc2, size_t length2)
+{
+    return EXIB_CRC32C_ShiftZeros(crc1, length2) ^ crc2;
+}
+
+uint32_t EXIB_CRC32C_Patch(uint32_t crc, size_t size, size_t offset, const void* oldData, const void* newData, size_t length)
+{
+    const uint8_t* oldBytes = oldData;
+    const uint8_t* newBytes = newData;
+    uint8_t flipped[64];
+    uint32_t delta = 0;
+
+    if (offset > size || length > size - offset)
+        return crc;
+
+    // The CRC of the bits that flip, without the initial value and final inversion,
+    // is what flipping them does to the CRC of the whole buffer once it's shifted to the end.
+    for (size_t done = 0; done < length; done += sizeof(flipped))
+    {
+        size_t chunk = (length - done < sizeof(flipped)) ? length - done : sizeof(flipped);
+
+        for (size_t i = 0; i < chunk; ++i)
+            flipped[i] = oldBytes[done + i] ^ newBytes[done + i];
+        delta = ~EXIB_CRC32C(~delta, flipped, chunk);
+    }
+
+    return crc ^ EXIB_CRC32C_ShiftZeros(delta, size - offset - length);
+}
+
+typedef struct _EXIB_CRC32C_Segment
+{
+    EXIB_Thread thread;
+    const uint8_t* buffer;
+    size_t size;
+    uint32_t crc;
+    int started;
+} EXIB_CRC32C_Segment;
+
+static void EXIB_CRC32C_SegmentMain(void* arg)
+{
+    EXIB_CRC32C_Segment* segment = arg;
+    segment->crc = EXIB_CRC32C(segment->crc, segment->buffer, segment->size);
+}
+
+uint32_t EXIB_CRC32C_Parallel(uint32_t crc, const void* buffer, size_t size, int threads)
+{
+    EXIB_CRC32C_Segment segments[EXIB_CRC32C_MAX_THREADS];
+    size_t segmentSize;
+
+    if (threads > EXIB_CRC32C_MAX_THREADS)
+        threads = EXIB_CRC32C_MAX_THREADS;
+
+    // Smaller segments aren't worth the cost of a thread.
+    if (threads > 1 && (size_t)threads > size / EXIB_CRC32C_MIN_SEGMENT)
+        threads = (int)(size / EXIB_CRC32C_MIN_SEGMENT);
+    if (threads <= 1)
+        return EXIB_CRC32C(crc, buffer, size);
+
+    // Build the tables once, before any of the threads race to do it.
+    EXIB_CRC32C_Initialize();
+
+    segmentSize = size / threads;
+    for (int i = 0; i < threads; ++i)
+    {
+        segments[i].buffer = (const uint8_t*)buffer + i * segmentSize;
+        segments[i].size = (i == threads - 1) ? size - i * segmentSize : segmentSize;
+        segments[i].crc = 0;
+        segments[i].started = 0;
+    }
+
+    // The calling thread takes the first segment, which continues `crc`.
+    segments[0].crc = crc;
+    for (int i = 1; i < threads; ++i)
+        segments[i].started = !EXIB_ThreadStart(&segments[i].thread, EXIB_CRC32C_SegmentMain, &segments[i]);
+
+    EXIB_CRC32C_SegmentMain(&segments[0]);
+
+    crc = segments[0].crc;
+    for (int i = 1; i < threads; ++i)
+    {
+        // Segments whose thread couldn't be started are done here instead.
+        if (segments[i].started)
+            EXIB_ThreadJoin(&segments[i].thread);
+        else
+            EXIB_CRC32C_SegmentMain(&segments[i]);
+
+        crc = EXIB_CRC32C_Combine(crc, segments[i].crc, segments[i].size);
+    }
+
+    return crc;
+}
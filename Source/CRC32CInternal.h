@@ -0,0 +1,33 @@
+#ifndef _EXIB_CRC32C_INTERNAL_H
+#define _EXIB_CRC32C_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t (*EXIB_CRC32CFn)(uint32_t crc, const void* buffer, size_t size);
+
+/*
+ * The individual CRC32C implementations behind EXIB_CRC32C, so they
+ * can be tested and benchmarked against each other. All of them but
+ * EXIB_CRC32C_Bytewise need EXIB_CRC32C_Initialize to be called first.
+ */
+
+/** Build the lookup tables and pick the implementation used by EXIB_CRC32C. Thread-safe. */
+void EXIB_CRC32C_Initialize();
+
+/** Reference implementation, one table lookup per byte. */
+uint32_t EXIB_CRC32C_Bytewise(uint32_t crc, const void* buffer, size_t size);
+
+/** Portable slicing-by-8 implementation. */
+uint32_t EXIB_CRC32C_Sliced(uint32_t crc, const void* buffer, size_t size);
+
+/**
+ * SSE 4.2 or ARMv8 CRC32 implementation. Only valid if EXIB_CRC32C_HardwareSupported
+ * returns 1, on other architectures it's the same as EXIB_CRC32C_Sliced.
+ */
+uint32_t EXIB_CRC32C_Hardware(uint32_t crc, const void* buffer, size_t size);
+
+/** @return 1 if the CPU has CRC32C instructions that EXIB_CRC32C_Hardware can use. */
+int EXIB_CRC32C_HardwareSupported();
+
+#endif
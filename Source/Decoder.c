@@ -18,10 +18,58 @@ static const char* s_DecoderErrors[] = {
     "Array expected",
     "String expected",
     "Array index out of bounds",
-    "Named field not found"
+    "Named field not found",
+    "Blob expected",
+    "Invalid blob",
+    "Out of memory",
+    "Unknown dictionary",
+    "Value expected",
+    "Packed array",
+    "Invalid packed array"
 };
 
-static EXIB_DEC_Options s_DefaultOptions = { };
+static EXIB_DEC_Options s_DefaultOptions =
+    {
+        .checksumMode = EXIB_DEC_CHECKSUM_REQUIRED,
+        .checksumThreads = 1,
+        .parallelChecksumSize = 64 * 1024 * 1024,
+        .dictionaries = NULL,
+        .dictionaryCount = 0
+    };
+
+void EXIB_DEC_GetDefaultOptions(EXIB_DEC_Options* options)
+{
+    *options = s_DefaultOptions;
+}
+
+/**
+ * Validate the header, and verify the checksum as the checksumMode option asks.
+ * The checksum is verified on several threads if the datum is large enough.
+ * @return EXIB_DEC_ERR_Success, EXIB_DEC_ERR_InvalidHeader or EXIB_DEC_ERR_BadChecksum.
+ */
+static EXIB_DEC_Error EXIB_DEC_CheckHeader(EXIB_DEC_Context* ctx, const EXIB_Header* header)
+{
+    EXIB_DEC_ChecksumMode mode = ctx->options.checksumMode;
+    int threads = 1;
+
+    if (EXIB_CheckHeaderFields(header, ctx->bufferSize))
+        return EXIB_DEC_ERR_InvalidHeader;
+
+    // A datum without a checksum is only as good as the transport it came through.
+    if (header->flags & EXIB_HEADER_NO_CHECKSUM)
+        return (mode == EXIB_DEC_CHECKSUM_REQUIRED) ? EXIB_DEC_ERR_BadChecksum : EXIB_DEC_ERR_Success;
+
+    if (mode == EXIB_DEC_CHECKSUM_NONE)
+        return EXIB_DEC_ERR_Success;
+
+    if (header->datumSize >= ctx->options.parallelChecksumSize)
+        threads = ctx->options.checksumThreads;
+
+    if (EXIB_CheckHeaderParallel(header, ctx->bufferSize, threads))
+        return EXIB_DEC_ERR_BadChecksum;
+
+    return EXIB_DEC_ERR_Success;
+}
 
 EXIB_DEC_Context* EXIB_DEC_CreateContext(EXIB_DEC_Options* options)
 {
@@ -59,6 +107,10 @@ EXIB_DEC_Error EXIB_DEC_ResetContext(EXIB_DEC_Context* ctx,
     ctx->rootObject.field = EXIB_DEC_INVALID_FIELD;
     ctx->rootObject.size  = 0;
     ctx->rootObject.dataOffset = 0;
+    ctx->blobDirectory = NULL;
+    ctx->blobTableSize = 0;
+    ctx->dictionary = NULL;
+    EXIB_DEC_ClearBlobCache(ctx);
 
     /**
      * The header must be meticulously validated because the decoder
@@ -66,8 +118,12 @@ EXIB_DEC_Error EXIB_DEC_ResetContext(EXIB_DEC_Context* ctx,
      */
 
     const EXIB_Header* header = ctx->buffer;
-    if ((bufferSize < expectedSize) || EXIB_CheckHeader(header, ctx->bufferSize)) // Ensure buffer meets minimum size and validate the header.
+    if (bufferSize < expectedSize) // Ensure buffer meets minimum size.
         return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_InvalidHeader);
+
+    EXIB_DEC_Error headerError = EXIB_DEC_CheckHeader(ctx, header);
+    if (headerError != EXIB_DEC_ERR_Success) // Validate the header and checksum.
+        return EXIB_DEC_SetError(ctx, headerError);
     else if (bufferSize < header->datumSize) // Make sure we have the whole datum.
         return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_BufferTooSmall);
     else
@@ -77,6 +133,12 @@ EXIB_DEC_Error EXIB_DEC_ResetContext(EXIB_DEC_Context* ctx,
         // Extended header or string table not accounted for in datumSize, ABORT.
         if (header->datumSize < expectedSize)
             return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_InvalidHeader);
+
+        if (EXIB_DEC_InitializeBlobTable(ctx, header) != EXIB_DEC_ERR_Success)
+            return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_InvalidHeader);
+
+        if (EXIB_DEC_InitializeDictionary(ctx, header) != EXIB_DEC_ERR_Success)
+            return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_UnknownDictionary);
         
         EXIB_FieldPrefix* rootField = ((EXIB_FieldPrefix*)header) + sizeof(EXIB_Header) + header->extendedSize;
         if (EXIB_DEC_PartialDecodeAggregate(ctx, rootField, &ctx->rootObject)
@@ -98,6 +160,9 @@ EXIB_DEC_Error EXIB_DEC_ResetContext(EXIB_DEC_Context* ctx,
 
 void EXIB_DEC_FreeContext(EXIB_DEC_Context* ctx)
 {
+    EXIB_DEC_ClearBlobCache(ctx);
+    if (ctx->blobCache)
+        EXIB_Free(ctx->blobCache);
     EXIB_Free(ctx);
 }
 
@@ -6,6 +6,7 @@
 #include <EXIB/Decoder.h>
 #include "AllocatorInternal.h"
 #include "DecoderInternal.h"
+#include "PackInternal.h"
 
 /**
  * Make sure an element pointer is within the bounds
@@ -26,6 +27,12 @@ static inline int EXIB_DEC_CheckArrayPointer(EXIB_DEC_Context* ctx, EXIB_DEC_Arr
 
 EXIB_Value* EXIB_DEC_ArrayBegin(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, size_t* lengthOut)
 {
+    if (EXIB_DEC_ArrayIsPacked(array))
+    {
+        ctx->lastError = EXIB_DEC_ERR_PackedArray;
+        return NULL;
+    }
+
     if (array->elements == 0)
     {
         ctx->lastError = EXIB_DEC_ERR_InvalidArrayIndex;
@@ -77,6 +84,12 @@ int EXIB_DEC_ArrayNext(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, EXIB_DEC_Fi
     if (array->elementSize == 0)
         return EXIB_DEC_ArraySpecialNext(ctx, array, value);
 
+    if (EXIB_DEC_ArrayIsPacked(array))
+    {
+        ctx->lastError = EXIB_DEC_ERR_PackedArray;
+        return -1;
+    }
+
     // Position of current element within array data.
     void* position = value->value;
     if (position == NULL)
@@ -105,6 +118,12 @@ int EXIB_DEC_ArrayNext(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, EXIB_DEC_Fi
 
 EXIB_Value* EXIB_DEC_ArrayLocateElement(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, size_t i)
 {
+    if (EXIB_DEC_ArrayIsPacked(array))
+    {
+        ctx->lastError = EXIB_DEC_ERR_PackedArray;
+        return NULL;
+    }
+
     if (i >= array->elements)
     {
         ctx->lastError = EXIB_DEC_ERR_InvalidArrayIndex;
@@ -114,4 +133,27 @@ EXIB_Value* EXIB_DEC_ArrayLocateElement(EXIB_DEC_Context* ctx, EXIB_DEC_Array* a
     int elementSize = EXIB_GetTypeSize(array->object.objectPrefix.arrayType);
     ctx->lastError = EXIB_DEC_ERR_Success;
     return (void*)(array->object.field) + array->object.dataOffset + (i * elementSize);
-}
\ No newline at end of file
+}
+
+EXIB_DEC_Error EXIB_DEC_ArrayDecodeInto(EXIB_DEC_Context* ctx, EXIB_DEC_Array* array, void* out, size_t capacity)
+{
+    EXIB_Type type = array->object.objectPrefix.arrayType;
+
+    if (array->elementSize == 0)
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_ValueExpected);
+
+    if ((size_t)array->elements > capacity)
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_BufferTooSmall);
+
+    if (!EXIB_DEC_ArrayIsPacked(array))
+    {
+        memcpy(out, array->data, (size_t)array->elements * array->elementSize);
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_Success);
+    }
+
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), type, array->object.objectPrefix.packing,
+                         array->data, array->object.size, out, array->elements))
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_InvalidPacking);
+
+    return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_Success);
+}
@@ -0,0 +1,222 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Decoder.h>
+#include "DecoderInternal.h"
+
+/*
+ * Binding walks an object once, and looks each field up in the table, instead of
+ * looking each member up in the object like EXIB_DEC_FindField. The lookup starts
+ * after the binding that matched last, so a table in encoding order only ever
+ * compares each name once.
+ */
+
+// Value of a field, widened so it can be range-checked against any member type.
+typedef struct _EXIB_DEC_Number
+{
+    int isReal;
+    int isNegative; // Only for integers, whose value is in `i` if set and in `u` otherwise.
+    int64_t i;
+    uint64_t u;
+    double d;
+} EXIB_DEC_Number;
+
+static void EXIB_DEC_ReadNumber(EXIB_Type type, const void* src, EXIB_DEC_Number* number)
+{
+    EXIB_Value value = { .uint64 = 0 };
+
+    // Values in a datum aren't always aligned.
+    memcpy(&value, src, EXIB_GetTypeSize(type));
+    memset(number, 0, sizeof(EXIB_DEC_Number));
+
+    switch (type)
+    {
+        case EXIB_TYPE_INT8:   number->i = value.int8; break;
+        case EXIB_TYPE_INT16:  number->i = value.int16; break;
+        case EXIB_TYPE_INT32:  number->i = value.int32; break;
+        case EXIB_TYPE_INT64:  number->i = value.int64; break;
+        case EXIB_TYPE_UINT8:  number->u = value.uint8; break;
+        case EXIB_TYPE_UINT16: number->u = value.uint16; break;
+        case EXIB_TYPE_UINT32: number->u = value.uint32; break;
+        case EXIB_TYPE_UINT64: number->u = value.uint64; break;
+        case EXIB_TYPE_FLOAT:  number->isReal = 1; number->d = value.float32; break;
+        case EXIB_TYPE_DOUBLE: number->isReal = 1; number->d = value.float64; break;
+        default: break;
+    }
+
+    if (number->i < 0)
+        number->isNegative = 1;
+    else if (type == EXIB_TYPE_INT8 || type == EXIB_TYPE_INT16 || type == EXIB_TYPE_INT32 || type == EXIB_TYPE_INT64)
+        number->u = (uint64_t)number->i;
+}
+
+/**
+ * Check that a number fits into an integer type, and truncate it to an integer.
+ * @param number Number to check, whose integer fields are set if it fits.
+ * @param isSigned 1 if the type is signed.
+ * @param bits Width of the type.
+ * @return 1 if the number fits, 0 otherwise.
+ */
+static int EXIB_DEC_FitInteger(EXIB_DEC_Number* number, int isSigned, int bits)
+{
+    // 2^(bits - 1) for signed types, 2^bits for unsigned ones.
+    double limit = (double)(UINT64_C(1) << (bits - 1)) * (isSigned ? 1.0 : 2.0);
+
+    if (number->isReal)
+    {
+        // Also rejects NaN.
+        if (!(number->d > (isSigned ? -limit - 1.0 : -1.0) && number->d < limit))
+            return 0;
+
+        number->isNegative = number->d <= -1.0;
+        if (number->isNegative)
+            number->i = (int64_t)number->d;
+        else
+            number->u = (uint64_t)number->d;
+        return 1;
+    }
+
+    if (number->isNegative)
+        return isSigned && (bits == 64 || number->i >= -(INT64_C(1) << (bits - 1)));
+
+    if (isSigned)
+        return number->u <= (UINT64_MAX >> (65 - bits));
+
+    return bits == 64 || number->u <= (UINT64_MAX >> (64 - bits));
+}
+
+/**
+ * Convert the value of a field to the type of a member.
+ * @param type Type of the field.
+ * @param src Value of the field.
+ * @param binding Binding of the member.
+ * @param dst Member to write.
+ * @return 1 if the value was written, 0 if it doesn't fit.
+ */
+static int EXIB_DEC_BindValue(EXIB_Type type, const void* src, const EXIB_DEC_Binding* binding, void* dst)
+{
+    EXIB_DEC_Number number;
+    EXIB_Value value;
+
+    if (type == binding->type)
+    {
+        memcpy(dst, src, EXIB_GetTypeSize(type));
+        return 1;
+    }
+
+    EXIB_DEC_ReadNumber(type, src, &number);
+
+    switch (binding->type)
+    {
+        case EXIB_TYPE_INT8:
+        case EXIB_TYPE_INT16:
+        case EXIB_TYPE_INT32:
+        case EXIB_TYPE_INT64:
+            if (!EXIB_DEC_FitInteger(&number, 1, EXIB_GetTypeSize(binding->type) * 8))
+                return 0;
+            if (!number.isNegative)
+                number.i = (int64_t)number.u;
+            break;
+        case EXIB_TYPE_UINT8:
+        case EXIB_TYPE_UINT16:
+        case EXIB_TYPE_UINT32:
+        case EXIB_TYPE_UINT64:
+            if (!EXIB_DEC_FitInteger(&number, 0, EXIB_GetTypeSize(binding->type) * 8))
+                return 0;
+            break;
+        case EXIB_TYPE_FLOAT:
+        case EXIB_TYPE_DOUBLE:
+            if (!number.isReal)
+                number.d = number.isNegative ? (double)number.i : (double)number.u;
+            break;
+        default:
+            return 0;
+    }
+
+    switch (binding->type)
+    {
+        case EXIB_TYPE_INT8:   value.int8 = (int8_t)number.i; break;
+        case EXIB_TYPE_INT16:  value.int16 = (int16_t)number.i; break;
+        case EXIB_TYPE_INT32:  value.int32 = (int32_t)number.i; break;
+        case EXIB_TYPE_INT64:  value.int64 = number.i; break;
+        case EXIB_TYPE_UINT8:  value.uint8 = (uint8_t)number.u; break;
+        case EXIB_TYPE_UINT16: value.uint16 = (uint16_t)number.u; break;
+        case EXIB_TYPE_UINT32: value.uint32 = (uint32_t)number.u; break;
+        case EXIB_TYPE_UINT64: value.uint64 = number.u; break;
+        case EXIB_TYPE_FLOAT:
+            // Doubles beyond the range of a float don't fit, but infinities do.
+            if (isfinite(number.d) && (number.d > FLT_MAX || number.d < -FLT_MAX))
+                return 0;
+            value.float32 = (float)number.d;
+            break;
+        default:
+            value.float64 = number.d;
+            break;
+    }
+
+    // Every member of the union starts at its first byte.
+    memcpy(dst, &value, EXIB_GetTypeSize(binding->type));
+    return 1;
+}
+
+// Compare a string table entry with a null-terminated name.
+static inline int EXIB_DEC_NameEquals(EXIB_DEC_TString string, const char* name)
+{
+    return strncmp(name, string->string, string->length) == 0 && name[string->length] == 0;
+}
+
+int EXIB_DEC_Bind(EXIB_DEC_Context* ctx,
+                  EXIB_DEC_Object* object,
+                  const EXIB_DEC_Binding* table,
+                  size_t count,
+                  void* dst)
+{
+    size_t next = 0; // Binding after the one that matched last, where the lookup starts.
+    int bound = 0;
+
+    if (object == NULL)
+        object = &ctx->rootObject;
+
+    for (size_t i = 0; i < count; ++i)
+        memcpy((uint8_t*)dst + table[i].offset, &table[i].defaultValue, EXIB_GetTypeSize(table[i].type));
+
+    for (EXIB_DEC_Field field = EXIB_DEC_NextField(ctx, object, EXIB_DEC_INVALID_FIELD);
+         field != EXIB_DEC_INVALID_FIELD;
+         field = EXIB_DEC_NextField(ctx, object, field))
+    {
+        EXIB_DEC_TString name;
+
+        if (!EXIB_DEC_FieldIsPrimitive(field))
+            continue;
+
+        name = EXIB_DEC_FieldGetName(ctx, field);
+        if (name == EXIB_DEC_INVALID_STRING)
+            continue;
+
+        for (size_t i = 0, index = next; i < count; ++i, index = (index + 1 < count) ? index + 1 : 0)
+        {
+            if (!EXIB_DEC_NameEquals(name, table[index].name))
+                continue;
+
+            void* src = ctx->buffer + EXIB_DEC_GetFieldDataOffset(ctx, field);
+            if (EXIB_DEC_CheckBounds(ctx, src + EXIB_DEC_FieldGetSize(field) - 1))
+            {
+                ctx->lastError = EXIB_DEC_ERR_OutOfBounds;
+                return -1;
+            }
+
+            if (EXIB_DEC_BindValue(EXIB_DEC_FieldGetType(field), src, &table[index], (uint8_t*)dst + table[index].offset))
+                ++bound;
+
+            next = (index + 1 < count) ? index + 1 : 0;
+            break;
+        }
+    }
+
+    // NextField reports malformed objects, and ends the walk early.
+    if (ctx->lastError != EXIB_DEC_ERR_Success)
+        return -1;
+
+    return bound;
+}
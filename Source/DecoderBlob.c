@@ -0,0 +1,175 @@
+#include <stdint.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Decoder.h>
+#include "AllocatorInternal.h"
+#include "DecoderInternal.h"
+#include "LZInternal.h"
+
+EXIB_DEC_Error EXIB_DEC_InitializeBlobTable(EXIB_DEC_Context* ctx, const EXIB_Header* header)
+{
+    const EXIB_ExtHeader* extHeader = (const EXIB_ExtHeader*)(header + 1);
+    const EXIB_BlobDirectory* directory;
+    size_t tableSize;
+
+    ctx->blobDirectory = NULL;
+    ctx->blobTableSize = 0;
+
+    // Extended headers too short to hold the offset have no blob table either.
+    if (!(header->flags & EXIB_HEADER_EXT)
+        || header->extendedSize < sizeof(exib_offset_t)
+        || extHeader->blobOffset == 0)
+        return EXIB_DEC_ERR_Success;
+
+    if (extHeader->blobOffset % EXIB_BLOB_ALIGNMENT != 0
+        || extHeader->blobOffset > header->datumSize - sizeof(EXIB_BlobDirectory))
+        return EXIB_DEC_ERR_InvalidHeader;
+
+    directory = (const EXIB_BlobDirectory*)((const uint8_t*)header + extHeader->blobOffset);
+    tableSize = header->datumSize - extHeader->blobOffset;
+
+    if (directory->entries > EXIB_MAX_BLOBS
+        || directory->entries > (tableSize - sizeof(EXIB_BlobDirectory)) / sizeof(uint32_t))
+        return EXIB_DEC_ERR_InvalidHeader;
+
+    ctx->blobDirectory = directory;
+    ctx->blobTableSize = tableSize;
+    return EXIB_DEC_ERR_Success;
+}
+
+/**
+ * Find the entry of a blob and check that its data lies within the datum.
+ * @param ctx Decoder context.
+ * @param index Index of the blob.
+ * @return Pointer to the entry, or NULL if the index or entry is invalid.
+ */
+static const EXIB_BlobEntry* EXIB_DEC_LocateBlob(EXIB_DEC_Context* ctx, uint32_t index)
+{
+    const EXIB_BlobDirectory* directory = ctx->blobDirectory;
+    const EXIB_BlobEntry* entry;
+    uint32_t offset;
+
+    if (!directory || index >= directory->entries)
+        return NULL;
+
+    offset = directory->offsets[index];
+    if (offset % EXIB_BLOB_ALIGNMENT != 0
+        || ctx->blobTableSize < sizeof(EXIB_BlobEntry)
+        || offset > ctx->blobTableSize - sizeof(EXIB_BlobEntry))
+        return NULL;
+
+    entry = (const EXIB_BlobEntry*)((const uint8_t*)directory + offset);
+    if (entry->storedSize > ctx->blobTableSize - offset - sizeof(EXIB_BlobEntry))
+        return NULL;
+
+    // Entries that are stored as they are must say so consistently.
+    if (entry->flags & ~EXIB_BLOB_COMPRESSED
+        || (!(entry->flags & EXIB_BLOB_COMPRESSED) && entry->storedSize != entry->realSize))
+        return NULL;
+
+    // Compressed entries can't claim more than their data decompresses to, which is allocated up front.
+    if ((uint64_t)entry->realSize > (uint64_t)entry->storedSize * EXIB_LZ_MAX_EXPANSION)
+        return NULL;
+
+    return entry;
+}
+
+void EXIB_DEC_ClearBlobCache(EXIB_DEC_Context* ctx)
+{
+    if (!ctx->blobCache)
+        return;
+
+    for (uint32_t i = 0; i < EXIB_MAX_BLOBS; ++i)
+    {
+        if (ctx->blobCache[i])
+            EXIB_Free(ctx->blobCache[i]);
+        ctx->blobCache[i] = NULL;
+    }
+}
+
+/**
+ * Decompress a blob into the cache, unless that happened already.
+ * @param ctx Decoder context.
+ * @param index Index of the blob.
+ * @param entry Entry of the blob, which is compressed.
+ * @param dataOut Receives a pointer to the decompressed data.
+ * @return EXIB_DEC_ERR_Success, EXIB_DEC_ERR_OutOfMemory, or EXIB_DEC_ERR_InvalidBlob
+ *         if the data is malformed or doesn't match its checksum.
+ */
+static EXIB_DEC_Error EXIB_DEC_DecompressBlob(EXIB_DEC_Context* ctx,
+                                              uint32_t index,
+                                              const EXIB_BlobEntry* entry,
+                                              const void** dataOut)
+{
+    const EXIB_Header* header = ctx->buffer;
+    void* data;
+
+    if (!ctx->blobCache)
+    {
+        ctx->blobCache = EXIB_Calloc(sizeof(void*), EXIB_MAX_BLOBS);
+        if (!ctx->blobCache)
+            return EXIB_DEC_ERR_OutOfMemory;
+    }
+
+    if (ctx->blobCache[index])
+    {
+        *dataOut = ctx->blobCache[index];
+        return EXIB_DEC_ERR_Success;
+    }
+
+    data = EXIB_Alloc(entry->realSize ? entry->realSize : 1);
+    if (!data)
+        return EXIB_DEC_ERR_OutOfMemory;
+
+    if (EXIB_LZ_Decompress(entry->data, entry->storedSize, data, entry->realSize))
+    {
+        EXIB_Free(data);
+        return EXIB_DEC_ERR_InvalidBlob;
+    }
+
+    // The datum checksum only covers the compressed data, this one covers what it decompressed to.
+    if (!(header->flags & EXIB_HEADER_NO_CHECKSUM)
+        && ctx->options.checksumMode != EXIB_DEC_CHECKSUM_NONE
+        && EXIB_CRC32C(0, data, entry->realSize) != entry->checksum)
+    {
+        EXIB_Free(data);
+        return EXIB_DEC_ERR_InvalidBlob;
+    }
+
+    ctx->blobCache[index] = data;
+    *dataOut = data;
+    return EXIB_DEC_ERR_Success;
+}
+
+EXIB_DEC_Error EXIB_DEC_GetBlob(EXIB_DEC_Context* ctx,
+                                EXIB_DEC_Field field,
+                                const void** dataOut,
+                                size_t* sizeOut)
+{
+    EXIB_DEC_FieldValue value;
+    const EXIB_BlobEntry* entry;
+    EXIB_DEC_Error error;
+
+    if (field == EXIB_DEC_INVALID_FIELD || EXIB_DEC_FieldGetType(field) != EXIB_TYPE_BLOB)
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_BlobExpected);
+
+    if (EXIB_DEC_FieldGet(ctx, field, &value) != EXIB_TYPE_BLOB
+        || EXIB_DEC_CheckBounds(ctx, value.value))
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_OutOfBounds);
+
+    entry = EXIB_DEC_LocateBlob(ctx, value.value->uint8);
+    if (!entry)
+        return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_InvalidBlob);
+
+    if (entry->flags & EXIB_BLOB_COMPRESSED)
+    {
+        error = EXIB_DEC_DecompressBlob(ctx, value.value->uint8, entry, dataOut);
+        if (error != EXIB_DEC_ERR_Success)
+            return EXIB_DEC_SetError(ctx, error);
+    }
+    else
+        *dataOut = entry->data;
+
+    *sizeOut = entry->realSize;
+    return EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_Success);
+}
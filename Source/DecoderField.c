@@ -80,4 +80,29 @@ EXIB_Type EXIB_DEC_FieldGet(EXIB_DEC_Context* ctx, EXIB_DEC_Field field, EXIB_DE
     valueOut->type = type;
     valueOut->value = ctx->buffer + dataOffset;
     return type;
+}
+
+int EXIB_DEC_PatchField(EXIB_DEC_Context* ctx, EXIB_DEC_Field field, EXIB_Value value)
+{
+    EXIB_Header* header = ctx->buffer;
+    size_t typeSize = EXIB_GetTypeSize(EXIB_DEC_FieldGetType(field));
+    size_t dataOffset = EXIB_DEC_GetFieldDataOffset(ctx, field);
+
+    if (!EXIB_DEC_FieldIsPrimitive(field))
+    {
+        EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_ValueExpected);
+        return 1;
+    }
+
+    if (EXIB_DEC_CheckBounds(ctx, ctx->buffer + dataOffset + typeSize - 1))
+    {
+        EXIB_DEC_SetError(ctx, EXIB_DEC_ERR_OutOfBounds);
+        return 1;
+    }
+
+    if (!(header->flags & EXIB_HEADER_NO_CHECKSUM))
+        header->checksum = EXIB_CRC32C_Patch(header->checksum, header->datumSize, dataOffset, ctx->buffer + dataOffset, &value, typeSize);
+
+    memcpy(ctx->buffer + dataOffset, &value, typeSize);
+    return 0;
 }
\ No newline at end of file
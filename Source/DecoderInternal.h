@@ -10,6 +10,10 @@ typedef struct _EXIB_DEC_Context
     void*  buffer; // Decode buffer.
     size_t bufferSize; // Size of decode buffer in bytes.
     void*  stringTable;
+    const EXIB_BlobDirectory* blobDirectory; // NULL if the datum has no blob table.
+    size_t blobTableSize; // Bytes from the blob directory to the end of the datum.
+    void** blobCache; // Decompressed blobs by index. Allocated by the first one, NULL until then.
+    const EXIB_Dictionary* dictionary; // Dictionary the datum's names come from, NULL if it doesn't use one.
 
     EXIB_DEC_Object rootObject;
     EXIB_DEC_Object objectCache;
@@ -36,6 +40,14 @@ exib_string_t EXIB_DEC_GetFieldNameOffset(EXIB_DEC_Context* ctx, EXIB_DEC_Field
  */
 size_t EXIB_DEC_GetFieldOffset(EXIB_DEC_Context* ctx, EXIB_DEC_Field field);
 
+/**
+ * Get the offset of a field's value relative to the beginning of the datum.
+ * @param ctx Decoder context.
+ * @param field Decoder field, of a primitive type.
+ * @return Offset of the value, after the prefix, name and padding.
+ */
+size_t EXIB_DEC_GetFieldDataOffset(EXIB_DEC_Context* ctx, EXIB_DEC_Field field);
+
 /**
  * Decode the size and data offset of an object. Also check bounds
  * to ensure object is valid.
@@ -54,4 +66,24 @@ EXIB_DEC_Error EXIB_DEC_PartialDecodeAggregate(EXIB_DEC_Context* ctx, EXIB_DEC_F
  */
 EXIB_DEC_TString EXIB_DEC_GetStringFromOffset(EXIB_DEC_Context* ctx, exib_string_t stringOffset);
 
+/**
+ * Find the dictionary the extended header names among the dictionaries option.
+ * @param ctx Decoder context.
+ * @param header Header of a datum whose fields have been validated.
+ * @return EXIB_DEC_ERR_Success, or EXIB_DEC_ERR_UnknownDictionary if it isn't one of them.
+ */
+EXIB_DEC_Error EXIB_DEC_InitializeDictionary(EXIB_DEC_Context* ctx, const EXIB_Header* header);
+
+/**
+ * Find the blob table through the extended header, and make sure its directory
+ * lies within the datum. Entries are checked when they are accessed.
+ * @param ctx Decoder context.
+ * @param header Header of a datum whose fields have been validated.
+ * @return EXIB_DEC_ERR_Success, or EXIB_DEC_ERR_InvalidHeader if the blob table is out of bounds.
+ */
+EXIB_DEC_Error EXIB_DEC_InitializeBlobTable(EXIB_DEC_Context* ctx, const EXIB_Header* header);
+
+/** Free the blobs decompressed from the current datum, but keep the cache itself. */
+void EXIB_DEC_ClearBlobCache(EXIB_DEC_Context* ctx);
+
 #endif // _EXIB_DECODER_INTERNAL_H
@@ -103,6 +103,28 @@ EXIB_DEC_Array* EXIB_DEC_ArrayFromField(EXIB_DEC_Context* ctx, EXIB_DEC_Field fi
     arrayOut->elements = arrayOut->object.size ? (arrayOut->object.size / arrayOut->elementSize) : 0;
     arrayOut->data = (void*)(arrayOut->object.field) + arrayOut->object.dataOffset;
 
+    // Packed arrays store their element count in front of the packed data, which `data` points at.
+    if (arrayOut->object.objectPrefix.packing != EXIB_PACKING_NONE)
+    {
+        EXIB_Type type = arrayOut->object.objectPrefix.arrayType;
+        uint32_t elements;
+
+        if (type < EXIB_TYPE_INT8 || type > EXIB_TYPE_UINT64 || arrayOut->object.objectPrefix.arrayString
+            || arrayOut->object.size < sizeof(EXIB_PackedArray))
+        {
+            ctx->lastError = EXIB_DEC_ERR_InvalidPacking;
+            return NULL;
+        }
+
+        memcpy(&elements, arrayOut->data, sizeof(elements));
+        if (elements > INT32_MAX)
+        {
+            ctx->lastError = EXIB_DEC_ERR_InvalidPacking;
+            return NULL;
+        }
+        arrayOut->elements = (int)elements;
+    }
+
     return arrayOut;
 }
 
@@ -148,16 +170,15 @@ EXIB_DEC_Field EXIB_DEC_NextField(EXIB_DEC_Context* ctx, EXIB_DEC_Object* object
 
     if (EXIB_DEC_FieldIsAggregate(field))
     {
-        EXIB_ObjectPrefix* objectPrefix = (EXIB_ObjectPrefix*)(prefix + stride);
-
         // Partially decode object into object cache.
         // Speeds up a potential GetObject call.
         if (EXIB_DEC_PartialDecodeAggregate(ctx, field, &ctx->objectCache) != EXIB_DEC_ERR_Success)
             return EXIB_DEC_INVALID_FIELD;
 
-        stride += 1 // Object prefix
-                  + (2 + (objectPrefix->size * 2)) // Object size
-                  + ctx->objectCache.size; // Object data
+        // Arrays put their padding after the size, so the data offset covers
+        // prefixes, name, size and padding in one go.
+        stride = ctx->objectCache.dataOffset // Everything up to the object data
+                 + ctx->objectCache.size; // Object data
     }
 
     next = field + stride;
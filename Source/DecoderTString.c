@@ -5,6 +5,7 @@
 #include <EXIB/Decoder.h>
 #include "AllocatorInternal.h"
 #include "DecoderInternal.h"
+#include "DictionaryInternal.h"
 
 EXIB_DEC_TString EXIB_DEC_GetStringFromOffset(EXIB_DEC_Context* ctx, exib_string_t stringOffset)
 {
@@ -12,8 +13,42 @@ EXIB_DEC_TString EXIB_DEC_GetStringFromOffset(EXIB_DEC_Context* ctx, exib_string
 
     if (stringOffset == EXIB_INVALID_STRING)
         return EXIB_DEC_INVALID_STRING;
-    else if ((stringOffset + sizeof(EXIB_StringEntry)) >= header->stringSize)
+
+    // The dictionary's names come first, the datum's string table follows them.
+    if (ctx->dictionary)
+    {
+        if (stringOffset < ctx->dictionary->tableSize)
+            return (EXIB_DEC_TString)EXIB_GetDictionaryString(ctx->dictionary, stringOffset);
+
+        stringOffset -= ctx->dictionary->tableSize;
+    }
+
+    if ((stringOffset + sizeof(EXIB_StringEntry)) >= header->stringSize)
         return EXIB_DEC_INVALID_STRING;
 
     return ctx->stringTable + stringOffset;
-}
\ No newline at end of file
+}
+
+EXIB_DEC_Error EXIB_DEC_InitializeDictionary(EXIB_DEC_Context* ctx, const EXIB_Header* header)
+{
+    const EXIB_ExtHeader* extHeader = (const EXIB_ExtHeader*)(header + 1);
+
+    ctx->dictionary = NULL;
+
+    // Extended headers that end before the ID don't use a dictionary either.
+    if (!(header->flags & EXIB_HEADER_EXT)
+        || header->extendedSize < sizeof(EXIB_ExtHeader)
+        || extHeader->dictionary == 0)
+        return EXIB_DEC_ERR_Success;
+
+    for (int i = 0; i < ctx->options.dictionaryCount; ++i)
+    {
+        if (EXIB_GetDictionaryId(ctx->options.dictionaries[i]) == extHeader->dictionary)
+        {
+            ctx->dictionary = ctx->options.dictionaries[i];
+            return EXIB_DEC_ERR_Success;
+        }
+    }
+
+    return EXIB_DEC_ERR_UnknownDictionary;
+}
@@ -0,0 +1,456 @@
+#include <stddef.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Decoder.h>
+#include <EXIB/Delta.h>
+#include "DecoderInternal.h"
+
+/*
+ * Bytes are compared with the base at the same offset, while walking the fields
+ * of the next datum. As long as the layouts agree, that's the same as walking both
+ * datums side by side, and once they don't, the fields that moved are sent whole.
+ */
+
+// A range costs at least two bytes of varints, so gaps up to that are sent along instead.
+// Being smaller than the checksum field, they never bridge it either.
+#define EXIB_DELTA_MERGE_GAP 2
+
+// Aggregates nested deeper than this are compared byte by byte, instead of by field.
+#define EXIB_DELTA_MAX_DEPTH 64
+
+// Bytes checksummed in about the time it takes to patch a checksum for one range.
+#define EXIB_DELTA_PATCH_COST 4096
+
+#define EXIB_DELTA_CHECKSUM_OFFSET offsetof(EXIB_Header, checksum)
+#define EXIB_DELTA_CHECKSUM_END (EXIB_DELTA_CHECKSUM_OFFSET + sizeof(uint32_t))
+
+typedef struct _EXIB_DELTA_Writer
+{
+    const uint8_t* base;
+    const uint8_t* next;
+    size_t baseSize;
+    size_t nextSize;
+
+    uint8_t* patch;
+    size_t capacity;
+    size_t size;         // Bytes of the patch written so far.
+    int overflow;        // Set if the patch didn't fit.
+
+    size_t previousEnd;  // End of the last range written.
+    size_t rangeStart;   // Range that hasn't been written yet, in case the next one joins it.
+    size_t rangeEnd;     // 0 if there is none.
+    uint32_t rangeCount;
+} EXIB_DELTA_Writer;
+
+static void EXIB_DELTA_WriteVarint(EXIB_DELTA_Writer* w, size_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+
+        if (w->size < w->capacity)
+            w->patch[w->size] = byte;
+        else
+            w->overflow = 1;
+        ++w->size;
+    } while (value);
+}
+
+static void EXIB_DELTA_Flush(EXIB_DELTA_Writer* w)
+{
+    size_t length = w->rangeEnd - w->rangeStart;
+
+    if (w->rangeEnd == 0)
+        return;
+
+    EXIB_DELTA_WriteVarint(w, w->rangeStart - w->previousEnd);
+    EXIB_DELTA_WriteVarint(w, length);
+    if (w->size + length <= w->capacity)
+        memcpy(w->patch + w->size, w->next + w->rangeStart, length);
+    else
+        w->overflow = 1;
+
+    w->size += length;
+    w->previousEnd = w->rangeEnd;
+    w->rangeEnd = 0;
+    ++w->rangeCount;
+}
+
+// Send [start, end) of the next datum. Ranges must be added in order.
+static void EXIB_DELTA_AddRange(EXIB_DELTA_Writer* w, size_t start, size_t end)
+{
+    if (w->rangeEnd != 0 && start <= w->rangeEnd + EXIB_DELTA_MERGE_GAP)
+    {
+        if (end > w->rangeEnd)
+            w->rangeEnd = end;
+        return;
+    }
+
+    EXIB_DELTA_Flush(w);
+    w->rangeStart = start;
+    w->rangeEnd = end;
+}
+
+// Check if [start, end) of the next datum differs from the base. Bytes past the end of the base always do.
+static int EXIB_DELTA_Differs(EXIB_DELTA_Writer* w, size_t start, size_t end)
+{
+    if (end > w->baseSize)
+        return 1;
+
+    return memcmp(w->next + start, w->base + start, end - start) != 0;
+}
+
+/**
+ * Send the elements of [start, end) that differ from the base.
+ * @param w Patch writer.
+ * @param start Offset of the first element.
+ * @param end Offset past the last element.
+ * @param stride Size of an element, 1 to compare byte by byte.
+ */
+static void EXIB_DELTA_DiffSpan(EXIB_DELTA_Writer* w, size_t start, size_t end, size_t stride)
+{
+    size_t common = (end < w->baseSize) ? end : w->baseSize;
+    size_t i = start;
+
+    while (i < common)
+    {
+        // Skip unchanged bytes a block at a time.
+        if (common - i >= 64 && memcmp(w->next + i, w->base + i, 64) == 0)
+        {
+            i += 64;
+            continue;
+        }
+
+        if (w->next[i] == w->base[i])
+        {
+            ++i;
+            continue;
+        }
+
+        // Send the element that changed, and the ones after it for as long as they keep changing.
+        size_t runStart = start + (i - start) / stride * stride;
+        size_t runEnd = runStart + stride;
+        while (runEnd < end && EXIB_DELTA_Differs(w, runEnd, (runEnd + stride < end) ? runEnd + stride : end))
+            runEnd += stride;
+        if (runEnd > end)
+            runEnd = end;
+
+        EXIB_DELTA_AddRange(w, runStart, runEnd);
+        i = runEnd;
+    }
+
+    // Elements past the end of the base.
+    if (i < common)
+        i = common;
+    if (i < end)
+        EXIB_DELTA_AddRange(w, start + (i - start) / stride * stride, end);
+}
+
+static int EXIB_DELTA_DiffAggregate(EXIB_DEC_Context* ctx, EXIB_DELTA_Writer* w, EXIB_DEC_Field field, int depth);
+
+// Send the fields of an object, or of an array of aggregates, that differ from the base.
+static int EXIB_DELTA_DiffObject(EXIB_DEC_Context* ctx, EXIB_DELTA_Writer* w, EXIB_DEC_Object* object, int depth)
+{
+    size_t objectEnd = EXIB_DEC_GetFieldOffset(ctx, object->field) + object->dataOffset + object->size;
+    EXIB_DEC_Field field = EXIB_DEC_NextField(ctx, object, EXIB_DEC_INVALID_FIELD);
+
+    while (field != EXIB_DEC_INVALID_FIELD)
+    {
+        EXIB_DEC_Field next = EXIB_DEC_NextField(ctx, object, field);
+        if (ctx->lastError != EXIB_DEC_ERR_Success)
+            return 1;
+
+        if (EXIB_DEC_FieldIsAggregate(field))
+        {
+            if (EXIB_DELTA_DiffAggregate(ctx, w, field, depth + 1))
+                return 1;
+        }
+        else
+        {
+            // A value ends where the next field starts, whatever its type.
+            size_t offset = EXIB_DEC_GetFieldOffset(ctx, field);
+            size_t dataOffset = EXIB_DEC_GetFieldDataOffset(ctx, field);
+            size_t end = (next != EXIB_DEC_INVALID_FIELD) ? EXIB_DEC_GetFieldOffset(ctx, next) : objectEnd;
+            if (dataOffset > end)
+                return 1;
+
+            // Send only the value if that's all that changed.
+            if (EXIB_DELTA_Differs(w, offset, dataOffset))
+                EXIB_DELTA_AddRange(w, offset, end);
+            else if (EXIB_DELTA_Differs(w, dataOffset, end))
+                EXIB_DELTA_AddRange(w, dataOffset, end);
+        }
+
+        field = next;
+    }
+
+    return ctx->lastError != EXIB_DEC_ERR_Success;
+}
+
+// Send the parts of an object or array that differ from the base.
+static int EXIB_DELTA_DiffAggregate(EXIB_DEC_Context* ctx, EXIB_DELTA_Writer* w, EXIB_DEC_Field field, int depth)
+{
+    EXIB_DEC_Object object;
+
+    if (EXIB_DEC_PartialDecodeAggregate(ctx, field, &object) != EXIB_DEC_ERR_Success)
+        return 1;
+
+    size_t offset = EXIB_DEC_GetFieldOffset(ctx, field);
+    size_t dataStart = offset + object.dataOffset;
+    size_t end = dataStart + object.size;
+
+    if (!EXIB_DELTA_Differs(w, offset, end))
+        return 0;
+
+    // Prefixes, name, size and padding.
+    if (EXIB_DELTA_Differs(w, offset, dataStart))
+        EXIB_DELTA_AddRange(w, offset, dataStart);
+
+    // Packed elements have no fixed stride, so they are compared byte by byte.
+    EXIB_Type arrayType = object.objectPrefix.arrayType;
+    if (EXIB_DEC_FieldGetType(field) == EXIB_TYPE_ARRAY && EXIB_GetTypeSize(arrayType) != 0 && !object.objectPrefix.packing)
+        EXIB_DELTA_DiffSpan(w, dataStart, end, EXIB_GetTypeSize(arrayType));
+    else if (EXIB_DEC_FieldGetType(field) == EXIB_TYPE_ARRAY && arrayType != EXIB_TYPE_OBJECT && arrayType != EXIB_TYPE_ARRAY)
+        EXIB_DELTA_DiffSpan(w, dataStart, end, 1);
+    else if (depth >= EXIB_DELTA_MAX_DEPTH)
+        EXIB_DELTA_DiffSpan(w, dataStart, end, 1);
+    else
+        return EXIB_DELTA_DiffObject(ctx, w, &object, depth);
+
+    return 0;
+}
+
+size_t EXIB_DELTA_Bound(const EXIB_Header* next)
+{
+    // Ranges are at least a byte long, with gaps longer than EXIB_DELTA_MERGE_GAP
+    // between them, and each has two varints of up to 5 bytes.
+    size_t ranges = (next->datumSize + EXIB_DELTA_MERGE_GAP + 1) / (EXIB_DELTA_MERGE_GAP + 2);
+    return sizeof(EXIB_DeltaHeader) + next->datumSize + ranges * 10;
+}
+
+size_t EXIB_DELTA_Encode(const EXIB_Header* base,
+                         const EXIB_Header* next,
+                         void* patch,
+                         size_t capacity)
+{
+    EXIB_DELTA_Writer w = {
+        .base = (const uint8_t*)base,
+        .next = (const uint8_t*)next,
+        .baseSize = base->datumSize,
+        .nextSize = next->datumSize,
+        .patch = patch,
+        .capacity = capacity,
+        .size = sizeof(EXIB_DeltaHeader)
+    };
+
+    if (EXIB_CheckHeaderFields(base, base->datumSize) || EXIB_CheckHeaderFields(next, next->datumSize))
+        return 0;
+
+    // Only the fields are walked, so the context isn't reset: the names,
+    // dictionary and blob table of the datum don't matter here.
+    EXIB_DEC_Context ctx = {
+        .buffer = (void*)next,
+        .bufferSize = next->datumSize,
+        .lastError = EXIB_DEC_ERR_Success
+    };
+
+    // The header and extended header, except for the checksum, which the patch carries.
+    size_t rootOffset = sizeof(EXIB_Header) + next->extendedSize;
+    EXIB_DELTA_DiffSpan(&w, 0, EXIB_DELTA_CHECKSUM_OFFSET, 1);
+    EXIB_DELTA_DiffSpan(&w, EXIB_DELTA_CHECKSUM_END, rootOffset, 1);
+
+    EXIB_DEC_Object root;
+    EXIB_DEC_Field rootField = (EXIB_DEC_Field)(w.next + rootOffset);
+    if (EXIB_DEC_PartialDecodeAggregate(&ctx, rootField, &root) != EXIB_DEC_ERR_Success
+        || EXIB_DELTA_DiffAggregate(&ctx, &w, rootField, 0))
+        return 0;
+
+    // String table and blob table.
+    EXIB_DELTA_DiffSpan(&w, rootOffset + root.dataOffset + root.size, w.nextSize, 1);
+    EXIB_DELTA_Flush(&w);
+
+    if (w.overflow || capacity < sizeof(EXIB_DeltaHeader))
+        return 0;
+
+    EXIB_DeltaHeader header = {
+        .magic = EXIB_DELTA_MAGIC,
+        .baseSize = base->datumSize,
+        .baseChecksum = base->checksum,
+        .nextSize = next->datumSize,
+        .nextChecksum = next->checksum,
+        .rangeCount = w.rangeCount
+    };
+    memcpy(patch, &header, sizeof(header));
+
+    return w.size;
+}
+
+// Read a varint, and advance past it. Returns NULL if it runs past the end of the patch or doesn't fit 32 bits.
+static const uint8_t* EXIB_DELTA_ReadVarint(const uint8_t* p, const uint8_t* end, uint32_t* value)
+{
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p >= end)
+            return NULL;
+
+        result |= (uint64_t)(*p & 0x7F) << shift;
+        if (!(*p++ & 0x80))
+        {
+            if (result > UINT32_MAX)
+                return NULL;
+            *value = (uint32_t)result;
+            return p;
+        }
+    }
+
+    return NULL;
+}
+
+// Checksum [start, end) of the base as part of the next datum, whose checksum field counts as 0.
+static uint32_t EXIB_DELTA_ChecksumBase(uint32_t crc, const uint8_t* base, size_t start, size_t end)
+{
+    static const uint8_t zeros[sizeof(uint32_t)] = { 0 };
+
+    if (start < end && start < EXIB_DELTA_CHECKSUM_OFFSET)
+    {
+        size_t split = (end < EXIB_DELTA_CHECKSUM_OFFSET) ? end : EXIB_DELTA_CHECKSUM_OFFSET;
+        crc = EXIB_CRC32C(crc, base + start, split - start);
+        start = split;
+    }
+
+    if (start < end && start < EXIB_DELTA_CHECKSUM_END)
+    {
+        size_t split = (end < EXIB_DELTA_CHECKSUM_END) ? end : EXIB_DELTA_CHECKSUM_END;
+        crc = EXIB_CRC32C(crc, zeros, split - start);
+        start = split;
+    }
+
+    if (start < end)
+        crc = EXIB_CRC32C(crc, base + start, end - start);
+
+    return crc;
+}
+
+/**
+ * Check that the ranges of a patch lie within the next datum, and that the
+ * result has the checksum the patch carries, without writing anything.
+ * @param base Base datum.
+ * @param delta Patch header.
+ * @param ranges First range.
+ * @param end End of the patch.
+ * @return 0 if the patch can be applied, 1 otherwise.
+ */
+static int EXIB_DELTA_Verify(const EXIB_Header* base, const EXIB_DeltaHeader* delta, const uint8_t* ranges, const uint8_t* end)
+{
+    const uint8_t* baseBytes = (const uint8_t*)base;
+    uint8_t flags = base->flags;
+    size_t position = 0;
+    uint32_t crc = 0;
+
+    // Patching the checksum of the base only works if the size didn't change and the
+    // base has a checksum to patch, and only pays off if the datum is large enough.
+    int incremental = delta->baseSize == delta->nextSize
+        && !(base->flags & EXIB_HEADER_NO_CHECKSUM)
+        && delta->rangeCount <= delta->nextSize / EXIB_DELTA_PATCH_COST;
+    if (incremental)
+        crc = base->checksum;
+
+    for (uint32_t i = 0; i < delta->rangeCount; ++i)
+    {
+        uint32_t gap, length;
+
+        ranges = EXIB_DELTA_ReadVarint(ranges, end, &gap);
+        if (ranges)
+            ranges = EXIB_DELTA_ReadVarint(ranges, end, &length);
+        if (!ranges || (size_t)(end - ranges) < length)
+            return 1;
+
+        size_t offset = position + gap;
+        if (offset + length > delta->nextSize || (gap > 0 && offset > delta->baseSize))
+            return 1;
+
+        // The checksum field isn't part of any range, the patch carries it separately.
+        if (offset < EXIB_DELTA_CHECKSUM_END && offset + length > EXIB_DELTA_CHECKSUM_OFFSET)
+            return 1;
+
+        if (offset <= offsetof(EXIB_Header, flags) && offset + length > offsetof(EXIB_Header, flags))
+            flags = ranges[offsetof(EXIB_Header, flags) - offset];
+
+        if (incremental)
+        {
+            crc = EXIB_CRC32C_Patch(crc, delta->nextSize, offset, baseBytes + offset, ranges, length);
+        }
+        else
+        {
+            crc = EXIB_DELTA_ChecksumBase(crc, baseBytes, position, offset);
+            crc = EXIB_CRC32C(crc, ranges, length);
+        }
+
+        ranges += length;
+        position = offset + length;
+    }
+
+    // Everything after the last range comes from the base, which has to have it.
+    if (ranges != end || (position < delta->nextSize && delta->nextSize > delta->baseSize))
+        return 1;
+
+    if (flags & EXIB_HEADER_NO_CHECKSUM)
+        return delta->nextChecksum != 0;
+
+    if (!incremental)
+        crc = EXIB_DELTA_ChecksumBase(crc, baseBytes, position, delta->nextSize);
+
+    return crc != delta->nextChecksum;
+}
+
+int EXIB_DELTA_Apply(const EXIB_Header* base,
+                     const void* patch,
+                     size_t patchSize,
+                     void* out,
+                     size_t capacity)
+{
+    const uint8_t* ranges = (const uint8_t*)patch + sizeof(EXIB_DeltaHeader);
+    const uint8_t* end = (const uint8_t*)patch + patchSize;
+    EXIB_DeltaHeader delta;
+
+    if (patchSize < sizeof(EXIB_DeltaHeader))
+        return 1;
+
+    memcpy(&delta, patch, sizeof(delta));
+    if (delta.magic != EXIB_DELTA_MAGIC
+        || delta.baseSize != base->datumSize
+        || delta.baseChecksum != base->checksum
+        || delta.nextSize < EXIB_MINIMUM
+        || delta.nextSize > capacity)
+        return 1;
+
+    // Nothing is written unless the whole patch checks out, so a base patched in place survives a bad patch.
+    if (EXIB_DELTA_Verify(base, &delta, ranges, end))
+        return 1;
+
+    uint8_t* dst = out;
+    if (out != (const void*)base)
+        memcpy(dst, base, (delta.baseSize < delta.nextSize) ? delta.baseSize : delta.nextSize);
+
+    size_t position = 0;
+    for (uint32_t i = 0; i < delta.rangeCount; ++i)
+    {
+        uint32_t gap = 0;
+        uint32_t length = 0;
+
+        ranges = EXIB_DELTA_ReadVarint(ranges, end, &gap);
+        ranges = EXIB_DELTA_ReadVarint(ranges, end, &length);
+
+        memcpy(dst + position + gap, ranges, length);
+        ranges += length;
+        position += gap + length;
+    }
+
+    ((EXIB_Header*)dst)->checksum = delta.nextChecksum;
+    return EXIB_CheckHeaderFields(out, delta.nextSize);
+}
@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include "AllocatorInternal.h"
+#include "DictionaryInternal.h"
+#include "EncoderInternal.h"
+
+/*
+ * A dictionary is a string table that is laid out once, and shared instead of
+ * being written to every datum. Encoders look names up in it before their own
+ * string cache, through the same kind of hash table, so its entries can stand
+ * in for cache entries. Decoders resolve offsets below its size in its table.
+ */
+
+/**
+ * Add a name to a dictionary that is being created, unless it's in there already.
+ * @param dictionary Dictionary with room for the name.
+ * @param name Name to add.
+ * @param length Length of the name.
+ * @return 0 on success, 1 if the name doesn't fit into the table.
+ */
+static int EXIB_AddDictionaryName(EXIB_Dictionary* dictionary, const char* name, uint32_t length)
+{
+    uint32_t hash = EXIB_ENC_HashString(name, length);
+    uint32_t slot = hash & dictionary->slotMask;
+    EXIB_ENC_StringEntry* entry;
+    EXIB_StringEntry* tableEntry;
+    char* buffer;
+
+    if (EXIB_FindDictionaryEntry(dictionary, name, hash, length))
+        return 0;
+
+    // The offset after the last name has to be valid too, it's where the string table of a datum starts.
+    if (dictionary->tableSize + sizeof(EXIB_StringEntry) + length >= EXIB_INVALID_STRING)
+        return 1;
+
+    while (dictionary->slots[slot] != 0)
+        slot = (slot + 1) & dictionary->slotMask;
+
+    // A name takes up as many bytes with its terminator as it does in the table, so it's at the same offset.
+    buffer = dictionary->names + dictionary->tableSize;
+    memcpy(buffer, name, length + 1);
+
+    tableEntry = (EXIB_StringEntry*)&dictionary->table[dictionary->tableSize];
+    tableEntry->length = length;
+    memcpy(tableEntry->string, name, length);
+
+    entry = &dictionary->entries[dictionary->count++];
+    entry->hash = hash;
+    entry->length = length;
+    entry->offset = dictionary->tableSize;
+    entry->buffer = buffer;
+    dictionary->slots[slot] = dictionary->count;
+
+    dictionary->tableSize += sizeof(EXIB_StringEntry) + length;
+    return 0;
+}
+
+EXIB_Dictionary* EXIB_CreateDictionary(uint16_t id, const char* const* names, size_t count)
+{
+    EXIB_Dictionary* dictionary;
+    size_t namesSize = 0;
+    uint32_t slots = 16;
+
+    // Every name takes up at least one byte of the table.
+    if (id == 0 || count >= EXIB_INVALID_STRING)
+        return NULL;
+
+    // Each name takes its length and one more byte, both in the table and with its terminator.
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t length = strlen(names[i]);
+
+        if (length > UINT8_MAX)
+            return NULL;
+        namesSize += length + 1;
+    }
+
+    // Keep the load factor at 50% or below.
+    while (slots < count * 2)
+        slots *= 2;
+
+    dictionary = EXIB_New(EXIB_Dictionary);
+    if (!dictionary)
+        return NULL;
+
+    dictionary->id = id;
+    dictionary->slotMask = slots - 1;
+    dictionary->entries = EXIB_Alloc((count ? count : 1) * sizeof(EXIB_ENC_StringEntry));
+    dictionary->slots = EXIB_Calloc(slots, sizeof(uint32_t));
+    dictionary->table = EXIB_Alloc(namesSize ? namesSize : 1);
+    dictionary->names = EXIB_Alloc(namesSize ? namesSize : 1);
+
+    if (!dictionary->entries || !dictionary->slots || !dictionary->table || !dictionary->names)
+    {
+        EXIB_FreeDictionary(dictionary);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (EXIB_AddDictionaryName(dictionary, names[i], strlen(names[i])))
+        {
+            EXIB_FreeDictionary(dictionary);
+            return NULL;
+        }
+    }
+
+    return dictionary;
+}
+
+void EXIB_FreeDictionary(EXIB_Dictionary* dictionary)
+{
+    if (dictionary->entries)
+        EXIB_Free(dictionary->entries);
+    if (dictionary->slots)
+        EXIB_Free(dictionary->slots);
+    if (dictionary->table)
+        EXIB_Free(dictionary->table);
+    if (dictionary->names)
+        EXIB_Free(dictionary->names);
+
+    EXIB_Free(dictionary);
+}
+
+uint16_t EXIB_GetDictionaryId(const EXIB_Dictionary* dictionary)
+{
+    return dictionary->id;
+}
+
+size_t EXIB_GetDictionarySize(const EXIB_Dictionary* dictionary)
+{
+    return dictionary->count;
+}
+
+const EXIB_ENC_StringEntry* EXIB_FindDictionaryEntry(const EXIB_Dictionary* dictionary, const char* str, uint32_t hash, uint32_t length)
+{
+    uint32_t slot = hash & dictionary->slotMask;
+
+    while (dictionary->slots[slot] != 0)
+    {
+        const EXIB_ENC_StringEntry* entry = &dictionary->entries[dictionary->slots[slot] - 1];
+
+        if (entry->hash == hash
+            && entry->length == length
+            && memcmp(entry->buffer, str, length) == 0)
+            return entry;
+
+        slot = (slot + 1) & dictionary->slotMask;
+    }
+
+    return NULL;
+}
+
+const EXIB_StringEntry* EXIB_GetDictionaryString(const EXIB_Dictionary* dictionary, exib_string_t offset)
+{
+    const EXIB_StringEntry* entry = (const EXIB_StringEntry*)&dictionary->table[offset];
+
+    // Offsets come from the datum, so the name has to be checked against the end of the table.
+    if (offset + sizeof(EXIB_StringEntry) + entry->length > dictionary->tableSize)
+        return NULL;
+
+    return entry;
+}
@@ -0,0 +1,41 @@
+#ifndef _EXIB_DICTIONARY_INTERNAL_H
+#define _EXIB_DICTIONARY_INTERNAL_H
+
+#include <EXIB/EXIB.h>
+#include "EncoderInternal.h"
+
+/*
+ * Nothing in a dictionary is written after it has been created,
+ * which is what lets contexts on any number of threads share it without locking.
+ */
+struct _EXIB_Dictionary
+{
+    uint16_t id;
+    uint32_t count;
+    EXIB_ENC_StringEntry* entries; // Entries in table order, with the offsets they have in every datum.
+    uint32_t* slots;    // Hash table of entry index + 1, or 0 if the slot is empty, like the string cache.
+    uint32_t  slotMask; // Number of slots - 1.
+    uint8_t*  table;     // Names laid out like a string table, which decoders resolve offsets in.
+    uint32_t  tableSize; // Size of the table, and string offset of the first name that isn't in it.
+    char*     names;     // Null-terminated characters the entries point to.
+};
+
+/**
+ * Find the entry of a name in a dictionary.
+ * @param dictionary Dictionary to search.
+ * @param str Name to find.
+ * @param hash Hash of the name, from EXIB_ENC_HashString.
+ * @param length Length of the name.
+ * @return Entry of the name, or NULL if it isn't in the dictionary.
+ */
+const EXIB_ENC_StringEntry* EXIB_FindDictionaryEntry(const EXIB_Dictionary* dictionary, const char* str, uint32_t hash, uint32_t length);
+
+/**
+ * Get the string table entry a dictionary has at a string offset.
+ * @param dictionary Dictionary whose names come first.
+ * @param offset String offset, smaller than the size of the dictionary's table.
+ * @return Pointer to the entry, or NULL if the name would run past the end of the table.
+ */
+const EXIB_StringEntry* EXIB_GetDictionaryString(const EXIB_Dictionary* dictionary, exib_string_t offset);
+
+#endif // _EXIB_DICTIONARY_INTERNAL_H
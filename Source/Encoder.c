@@ -5,14 +5,21 @@
 #include <EXIB/EXIB.h>
 #include <EXIB/Encoder.h>
 #include "EXIB/EncoderTypes.h"
+#include "DictionaryInternal.h"
 #include "EncoderInternal.h"
 
+// Smallest encode buffer allocated when the context starts out without one.
+#define EXIB_ENC_MIN_BUFFER 256
+
 static EXIB_ENC_Options s_DefaultOptions =
     {
-        .bufferSize = 65535,
+        .bufferSize = 0,
         .stringCacheCapacity = 128,
         .arrayCapacity = 32,
-        .datumName = NULL
+        .datumName = NULL,
+        .blobCompressThreshold = 0,
+        .noChecksum = 0,
+        .dictionary = NULL
     };
 
 void EXIB_ENC_GetDefaultOptions(EXIB_ENC_Options* options)
@@ -20,47 +27,102 @@ void EXIB_ENC_GetDefaultOptions(EXIB_ENC_Options* options)
     *options = s_DefaultOptions;
 }
 
+// Set up an empty root object, named after the datumName option.
+static void EXIB_ENC_InitializeRoot(EXIB_ENC_Context* ctx)
+{
+    memset(&ctx->rootObject, 0, sizeof(ctx->rootObject));
+
+    if (ctx->options.datumName)
+    {
+        // Names that are already cached keep their offset.
+        EXIB_ENC_StringEntry* nameEntry = EXIB_ENC_GetStringEntry(ctx, ctx->options.datumName);
+        ctx->rootObject.field.nameOffset = nameEntry->offset;
+        ctx->rootObject.field.nameBuffer = nameEntry->buffer;
+    }
+    else
+        ctx->rootObject.field.nameOffset = EXIB_INVALID_STRING;
+    ctx->rootObject.field.type = EXIB_TYPE_OBJECT;
+}
+
 EXIB_ENC_Context* EXIB_ENC_CreateContext(EXIB_ENC_Options* options)
 {
     EXIB_ENC_Context* ctx = EXIB_New(EXIB_ENC_Context);
+    if (!ctx)
+        return NULL;
     if (!options)
         options = &s_DefaultOptions;
     ctx->options = *options;
 
-    // Allocate encode buffer.
-    ctx->encodeBuffer = EXIB_Calloc(options->bufferSize, 1);
-    ctx->encodeBufferSize = ctx->options.bufferSize;
+    // Allocate encode buffer, unless it should be deferred until the first encode.
+    if (ctx->options.bufferSize > 0)
+    {
+        ctx->encodeBuffer = EXIB_Alloc(ctx->options.bufferSize);
+        ctx->encodeBufferSize = ctx->encodeBuffer ? ctx->options.bufferSize : 0;
+    }
 
-    // Initialize field pool.
+    // Initialize pools.
     EXIB_InitializePool(&ctx->fieldPool, sizeof(EXIB_ENC_Field));
+    EXIB_InitializeArena(&ctx->arena);
+    EXIB_InitializeArena(&ctx->nameArena);
+    EXIB_InitializeArena(&ctx->internArena);
 
-    // Allocate string cache.
-    ctx->stringCacheCapacity = ctx->options.stringCacheCapacity;
-    ctx->stringCache = EXIB_Calloc(ctx->options.stringCacheCapacity,
-                      sizeof(EXIB_ENC_StringEntry));
+    // The dictionary's names take up the first string offsets, the string table follows them.
+    if (ctx->options.dictionary)
+        ctx->stringBase = ctx->options.dictionary->tableSize;
 
-    // Initialize root object.
-    if (options->datumName)
+    // Allocate string cache.
+    if (EXIB_ENC_InitializeStringCache(ctx, ctx->options.stringCacheCapacity))
     {
-        EXIB_ENC_StringEntry* nameEntry = EXIB_ENC_GetStringEntry(ctx, options->datumName);
-        ctx->rootObject.field.nameOffset = nameEntry->offset;
+        EXIB_ENC_FreeContext(ctx);
+        return NULL;
     }
-    else
-        ctx->rootObject.field.nameOffset = EXIB_INVALID_STRING;
-    ctx->rootObject.field.type = EXIB_TYPE_OBJECT;
 
+    EXIB_ENC_InitializeRoot(ctx);
     return ctx;
 }
 
+void EXIB_ENC_ResetContext(EXIB_ENC_Context* ctx, int keepStrings)
+{
+    // Everything in the pool and the arena belonged to the old tree, so they can be reused as a whole.
+    EXIB_ENC_ReleaseExternalArrays(ctx);
+    EXIB_PoolReset(&ctx->fieldPool);
+    EXIB_ArenaReset(&ctx->arena);
+    ctx->blobs = NULL;
+    ctx->blobCount = 0;
+
+    if (ctx->stream)
+        ctx->stream->depth = 0;
+
+    if (!keepStrings)
+        EXIB_ENC_ClearStringCache(ctx);
+
+    EXIB_ENC_InitializeRoot(ctx);
+    ctx->lastError = EXIB_ENC_ERR_Success;
+}
+
 void EXIB_ENC_FreeContext(EXIB_ENC_Context* ctx)
 {
     if (ctx->encodeBuffer)
         EXIB_Free(ctx->encodeBuffer);
 
+    EXIB_ENC_ReleaseExternalArrays(ctx);
     EXIB_DestroyPool(&ctx->fieldPool);
+    EXIB_DestroyArena(&ctx->arena);
+    EXIB_DestroyArena(&ctx->nameArena);
+    EXIB_DestroyArena(&ctx->internArena);
 
-    if (ctx->stringCache)
-        EXIB_Free(ctx->stringCache);
+    EXIB_ENC_DestroyStringCache(ctx);
+
+    if (ctx->stream)
+    {
+        if (ctx->stream->scratch)
+            EXIB_Free(ctx->stream->scratch);
+        EXIB_Free(ctx->stream);
+    }
+
+    if (ctx->tasks)
+        EXIB_Free(ctx->tasks);
+    EXIB_ThreadPoolDestroy(&ctx->threadPool);
 
     EXIB_Free(ctx);
 }
@@ -70,12 +132,155 @@ EXIB_ENC_Error EXIB_ENC_GetLastError(EXIB_ENC_Context* ctx)
     return ctx->lastError;
 }
 
+/*
+ * Encoding happens in two phases. The layout phase calculates the size of
+ * every aggregate before anything is written, which lets the write phase
+ * emit the whole datum in a single forward pass. Nothing that has been
+ * written is ever moved, so the cost stays linear in the size of the datum
+ * no matter how deeply large objects are nested.
+ */
+
+// Returned by the first layout pass if the tree can't be encoded.
+#define EXIB_ENC_INVALID_BOUND SIZE_MAX
+
+/**
+ * First layout pass. Calculate an upper bound of the encoded size of a field
+ * that holds at any offset, by assuming every value needs maximum padding.
+ * The bound decides whether an aggregate uses a Size16 or a Size32, so that
+ * the choice is known before the exact offsets of its children are.
+ * @param field Field to lay out.
+ * @return Upper bound of the field's encoded size in bytes, or EXIB_ENC_INVALID_BOUND
+ *         if an array holds a field that isn't one of its elements.
+ */
+static size_t EXIB_ENC_LayoutBound(EXIB_ENC_Field* field)
+{
+    if (EXIB_ENC_IsAggregate(field))
+    {
+        EXIB_ENC_Object* object = (EXIB_ENC_Object*)field;
+        int isArray = field->type == EXIB_TYPE_ARRAY;
+        size_t innerBound = object->structType ? object->structType->bound : 0;
+
+        for (EXIB_ENC_Field* child = object->children; child != NULL; child = child->next)
+        {
+            size_t childBound;
+
+            if (isArray && child->type != field->elementType)
+                return EXIB_ENC_INVALID_BOUND;
+
+            childBound = EXIB_ENC_LayoutBound(child);
+            if (childBound == EXIB_ENC_INVALID_BOUND)
+                return EXIB_ENC_INVALID_BOUND;
+            innerBound += childBound;
+        }
+
+        object->wideSize = innerBound > UINT16_MAX;
+        return EXIB_ENC_AggregateHeaderSize(field, object->wideSize) + innerBound;
+    }
+    else if (field->type == EXIB_TYPE_ARRAY)
+    {
+        // Elements of arrays of values aren't fields, so nothing may have been added to them.
+        if (((EXIB_ENC_Object*)field)->children)
+            return EXIB_ENC_INVALID_BOUND;
+
+        EXIB_ENC_ArrayPack((EXIB_ENC_Array*)field);
+        return EXIB_ENC_ArrayBound((EXIB_ENC_Array*)field);
+    }
+
+    return EXIB_ENC_ValueBound(field);
+}
+
+/**
+ * Second layout pass. Calculate the exact encoded size of a field at the
+ * given offset, and store the inner size of every aggregate on the way.
+ * @param field Field to lay out.
+ * @param offset Datum offset the field will be encoded at.
+ * @return Encoded size of the field in bytes.
+ */
+static size_t EXIB_ENC_LayoutField(EXIB_ENC_Field* field, size_t offset)
+{
+    size_t fieldOffset = offset;
+
+    offset += EXIB_ENC_FieldHeaderSize(field);
+
+    if (EXIB_ENC_IsAggregate(field))
+    {
+        EXIB_ENC_Object* object = (EXIB_ENC_Object*)field;
+        size_t innerOffset;
+
+        offset += 1 + (object->wideSize ? 4 : 2);
+        innerOffset = offset;
+
+        // Struct members were laid out when their type was compiled.
+        if (object->structType)
+            offset += object->structType->sizes[offset % 8];
+
+        for (EXIB_ENC_Field* child = object->children; child != NULL; child = child->next)
+            offset += EXIB_ENC_LayoutField(child, offset);
+
+        object->innerSize = offset - innerOffset;
+    }
+    else if (field->type == EXIB_TYPE_ARRAY)
+    {
+        int alignment = EXIB_ENC_ArrayAlignment((EXIB_ENC_Array*)field);
+        size_t dataSize = EXIB_ENC_ArrayDataSize((EXIB_ENC_Array*)field);
+
+        offset += 1 + ((dataSize > UINT16_MAX) ? 4 : 2);
+        if (alignment > 1)
+            offset += EXIB_ENC_Padding(offset, alignment);
+        offset += dataSize;
+    }
+    else
+    {
+        int typeSize = EXIB_GetTypeSize(field->type);
+        if (typeSize > 0)
+            offset += EXIB_ENC_Padding(offset, typeSize) + typeSize;
+    }
+
+    return offset - fieldOffset;
+}
+
+size_t EXIB_ENC_FieldSize(EXIB_ENC_Field* field, size_t offset)
+{
+    if (EXIB_ENC_IsAggregate(field))
+    {
+        EXIB_ENC_Object* object = (EXIB_ENC_Object*)field;
+        return EXIB_ENC_AggregateHeaderSize(field, object->wideSize) + object->innerSize;
+    }
+
+    // Nothing else has children, so this doesn't walk any further.
+    return EXIB_ENC_LayoutField(field, offset);
+}
+
+size_t EXIB_ENC_Layout(EXIB_ENC_Context* ctx)
+{
+    size_t offset = sizeof(EXIB_Header) + EXIB_ENC_ExtendedHeaderSize(ctx);
+
+    if (EXIB_ENC_LayoutBound(&ctx->rootObject.field) == EXIB_ENC_INVALID_BOUND)
+    {
+        ctx->lastError = EXIB_ENC_ERR_InvalidElement;
+        return 0;
+    }
+
+    offset += EXIB_ENC_LayoutField(&ctx->rootObject.field, offset);
+    offset += ctx->stringOffset;
+    offset += EXIB_ENC_LayoutBlobTable(ctx, offset);
+
+    return offset;
+}
+
+size_t EXIB_ENC_MeasureSize(EXIB_ENC_Context* ctx)
+{
+    return EXIB_ENC_Layout(ctx);
+}
+
 size_t EXIB_ENC_EncodeStringTable(EXIB_ENC_Context* ctx, size_t offset)
 {
+    uint8_t* out = &ctx->output[offset - ctx->outputBase];
+
     for (int i = 0; i < ctx->stringCacheSize; ++i)
     {
         EXIB_ENC_StringEntry* cacheEntry = &ctx->stringCache[i];
-        EXIB_StringEntry* e = (EXIB_StringEntry*)&ctx->encodeBuffer[offset + cacheEntry->offset];
+        EXIB_StringEntry* e = (EXIB_StringEntry*)&out[cacheEntry->offset - ctx->stringBase];
 
         e->length = cacheEntry->length;
         memcpy(e->string, cacheEntry->buffer, cacheEntry->length);
@@ -89,8 +294,11 @@ size_t EXIB_ENC_EncodeField(EXIB_ENC_Context* ctx, EXIB_ENC_Field* field, size_t
     int typeSize = EXIB_GetTypeSize(field->type);
     int nameSize = (field->nameOffset != EXIB_INVALID_STRING) ? (int)sizeof(exib_string_t) : 0;
     int bytes    = 1 + nameSize + typeSize;
+    uint8_t* out = &ctx->output[offset - ctx->outputBase];
 
-    EXIB_FieldPrefix* fieldPrefix = (EXIB_FieldPrefix*)&ctx->encodeBuffer[offset];
+    // Write the whole prefix byte so nothing is left over from a previous encode.
+    EXIB_FieldPrefix* fieldPrefix = (EXIB_FieldPrefix*)out++;
+    fieldPrefix->byte = 0;
     fieldPrefix->type = field->type;
     fieldPrefix->named = nameSize != 0;
 
@@ -99,207 +307,275 @@ size_t EXIB_ENC_EncodeField(EXIB_ENC_Context* ctx, EXIB_ENC_Field* field, size_t
     // Write name if one is present.
     if (nameSize != 0)
     {
-        ctx->encodeBuffer[offset] = field->nameOffset & 0xFF;
-        ctx->encodeBuffer[offset + 1] = (field->nameOffset >> 8) & 0xFF;
+        *out++ = field->nameOffset & 0xFF;
+        *out++ = (field->nameOffset >> 8) & 0xFF;
         offset += 2;
     }
 
     if (typeSize > 0)
     {
-        int r = (int)offset % typeSize;
-        int padding = (r > 0) ? (typeSize - r) : 0;
+        int padding = EXIB_ENC_Padding(offset, typeSize);
         bytes += padding;
         fieldPrefix->padding = padding;
 
         // Add padding bytes if necessary.
         for (int i = 0; i < padding; ++i)
-            ctx->encodeBuffer[offset++] = 0;
+            *out++ = 0;
 
-        // Write value.
-        *(void**)&ctx->encodeBuffer[offset] = field->value.pointer;
+        // Write value, only as many bytes as the type occupies.
+        memcpy(out, &field->value, typeSize);
     }
 
     return bytes;
 }
 
-size_t EXIB_ENC_EncodeArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset);
-size_t EXIB_ENC_EncodeObject(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset);
-
-int EXIB_ENC_EncodeObjectSize(EXIB_ENC_Context* ctx, size_t sizeOffset, size_t innerSize)
+size_t EXIB_ENC_EncodeObjectPrefix(EXIB_ENC_Context* ctx, EXIB_ObjectPrefix objectPrefix, size_t size, size_t offset)
 {
-    if (innerSize < 65536)
-    {
-        *(uint16_t*)&ctx->encodeBuffer[sizeOffset] = innerSize;
-        return 0;
-    }
-
-    // Shift data forward 2 bytes to make room for Size32 encoding.
-    ctx->encodeBuffer[sizeOffset - 1] |= 0x80; // Set Size flag on object.
-    memmove(ctx->encodeBuffer + sizeOffset + 4,
-            ctx->encodeBuffer + sizeOffset + 2,
-            innerSize);
-    *(uint32_t*)&ctx->encodeBuffer[sizeOffset] = innerSize;
+    uint8_t* out = &ctx->output[offset - ctx->outputBase];
+    out[0] = objectPrefix.byte;
 
-    return 2;
-}
-
-size_t EXIB_ENC_EncodeSpecialArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset)
-{
-    EXIB_ENC_Field* field = array->object.children;
-    size_t origin = offset;
-    size_t sizeOffset;
-    size_t innerSize = 0;
-    EXIB_ObjectPrefix objectPrefix = {
-        .arrayType = array->object.field.elementType,
-        .size = 0
-    };
-
-    // Write object prefix, use Size16 encoding at first.
-    ctx->encodeBuffer[offset++] = objectPrefix.byte;
-
-    // Allocate space and save position of size.
-    sizeOffset = offset;
-    offset += 2;
-
-    EXIB_Type type = objectPrefix.arrayType;
-
-    // Loop through object/array child list.
-    while (field != NULL)
+    // The size follows a single byte, and sink chunks and caller buffers don't keep the datum's alignment anyway.
+    if (objectPrefix.size)
     {
-        size_t bytes = 0;
-
-        if (field->type != type)
-        {
-            // TODO: Actually handle the error.
-            exit(1);
-        }
-
-        if (field->type == EXIB_TYPE_OBJECT)
-            bytes = EXIB_ENC_EncodeObject(ctx, (EXIB_ENC_Object*)field, offset);
-        else if (field->type == EXIB_TYPE_ARRAY)
-            bytes = EXIB_ENC_EncodeArray(ctx, (EXIB_ENC_Array*)field, offset);
-
-        offset += bytes;
-        innerSize += bytes;
-        field = field->next;
+        uint32_t size32 = (uint32_t)size;
+        memcpy(&out[1], &size32, sizeof(size32));
+        return 5;
     }
 
-    offset += EXIB_ENC_EncodeObjectSize(ctx, sizeOffset, innerSize);
-
-    return offset - origin;
+    uint16_t size16 = (uint16_t)size;
+    memcpy(&out[1], &size16, sizeof(size16));
+    return 3;
 }
 
-size_t EXIB_ENC_EncodeArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset)
+size_t EXIB_ENC_EncodeArrayHeader(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset)
 {
     EXIB_ENC_Field* field = &array->object.field;
-    EXIB_FieldPrefix* fieldPrefix = (EXIB_FieldPrefix*)(ctx->encodeBuffer + offset);
+    EXIB_FieldPrefix* fieldPrefix = (EXIB_FieldPrefix*)&ctx->output[offset - ctx->outputBase];
     size_t fieldOffset = offset;
 
     // Write field prefix and name.
     offset += EXIB_ENC_EncodeField(ctx, field, offset);
 
-    // Deal with arrays of arrays or arrays of objects.
-    if (field->elementType >= EXIB_TYPE_ARRAY)
-    {
-        offset += EXIB_ENC_EncodeSpecialArray(ctx, array, offset);
-        return offset - fieldOffset;
-    }
-
     // Calculate size.
-    int typeSize = EXIB_GetTypeSize(field->elementType);
-    size_t dataSize = typeSize * EXIB_ENC_ArrayGetSize(array);
+    int alignment = EXIB_ENC_ArrayAlignment(array);
+    size_t dataSize = EXIB_ENC_ArrayDataSize(array);
 
-    // Write object prefix.
+    // Write object prefix and size.
     EXIB_ObjectPrefix objectPrefix = {
         .arrayType = field->elementType,
         .arrayString = array->isString,
+        .packing = array->packedSize ? array->packing : EXIB_PACKING_NONE,
         .size = (dataSize > UINT16_MAX)
     };
-    ctx->encodeBuffer[offset++] = objectPrefix.byte;
-
-    // Write size.
-    if (objectPrefix.size)
-    {
-        *(uint32_t*)&ctx->encodeBuffer[offset] = dataSize;
-        offset += 4;
-    }
-    else
-    {
-        *(uint16_t*)&ctx->encodeBuffer[offset] = dataSize;
-        offset += 2;
-    }
+    offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, dataSize, offset);
 
     // Calculate padding.
-    if (typeSize > 1)
+    if (alignment > 1)
     {
-        int r = (int)offset % typeSize;
-        int padding = (r > 0) ? (typeSize - r) : 0;
+        int padding = EXIB_ENC_Padding(offset, alignment);
+        memset(&ctx->output[offset - ctx->outputBase], 0, padding);
         offset += padding;
         fieldPrefix->padding = padding;
     }
 
+    return offset - fieldOffset;
+}
+
+size_t EXIB_ENC_EncodeArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset)
+{
+    size_t fieldOffset = offset;
+    size_t dataSize = EXIB_ENC_ArrayDataSize(array);
+
+    offset += EXIB_ENC_EncodeArrayHeader(ctx, array, offset);
+
     // Write data.
-    memcpy(&ctx->encodeBuffer[offset], array->valueElements, dataSize);
+    memcpy(&ctx->output[offset - ctx->outputBase], EXIB_ENC_ArrayData(array), dataSize);
     offset += dataSize;
 
     return offset - fieldOffset;
 }
 
-size_t EXIB_ENC_EncodeObject(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset)
+size_t EXIB_ENC_EncodeObjectHeader(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset)
 {
-    EXIB_ENC_Field* field = object->children;
     size_t fieldOffset = offset;
-    size_t sizeOffset;
-    size_t innerSize = 0;
-    EXIB_ObjectPrefix objectPrefix = { 0 };
+    int isArray = object->field.type == EXIB_TYPE_ARRAY;
 
-    // Write field prefix and name.
+    // Arrays of arrays and arrays of objects are encoded just like objects.
+    EXIB_ObjectPrefix objectPrefix = {
+        .arrayType = isArray ? object->field.elementType : 0,
+        .size = object->wideSize
+    };
+
+    // Write field prefix and name, then the object prefix with the size from the layout pass.
     offset += EXIB_ENC_EncodeField(ctx, &object->field, offset);
+    offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, object->innerSize, offset);
 
-    // Write object prefix, use Size16 encoding at first.
-    ctx->encodeBuffer[offset++] = objectPrefix.byte;
+    return offset - fieldOffset;
+}
 
-    // Allocate space and save position of size.
-    sizeOffset = offset;
-    offset += 2;
+size_t EXIB_ENC_EncodeObject(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset)
+{
+    EXIB_ENC_Field* field = object->children;
+    size_t fieldOffset = offset;
+
+    offset += EXIB_ENC_EncodeObjectHeader(ctx, object, offset);
+
+    if (object->structType)
+        offset += EXIB_ENC_EncodeStructMembers(ctx, object->structType, object->structData, offset);
 
     while (field != NULL)
     {
-        size_t bytes;
-
-        if (field->type == EXIB_TYPE_OBJECT)
-            bytes = EXIB_ENC_EncodeObject(ctx, (EXIB_ENC_Object*)field, offset);
+        if (EXIB_ENC_IsAggregate(field))
+            offset += EXIB_ENC_EncodeObject(ctx, (EXIB_ENC_Object*)field, offset);
         else if (field->type == EXIB_TYPE_ARRAY)
-            bytes = EXIB_ENC_EncodeArray(ctx, (EXIB_ENC_Array*)field, offset);
+            offset += EXIB_ENC_EncodeArray(ctx, (EXIB_ENC_Array*)field, offset);
         else
-            bytes = EXIB_ENC_EncodeField(ctx, field, offset);
+            offset += EXIB_ENC_EncodeField(ctx, field, offset);
 
-        offset += bytes;
-        innerSize += bytes;
         field = field->next;
     }
 
-    offset += EXIB_ENC_EncodeObjectSize(ctx, sizeOffset, innerSize);
-
     return offset - fieldOffset;
 }
 
-EXIB_Header* EXIB_ENC_Encode(EXIB_ENC_Context* ctx)
+int EXIB_ENC_ReserveBuffer(EXIB_ENC_Context* ctx, size_t size, size_t keep)
+{
+    size_t capacity = ctx->encodeBufferSize ? ctx->encodeBufferSize : EXIB_ENC_MIN_BUFFER;
+
+    if (size <= ctx->encodeBufferSize)
+        return 0;
+
+    while (capacity < size)
+        capacity *= 2;
+
+    uint8_t* buffer = EXIB_Alloc(capacity);
+    if (!buffer)
+        return 1;
+
+    if (ctx->encodeBuffer)
+    {
+        memcpy(buffer, ctx->encodeBuffer, keep);
+        EXIB_Free(ctx->encodeBuffer);
+    }
+
+    ctx->encodeBuffer = buffer;
+    ctx->encodeBufferSize = capacity;
+    return 0;
+}
+
+void EXIB_ENC_FillHeader(EXIB_ENC_Context* ctx, EXIB_Header* header, size_t datumSize, size_t stringTableSize)
+{
+    header->magic        = EXIB_MAGIC;
+    header->version      = EXIB_VERSION;
+    header->flags        = ctx->options.noChecksum ? EXIB_HEADER_NO_CHECKSUM : 0;
+    header->datumSize    = datumSize;
+    header->stringSize   = stringTableSize;
+    header->extendedSize = 0;
+
+    if (ctx->blobTableOffset || ctx->options.dictionary)
+    {
+        header->flags |= EXIB_HEADER_EXT;
+        header->extendedSize = sizeof(EXIB_ExtHeader);
+    }
+
+    header->reserved     = 0;
+    header->checksum     = 0;
+}
+
+EXIB_Header* EXIB_ENC_EncodeHeader(EXIB_ENC_Context* ctx, size_t datumSize, size_t stringTableSize)
+{
+    EXIB_Header* header = (EXIB_Header*)ctx->output;
+
+    EXIB_ENC_FillHeader(ctx, header, datumSize, stringTableSize);
+    if (!ctx->options.noChecksum)
+        header->checksum = EXIB_CRC32C(0, header, header->datumSize);
+
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return header;
+}
+
+int EXIB_ENC_PatchValue(EXIB_Header* header, void* value, EXIB_Type type, EXIB_Value newValue)
+{
+    size_t typeSize = EXIB_GetTypeSize(type);
+    size_t offset = (uint8_t*)value - (uint8_t*)header;
+
+    // Values can't be in the header, and the bytes before it aren't part of the datum.
+    if (type < EXIB_TYPE_INT8 || type > EXIB_TYPE_DOUBLE
+        || (uint8_t*)value < (uint8_t*)(header + 1)
+        || offset + typeSize > header->datumSize)
+        return 1;
+
+    if (!(header->flags & EXIB_HEADER_NO_CHECKSUM))
+        header->checksum = EXIB_CRC32C_Patch(header->checksum, header->datumSize, offset, value, &newValue, typeSize);
+
+    memcpy(value, &newValue, typeSize);
+    return 0;
+}
+
+// Write the laid out datum into ctx->output, which must be large enough to hold all of it.
+static EXIB_Header* EXIB_ENC_EncodeDatum(EXIB_ENC_Context* ctx)
 {
-    EXIB_Header* header = (EXIB_Header*)ctx->encodeBuffer;
     size_t stringTableSize = 0;
     size_t offset = sizeof(EXIB_Header);
 
-    // TODO: Add context option for enabling the extended header.
+    // The extended header is only present if the datum has blobs or uses a dictionary.
+    offset += EXIB_ENC_EncodeExtendedHeader(ctx, offset);
     offset += EXIB_ENC_EncodeObject(ctx, &ctx->rootObject, offset);
 
     stringTableSize = EXIB_ENC_EncodeStringTable(ctx, offset);
     offset += stringTableSize;
+    offset += EXIB_ENC_EncodeBlobTable(ctx, offset);
 
-    header->magic      = EXIB_MAGIC;
-    header->version    = EXIB_VERSION;
-    header->datumSize  = offset;
-    header->stringSize = stringTableSize;
-    header->checksum   = EXIB_CRC32C(0, header, header->datumSize);
-    return header;
+    return EXIB_ENC_EncodeHeader(ctx, offset, stringTableSize);
+}
+
+EXIB_Header* EXIB_ENC_Encode(EXIB_ENC_Context* ctx)
+{
+    // Lay out the datum, which also prepares the aggregate sizes for the write pass.
+    size_t datumSize = EXIB_ENC_Layout(ctx);
+
+    if (datumSize == 0)
+        return NULL;
+
+    if (datumSize > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return NULL;
+    }
+
+    // Contents don't need to survive, the whole datum is rewritten anyway.
+    if (EXIB_ENC_ReserveBuffer(ctx, datumSize, 0))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    ctx->output = ctx->encodeBuffer;
+    ctx->outputBase = 0;
+    return EXIB_ENC_EncodeDatum(ctx);
+}
+
+EXIB_Header* EXIB_ENC_EncodeInto(EXIB_ENC_Context* ctx, void* buffer, size_t capacity)
+{
+    // Lay out the datum, which also prepares the aggregate sizes for the write pass.
+    size_t datumSize = EXIB_ENC_Layout(ctx);
+
+    if (datumSize == 0)
+        return NULL;
+
+    if (datumSize > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return NULL;
+    }
+
+    if (datumSize > capacity)
+    {
+        ctx->lastError = EXIB_ENC_ERR_BufferTooSmall;
+        return NULL;
+    }
+
+    ctx->output = buffer;
+    ctx->outputBase = 0;
+    return EXIB_ENC_EncodeDatum(ctx);
 }
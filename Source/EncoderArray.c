@@ -5,19 +5,21 @@
 #include "AllocatorInternal.h"
 #include "EXIB/EncoderTypes.h"
 #include "EncoderInternal.h"
+#include "PackInternal.h"
 
 int EXIB_ENC_InitializeArray(EXIB_ENC_Context* ctx,
                              EXIB_ENC_Array* array,
                              EXIB_ENC_Object* parent,
-                             const char* name,
+                             const EXIB_ENC_StringEntry* nameEntry,
                              EXIB_Type type,
                              int reserve)
 {
     EXIB_ENC_Field* field = &array->object.field;
-    EXIB_ENC_InitializeField(ctx, field, parent, name,
+    EXIB_ENC_InitializeField(ctx, field, parent, nameEntry,
                            EXIB_TYPE_ARRAY);
     
     field->elementType = type;
+    array->ctx = ctx;
 
     if (reserve < 0)
         reserve = 32;
@@ -29,20 +31,85 @@ int EXIB_ENC_InitializeArray(EXIB_ENC_Context* ctx,
     return 0;
 }
 
+static EXIB_ENC_Array* EXIB_ENC_AddArrayEntry(EXIB_ENC_Context* ctx,
+                                              EXIB_ENC_Object* parent,
+                                              const EXIB_ENC_StringEntry* name,
+                                              EXIB_Type elementType)
+{
+    EXIB_ENC_Array* array = EXIB_ArenaAlloc(&ctx->arena, sizeof(EXIB_ENC_Array), sizeof(void*));
+    if (!array)
+        return NULL;
+
+    memset(array, 0, sizeof(EXIB_ENC_Array));
+    if (EXIB_ENC_InitializeArray(ctx, array, parent, name, elementType, -1) != 0)
+        return NULL;
+
+    return array;
+}
+
 EXIB_ENC_Array* EXIB_ENC_AddArray(EXIB_ENC_Context* ctx,
                                   EXIB_ENC_Object* parent,
                                   const char* name,
                                   EXIB_Type elementType)
 {
-    EXIB_ENC_Array* array = EXIB_New(EXIB_ENC_Array);
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
 
-    if (EXIB_ENC_InitializeArray(ctx, array, parent, name, elementType, -1) != 0)
-    {
-        EXIB_Free(array);
+    return EXIB_ENC_AddArrayEntry(ctx, parent, nameEntry, elementType);
+}
+
+EXIB_ENC_Array* EXIB_ENC_AddArrayInterned(EXIB_ENC_Context* ctx,
+                                          EXIB_ENC_Object* parent,
+                                          EXIB_ENC_Name name,
+                                          EXIB_Type elementType)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetInternedEntry(ctx, name, &nameEntry))
         return NULL;
-    }
 
-    return array;
+    return EXIB_ENC_AddArrayEntry(ctx, parent, nameEntry, elementType);
+}
+
+// Hand external elements back to their owner.
+static void EXIB_ENC_ArrayRelease(EXIB_ENC_Array* array)
+{
+    if (array->isExternal && array->releaseFn)
+        array->releaseFn(array->valueElements);
+
+    array->isExternal = 0;
+    array->releaseFn = NULL;
+}
+
+/**
+ * Copy external elements into a buffer of the context's arena and release them.
+ * @param array Array with external elements.
+ * @param newCapacity Minimum capacity of the new buffer.
+ * @return 0 on success, 1 on failure.
+ */
+static int EXIB_ENC_ArrayDetach(EXIB_ENC_Array* array, uint32_t newCapacity)
+{
+    size_t elementSize = EXIB_GetTypeSize(array->object.field.elementType);
+    size_t usedSize = elementSize * array->elementCount;
+    size_t newSize;
+    uint8_t* elements;
+
+    if (newCapacity < array->elementCount)
+        newCapacity = array->elementCount;
+
+    newSize = elementSize * newCapacity;
+    elements = EXIB_ArenaAlloc(&array->ctx->arena, newSize ? newSize : 1, sizeof(EXIB_Value));
+    if (!elements)
+        return 1;
+
+    memcpy(elements, array->valueElements, usedSize);
+    memset(elements + usedSize, 0, newSize - usedSize);
+
+    EXIB_ENC_ArrayRelease(array);
+    array->valueElements = (EXIB_Value*)elements;
+    array->elementCapacity = newCapacity;
+
+    return 0;
 }
 
 int EXIB_ENC_ArrayReserve(EXIB_ENC_Array* array, uint32_t newCapacity)
@@ -54,40 +121,59 @@ int EXIB_ENC_ArrayReserve(EXIB_ENC_Array* array, uint32_t newCapacity)
     if (type == EXIB_TYPE_OBJECT || type == EXIB_TYPE_ARRAY)
         return 0;
 
+    // External elements are never written to, so they are copied into the arena first.
+    if (array->isExternal)
+        return EXIB_ENC_ArrayDetach(array, newCapacity);
+
     // Don't try to shrink the array.
     if (!newCapacity || newCapacity < array->elementCapacity)
         return 0;
 
-    if (!array->valueElements)
-    {
-        // Allocate array from scratch.
-        array->elementCapacity = newCapacity;
-        array->valueElements = EXIB_Calloc(elementSize, 
-                                           array->elementCapacity);
-        if (!array->valueElements)
-            return 1;
-        return 0;
-    }
-
-    void* elements = EXIB_Calloc(elementSize, newCapacity);
+    // Grows in place if nothing else has been allocated since, otherwise the
+    // old buffer stays in the arena until the context is reset.
+    size_t oldSize = (size_t)elementSize * array->elementCapacity;
+    size_t newSize = (size_t)elementSize * newCapacity;
+    uint8_t* elements = EXIB_ArenaRealloc(&array->ctx->arena, array->valueElements,
+                                          oldSize, newSize, sizeof(EXIB_Value));
     if (!elements)
         return 1;
 
-    // Copy data into new buffer, then free old one.
-    memcpy(elements, array->valueElements, elementSize * array->elementCapacity);
-    EXIB_Free(array->valueElements);
-    array->valueElements = elements;
+    // New elements start out as 0.
+    memset(elements + oldSize, 0, newSize - oldSize);
+    array->valueElements = (EXIB_Value*)elements;
     array->elementCapacity = newCapacity;
 
     return 0;
 }
 
-void EXIB_ENC_ArrayResize(EXIB_ENC_Array* array, size_t newSize)
+/**
+ * Make room for at least `minCapacity` elements, at least doubling the capacity
+ * if the array has to grow, so that appending n elements costs O(n) overall.
+ * @return 0 on success, 1 on failure.
+ */
+static int EXIB_ENC_ArrayGrow(EXIB_ENC_Array* array, size_t minCapacity)
 {
-    uint32_t capacity = array->elementCapacity;
+    size_t newCapacity = (size_t)array->elementCapacity * 2;
+
+    if (minCapacity <= array->elementCapacity && !array->isExternal)
+        return 0;
+
+    // Element counts are stored as 32 bits.
+    if (minCapacity > UINT32_MAX)
+        return 1;
 
-    if (capacity < newSize)
-        EXIB_ENC_ArrayReserve(array, capacity + (newSize - capacity));
+    if (newCapacity < minCapacity)
+        newCapacity = minCapacity;
+    if (newCapacity > UINT32_MAX)
+        newCapacity = UINT32_MAX;
+
+    return EXIB_ENC_ArrayReserve(array, (uint32_t)newCapacity);
+}
+
+void EXIB_ENC_ArrayResize(EXIB_ENC_Array* array, size_t newSize)
+{
+    if (EXIB_ENC_ArrayGrow(array, newSize))
+        return;
 
     array->elementCount = newSize;
 }
@@ -109,6 +195,9 @@ void* EXIB_ENC_ArraySet(EXIB_ENC_Array* array, size_t index, EXIB_Value value)
     if (index >= array->elementCount)
         return NULL;
 
+    if (array->isExternal && EXIB_ENC_ArrayReserve(array, array->elementCount))
+        return NULL;
+
     void* p = ((void*)array->valueElements) + (index * elementSize);
 
     if (elementSize == 1)
@@ -127,13 +216,127 @@ void* EXIB_ENC_ArrayAppend(EXIB_ENC_Array* array, EXIB_Value value)
 {
     if (array->elementCount == array->elementCapacity)
     {
-        if (!EXIB_ENC_ArrayReserve(array, array->elementCapacity + 32))
+        if (EXIB_ENC_ArrayGrow(array, (size_t)array->elementCount + 1))
             return NULL;
     }
 
     return EXIB_ENC_ArraySet(array, array->elementCount++, value);
 }
 
+void* EXIB_ENC_ArrayAppendN(EXIB_ENC_Array* array, const void* data, size_t count)
+{
+    EXIB_Type type = array->object.field.elementType;
+    size_t elementSize = EXIB_GetTypeSize(type);
+    uint8_t* p;
+
+    // Only arrays of values have a buffer to copy into.
+    if (type == EXIB_TYPE_OBJECT || type == EXIB_TYPE_ARRAY)
+        return NULL;
+
+    if (EXIB_ENC_ArrayGrow(array, (size_t)array->elementCount + count))
+        return NULL;
+
+    p = (uint8_t*)array->valueElements + array->elementCount * elementSize;
+    if (count)
+        memcpy(p, data, count * elementSize);
+    array->elementCount += count;
+
+    return p;
+}
+
+int EXIB_ENC_ArrayAssign(EXIB_ENC_Array* array, const void* data, size_t count)
+{
+    uint32_t oldCount = array->elementCount;
+
+    array->elementCount = 0;
+    if (!EXIB_ENC_ArrayAppendN(array, data, count))
+    {
+        array->elementCount = oldCount;
+        return 1;
+    }
+
+    return 0;
+}
+
+int EXIB_ENC_ArraySetExternal(EXIB_ENC_Array* array, const void* data, size_t count, EXIB_ENC_ReleaseFn releaseFn)
+{
+    EXIB_Type type = array->object.field.elementType;
+    EXIB_ENC_Context* ctx = array->ctx;
+
+    if (type == EXIB_TYPE_OBJECT || type == EXIB_TYPE_ARRAY || count > UINT32_MAX)
+        return 1;
+
+    // Setting the same elements again must not release them.
+    if (!array->isExternal || array->valueElements != data)
+        EXIB_ENC_ArrayRelease(array);
+
+    if (!array->isListed)
+    {
+        array->nextExternal = ctx->externalArrays;
+        ctx->externalArrays = array;
+        array->isListed = 1;
+    }
+
+    // Whatever buffer the array had before stays in the arena until the context is reset.
+    array->valueElements = (EXIB_Value*)data;
+    array->elementCount = count;
+    array->elementCapacity = count;
+    array->isExternal = 1;
+    array->releaseFn = releaseFn;
+
+    return 0;
+}
+
+int EXIB_ENC_ArraySetPacking(EXIB_ENC_Array* array, EXIB_ArrayPacking packing, int delta)
+{
+    EXIB_Type type = array->object.field.elementType;
+
+    // Only arrays of integers can be packed.
+    if (type < EXIB_TYPE_INT8 || type > EXIB_TYPE_UINT64 || array->isString || packing > EXIB_PACKING_RLE)
+        return 1;
+
+    array->packing = packing;
+    array->packDelta = delta ? 1 : 0;
+    array->packedSize = 0;
+
+    return 0;
+}
+
+void EXIB_ENC_ArrayPack(EXIB_ENC_Array* array)
+{
+    size_t rawSize = EXIB_GetTypeSize(array->object.field.elementType) * (size_t)array->elementCount;
+    size_t bound = EXIB_PACK_Bound(array->packing, array->elementCount);
+
+    array->packedSize = 0;
+    if (array->packing == EXIB_PACKING_NONE || !array->elementCount)
+        return;
+
+    // The buffer is kept for the next encode, and only grows.
+    if (bound > array->packedCapacity)
+    {
+        uint8_t* packed = EXIB_ArenaAlloc(&array->ctx->arena, bound, sizeof(uint64_t));
+        if (!packed)
+            return;
+
+        array->packed = packed;
+        array->packedCapacity = bound;
+    }
+
+    // Packing pays off for the data that this is meant for, but not for every array.
+    size_t packedSize = EXIB_PACK_Encode(array->object.field.elementType, array->valueElements, array->elementCount,
+                                         array->packing, array->packDelta, array->packed, array->packedCapacity);
+    if (packedSize < rawSize)
+        array->packedSize = packedSize;
+}
+
+void EXIB_ENC_ReleaseExternalArrays(EXIB_ENC_Context* ctx)
+{
+    for (EXIB_ENC_Array* array = ctx->externalArrays; array != NULL; array = array->nextExternal)
+        EXIB_ENC_ArrayRelease(array);
+
+    ctx->externalArrays = NULL;
+}
+
 EXIB_ENC_Object* EXIB_ENC_ArrayAddObject(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array)
 {
     return EXIB_ENC_AddObject(ctx, &array->object, NULL);
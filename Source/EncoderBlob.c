@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
+#include "AllocatorInternal.h"
+#include "EncoderInternal.h"
+#include "LZInternal.h"
+
+/*
+ * The blob table comes after the string table, aligned to EXIB_BLOB_ALIGNMENT.
+ * It starts with the blob directory, followed by the entries in the order
+ * the blobs were added, each aligned to EXIB_BLOB_ALIGNMENT as well.
+ * Blobs are compressed as they are added, so encoding only copies them.
+ */
+
+/**
+ * Copy a blob into the context, compressed if that's asked for and makes it smaller.
+ * @param ctx Encoder context.
+ * @param blob Blob to store the data of, with `size` set.
+ * @param data Data of the blob.
+ * @param mode How to store the blob.
+ * @return 0 on success, 1 on failure.
+ */
+static int EXIB_ENC_StoreBlob(EXIB_ENC_Context* ctx, EXIB_ENC_Blob* blob, const void* data, EXIB_ENC_BlobMode mode)
+{
+    uint32_t size = blob->size;
+    size_t threshold = ctx->options.blobCompressThreshold;
+    size_t storedSize = 0;
+    uint8_t* copy = EXIB_ArenaAlloc(&ctx->arena, size ? size : 1, EXIB_BLOB_ALIGNMENT);
+
+    if (!copy)
+        return 1;
+
+    // Compressed data has to be smaller than the original to be worth it.
+    if (mode == EXIB_ENC_BLOB_COMPRESS || (mode == EXIB_ENC_BLOB_AUTO && threshold && size >= threshold))
+        storedSize = size > 1 ? EXIB_LZ_Compress(data, size, copy, size - 1) : 0;
+
+    if (storedSize)
+    {
+        // Hand back the room the compressed data doesn't need.
+        EXIB_ArenaRealloc(&ctx->arena, copy, size, storedSize, EXIB_BLOB_ALIGNMENT);
+        blob->flags = EXIB_BLOB_COMPRESSED;
+    }
+    else
+    {
+        if (size)
+            memcpy(copy, data, size);
+        storedSize = size;
+        blob->flags = 0;
+    }
+
+    blob->data = copy;
+    blob->storedSize = (uint32_t)storedSize;
+    return 0;
+}
+
+static EXIB_ENC_Field* EXIB_ENC_AddBlobEntry(EXIB_ENC_Context* ctx,
+                                             EXIB_ENC_Object* parent,
+                                             const EXIB_ENC_StringEntry* name,
+                                             const void* data,
+                                             size_t size,
+                                             EXIB_ENC_BlobMode mode)
+{
+    EXIB_ENC_Field* field;
+    EXIB_ENC_Blob* blob;
+
+    if (ctx->blobCount == EXIB_MAX_BLOBS)
+    {
+        ctx->lastError = EXIB_ENC_ERR_BlobTableFull;
+        return NULL;
+    }
+
+    if (size > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return NULL;
+    }
+
+    if (!ctx->blobs)
+        ctx->blobs = EXIB_ArenaAlloc(&ctx->arena, EXIB_MAX_BLOBS * sizeof(EXIB_ENC_Blob), sizeof(void*));
+
+    blob = ctx->blobs ? &ctx->blobs[ctx->blobCount] : NULL;
+    if (blob)
+        blob->size = (uint32_t)size;
+
+    if (!blob || EXIB_ENC_StoreBlob(ctx, blob, data, mode))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    field = EXIB_PoolAlloc(&ctx->fieldPool);
+    if (!field)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    memset(field, 0, sizeof(EXIB_ENC_Field));
+    EXIB_ENC_InitializeField(ctx, field, parent, name, EXIB_TYPE_BLOB);
+    field->value.uint8 = (uint8_t)ctx->blobCount++;
+
+    blob->checksum = ctx->options.noChecksum ? 0 : EXIB_CRC32C(0, data, size);
+    blob->offset = 0;
+
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return field;
+}
+
+EXIB_ENC_Field* EXIB_ENC_AddBlob(EXIB_ENC_Context* ctx,
+                                 EXIB_ENC_Object* parent,
+                                 const char* name,
+                                 const void* data,
+                                 size_t size)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddBlobEntry(ctx, parent, nameEntry, data, size, EXIB_ENC_BLOB_AUTO);
+}
+
+EXIB_ENC_Field* EXIB_ENC_AddBlobWithMode(EXIB_ENC_Context* ctx,
+                                         EXIB_ENC_Object* parent,
+                                         const char* name,
+                                         const void* data,
+                                         size_t size,
+                                         EXIB_ENC_BlobMode mode)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddBlobEntry(ctx, parent, nameEntry, data, size, mode);
+}
+
+EXIB_ENC_Field* EXIB_ENC_AddBlobInterned(EXIB_ENC_Context* ctx,
+                                         EXIB_ENC_Object* parent,
+                                         EXIB_ENC_Name name,
+                                         const void* data,
+                                         size_t size)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetInternedEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddBlobEntry(ctx, parent, nameEntry, data, size, EXIB_ENC_BLOB_AUTO);
+}
+
+size_t EXIB_ENC_LayoutBlobTable(EXIB_ENC_Context* ctx, size_t offset)
+{
+    size_t tableSize;
+
+    ctx->blobTableOffset = 0;
+    if (ctx->blobCount == 0)
+        return 0;
+
+    ctx->blobTableOffset = offset + EXIB_ENC_Padding(offset, EXIB_BLOB_ALIGNMENT);
+    tableSize = sizeof(EXIB_BlobDirectory) + ctx->blobCount * sizeof(uint32_t);
+
+    // The table itself is aligned, so relative offsets are aligned the same way.
+    for (uint32_t i = 0; i < ctx->blobCount; ++i)
+    {
+        EXIB_ENC_Blob* blob = &ctx->blobs[i];
+
+        tableSize += EXIB_ENC_Padding(tableSize, EXIB_BLOB_ALIGNMENT);
+        blob->offset = tableSize;
+        tableSize += sizeof(EXIB_BlobEntry) + blob->storedSize;
+    }
+
+    return (ctx->blobTableOffset - offset) + tableSize;
+}
+
+size_t EXIB_ENC_EncodeExtendedHeader(EXIB_ENC_Context* ctx, size_t offset)
+{
+    EXIB_ExtHeader extHeader = {
+        .blobOffset = ctx->blobTableOffset,
+        .blobSize = ctx->blobTableOffset ? ctx->blobCount : 0,
+        .dictionary = ctx->options.dictionary ? EXIB_GetDictionaryId(ctx->options.dictionary) : 0
+    };
+
+    if (ctx->blobTableOffset == 0 && !ctx->options.dictionary)
+        return 0;
+
+    memcpy(&ctx->output[offset - ctx->outputBase], &extHeader, sizeof(extHeader));
+    return sizeof(extHeader);
+}
+
+size_t EXIB_ENC_EncodeBlobDirectory(EXIB_ENC_Context* ctx, size_t offset)
+{
+    uint8_t* out = &ctx->output[offset - ctx->outputBase];
+    size_t padding = ctx->blobTableOffset - offset;
+    uint32_t entries = ctx->blobCount;
+
+    memset(out, 0, padding);
+    out += padding;
+
+    // Written byte by byte, since sink chunks don't keep the datum's alignment.
+    memcpy(out, &entries, sizeof(entries));
+    out += sizeof(entries);
+    for (uint32_t i = 0; i < ctx->blobCount; ++i)
+    {
+        memcpy(out, &ctx->blobs[i].offset, sizeof(uint32_t));
+        out += sizeof(uint32_t);
+    }
+
+    return padding + sizeof(EXIB_BlobDirectory) + ctx->blobCount * sizeof(uint32_t);
+}
+
+size_t EXIB_ENC_EncodeBlobHeader(EXIB_ENC_Context* ctx, uint32_t index, size_t offset)
+{
+    EXIB_ENC_Blob* blob = &ctx->blobs[index];
+    uint8_t* out = &ctx->output[offset - ctx->outputBase];
+    size_t padding = (ctx->blobTableOffset + blob->offset) - offset;
+    EXIB_BlobEntry entry = {
+        .flags = blob->flags,
+        .storedSize = blob->storedSize,
+        .realSize = blob->size,
+        .checksum = blob->checksum
+    };
+
+    memset(out, 0, padding);
+    memcpy(out + padding, &entry, sizeof(entry));
+    return padding + sizeof(entry);
+}
+
+size_t EXIB_ENC_EncodeBlobTable(EXIB_ENC_Context* ctx, size_t offset)
+{
+    size_t tableOffset = offset;
+
+    if (ctx->blobTableOffset == 0)
+        return 0;
+
+    offset += EXIB_ENC_EncodeBlobDirectory(ctx, offset);
+    for (uint32_t i = 0; i < ctx->blobCount; ++i)
+    {
+        EXIB_ENC_Blob* blob = &ctx->blobs[i];
+
+        offset += EXIB_ENC_EncodeBlobHeader(ctx, i, offset);
+        memcpy(&ctx->output[offset - ctx->outputBase], blob->data, blob->storedSize);
+        offset += blob->storedSize;
+    }
+
+    return offset - tableOffset;
+}
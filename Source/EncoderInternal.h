@@ -4,13 +4,14 @@
 #include <EXIB/EXIB.h>
 #include <EXIB/Encoder.h>
 #include "AllocatorInternal.h"
+#include "ThreadInternal.h"
 
 /** Encoder string cache entry. */
 typedef struct _EXIB_ENC_StringEntry
 {
-    uint32_t      hash;   // FNV-1 hash of string.
+    uint32_t      hash;   // String cache hash of string, not EXIB_StringHashAndLength.
     uint16_t      length; // Length of string.
-    exib_string_t offset; // String table relative offset.
+    exib_string_t offset; // String offset, which counts the names of the dictionary before the string table.
     char*         buffer; // Buffer containing string characters.
 } EXIB_ENC_StringEntry;
 
@@ -23,6 +24,91 @@ typedef struct _EXIB_ENC_StringEntry
  */
 EXIB_ENC_StringEntry* EXIB_ENC_GetStringEntry(EXIB_ENC_Context* ctx, const char* str);
 
+/**
+ * Hash a string for the string cache and dictionaries.
+ * @param str String to hash.
+ * @param length Length of string.
+ * @return Hash of string.
+ */
+uint32_t EXIB_ENC_HashString(const char* str, size_t length);
+
+/** Name interned with EXIB_ENC_InternName. */
+typedef struct _EXIB_ENC_InternedName
+{
+    const EXIB_ENC_StringEntry* shared; // Entry in the dictionary, NULL if the name is in the string cache.
+    uint32_t    entry;  // Index of the string cache entry.
+    uint32_t    hash;   // Hash and length of the entry, to add it back after the cache is cleared.
+    uint16_t    length;
+    const char* buffer; // Characters in the intern arena, which is never rewound, or in the dictionary.
+} EXIB_ENC_InternedName;
+
+/**
+ * Get the string cache entry of an interned name.
+ * @param ctx Encoder context.
+ * @param name Name handle, or EXIB_ENC_NO_NAME.
+ * @param entryOut Receives the entry, or NULL for EXIB_ENC_NO_NAME.
+ * @return 0 on success, 1 if the handle is invalid.
+ */
+int EXIB_ENC_GetInternedEntry(EXIB_ENC_Context* ctx, EXIB_ENC_Name name, EXIB_ENC_StringEntry** entryOut);
+
+/**
+ * Get the string cache entry of a name passed to one of the Add functions.
+ * @param ctx Encoder context.
+ * @param name Name, or NULL.
+ * @param entryOut Receives the entry, or NULL if the name is NULL.
+ * @return 0 on success, 1 if the name couldn't be added to the cache.
+ */
+static inline int EXIB_ENC_GetNameEntry(EXIB_ENC_Context* ctx, const char* name, EXIB_ENC_StringEntry** entryOut)
+{
+    *entryOut = name ? EXIB_ENC_GetStringEntry(ctx, name) : NULL;
+    return name && !*entryOut;
+}
+
+/**
+ * Allocate the string cache of a new context.
+ * @param ctx Encoder context.
+ * @param capacity Initial number of entries.
+ * @return 0 on success, 1 on failure.
+ */
+int EXIB_ENC_InitializeStringCache(EXIB_ENC_Context* ctx, uint32_t capacity);
+
+/**
+ * Free the string cache of a context.
+ * @param ctx Encoder context.
+ */
+void EXIB_ENC_DestroyStringCache(EXIB_ENC_Context* ctx);
+
+/**
+ * Remove all strings from the string cache, keeping its capacity.
+ * Interned names are added back first, in the order they were interned.
+ * @param ctx Encoder context.
+ */
+void EXIB_ENC_ClearStringCache(EXIB_ENC_Context* ctx);
+
+struct _EXIB_ENC_StructType;
+
+/** Member of a compiled struct type. */
+typedef struct _EXIB_ENC_StructMember
+{
+    exib_string_t nameOffset; // String offset of the name, valid while the type's names are current.
+    int           wideSize; // Nested structs and arrays only. 1 if the aggregate uses a Size32.
+    const struct _EXIB_ENC_StructType* type; // Nested structs and arrays of structs only.
+    size_t        sizes[8]; // Arrays of structs only. Inner size when the elements start at an offset that's n modulo 8.
+} EXIB_ENC_StructMember;
+
+/** Binding table compiled by EXIB_ENC_AddStruct, which lives as long as the context. */
+typedef struct _EXIB_ENC_StructType
+{
+    const EXIB_ENC_Binding* table;
+    size_t                  count;
+    EXIB_ENC_StructMember*  members;
+    size_t                  bound;    // Upper bound of the inner size, as the first layout pass calculates it.
+    int                     wideSize; // 1 if objects of this type use a Size32.
+    size_t                  sizes[8]; // Inner size when the members start at an offset that's n modulo 8.
+    uint32_t                nameGeneration; // String generation the member names were added in, see EXIB_ENC_AddStructNames.
+    struct _EXIB_ENC_StructType* next; // Next type compiled by the context.
+} EXIB_ENC_StructType;
+
 struct _EXIB_ENC_Object;
 typedef struct _EXIB_ENC_Field
 {
@@ -40,6 +126,10 @@ typedef struct _EXIB_ENC_Object
 {
     EXIB_ENC_Field  field;
     EXIB_ENC_Field* children;
+    size_t          innerSize; // Size of object data in bytes, calculated by the layout pass.
+    int             wideSize;  // 1 if the object uses a Size32, decided by the layout pass.
+    const EXIB_ENC_StructType* structType; // Members written ahead of the children, NULL if the object isn't a struct.
+    const void*     structData; // Struct the members are read from.
 } EXIB_ENC_Object;
 
 typedef struct _EXIB_ENC_Array
@@ -49,6 +139,16 @@ typedef struct _EXIB_ENC_Array
     uint32_t         elementCapacity; // Size of element buffer.
     int              isString; // 1 if the array is a string.
     EXIB_Value*      valueElements; // Regular values are stored in a vector.
+    EXIB_ENC_Context* ctx; // Owning context, whose arena element buffers come from.
+    int              isExternal; // 1 if valueElements points to caller memory set by EXIB_ENC_ArraySetExternal.
+    int              isListed; // 1 if the array is in the context's list of external arrays.
+    EXIB_ENC_ReleaseFn releaseFn; // Called on the external elements once the array lets go of them.
+    struct _EXIB_ENC_Array* nextExternal;
+    uint8_t          packing; // EXIB_ArrayPacking set by EXIB_ENC_ArraySetPacking.
+    uint8_t          packDelta; // 1 to pack the differences between elements.
+    uint8_t*         packed; // Packed elements, written by the layout pass.
+    size_t           packedSize; // Size of the packed elements, 0 if the array is stored as it is.
+    size_t           packedCapacity; // Size of the packed buffer.
 } EXIB_ENC_Array;
 
 typedef struct _EXIB_ENC_String
@@ -59,24 +159,274 @@ typedef struct _EXIB_ENC_String
 void EXIB_ENC_InitializeField(EXIB_ENC_Context* ctx,
                               EXIB_ENC_Field* field,
                               EXIB_ENC_Object* parent,
-                              const char* name,
+                              const EXIB_ENC_StringEntry* nameEntry,
                               EXIB_Type type);
 
+int EXIB_ENC_InitializeArray(EXIB_ENC_Context* ctx,
+                             EXIB_ENC_Array* array,
+                             EXIB_ENC_Object* parent,
+                             const EXIB_ENC_StringEntry* nameEntry,
+                             EXIB_Type type,
+                             int reserve);
+
+/**
+ * Pack the elements of an array, if it has a packing set, into its packed buffer.
+ * The array is stored as it is if packing doesn't make it smaller, or the buffer can't be allocated.
+ * @param array Array of values.
+ */
+void EXIB_ENC_ArrayPack(EXIB_ENC_Array* array);
+
+/**
+ * Give the elements of all external arrays back to their owners.
+ * Called before the arrays themselves are freed.
+ * @param ctx Encoder context.
+ */
+void EXIB_ENC_ReleaseExternalArrays(EXIB_ENC_Context* ctx);
+
+int EXIB_ENC_InitializeString(EXIB_ENC_Context* ctx,
+                              EXIB_ENC_String* string,
+                              EXIB_ENC_Object* parent,
+                              const EXIB_ENC_StringEntry* nameEntry,
+                              EXIB_Type type);
+
+/** Blob added with EXIB_ENC_AddBlob. */
+typedef struct _EXIB_ENC_Blob
+{
+    const void* data;       // Data as it is stored, in the context's arena.
+    uint32_t    size;       // Size of the data while uncompressed.
+    uint32_t    storedSize; // Size of `data`.
+    uint32_t    checksum;   // CRC-32C of the uncompressed data, 0 with the noChecksum option.
+    uint32_t    offset;     // Blob table relative offset of the entry, set by the layout pass.
+    uint8_t     flags;      // EXIB_BlobFlag
+} EXIB_ENC_Blob;
+
+#define EXIB_ENC_STREAM_DEPTH 64
+
+/** Aggregate that is currently open in the stream writer. */
+typedef struct _EXIB_ENC_StreamLevel
+{
+    size_t    fieldOffset; // Datum offset of the aggregate's field prefix.
+    size_t    dataOffset;  // Datum offset of the aggregate's first child.
+    size_t    bound;       // Upper bound of the inner size, same as the layout pass calculates.
+    EXIB_Type elementType; // Type of children for arrays, EXIB_TYPE_NULL for objects.
+    int       wideSize;    // 1 if the aggregate uses a Size32.
+} EXIB_ENC_StreamLevel;
+
+/** State of the stream writer. */
+typedef struct _EXIB_ENC_Stream
+{
+    size_t               offset; // End of the data written so far.
+    int                  depth;  // Number of open aggregates, 0 if no stream is active.
+    uint8_t*             scratch; // Holds the contents of an aggregate while it's promoted to Size32.
+    size_t               scratchSize;
+    EXIB_ENC_StreamLevel levels[EXIB_ENC_STREAM_DEPTH];
+} EXIB_ENC_Stream;
+
+/**
+ * Part of the datum that EXIB_ENC_EncodeParallel hands to a thread:
+ * either a run of sibling fields, or a slice of array or blob data.
+ */
+typedef struct _EXIB_ENC_Task
+{
+    EXIB_ENC_Field* first;  // First field of the run, NULL if this is a copy.
+    EXIB_ENC_Field* last;   // Field after the run, NULL if it goes on to the last sibling.
+    const void*     data;   // Data to copy.
+    size_t          offset; // Datum offset the task writes at.
+    size_t          size;   // Number of bytes the task writes.
+} EXIB_ENC_Task;
+
 typedef struct _EXIB_ENC_Context
 {
-    uint8_t* encodeBuffer;
+    uint8_t* encodeBuffer; // Internal encode buffer, grown on demand.
     size_t   encodeBufferSize;
+    uint8_t* output; // Buffer the current encode pass writes into.
+    size_t   outputBase; // Datum offset of output[0]. Only non-zero while encoding to a sink.
 
     EXIB_ENC_Object rootObject;
     EXIB_MemoryPool fieldPool;
+    EXIB_Arena      arena;     // Objects, arrays, strings and element buffers. Rewound on reset.
+    EXIB_Arena      nameArena; // Characters of cached strings, which may outlive a reset.
+    EXIB_Arena      internArena; // Characters of interned names and compiled struct types, which outlive every reset.
+
+    EXIB_ENC_StringEntry* stringCache; // Entries in string table order.
+    uint32_t  stringCacheSize;
+    uint32_t  stringCacheCapacity;
+    uint32_t* stringSlots;    // Hash table of entry index + 1, or 0 if the slot is empty.
+    uint32_t  stringSlotMask; // Number of slots - 1.
+    uint32_t  stringOffset;   // Size of the string table.
+    uint32_t  stringBase;     // String offset of the string table, the size of the dictionary's names.
 
-    EXIB_ENC_StringEntry* stringCache;
-    uint16_t stringCacheSize;
-    uint16_t stringCacheCapacity;
-    uint32_t stringOffset;
+    EXIB_ENC_Array* externalArrays; // Arrays that have been given external elements since the last reset.
+
+    EXIB_ENC_Blob* blobs; // EXIB_MAX_BLOBS entries, allocated from the arena by the first blob.
+    uint32_t blobCount;
+    size_t   blobTableOffset; // Datum offset of the blob table, set by the layout pass. 0 if the datum has none.
+
+    EXIB_ENC_InternedName* internedNames; // Indexed by EXIB_ENC_Name.
+    uint32_t internedCount;
+    uint32_t internedCapacity;
+
+    EXIB_ENC_StructType* structTypes; // Struct types compiled by EXIB_ENC_AddStruct.
+    uint32_t stringGeneration; // Incremented whenever the string cache is cleared.
+
+    EXIB_ENC_Stream* stream; // Allocated by the first EXIB_ENC_BeginStream.
+
+    EXIB_ENC_Task* tasks; // Plan of the last parallel encode, kept to reuse its memory.
+    size_t taskCount;
+    size_t taskCapacity;
+    EXIB_ThreadPool threadPool; // Workers of parallel encodes, started by the first one.
 
     EXIB_ENC_Options options;
     EXIB_ENC_Error lastError;
 } EXIB_ENC_Context;
 
+/**
+ * Calculate the number of padding bytes needed to align `offset` to `alignment`.
+ */
+static inline int EXIB_ENC_Padding(size_t offset, int alignment)
+{
+    int r = (int)(offset % alignment);
+    return (r > 0) ? (alignment - r) : 0;
+}
+
+// Worst case padding in front of a value of the given size.
+static inline int EXIB_ENC_MaxPadding(int typeSize)
+{
+    return (typeSize > 1) ? typeSize - 1 : 0;
+}
+
+// Size of a field prefix and its name.
+static inline size_t EXIB_ENC_FieldHeaderSize(EXIB_ENC_Field* field)
+{
+    return 1 + ((field->nameOffset != EXIB_INVALID_STRING) ? sizeof(exib_string_t) : 0);
+}
+
+// Size of a field prefix, name, object prefix and Size16/Size32.
+static inline size_t EXIB_ENC_AggregateHeaderSize(EXIB_ENC_Field* field, int wideSize)
+{
+    return EXIB_ENC_FieldHeaderSize(field) + 1 + (wideSize ? 4 : 2);
+}
+
+// Objects, arrays of arrays and arrays of objects all contain complete fields.
+static inline int EXIB_ENC_IsAggregate(EXIB_ENC_Field* field)
+{
+    return field->type == EXIB_TYPE_OBJECT
+        || (field->type == EXIB_TYPE_ARRAY && field->elementType >= EXIB_TYPE_ARRAY);
+}
+
+// Objects added with EXIB_ENC_AddStruct, which are written as a whole.
+static inline int EXIB_ENC_IsStruct(EXIB_ENC_Field* field)
+{
+    return field->type == EXIB_TYPE_OBJECT && ((EXIB_ENC_Object*)field)->structType != NULL;
+}
+
+// Size of the element data of an array of values.
+static inline size_t EXIB_ENC_ArrayDataSize(EXIB_ENC_Array* array)
+{
+    if (array->packedSize)
+        return array->packedSize;
+    return EXIB_GetTypeSize(array->object.field.elementType) * (size_t)array->elementCount;
+}
+
+// Element data of an array of values, as it is written.
+static inline const void* EXIB_ENC_ArrayData(EXIB_ENC_Array* array)
+{
+    return array->packedSize ? (const void*)array->packed : (const void*)array->valueElements;
+}
+
+// Alignment of the element data of an array of values. The header of packed data has 64-bit fields.
+static inline int EXIB_ENC_ArrayAlignment(EXIB_ENC_Array* array)
+{
+    return array->packedSize ? 8 : EXIB_GetTypeSize(array->object.field.elementType);
+}
+
+// Upper bound of the encoded size of a value field at any offset.
+static inline size_t EXIB_ENC_ValueBound(EXIB_ENC_Field* field)
+{
+    int typeSize = EXIB_GetTypeSize(field->type);
+    return EXIB_ENC_FieldHeaderSize(field) + EXIB_ENC_MaxPadding(typeSize) + typeSize;
+}
+
+// Upper bound of the encoded size of an array of values at any offset.
+static inline size_t EXIB_ENC_ArrayBound(EXIB_ENC_Array* array)
+{
+    size_t dataSize = EXIB_ENC_ArrayDataSize(array);
+    return EXIB_ENC_AggregateHeaderSize(&array->object.field, dataSize > UINT16_MAX)
+        + EXIB_ENC_MaxPadding(EXIB_ENC_ArrayAlignment(array))
+        + dataSize;
+}
+
+// Size of the extended header, which is only written if the datum has blobs or uses a dictionary.
+static inline size_t EXIB_ENC_ExtendedHeaderSize(EXIB_ENC_Context* ctx)
+{
+    return (ctx->blobCount || ctx->options.dictionary) ? sizeof(EXIB_ExtHeader) : 0;
+}
+
+/**
+ * Lay out the blob table after the rest of the datum, and set ctx->blobTableOffset.
+ * @param ctx Encoder context.
+ * @param offset Datum offset of the end of the string table.
+ * @return Size of the blob table in bytes, including the padding in front of it.
+ */
+size_t EXIB_ENC_LayoutBlobTable(EXIB_ENC_Context* ctx, size_t offset);
+
+/**
+ * Run both layout passes over the whole datum.
+ * @param ctx Encoder context.
+ * @return Size of the datum in bytes, or 0 if the tree can't be encoded.
+ */
+size_t EXIB_ENC_Layout(EXIB_ENC_Context* ctx);
+
+/**
+ * Get the encoded size of a field after the layout pass, without walking its children.
+ * @param field Field that has been laid out.
+ * @param offset Datum offset the field is encoded at.
+ * @return Encoded size of the field in bytes.
+ */
+size_t EXIB_ENC_FieldSize(EXIB_ENC_Field* field, size_t offset);
+
+/**
+ * Make sure the internal encode buffer can hold at least `size` bytes.
+ * Grows geometrically so repeated encodes of a growing datum stay cheap.
+ * @param ctx Encoder context.
+ * @param size Minimum capacity in bytes.
+ * @param keep Number of bytes at the beginning of the buffer that must survive.
+ * @return 0 on success, 1 if the buffer could not be allocated.
+ */
+int EXIB_ENC_ReserveBuffer(EXIB_ENC_Context* ctx, size_t size, size_t keep);
+
+/*
+ * Write functions shared by the tree encoder and the stream writer.
+ * They write to ctx->output at the given datum offset and return the
+ * number of bytes written.
+ */
+size_t EXIB_ENC_EncodeField(EXIB_ENC_Context* ctx, EXIB_ENC_Field* field, size_t offset);
+size_t EXIB_ENC_EncodeArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset);
+size_t EXIB_ENC_EncodeArrayHeader(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset); // Everything but the element data.
+size_t EXIB_ENC_EncodeObjectPrefix(EXIB_ENC_Context* ctx, EXIB_ObjectPrefix objectPrefix, size_t size, size_t offset);
+size_t EXIB_ENC_EncodeObjectHeader(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset); // Everything but the children.
+size_t EXIB_ENC_EncodeObject(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset);
+size_t EXIB_ENC_EncodeStructMembers(EXIB_ENC_Context* ctx, const EXIB_ENC_StructType* type, const void* data, size_t offset);
+size_t EXIB_ENC_EncodeExtendedHeader(EXIB_ENC_Context* ctx, size_t offset);
+size_t EXIB_ENC_EncodeBlobDirectory(EXIB_ENC_Context* ctx, size_t offset); // Padding in front of the blob table, and its directory.
+size_t EXIB_ENC_EncodeBlobHeader(EXIB_ENC_Context* ctx, uint32_t index, size_t offset); // Padding and entry of a blob, but not its data.
+size_t EXIB_ENC_EncodeBlobTable(EXIB_ENC_Context* ctx, size_t offset);
+size_t EXIB_ENC_EncodeStringTable(EXIB_ENC_Context* ctx, size_t offset);
+
+/** Fill in all header fields, leaving the checksum at 0. */
+void EXIB_ENC_FillHeader(EXIB_ENC_Context* ctx, EXIB_Header* header, size_t datumSize, size_t stringTableSize);
+
+/**
+ * Fill in the header at the beginning of ctx->output and calculate the checksum,
+ * unless the noChecksum option is set.
+ * @param ctx Encoder context.
+ * @param datumSize Size of the datum in bytes.
+ * @param stringTableSize Size of the string table in bytes.
+ * @return Pointer to header.
+ */
+EXIB_Header* EXIB_ENC_EncodeHeader(EXIB_ENC_Context* ctx, size_t datumSize, size_t stringTableSize);
+
+/** Get the number of characters in a null-terminated string, not including the terminator. */
+size_t EXIB_ENC_StringLength(const void* str, int charSize);
+
 #endif // _EXIB_ENCODER_INTERNAL_H
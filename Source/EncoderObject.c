@@ -8,16 +8,14 @@
 void EXIB_ENC_InitializeField(EXIB_ENC_Context* ctx,
                               EXIB_ENC_Field* field,
                               EXIB_ENC_Object* parent,
-                              const char* name,
+                              const EXIB_ENC_StringEntry* nameEntry,
                               EXIB_Type type)
 {
     if (parent == NULL)
         parent = &ctx->rootObject;
 
-    if (name != NULL)
+    if (nameEntry != NULL)
     {
-        EXIB_ENC_StringEntry* nameEntry = EXIB_ENC_GetStringEntry(ctx, name);
-
         field->nameOffset = nameEntry->offset;
         field->nameBuffer = nameEntry->buffer;
     }
@@ -45,15 +43,55 @@ void EXIB_ENC_InitializeField(EXIB_ENC_Context* ctx,
     }
 }
 
+static EXIB_ENC_Object* EXIB_ENC_AddObjectEntry(EXIB_ENC_Context* ctx,
+                                                EXIB_ENC_Object* parent,
+                                                const EXIB_ENC_StringEntry* name)
+{
+    EXIB_ENC_Object* object = EXIB_ArenaAlloc(&ctx->arena, sizeof(EXIB_ENC_Object), sizeof(void*));
+    if (!object)
+        return NULL;
+
+    memset(object, 0, sizeof(EXIB_ENC_Object));
+    EXIB_ENC_InitializeField(ctx, &object->field, parent, name, EXIB_TYPE_OBJECT);
+
+    return object;
+}
+
+static EXIB_ENC_Field* EXIB_ENC_AddFieldEntry(EXIB_ENC_Context* ctx,
+                                              EXIB_ENC_Object* parent,
+                                              const EXIB_ENC_StringEntry* name,
+                                              EXIB_Type type)
+{
+    EXIB_ENC_Field* field = EXIB_PoolAlloc(&ctx->fieldPool);
+    if (!field)
+        return NULL;
+
+    memset(field, 0, sizeof(EXIB_ENC_Field));
+    EXIB_ENC_InitializeField(ctx, field, parent, name, type);
+
+    return field;
+}
+
 EXIB_ENC_Object* EXIB_ENC_AddObject(EXIB_ENC_Context* ctx,
                                     EXIB_ENC_Object* parent,
                                     const char* name)
 {
-    EXIB_ENC_Object* object = EXIB_New(EXIB_ENC_Object);
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
 
-    EXIB_ENC_InitializeField(ctx, &object->field, parent, name, EXIB_TYPE_OBJECT);
+    return EXIB_ENC_AddObjectEntry(ctx, parent, nameEntry);
+}
 
-    return object;
+EXIB_ENC_Object* EXIB_ENC_AddObjectInterned(EXIB_ENC_Context* ctx,
+                                            EXIB_ENC_Object* parent,
+                                            EXIB_ENC_Name name)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetInternedEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddObjectEntry(ctx, parent, nameEntry);
 }
 
 EXIB_ENC_Field* EXIB_ENC_AddField(EXIB_ENC_Context* ctx,
@@ -61,11 +99,23 @@ EXIB_ENC_Field* EXIB_ENC_AddField(EXIB_ENC_Context* ctx,
                                   const char* name,
                                   EXIB_Type type)
 {
-    EXIB_ENC_Field* field = EXIB_PoolAlloc(&ctx->fieldPool);
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
 
-    EXIB_ENC_InitializeField(ctx, field, parent, name, type);
+    return EXIB_ENC_AddFieldEntry(ctx, parent, nameEntry, type);
+}
 
-    return field;
+EXIB_ENC_Field* EXIB_ENC_AddFieldInterned(EXIB_ENC_Context* ctx,
+                                          EXIB_ENC_Object* parent,
+                                          EXIB_ENC_Name name,
+                                          EXIB_Type type)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetInternedEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddFieldEntry(ctx, parent, nameEntry, type);
 }
 
 const char* EXIB_ENC_GetName(EXIB_ENC_Field* field)
@@ -0,0 +1,343 @@
+#include <stdlib.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
+#include "AllocatorInternal.h"
+#include "CRC32CInternal.h"
+#include "EncoderInternal.h"
+#include "ThreadInternal.h"
+
+/*
+ * The layout pass fixes the offset of every field, and padding only depends
+ * on the offset, so every part of the datum can be written independently.
+ * The plan splits the datum into tasks of about the same size, in datum order.
+ * Aggregates, arrays and blobs too large for one task are opened up: the calling
+ * thread writes their headers, and their children or data become tasks of their own.
+ * Each thread then takes a contiguous run of tasks, and checksums its part of
+ * the datum as soon as it's written, while it's still in cache. The threads
+ * are kept in the context's pool, so only the first parallel encode starts them.
+ */
+
+#define EXIB_ENC_MAX_THREADS 64
+
+// Datums are split into more tasks than threads, so uneven subtrees still balance out.
+#define EXIB_ENC_TASKS_PER_THREAD 8
+
+// Smaller tasks aren't worth the overhead, and datums below two of them aren't split at all.
+#define EXIB_ENC_MIN_TASK (256 * 1024)
+
+typedef struct _EXIB_ENC_Worker
+{
+    EXIB_ENC_Context* ctx;
+    size_t firstTask;
+    size_t lastTask; // Task after the worker's last one.
+    size_t start; // Datum range the worker's tasks cover, including headers in between.
+    size_t size;
+    uint32_t crc;
+} EXIB_ENC_Worker;
+
+static int EXIB_ENC_AddTask(EXIB_ENC_Context* ctx, const EXIB_ENC_Task* task)
+{
+    if (ctx->taskCount == ctx->taskCapacity)
+    {
+        size_t newCapacity = ctx->taskCapacity ? ctx->taskCapacity * 2 : 64;
+        EXIB_ENC_Task* newTasks = EXIB_Alloc(newCapacity * sizeof(EXIB_ENC_Task));
+
+        if (!newTasks)
+            return 1;
+
+        if (ctx->tasks)
+        {
+            memcpy(newTasks, ctx->tasks, ctx->taskCount * sizeof(EXIB_ENC_Task));
+            EXIB_Free(ctx->tasks);
+        }
+
+        ctx->tasks = newTasks;
+        ctx->taskCapacity = newCapacity;
+    }
+
+    ctx->tasks[ctx->taskCount++] = *task;
+    return 0;
+}
+
+// Split data that's copied as it is into tasks of at most `taskSize` bytes.
+static int EXIB_ENC_PlanCopy(EXIB_ENC_Context* ctx, const void* data, size_t size, size_t offset, size_t taskSize)
+{
+    for (size_t done = 0; done < size; done += taskSize)
+    {
+        EXIB_ENC_Task task = {
+            .data = (const uint8_t*)data + done,
+            .offset = offset + done,
+            .size = (size - done < taskSize) ? size - done : taskSize
+        };
+
+        if (EXIB_ENC_AddTask(ctx, &task))
+            return 1;
+    }
+
+    return 0;
+}
+
+// Write the header of an array of values, and split its elements into copies.
+static int EXIB_ENC_PlanArray(EXIB_ENC_Context* ctx, EXIB_ENC_Array* array, size_t offset, size_t size, size_t taskSize)
+{
+    size_t headerSize = EXIB_ENC_EncodeArrayHeader(ctx, array, offset);
+    return EXIB_ENC_PlanCopy(ctx, EXIB_ENC_ArrayData(array), size - headerSize, offset + headerSize, taskSize);
+}
+
+/**
+ * Write the header of an object, and plan its children. Runs of small siblings
+ * are grouped into a single task, large children are opened up in turn.
+ * @param ctx Encoder context.
+ * @param object Object or array of aggregates, that has been laid out.
+ * @param offset Datum offset of the object.
+ * @param taskSize Size a task should have.
+ * @return 0 on success, 1 on failure.
+ */
+static int EXIB_ENC_PlanObject(EXIB_ENC_Context* ctx, EXIB_ENC_Object* object, size_t offset, size_t taskSize)
+{
+    EXIB_ENC_Task run = { .first = NULL };
+
+    offset += EXIB_ENC_EncodeObjectHeader(ctx, object, offset);
+
+    for (EXIB_ENC_Field* child = object->children; child != NULL; child = child->next)
+    {
+        size_t size = EXIB_ENC_FieldSize(child, offset);
+
+        // Structs are encoded by a single task, like value fields.
+        if (size > taskSize && !EXIB_ENC_IsStruct(child) && (EXIB_ENC_IsAggregate(child) || child->type == EXIB_TYPE_ARRAY))
+        {
+            // Tasks stay in datum order, so the run before the child ends here.
+            if (run.first && EXIB_ENC_AddTask(ctx, &run))
+                return 1;
+            run.first = NULL;
+
+            if (EXIB_ENC_IsAggregate(child))
+            {
+                if (EXIB_ENC_PlanObject(ctx, (EXIB_ENC_Object*)child, offset, taskSize))
+                    return 1;
+            }
+            else if (EXIB_ENC_PlanArray(ctx, (EXIB_ENC_Array*)child, offset, size, taskSize))
+                return 1;
+        }
+        else
+        {
+            if (!run.first)
+            {
+                run.first = child;
+                run.offset = offset;
+                run.size = 0;
+            }
+
+            run.last = child->next;
+            run.size += size;
+
+            if (run.size >= taskSize)
+            {
+                if (EXIB_ENC_AddTask(ctx, &run))
+                    return 1;
+                run.first = NULL;
+            }
+        }
+
+        offset += size;
+    }
+
+    if (run.first && EXIB_ENC_AddTask(ctx, &run))
+        return 1;
+
+    return 0;
+}
+
+/**
+ * Write everything but the tasks, and plan the tasks.
+ * @param ctx Encoder context, laid out with ctx->output set.
+ * @param datumSize Size of the datum.
+ * @param taskSize Size a task should have.
+ * @return 0 on success, 1 on failure.
+ */
+static int EXIB_ENC_PlanDatum(EXIB_ENC_Context* ctx, size_t datumSize, size_t taskSize)
+{
+    size_t offset = sizeof(EXIB_Header);
+
+    ctx->taskCount = 0;
+
+    // The checksum is filled in once the threads are done.
+    EXIB_ENC_FillHeader(ctx, (EXIB_Header*)ctx->output, datumSize, ctx->stringOffset);
+    offset += EXIB_ENC_EncodeExtendedHeader(ctx, offset);
+
+    if (EXIB_ENC_PlanObject(ctx, &ctx->rootObject, offset, taskSize))
+        return 1;
+
+    offset += EXIB_ENC_FieldSize(&ctx->rootObject.field, offset);
+    offset += EXIB_ENC_EncodeStringTable(ctx, offset);
+
+    if (ctx->blobTableOffset == 0)
+        return 0;
+
+    offset += EXIB_ENC_EncodeBlobDirectory(ctx, offset);
+    for (uint32_t i = 0; i < ctx->blobCount; ++i)
+    {
+        EXIB_ENC_Blob* blob = &ctx->blobs[i];
+
+        offset += EXIB_ENC_EncodeBlobHeader(ctx, i, offset);
+        if (EXIB_ENC_PlanCopy(ctx, blob->data, blob->storedSize, offset, taskSize))
+            return 1;
+        offset += blob->storedSize;
+    }
+
+    return 0;
+}
+
+static void EXIB_ENC_RunTask(EXIB_ENC_Context* ctx, const EXIB_ENC_Task* task)
+{
+    size_t offset = task->offset;
+
+    if (!task->first)
+    {
+        memcpy(&ctx->output[offset], task->data, task->size);
+        return;
+    }
+
+    for (EXIB_ENC_Field* field = task->first; field != task->last; field = field->next)
+    {
+        if (EXIB_ENC_IsAggregate(field))
+            offset += EXIB_ENC_EncodeObject(ctx, (EXIB_ENC_Object*)field, offset);
+        else if (field->type == EXIB_TYPE_ARRAY)
+            offset += EXIB_ENC_EncodeArray(ctx, (EXIB_ENC_Array*)field, offset);
+        else
+            offset += EXIB_ENC_EncodeField(ctx, field, offset);
+    }
+}
+
+static void EXIB_ENC_WorkerMain(void* arg)
+{
+    EXIB_ENC_Worker* worker = arg;
+    EXIB_ENC_Context* ctx = worker->ctx;
+
+    for (size_t i = worker->firstTask; i < worker->lastTask; ++i)
+        EXIB_ENC_RunTask(ctx, &ctx->tasks[i]);
+
+    if (!ctx->options.noChecksum)
+        worker->crc = EXIB_CRC32C(0, &ctx->output[worker->start], worker->size);
+}
+
+/**
+ * Give each worker a contiguous run of tasks with about the same number of bytes.
+ * @param ctx Encoder context with a plan.
+ * @param workers Workers to fill in.
+ * @param threads Maximum number of workers.
+ * @param datumSize Size of the datum.
+ * @return Number of workers that have tasks.
+ */
+static int EXIB_ENC_AssignTasks(EXIB_ENC_Context* ctx, EXIB_ENC_Worker* workers, int threads, size_t datumSize)
+{
+    size_t taskBytes = 0;
+    size_t done = 0;
+    int count = 1;
+
+    for (size_t i = 0; i < ctx->taskCount; ++i)
+        taskBytes += ctx->tasks[i].size;
+
+    workers[0].firstTask = 0;
+    workers[0].start = 0;
+
+    for (size_t i = 0; i < ctx->taskCount; ++i)
+    {
+        if (count < threads && done >= (taskBytes / threads) * count)
+        {
+            workers[count - 1].lastTask = i;
+            workers[count].firstTask = i;
+            workers[count].start = ctx->tasks[i].offset;
+            ++count;
+        }
+
+        done += ctx->tasks[i].size;
+    }
+
+    workers[count - 1].lastTask = ctx->taskCount;
+
+    for (int i = 0; i < count; ++i)
+    {
+        size_t end = (i == count - 1) ? datumSize : workers[i + 1].start;
+
+        workers[i].ctx = ctx;
+        workers[i].size = end - workers[i].start;
+        workers[i].crc = 0;
+    }
+
+    return count;
+}
+
+EXIB_Header* EXIB_ENC_EncodeParallel(EXIB_ENC_Context* ctx, int threads)
+{
+    EXIB_ENC_Worker workers[EXIB_ENC_MAX_THREADS];
+    void* jobs[EXIB_ENC_MAX_THREADS];
+    EXIB_Header* header;
+    size_t datumSize;
+    size_t taskSize;
+    uint32_t crc;
+    int count;
+    int started;
+
+    if (threads > EXIB_ENC_MAX_THREADS)
+        threads = EXIB_ENC_MAX_THREADS;
+
+    datumSize = EXIB_ENC_Layout(ctx);
+    if (datumSize == 0)
+        return NULL;
+    if (threads <= 1 || datumSize < 2 * EXIB_ENC_MIN_TASK)
+        return EXIB_ENC_Encode(ctx);
+
+    if (datumSize > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return NULL;
+    }
+
+    if (EXIB_ENC_ReserveBuffer(ctx, datumSize, 0))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    ctx->output = ctx->encodeBuffer;
+    ctx->outputBase = 0;
+
+    taskSize = datumSize / ((size_t)threads * EXIB_ENC_TASKS_PER_THREAD);
+    if (taskSize < EXIB_ENC_MIN_TASK)
+        taskSize = EXIB_ENC_MIN_TASK;
+
+    if (EXIB_ENC_PlanDatum(ctx, datumSize, taskSize))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    // Build the tables once, before any of the threads race to do it.
+    EXIB_CRC32C_Initialize();
+
+    // The calling thread takes the first run of tasks, the pool's workers the others.
+    count = EXIB_ENC_AssignTasks(ctx, workers, threads, datumSize);
+    for (int i = 1; i < count; ++i)
+        jobs[i - 1] = &workers[i];
+    started = EXIB_ThreadPoolStart(&ctx->threadPool, count - 1, EXIB_ENC_WorkerMain, jobs);
+
+    EXIB_ENC_WorkerMain(&workers[0]);
+
+    // Tasks that no worker could be started for are done here instead.
+    for (int i = started + 1; i < count; ++i)
+        EXIB_ENC_WorkerMain(&workers[i]);
+    EXIB_ThreadPoolWait(&ctx->threadPool);
+
+    crc = workers[0].crc;
+    for (int i = 1; i < count; ++i)
+        crc = EXIB_CRC32C_Combine(crc, workers[i].crc, workers[i].size);
+
+    header = (EXIB_Header*)ctx->output;
+    if (!ctx->options.noChecksum)
+        header->checksum = crc;
+
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return header;
+}
@@ -0,0 +1,436 @@
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
+#include "EncoderInternal.h"
+
+#ifdef WIN32
+    #include <io.h>
+    #define write _write
+    #define lseek _lseeki64
+    typedef __int64 exib_off_t;
+#else
+    #include <unistd.h>
+    typedef off_t exib_off_t;
+#endif
+
+/*
+ * Sink encoding reuses the write functions of the buffered encoder, but with
+ * ctx->output pointing at a single chunk that is flushed whenever it runs out
+ * of room. Large arrays bypass the chunk and go to the sink directly.
+ *
+ * All aggregate sizes are known from the layout pass, so the only thing that
+ * needs to be patched afterwards is the checksum in the header.
+ *
+ * In iovec mode the chunk is big enough for all of the structure, and large
+ * arrays and blobs become segments of their own that point at their data.
+ */
+
+// Size of the chunk buffer. It must be able to hold the entire string table.
+#define EXIB_ENC_SINK_CHUNK (64 * 1024)
+
+// Enough room for the prefixes, name, size and padding of any field, and the value of a value field.
+// Also fits the padding and entry in front of a blob.
+#define EXIB_ENC_SINK_FIELD 32
+
+// Enough room for the padding in front of the blob table and a full blob directory.
+#define EXIB_ENC_SINK_DIRECTORY (EXIB_BLOB_ALIGNMENT + sizeof(EXIB_BlobDirectory) + EXIB_MAX_BLOBS * sizeof(uint32_t))
+
+// Arrays with at least this many bytes of elements get a segment of their own in iovec mode.
+#define EXIB_ENC_IOV_PAYLOAD 1024
+
+typedef struct _EXIB_ENC_Sink
+{
+    EXIB_ENC_WriteFn writeFn; // NULL if only the checksum is calculated.
+    void*            user;
+    size_t           fill; // Number of bytes in the chunk.
+    uint32_t         crc;
+    int              noChecksum; // Set from the encoder option, skips calculating `crc`.
+    int              failed;
+    struct iovec*    iov;      // Receives the segments in iovec mode, where the chunk holds the whole structure.
+    int              iovCount;
+    size_t           segment;  // Chunk offset of the current structural segment in iovec mode.
+} EXIB_ENC_Sink;
+
+// Datum offset that the next byte will be written to.
+static inline size_t EXIB_ENC_SinkOffset(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink)
+{
+    return ctx->outputBase + sink->fill;
+}
+
+// Pass data on to the sink and the checksum.
+static void EXIB_ENC_SinkWrite(EXIB_ENC_Sink* sink, const void* data, size_t size)
+{
+    if (sink->failed || size == 0)
+        return;
+
+    if (!sink->noChecksum)
+        sink->crc = EXIB_CRC32C(sink->crc, data, size);
+
+    if (sink->writeFn && sink->writeFn(sink->user, data, size) != 0)
+        sink->failed = 1;
+}
+
+// Add a segment in iovec mode.
+static void EXIB_ENC_SinkSegment(EXIB_ENC_Sink* sink, const void* data, size_t size)
+{
+    if (size == 0)
+        return;
+
+    sink->iov[sink->iovCount].iov_base = (void*)data;
+    sink->iov[sink->iovCount].iov_len = size;
+    sink->iovCount++;
+}
+
+static void EXIB_ENC_SinkFlush(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink)
+{
+    // Structural segments stay in the chunk, just ending the current one.
+    if (sink->iov)
+    {
+        EXIB_ENC_SinkSegment(sink, &ctx->output[sink->segment], sink->fill - sink->segment);
+        sink->segment = sink->fill;
+        return;
+    }
+
+    EXIB_ENC_SinkWrite(sink, ctx->output, sink->fill);
+    ctx->outputBase += sink->fill;
+    sink->fill = 0;
+}
+
+// Make sure the chunk has room for `size` more bytes.
+static inline void EXIB_ENC_SinkReserve(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, size_t size)
+{
+    if (!sink->iov && sink->fill + size > ctx->encodeBufferSize)
+        EXIB_ENC_SinkFlush(ctx, sink);
+}
+
+// Pass a large run of data to the sink directly, after everything that is in the chunk.
+static void EXIB_ENC_SinkPayload(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, const void* data, size_t size)
+{
+    EXIB_ENC_SinkFlush(ctx, sink);
+    if (sink->iov)
+        EXIB_ENC_SinkSegment(sink, data, size);
+    else
+        EXIB_ENC_SinkWrite(sink, data, size);
+    ctx->outputBase += size;
+}
+
+static void EXIB_ENC_SinkArray(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, EXIB_ENC_Array* array)
+{
+    size_t dataSize = EXIB_ENC_ArrayDataSize(array);
+
+    EXIB_ENC_SinkReserve(ctx, sink, EXIB_ENC_SINK_FIELD);
+    sink->fill += EXIB_ENC_EncodeArrayHeader(ctx, array, EXIB_ENC_SinkOffset(ctx, sink));
+
+    // Copy small arrays into the chunk, but don't bother for anything that needs a flush.
+    if (sink->iov ? dataSize < EXIB_ENC_IOV_PAYLOAD : sink->fill + dataSize <= ctx->encodeBufferSize)
+    {
+        memcpy(&ctx->output[sink->fill], EXIB_ENC_ArrayData(array), dataSize);
+        sink->fill += dataSize;
+        return;
+    }
+
+    EXIB_ENC_SinkPayload(ctx, sink, EXIB_ENC_ArrayData(array), dataSize);
+}
+
+/**
+ * Write an object added with EXIB_ENC_AddStruct in one piece, growing the chunk if it doesn't fit.
+ * In iovec mode it's counted as structure, so it always fits.
+ */
+static void EXIB_ENC_SinkStruct(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, EXIB_ENC_Object* object)
+{
+    size_t size = EXIB_ENC_FieldSize(&object->field, EXIB_ENC_SinkOffset(ctx, sink));
+
+    EXIB_ENC_SinkReserve(ctx, sink, size);
+    if (!sink->iov && sink->fill + size > ctx->encodeBufferSize)
+    {
+        // The chunk has just been flushed, so none of it has to be kept.
+        if (EXIB_ENC_ReserveBuffer(ctx, size, 0))
+        {
+            sink->failed = 1;
+            return;
+        }
+        ctx->output = ctx->encodeBuffer;
+    }
+
+    sink->fill += EXIB_ENC_EncodeObject(ctx, object, EXIB_ENC_SinkOffset(ctx, sink));
+}
+
+static void EXIB_ENC_SinkObject(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, EXIB_ENC_Object* object)
+{
+    EXIB_ENC_SinkReserve(ctx, sink, EXIB_ENC_SINK_FIELD);
+    sink->fill += EXIB_ENC_EncodeObjectHeader(ctx, object, EXIB_ENC_SinkOffset(ctx, sink));
+
+    for (EXIB_ENC_Field* field = object->children; field != NULL && !sink->failed; field = field->next)
+    {
+        if (EXIB_ENC_IsStruct(field))
+            EXIB_ENC_SinkStruct(ctx, sink, (EXIB_ENC_Object*)field);
+        else if (EXIB_ENC_IsAggregate(field))
+            EXIB_ENC_SinkObject(ctx, sink, (EXIB_ENC_Object*)field);
+        else if (field->type == EXIB_TYPE_ARRAY)
+            EXIB_ENC_SinkArray(ctx, sink, (EXIB_ENC_Array*)field);
+        else
+        {
+            EXIB_ENC_SinkReserve(ctx, sink, EXIB_ENC_SINK_FIELD);
+            sink->fill += EXIB_ENC_EncodeField(ctx, field, EXIB_ENC_SinkOffset(ctx, sink));
+        }
+    }
+}
+
+static void EXIB_ENC_SinkBlobTable(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink)
+{
+    EXIB_ENC_SinkReserve(ctx, sink, EXIB_ENC_SINK_DIRECTORY);
+    sink->fill += EXIB_ENC_EncodeBlobDirectory(ctx, EXIB_ENC_SinkOffset(ctx, sink));
+
+    for (uint32_t i = 0; i < ctx->blobCount && !sink->failed; ++i)
+    {
+        EXIB_ENC_Blob* blob = &ctx->blobs[i];
+
+        EXIB_ENC_SinkReserve(ctx, sink, EXIB_ENC_SINK_FIELD);
+        sink->fill += EXIB_ENC_EncodeBlobHeader(ctx, i, EXIB_ENC_SinkOffset(ctx, sink));
+
+        // Same rules as the elements of arrays.
+        if (sink->iov ? blob->storedSize < EXIB_ENC_IOV_PAYLOAD : sink->fill + blob->storedSize <= ctx->encodeBufferSize)
+        {
+            memcpy(&ctx->output[sink->fill], blob->data, blob->storedSize);
+            sink->fill += blob->storedSize;
+        }
+        else
+            EXIB_ENC_SinkPayload(ctx, sink, blob->data, blob->storedSize);
+    }
+}
+
+/**
+ * Write the laid out datum to a sink.
+ * @param ctx Encoder context.
+ * @param sink Sink to write to.
+ * @param datumSize Size of the datum from the layout pass.
+ * @param checksum Checksum to store in the header, if it's known already.
+ */
+static void EXIB_ENC_SinkDatum(EXIB_ENC_Context* ctx, EXIB_ENC_Sink* sink, size_t datumSize, uint32_t checksum)
+{
+    EXIB_Header* header = (EXIB_Header*)ctx->output;
+
+    ctx->outputBase = 0;
+    sink->fill = sizeof(EXIB_Header);
+    sink->crc = 0;
+
+    EXIB_ENC_FillHeader(ctx, header, datumSize, ctx->stringOffset);
+    header->checksum = checksum;
+    sink->fill += EXIB_ENC_EncodeExtendedHeader(ctx, sink->fill);
+
+    EXIB_ENC_SinkObject(ctx, sink, &ctx->rootObject);
+
+    EXIB_ENC_SinkReserve(ctx, sink, ctx->stringOffset);
+    sink->fill += EXIB_ENC_EncodeStringTable(ctx, EXIB_ENC_SinkOffset(ctx, sink));
+
+    if (ctx->blobTableOffset)
+        EXIB_ENC_SinkBlobTable(ctx, sink);
+
+    EXIB_ENC_SinkFlush(ctx, sink);
+}
+
+int EXIB_ENC_EncodeToSink(EXIB_ENC_Context* ctx, EXIB_ENC_WriteFn writeFn, EXIB_ENC_SeekFn seekFn, void* user)
+{
+    EXIB_ENC_Sink sink = {
+        .writeFn = writeFn,
+        .user = user,
+        .noChecksum = ctx->options.noChecksum
+    };
+    size_t datumSize = EXIB_ENC_Layout(ctx);
+    int result = 0;
+
+    if (datumSize == 0)
+        return 1;
+
+    if (datumSize > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return 1;
+    }
+
+    if (EXIB_ENC_ReserveBuffer(ctx, EXIB_ENC_SINK_CHUNK, 0))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return 1;
+    }
+
+    ctx->output = ctx->encodeBuffer;
+
+    if (sink.noChecksum)
+        EXIB_ENC_SinkDatum(ctx, &sink, datumSize, 0);
+    else if (seekFn)
+    {
+        EXIB_ENC_SinkDatum(ctx, &sink, datumSize, 0);
+
+        // Patch the checksum, then leave the sink at the end of the datum.
+        if (!sink.failed)
+            sink.failed = seekFn(user, offsetof(EXIB_Header, checksum)) != 0
+                || writeFn(user, &sink.crc, sizeof(sink.crc)) != 0
+                || seekFn(user, datumSize) != 0;
+    }
+    else
+    {
+        // Calculate the checksum first, so it can be written along with the rest of the header.
+        sink.writeFn = NULL;
+        EXIB_ENC_SinkDatum(ctx, &sink, datumSize, 0);
+
+        sink.writeFn = writeFn;
+        EXIB_ENC_SinkDatum(ctx, &sink, datumSize, sink.crc);
+    }
+
+    if (sink.failed)
+    {
+        ctx->lastError = EXIB_ENC_ERR_SinkFailed;
+        result = 1;
+    }
+    else
+        ctx->lastError = EXIB_ENC_ERR_Success;
+
+    ctx->outputBase = 0;
+    return result;
+}
+
+/**
+ * Count the arrays that get a segment of their own in iovec mode.
+ * @param object Object or array of aggregates to search.
+ * @param payloadSize Incremented by the size of their elements.
+ * @return Number of arrays.
+ */
+static int EXIB_ENC_CountPayloads(EXIB_ENC_Object* object, size_t* payloadSize)
+{
+    int count = 0;
+
+    for (EXIB_ENC_Field* field = object->children; field != NULL; field = field->next)
+    {
+        // Structs are written into the chunk as a whole.
+        if (EXIB_ENC_IsStruct(field))
+            continue;
+
+        if (EXIB_ENC_IsAggregate(field))
+            count += EXIB_ENC_CountPayloads((EXIB_ENC_Object*)field, payloadSize);
+        else if (field->type == EXIB_TYPE_ARRAY)
+        {
+            size_t dataSize = EXIB_ENC_ArrayDataSize((EXIB_ENC_Array*)field);
+            if (dataSize >= EXIB_ENC_IOV_PAYLOAD)
+            {
+                *payloadSize += dataSize;
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+int EXIB_ENC_EncodeIOV(EXIB_ENC_Context* ctx, struct iovec* out, int* count)
+{
+    EXIB_ENC_Sink sink = {
+        .iov = out,
+        .noChecksum = ctx->options.noChecksum
+    };
+    size_t datumSize = EXIB_ENC_Layout(ctx);
+    size_t payloadSize = 0;
+    int payloads = EXIB_ENC_CountPayloads(&ctx->rootObject, &payloadSize);
+    EXIB_Header* header;
+
+    // Large blobs get segments of their own as well.
+    for (uint32_t i = 0; i < ctx->blobCount; ++i)
+    {
+        if (ctx->blobs[i].storedSize >= EXIB_ENC_IOV_PAYLOAD)
+        {
+            payloadSize += ctx->blobs[i].storedSize;
+            ++payloads;
+        }
+    }
+
+    if (datumSize == 0)
+        return 1;
+
+    if (datumSize > UINT32_MAX)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return 1;
+    }
+
+    // Structural segments alternate with payloads, from the header to the end of the datum.
+    if (*count < payloads * 2 + 1)
+    {
+        *count = payloads * 2 + 1;
+        ctx->lastError = EXIB_ENC_ERR_BufferTooSmall;
+        return 1;
+    }
+
+    // The chunk holds all of the structure, so it never has to be flushed.
+    if (EXIB_ENC_ReserveBuffer(ctx, datumSize - payloadSize, 0))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return 1;
+    }
+
+    ctx->output = ctx->encodeBuffer;
+    EXIB_ENC_SinkDatum(ctx, &sink, datumSize, 0);
+
+    // The checksum covers the segments in order, with the checksum field still 0.
+    for (int i = 0; i < sink.iovCount && !sink.noChecksum; ++i)
+        sink.crc = EXIB_CRC32C(sink.crc, out[i].iov_base, out[i].iov_len);
+
+    header = (EXIB_Header*)ctx->output;
+    header->checksum = sink.crc;
+
+    *count = sink.iovCount;
+    ctx->outputBase = 0;
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return 0;
+}
+
+typedef struct _EXIB_ENC_FileSink
+{
+    int        fd;
+    exib_off_t start; // File offset of the beginning of the datum.
+} EXIB_ENC_FileSink;
+
+static int EXIB_ENC_FileWrite(void* user, const void* data, size_t size)
+{
+    EXIB_ENC_FileSink* file = user;
+    const uint8_t* p = data;
+
+    // Writes may be cut short, by signals or by pipes that are full.
+    while (size > 0)
+    {
+        size_t n = (size > (1 << 30)) ? (1 << 30) : size;
+        ptrdiff_t written = write(file->fd, p, n);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 1;
+        }
+
+        p += written;
+        size -= written;
+    }
+
+    return 0;
+}
+
+static int EXIB_ENC_FileSeek(void* user, size_t offset)
+{
+    EXIB_ENC_FileSink* file = user;
+    return lseek(file->fd, file->start + (exib_off_t)offset, SEEK_SET) < 0;
+}
+
+int EXIB_ENC_EncodeToFD(EXIB_ENC_Context* ctx, int fd)
+{
+    EXIB_ENC_FileSink file = {
+        .fd = fd,
+        .start = lseek(fd, 0, SEEK_CUR)
+    };
+
+    if (file.start < 0)
+        return EXIB_ENC_EncodeToSink(ctx, EXIB_ENC_FileWrite, NULL, &file);
+
+    return EXIB_ENC_EncodeToSink(ctx, EXIB_ENC_FileWrite, EXIB_ENC_FileSeek, &file);
+}
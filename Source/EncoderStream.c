@@ -0,0 +1,472 @@
+#include <stdlib.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
+#include "AllocatorInternal.h"
+#include "EncoderInternal.h"
+
+/*
+ * The stream writer follows the same layout rules as the tree encoder, see
+ * Encoder.c. Whether an aggregate uses a Size16 or a Size32 depends on an
+ * upper bound of its size, which isn't known until the aggregate is closed.
+ *
+ * Every aggregate starts out with a Size16 and the bound of each open
+ * aggregate is updated as fields are written. As soon as the bound no longer
+ * fits in a Size16, the aggregate is promoted to a Size32 and its contents
+ * are moved up and re-padded. The bound only grows, so that happens at most
+ * once per aggregate and always before it holds more than 64 KiB of data.
+ */
+
+static int EXIB_ENC_StreamError(EXIB_ENC_Context* ctx, EXIB_ENC_Error err)
+{
+    ctx->lastError = err;
+    return 1;
+}
+
+// Make room for `bytes` more bytes after the end of the stream.
+static int EXIB_ENC_StreamReserve(EXIB_ENC_Context* ctx, size_t bytes)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+
+    if (EXIB_ENC_ReserveBuffer(ctx, stream->offset + bytes, stream->offset))
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfMemory);
+
+    ctx->output = ctx->encodeBuffer;
+    return 0;
+}
+
+/**
+ * Re-encode a complete field at a new offset, recalculating its padding.
+ * @param ctx Encoder context.
+ * @param src Encoded field.
+ * @param offset Datum offset to write the field to.
+ * @param srcSizeOut Pointer to variable that will receive the size of `src`.
+ * @return Number of bytes written.
+ */
+static size_t EXIB_ENC_StreamMoveField(EXIB_ENC_Context* ctx, const uint8_t* src, size_t offset, size_t* srcSizeOut)
+{
+    EXIB_FieldPrefix prefix = { .byte = src[0] };
+    size_t header = 1 + (prefix.named ? sizeof(exib_string_t) : 0);
+    int oldPadding = prefix.padding;
+    size_t fieldOffset = offset;
+
+    memcpy(&ctx->output[offset], src, header);
+    offset += header;
+
+    if (prefix.type != EXIB_TYPE_OBJECT && prefix.type != EXIB_TYPE_ARRAY)
+    {
+        int typeSize = EXIB_GetTypeSize(prefix.type);
+        int padding = (typeSize > 0) ? EXIB_ENC_Padding(offset, typeSize) : 0;
+
+        prefix.padding = padding;
+        ctx->output[fieldOffset] = prefix.byte;
+        memset(&ctx->output[offset], 0, padding);
+        offset += padding;
+        memcpy(&ctx->output[offset], src + header + oldPadding, typeSize);
+        offset += typeSize;
+
+        *srcSizeOut = header + oldPadding + typeSize;
+        return offset - fieldOffset;
+    }
+
+    EXIB_ObjectPrefix objectPrefix = { .byte = src[header] };
+    size_t sizeBytes = objectPrefix.size ? 4 : 2;
+    size_t innerSize = objectPrefix.size
+        ? *(const uint32_t*)(src + header + 1)
+        : *(const uint16_t*)(src + header + 1);
+    const uint8_t* data = src + header + 1 + sizeBytes + oldPadding;
+
+    *srcSizeOut = (data - src) + innerSize;
+
+    if (prefix.type == EXIB_TYPE_ARRAY && objectPrefix.arrayType < EXIB_TYPE_ARRAY)
+    {
+        int alignment = objectPrefix.packing ? 8 : EXIB_GetTypeSize(objectPrefix.arrayType);
+        int padding;
+
+        offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, innerSize, offset);
+        padding = (alignment > 1) ? EXIB_ENC_Padding(offset, alignment) : 0;
+
+        prefix.padding = padding;
+        ctx->output[fieldOffset] = prefix.byte;
+        memset(&ctx->output[offset], 0, padding);
+        offset += padding;
+        memcpy(&ctx->output[offset], data, innerSize);
+        offset += innerSize;
+
+        return offset - fieldOffset;
+    }
+
+    // Move the children of an aggregate one by one, then fill in the new size.
+    size_t prefixOffset = offset;
+    size_t innerOffset = offset + 1 + sizeBytes;
+
+    offset = innerOffset;
+    for (size_t i = 0; i < innerSize;)
+    {
+        size_t childSize;
+        offset += EXIB_ENC_StreamMoveField(ctx, data + i, offset, &childSize);
+        i += childSize;
+    }
+
+    EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, offset - innerOffset, prefixOffset);
+
+    return offset - fieldOffset;
+}
+
+/**
+ * Move an open aggregate and everything written after it to a new offset.
+ * @param ctx Encoder context.
+ * @param level Index of the open aggregate.
+ * @param src Copy of the stream starting at the aggregate's field prefix.
+ * @param srcOffset Datum offset that `src` was copied from.
+ * @param srcEnd Datum offset of the end of the copied data.
+ * @param offset Datum offset to move the aggregate to.
+ * @return New end of the stream.
+ */
+static size_t EXIB_ENC_StreamMoveLevel(EXIB_ENC_Context* ctx,
+                                       int level,
+                                       const uint8_t* src,
+                                       size_t srcOffset,
+                                       size_t srcEnd,
+                                       size_t offset)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+    EXIB_ENC_StreamLevel* l = &stream->levels[level];
+    const uint8_t* field = src + (l->fieldOffset - srcOffset);
+    EXIB_FieldPrefix prefix = { .byte = field[0] };
+    size_t header = 1 + (prefix.named ? sizeof(exib_string_t) : 0);
+    EXIB_ObjectPrefix objectPrefix = { .byte = field[header] };
+
+    // Closed children end where the next open aggregate begins.
+    size_t childEnd = (level + 1 < stream->depth) ? stream->levels[level + 1].fieldOffset : srcEnd;
+    size_t childOffset = l->dataOffset;
+
+    // Size is filled in once the aggregate is closed.
+    objectPrefix.size = l->wideSize;
+    memcpy(&ctx->output[offset], field, header);
+    l->fieldOffset = offset;
+    offset += header;
+    offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, 0, offset);
+    l->dataOffset = offset;
+
+    while (childOffset < childEnd)
+    {
+        size_t childSize;
+        offset += EXIB_ENC_StreamMoveField(ctx, src + (childOffset - srcOffset), offset, &childSize);
+        childOffset += childSize;
+    }
+
+    if (level + 1 < stream->depth)
+        offset = EXIB_ENC_StreamMoveLevel(ctx, level + 1, src, srcOffset, srcEnd, offset);
+
+    return offset;
+}
+
+// Switch an open aggregate over to a Size32.
+static int EXIB_ENC_StreamPromote(EXIB_ENC_Context* ctx, int level)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+    EXIB_ENC_StreamLevel* l = &stream->levels[level];
+    size_t length = stream->offset - l->fieldOffset;
+
+    if (length > stream->scratchSize)
+    {
+        uint8_t* scratch = EXIB_Alloc(length);
+        if (!scratch)
+            return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfMemory);
+
+        if (stream->scratch)
+            EXIB_Free(stream->scratch);
+        stream->scratch = scratch;
+        stream->scratchSize = length;
+    }
+
+    // The bound covers everything the aggregate may grow to after moving.
+    if (EXIB_ENC_ReserveBuffer(ctx, l->fieldOffset + EXIB_ENC_AggregateHeaderSize(&ctx->rootObject.field, 1)
+                                   + sizeof(exib_string_t) + l->bound, stream->offset))
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfMemory);
+    ctx->output = ctx->encodeBuffer;
+
+    memcpy(stream->scratch, &ctx->output[l->fieldOffset], length);
+    stream->offset = EXIB_ENC_StreamMoveLevel(ctx, level, stream->scratch,
+                                              l->fieldOffset, stream->offset, l->fieldOffset);
+    return 0;
+}
+
+/**
+ * Account for a new child of the innermost aggregate, whose upper bound is
+ * `bytes`, and promote any aggregate that outgrows its Size16.
+ */
+static int EXIB_ENC_StreamGrow(EXIB_ENC_Context* ctx, size_t bytes)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+
+    for (int i = 0; i < stream->depth; ++i)
+        stream->levels[i].bound += bytes;
+
+    // Outer aggregates are always promoted first, the inner ones move along with them.
+    for (int i = 0; i < stream->depth; ++i)
+    {
+        EXIB_ENC_StreamLevel* l = &stream->levels[i];
+
+        if (l->wideSize || l->bound <= UINT16_MAX)
+            continue;
+
+        l->wideSize = 1;
+        for (int j = 0; j < i; ++j)
+            stream->levels[j].bound += 2;
+
+        if (EXIB_ENC_StreamPromote(ctx, i))
+            return 1;
+    }
+
+    return 0;
+}
+
+// Look up the name of a new field, and make sure it fits into the current aggregate.
+static int EXIB_ENC_StreamPrepareField(EXIB_ENC_Context* ctx, EXIB_ENC_Field* field, const char* name, EXIB_Type type)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+    EXIB_ENC_StreamLevel* parent;
+
+    if (!stream || stream->depth == 0)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    // Arrays only hold unnamed elements of their own element type.
+    parent = &stream->levels[stream->depth - 1];
+    if (parent->elementType != EXIB_TYPE_NULL && (parent->elementType != type || name != NULL))
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    memset(field, 0, sizeof(EXIB_ENC_Field));
+    field->type = type;
+    field->nameOffset = EXIB_INVALID_STRING;
+
+    if (name != NULL)
+    {
+        EXIB_ENC_StringEntry* nameEntry = EXIB_ENC_GetStringEntry(ctx, name);
+        if (!nameEntry)
+            return 1;
+
+        field->nameOffset = nameEntry->offset;
+        field->nameBuffer = nameEntry->buffer;
+    }
+
+    return 0;
+}
+
+static int EXIB_ENC_StreamBeginAggregate(EXIB_ENC_Context* ctx, EXIB_ENC_Field* field)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+    size_t header = EXIB_ENC_AggregateHeaderSize(field, 0);
+
+    if (stream->depth == EXIB_ENC_STREAM_DEPTH)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    if (EXIB_ENC_StreamGrow(ctx, header) || EXIB_ENC_StreamReserve(ctx, header))
+        return 1;
+
+    EXIB_ObjectPrefix objectPrefix = {
+        .arrayType = (field->type == EXIB_TYPE_ARRAY) ? field->elementType : 0,
+        .size = 0
+    };
+
+    EXIB_ENC_StreamLevel* l = &stream->levels[stream->depth++];
+    l->fieldOffset = stream->offset;
+    l->bound = 0;
+    l->elementType = (field->type == EXIB_TYPE_ARRAY) ? field->elementType : EXIB_TYPE_NULL;
+    l->wideSize = 0;
+
+    // Size is filled in once the aggregate is closed.
+    stream->offset += EXIB_ENC_EncodeField(ctx, field, stream->offset);
+    stream->offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, 0, stream->offset);
+    l->dataOffset = stream->offset;
+
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return 0;
+}
+
+static int EXIB_ENC_StreamEndAggregate(EXIB_ENC_Context* ctx, EXIB_Type type, int minDepth)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+
+    if (!stream || stream->depth <= minDepth)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    EXIB_ENC_StreamLevel* l = &stream->levels[stream->depth - 1];
+    size_t sizeBytes = l->wideSize ? 4 : 2;
+    EXIB_ObjectPrefix objectPrefix = { .byte = ctx->output[l->dataOffset - sizeBytes - 1] };
+
+    if ((type == EXIB_TYPE_OBJECT) != (l->elementType == EXIB_TYPE_NULL))
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, stream->offset - l->dataOffset,
+                                l->dataOffset - sizeBytes - 1);
+    --stream->depth;
+
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return 0;
+}
+
+int EXIB_ENC_BeginStream(EXIB_ENC_Context* ctx)
+{
+    if (!ctx->stream)
+    {
+        ctx->stream = EXIB_New(EXIB_ENC_Stream);
+        if (!ctx->stream)
+            return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfMemory);
+    }
+
+    ctx->stream->depth = 0;
+    ctx->stream->offset = sizeof(EXIB_Header);
+    ctx->outputBase = 0;
+
+    // Blobs belong to the tree, streamed datums have no blob table.
+    ctx->blobTableOffset = 0;
+    if (EXIB_ENC_StreamReserve(ctx, sizeof(EXIB_ExtHeader)))
+        return 1;
+
+    // Only needed for the dictionary's ID.
+    ctx->stream->offset += EXIB_ENC_EncodeExtendedHeader(ctx, ctx->stream->offset);
+
+    EXIB_ENC_Field root = {
+        .type = EXIB_TYPE_OBJECT,
+        .nameOffset = ctx->rootObject.field.nameOffset
+    };
+    return EXIB_ENC_StreamBeginAggregate(ctx, &root);
+}
+
+EXIB_Header* EXIB_ENC_EndStream(EXIB_ENC_Context* ctx)
+{
+    EXIB_ENC_Stream* stream = ctx->stream;
+
+    if (!stream || stream->depth != 1)
+    {
+        EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+        return NULL;
+    }
+
+    if (EXIB_ENC_StreamEndAggregate(ctx, EXIB_TYPE_OBJECT, 0))
+        return NULL;
+
+    if (stream->offset + ctx->stringOffset > UINT32_MAX)
+    {
+        EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfBounds);
+        return NULL;
+    }
+
+    if (EXIB_ENC_StreamReserve(ctx, ctx->stringOffset))
+        return NULL;
+
+    size_t stringTableSize = EXIB_ENC_EncodeStringTable(ctx, stream->offset);
+    return EXIB_ENC_EncodeHeader(ctx, stream->offset + stringTableSize, stringTableSize);
+}
+
+int EXIB_ENC_BeginObject(EXIB_ENC_Context* ctx, const char* name)
+{
+    EXIB_ENC_Field field;
+
+    if (EXIB_ENC_StreamPrepareField(ctx, &field, name, EXIB_TYPE_OBJECT))
+        return 1;
+
+    return EXIB_ENC_StreamBeginAggregate(ctx, &field);
+}
+
+int EXIB_ENC_EndObject(EXIB_ENC_Context* ctx)
+{
+    // The root object is closed by EXIB_ENC_EndStream.
+    return EXIB_ENC_StreamEndAggregate(ctx, EXIB_TYPE_OBJECT, 1);
+}
+
+int EXIB_ENC_BeginArray(EXIB_ENC_Context* ctx, const char* name, EXIB_Type elementType)
+{
+    EXIB_ENC_Field field;
+
+    if (elementType != EXIB_TYPE_OBJECT && elementType != EXIB_TYPE_ARRAY)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    if (EXIB_ENC_StreamPrepareField(ctx, &field, name, EXIB_TYPE_ARRAY))
+        return 1;
+
+    field.elementType = elementType;
+    return EXIB_ENC_StreamBeginAggregate(ctx, &field);
+}
+
+int EXIB_ENC_EndArray(EXIB_ENC_Context* ctx)
+{
+    return EXIB_ENC_StreamEndAggregate(ctx, EXIB_TYPE_ARRAY, 1);
+}
+
+int EXIB_ENC_WriteValue(EXIB_ENC_Context* ctx, const char* name, EXIB_Type type, EXIB_Value value)
+{
+    EXIB_ENC_Field field;
+
+    if (type < EXIB_TYPE_INT8 || type > EXIB_TYPE_DOUBLE)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    if (EXIB_ENC_StreamPrepareField(ctx, &field, name, type))
+        return 1;
+
+    field.value = value;
+
+    size_t bound = EXIB_ENC_ValueBound(&field);
+    if (EXIB_ENC_StreamGrow(ctx, bound) || EXIB_ENC_StreamReserve(ctx, bound))
+        return 1;
+
+    ctx->stream->offset += EXIB_ENC_EncodeField(ctx, &field, ctx->stream->offset);
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return 0;
+}
+
+// Write an array of values, borrowing `data` for the duration of the call.
+static int EXIB_ENC_StreamWriteArray(EXIB_ENC_Context* ctx,
+                                     const char* name,
+                                     EXIB_Type elementType,
+                                     const void* data,
+                                     size_t count,
+                                     int isString)
+{
+    EXIB_ENC_Array array = { 0 };
+
+    if (elementType < EXIB_TYPE_INT8 || elementType > EXIB_TYPE_DOUBLE)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    if (count > UINT32_MAX)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_OutOfBounds);
+
+    if (EXIB_ENC_StreamPrepareField(ctx, &array.object.field, name, EXIB_TYPE_ARRAY))
+        return 1;
+
+    array.object.field.elementType = elementType;
+    array.elementCount = count;
+    array.elementCapacity = count;
+    array.isString = isString;
+    array.valueElements = (EXIB_Value*)data;
+
+    size_t bound = EXIB_ENC_ArrayBound(&array);
+    if (EXIB_ENC_StreamGrow(ctx, bound) || EXIB_ENC_StreamReserve(ctx, bound))
+        return 1;
+
+    ctx->stream->offset += EXIB_ENC_EncodeArray(ctx, &array, ctx->stream->offset);
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return 0;
+}
+
+int EXIB_ENC_WriteArray(EXIB_ENC_Context* ctx,
+                        const char* name,
+                        EXIB_Type elementType,
+                        const void* data,
+                        size_t count)
+{
+    return EXIB_ENC_StreamWriteArray(ctx, name, elementType, data, count, 0);
+}
+
+int EXIB_ENC_WriteString(EXIB_ENC_Context* ctx, const char* name, EXIB_Type charType, const void* str)
+{
+    // Reject non-integer types.
+    if (charType < EXIB_TYPE_INT8 || charType > EXIB_TYPE_UINT64)
+        return EXIB_ENC_StreamError(ctx, EXIB_ENC_ERR_StreamState);
+
+    // Strings include their terminator.
+    size_t length = EXIB_ENC_StringLength(str, EXIB_GetTypeSize(charType));
+    return EXIB_ENC_StreamWriteArray(ctx, name, charType, str, length + 1, 1);
+}
@@ -4,17 +4,51 @@
 #include <EXIB/Encoder.h>
 #include "EncoderInternal.h"
 
+size_t EXIB_ENC_StringLength(const void* str, int charSize)
+{
+    size_t length = 0;
+    const void* ptr = str;
+    while (1)
+    {
+        int n = 0;
+        switch (charSize)
+        {
+            case 1:
+                n = (*(const uint8_t*)ptr) == 0;
+                break;
+            case 2:
+                n = (*(const uint16_t*)ptr) == 0;
+                break;
+            case 4:
+                n = (*(const uint32_t*)ptr) == 0;
+                break;
+            case 8:
+                n = (*(const uint64_t*)ptr) == 0;
+                break;
+            default:
+                break;
+        }
+        ptr += charSize;
+        if (n)
+            break;
+        ++length;
+    }
+
+    return length;
+}
+
 int EXIB_ENC_InitializeString(EXIB_ENC_Context* ctx,
                               EXIB_ENC_String* string,
                               EXIB_ENC_Object* parent,
-                              const char* name,
+                              const EXIB_ENC_StringEntry* nameEntry,
                               EXIB_Type type)
 {
     EXIB_ENC_Field* field = &string->array.object.field;
-    EXIB_ENC_InitializeField(ctx, field, parent, name,
+    EXIB_ENC_InitializeField(ctx, field, parent, nameEntry,
                              EXIB_TYPE_ARRAY);
 
     field->elementType = type;
+    string->array.ctx = ctx;
 
     if (EXIB_ENC_ArrayReserve(&string->array, 0))
         return 1;
@@ -22,11 +56,11 @@ int EXIB_ENC_InitializeString(EXIB_ENC_Context* ctx,
     return 0;
 }
 
-EXIB_ENC_String* EXIB_ENC_AddString(EXIB_ENC_Context* ctx,
-                                   EXIB_ENC_Object* parent,
-                                   const char* name,
-                                   EXIB_Type charType,
-                                   void* str)
+static EXIB_ENC_String* EXIB_ENC_AddStringEntry(EXIB_ENC_Context* ctx,
+                                                EXIB_ENC_Object* parent,
+                                                const EXIB_ENC_StringEntry* name,
+                                                EXIB_Type charType,
+                                                void* str)
 {
     int charSize = EXIB_GetTypeSize(charType);
     EXIB_ENC_String* string;
@@ -37,41 +71,16 @@ EXIB_ENC_String* EXIB_ENC_AddString(EXIB_ENC_Context* ctx,
 
     // Allocate an array and initialize it as a string.
     // Doesn't allocate any memory for the array elements just yet.
-    string = EXIB_New(EXIB_ENC_String);
+    string = EXIB_ArenaAlloc(&ctx->arena, sizeof(EXIB_ENC_String), sizeof(void*));
+    if (!string)
+        return NULL;
+
+    memset(string, 0, sizeof(EXIB_ENC_String));
     if (EXIB_ENC_InitializeString(ctx, string, parent, name, charType) != 0)
-    {
-        EXIB_Free(string);
         return NULL;
-    }
 
     // Get length of string.
-    size_t length = 0;
-    void* ptr = str;
-    while (1)
-    {
-        int n = 0;
-        switch (charSize)
-        {
-            case 1:
-                n = (*(uint8_t*)ptr) == 0;
-                break;
-            case 2:
-                n = (*(uint16_t*)ptr) == 0;
-                break;
-            case 4:
-                n = (*(uint32_t*)ptr) == 0;
-                break;
-            case 8:
-                n = (*(uint64_t*)ptr) == 0;
-                break;
-            default:
-                break;
-        }
-        ptr += charSize;
-        if (n)
-            break;
-        ++length;
-    }
+    size_t length = EXIB_ENC_StringLength(str, charSize);
 
     // Allocate elements and copy string over.
     EXIB_ENC_ArrayResize(&string->array, length + 1);
@@ -82,3 +91,29 @@ EXIB_ENC_String* EXIB_ENC_AddString(EXIB_ENC_Context* ctx,
 
     return string;
 }
+
+EXIB_ENC_String* EXIB_ENC_AddString(EXIB_ENC_Context* ctx,
+                                   EXIB_ENC_Object* parent,
+                                   const char* name,
+                                   EXIB_Type charType,
+                                   void* str)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetNameEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddStringEntry(ctx, parent, nameEntry, charType, str);
+}
+
+EXIB_ENC_String* EXIB_ENC_AddStringInterned(EXIB_ENC_Context* ctx,
+                                           EXIB_ENC_Object* parent,
+                                           EXIB_ENC_Name name,
+                                           EXIB_Type charType,
+                                           void* str)
+{
+    EXIB_ENC_StringEntry* nameEntry;
+    if (EXIB_ENC_GetInternedEntry(ctx, name, &nameEntry))
+        return NULL;
+
+    return EXIB_ENC_AddStringEntry(ctx, parent, nameEntry, charType, str);
+}
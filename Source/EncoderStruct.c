@@ -0,0 +1,384 @@
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
+#include "AllocatorInternal.h"
+#include "EncoderInternal.h"
+
+/*
+ * A binding table is compiled into a struct type the first time it's added.
+ * Each member always has a name, a type and a size, so everything the layout
+ * passes need is known up front: the bound of the whole struct, and its exact
+ * size for every alignment it can start at. Objects added with the table only
+ * point at the type and the struct, and cost the same to lay out as a field.
+ *
+ * Member names go into the string table the first time a datum adds the type,
+ * in the order the members are written, like adding them one by one would.
+ * Their offsets stay valid until the string cache is cleared.
+ */
+
+// Deepest nesting of struct tables, which also stops tables that contain themselves.
+#define EXIB_ENC_STRUCT_DEPTH 32
+
+// Size of a field prefix and, if the member is named, its name.
+static inline size_t EXIB_ENC_MemberHeaderSize(const EXIB_ENC_StructMember* member)
+{
+    return 1 + ((member->nameOffset != EXIB_INVALID_STRING) ? sizeof(exib_string_t) : 0);
+}
+
+// Size of an object prefix and its Size16/Size32.
+static inline size_t EXIB_ENC_SizeFieldSize(int wideSize)
+{
+    return 1 + (wideSize ? 4 : 2);
+}
+
+/**
+ * Get the encoded size of a member, like the second layout pass would.
+ * @param binding Binding of the member.
+ * @param member Compiled member.
+ * @param offset Datum offset the member is encoded at.
+ * @return Encoded size of the member in bytes.
+ */
+static size_t EXIB_ENC_MemberSize(const EXIB_ENC_Binding* binding, const EXIB_ENC_StructMember* member, size_t offset)
+{
+    size_t fieldOffset = offset;
+
+    offset += EXIB_ENC_MemberHeaderSize(member);
+
+    if (binding->type == EXIB_TYPE_OBJECT)
+    {
+        offset += EXIB_ENC_SizeFieldSize(member->wideSize);
+        offset += member->type->sizes[offset % 8];
+    }
+    else if (binding->type == EXIB_TYPE_ARRAY && binding->elementType == EXIB_TYPE_OBJECT)
+    {
+        offset += EXIB_ENC_SizeFieldSize(member->wideSize);
+        offset += member->sizes[offset % 8];
+    }
+    else if (binding->type == EXIB_TYPE_ARRAY)
+    {
+        int typeSize = EXIB_GetTypeSize(binding->elementType);
+
+        offset += EXIB_ENC_SizeFieldSize(member->wideSize);
+        if (typeSize > 1)
+            offset += EXIB_ENC_Padding(offset, typeSize);
+        offset += typeSize * binding->count;
+    }
+    else
+    {
+        int typeSize = EXIB_GetTypeSize(binding->type);
+        offset += EXIB_ENC_Padding(offset, typeSize) + typeSize;
+    }
+
+    return offset - fieldOffset;
+}
+
+/**
+ * Get the upper bound of the encoded size of a member, like the first layout pass would,
+ * and decide whether it uses a Size32 if it's an aggregate.
+ * @param binding Binding of the member.
+ * @param member Compiled member, whose wideSize is set.
+ * @return Upper bound of the member's encoded size in bytes.
+ */
+static size_t EXIB_ENC_MemberBound(const EXIB_ENC_Binding* binding, EXIB_ENC_StructMember* member)
+{
+    size_t headerSize = EXIB_ENC_MemberHeaderSize(member);
+
+    if (binding->type == EXIB_TYPE_OBJECT)
+    {
+        member->wideSize = member->type->wideSize;
+        return headerSize + EXIB_ENC_SizeFieldSize(member->wideSize) + member->type->bound;
+    }
+    else if (binding->type == EXIB_TYPE_ARRAY && binding->elementType == EXIB_TYPE_OBJECT)
+    {
+        // Elements are unnamed objects.
+        const EXIB_ENC_StructType* type = member->type;
+        size_t innerBound = (1 + EXIB_ENC_SizeFieldSize(type->wideSize) + type->bound) * binding->count;
+
+        member->wideSize = innerBound > UINT16_MAX;
+        return headerSize + EXIB_ENC_SizeFieldSize(member->wideSize) + innerBound;
+    }
+    else if (binding->type == EXIB_TYPE_ARRAY)
+    {
+        int typeSize = EXIB_GetTypeSize(binding->elementType);
+        size_t dataSize = typeSize * binding->count;
+
+        member->wideSize = dataSize > UINT16_MAX;
+        return headerSize + EXIB_ENC_SizeFieldSize(member->wideSize) + EXIB_ENC_MaxPadding(typeSize) + dataSize;
+    }
+
+    return headerSize + EXIB_ENC_MaxPadding(EXIB_GetTypeSize(binding->type)) + EXIB_GetTypeSize(binding->type);
+}
+
+// Check the parts of a binding that don't depend on the nested table.
+static int EXIB_ENC_IsValidBinding(const EXIB_ENC_Binding* binding)
+{
+    if (binding->type == EXIB_TYPE_OBJECT)
+        return binding->members != NULL;
+
+    if (binding->type == EXIB_TYPE_ARRAY)
+    {
+        if (binding->count > UINT32_MAX)
+            return 0;
+        if (binding->elementType == EXIB_TYPE_OBJECT)
+            return binding->members != NULL && binding->stride > 0;
+        return binding->elementType >= EXIB_TYPE_INT8 && binding->elementType <= EXIB_TYPE_DOUBLE;
+    }
+
+    return binding->type >= EXIB_TYPE_INT8 && binding->type <= EXIB_TYPE_DOUBLE;
+}
+
+/**
+ * Get the compiled type of a binding table, compiling it and its nested tables if necessary.
+ * @param ctx Encoder context.
+ * @param table Binding table.
+ * @param count Number of members.
+ * @param depth Number of tables this one is nested in.
+ * @return Compiled type, or NULL if an error occurred.
+ */
+static EXIB_ENC_StructType* EXIB_ENC_CompileStruct(EXIB_ENC_Context* ctx,
+                                                   const EXIB_ENC_Binding* table,
+                                                   size_t count,
+                                                   int depth)
+{
+    EXIB_ENC_StructType* type;
+
+    for (type = ctx->structTypes; type != NULL; type = type->next)
+    {
+        if (type->table == table && type->count == count)
+            return type;
+    }
+
+    if (depth >= EXIB_ENC_STRUCT_DEPTH)
+    {
+        ctx->lastError = EXIB_ENC_ERR_InvalidBinding;
+        return NULL;
+    }
+
+    type = EXIB_ArenaAlloc(&ctx->internArena, sizeof(EXIB_ENC_StructType), sizeof(void*));
+    if (type)
+        type->members = count ? EXIB_ArenaAlloc(&ctx->internArena, count * sizeof(EXIB_ENC_StructMember), sizeof(void*)) : NULL;
+
+    if (!type || (count && !type->members))
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+
+    type->table = table;
+    type->count = count;
+    type->bound = 0;
+    type->nameGeneration = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const EXIB_ENC_Binding* binding = &table[i];
+        EXIB_ENC_StructMember* member = &type->members[i];
+
+        memset(member, 0, sizeof(EXIB_ENC_StructMember));
+
+        if (!EXIB_ENC_IsValidBinding(binding))
+        {
+            ctx->lastError = EXIB_ENC_ERR_InvalidBinding;
+            return NULL;
+        }
+
+        // Any valid offset until the names are added, only whether there is one matters for the sizes.
+        member->nameOffset = binding->name ? 0 : EXIB_INVALID_STRING;
+
+        if (binding->members)
+        {
+            member->type = EXIB_ENC_CompileStruct(ctx, binding->members, binding->memberCount, depth + 1);
+            if (!member->type)
+                return NULL;
+        }
+
+        type->bound += EXIB_ENC_MemberBound(binding, member);
+
+        // Each element starts where the one before it ends, so the sizes are added up one element at a time.
+        if (binding->type == EXIB_TYPE_ARRAY && binding->elementType == EXIB_TYPE_OBJECT)
+        {
+            for (size_t start = 0; start < 8; ++start)
+            {
+                size_t offset = start;
+
+                for (size_t e = 0; e < binding->count; ++e)
+                {
+                    offset += 1 + EXIB_ENC_SizeFieldSize(member->type->wideSize);
+                    offset += member->type->sizes[offset % 8];
+                }
+
+                member->sizes[start] = offset - start;
+            }
+        }
+    }
+
+    type->wideSize = type->bound > UINT16_MAX;
+
+    for (size_t start = 0; start < 8; ++start)
+    {
+        size_t offset = start;
+
+        for (size_t i = 0; i < count; ++i)
+            offset += EXIB_ENC_MemberSize(&table[i], &type->members[i], offset);
+
+        type->sizes[start] = offset - start;
+    }
+
+    // Nested types are already in the list, so the list is in the order the types were compiled.
+    type->next = ctx->structTypes;
+    ctx->structTypes = type;
+    return type;
+}
+
+/**
+ * Add the member names of a struct type to the string cache, unless they already are.
+ * Nested types are visited where their members are written, and not at all under
+ * arrays without elements, so the names end up in the order the tree would add them.
+ * @param ctx Encoder context.
+ * @param type Compiled struct type.
+ * @return 0 on success, 1 if the string table is full or out of memory.
+ */
+static int EXIB_ENC_AddStructNames(EXIB_ENC_Context* ctx, EXIB_ENC_StructType* type)
+{
+    if (type->nameGeneration == ctx->stringGeneration)
+        return 0;
+
+    for (size_t i = 0; i < type->count; ++i)
+    {
+        const EXIB_ENC_Binding* binding = &type->table[i];
+        EXIB_ENC_StructMember* member = &type->members[i];
+
+        if (binding->name)
+        {
+            EXIB_ENC_StringEntry* entry = EXIB_ENC_GetStringEntry(ctx, binding->name);
+            if (!entry)
+                return 1;
+            member->nameOffset = entry->offset;
+        }
+
+        if (member->type && (binding->type == EXIB_TYPE_OBJECT || binding->count > 0)
+            && EXIB_ENC_AddStructNames(ctx, (EXIB_ENC_StructType*)member->type))
+            return 1;
+    }
+
+    type->nameGeneration = ctx->stringGeneration;
+    return 0;
+}
+
+EXIB_ENC_Object* EXIB_ENC_AddStruct(EXIB_ENC_Context* ctx,
+                                    EXIB_ENC_Object* parent,
+                                    const char* name,
+                                    const EXIB_ENC_Binding* table,
+                                    size_t count,
+                                    const void* src)
+{
+    EXIB_ENC_StructType* type = EXIB_ENC_CompileStruct(ctx, table, count, 0);
+    EXIB_ENC_Object* object;
+
+    if (!type)
+        return NULL;
+
+    object = EXIB_ENC_AddObject(ctx, parent, name);
+    if (!object || EXIB_ENC_AddStructNames(ctx, type))
+        return NULL;
+
+    object->structType = type;
+    object->structData = src;
+    return object;
+}
+
+void EXIB_ENC_StructSetData(EXIB_ENC_Object* object, const void* src)
+{
+    object->structData = src;
+}
+
+/**
+ * Write the field prefix, name and object prefix of an aggregate member.
+ * @param ctx Encoder context.
+ * @param field Field with the type and name of the member.
+ * @param objectPrefix Object prefix of the member.
+ * @param innerSizes Inner size of the member for each alignment it can start at.
+ * @param offset Datum offset to write at.
+ * @return Number of bytes written.
+ */
+static size_t EXIB_ENC_EncodeMemberHeader(EXIB_ENC_Context* ctx,
+                                          EXIB_ENC_Field* field,
+                                          EXIB_ObjectPrefix objectPrefix,
+                                          const size_t* innerSizes,
+                                          size_t offset)
+{
+    size_t fieldOffset = offset;
+
+    offset += EXIB_ENC_EncodeField(ctx, field, offset);
+    offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, innerSizes[(offset + EXIB_ENC_SizeFieldSize(objectPrefix.size)) % 8], offset);
+
+    return offset - fieldOffset;
+}
+
+size_t EXIB_ENC_EncodeStructMembers(EXIB_ENC_Context* ctx, const EXIB_ENC_StructType* type, const void* data, size_t offset)
+{
+    size_t startOffset = offset;
+
+    for (size_t i = 0; i < type->count; ++i)
+    {
+        const EXIB_ENC_Binding* binding = &type->table[i];
+        const EXIB_ENC_StructMember* member = &type->members[i];
+        const uint8_t* src = (const uint8_t*)data + binding->offset;
+        EXIB_ENC_Field field;
+
+        // Only what EXIB_ENC_EncodeField reads.
+        field.type = binding->type;
+        field.nameOffset = member->nameOffset;
+
+        if (binding->type == EXIB_TYPE_OBJECT)
+        {
+            EXIB_ObjectPrefix objectPrefix = { .size = member->wideSize };
+
+            offset += EXIB_ENC_EncodeMemberHeader(ctx, &field, objectPrefix, member->type->sizes, offset);
+            offset += EXIB_ENC_EncodeStructMembers(ctx, member->type, src, offset);
+        }
+        else if (binding->type == EXIB_TYPE_ARRAY && binding->elementType == EXIB_TYPE_OBJECT)
+        {
+            const EXIB_ENC_StructType* elementType = member->type;
+            EXIB_ObjectPrefix objectPrefix = { .arrayType = EXIB_TYPE_OBJECT, .size = member->wideSize };
+            EXIB_ObjectPrefix elementPrefix = { .size = elementType->wideSize };
+            EXIB_ENC_Field element = { .type = EXIB_TYPE_OBJECT, .nameOffset = EXIB_INVALID_STRING };
+
+            offset += EXIB_ENC_EncodeMemberHeader(ctx, &field, objectPrefix, member->sizes, offset);
+
+            for (size_t e = 0; e < binding->count; ++e)
+            {
+                offset += EXIB_ENC_EncodeMemberHeader(ctx, &element, elementPrefix, elementType->sizes, offset);
+                offset += EXIB_ENC_EncodeStructMembers(ctx, elementType, src + e * binding->stride, offset);
+            }
+        }
+        else if (binding->type == EXIB_TYPE_ARRAY)
+        {
+            EXIB_FieldPrefix* fieldPrefix = (EXIB_FieldPrefix*)&ctx->output[offset - ctx->outputBase];
+            int typeSize = EXIB_GetTypeSize(binding->elementType);
+            size_t dataSize = typeSize * binding->count;
+            EXIB_ObjectPrefix objectPrefix = { .arrayType = binding->elementType, .size = member->wideSize };
+
+            offset += EXIB_ENC_EncodeField(ctx, &field, offset);
+            offset += EXIB_ENC_EncodeObjectPrefix(ctx, objectPrefix, dataSize, offset);
+
+            if (typeSize > 1)
+            {
+                int padding = EXIB_ENC_Padding(offset, typeSize);
+                memset(&ctx->output[offset - ctx->outputBase], 0, padding);
+                offset += padding;
+                fieldPrefix->padding = padding;
+            }
+
+            memcpy(&ctx->output[offset - ctx->outputBase], src, dataSize);
+            offset += dataSize;
+        }
+        else
+        {
+            memcpy(&field.value, src, EXIB_GetTypeSize(binding->type));
+            offset += EXIB_ENC_EncodeField(ctx, &field, offset);
+        }
+    }
+
+    return offset - startOffset;
+}
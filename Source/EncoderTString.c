@@ -2,123 +2,344 @@
 #include <string.h>
 #include <EXIB/EXIB.h>
 #include <EXIB/Encoder.h>
+#include "DictionaryInternal.h"
 #include "EncoderInternal.h"
 
 /*
  * TStrings (table strings) are stored in the string table,
  * and are only used for field names.
+ *
+ * Cache entries are kept in the order they were added, which is also the
+ * order of the string table. They are found through an open addressing
+ * hash table with linear probing, which holds indices into the entries.
+ *
+ * Names in the dictionary option are found in the dictionary first, and never
+ * make it into the cache. Its entries are shared, so they're never written to.
  */
 
-static EXIB_ENC_StringEntry* EXIB_ENC_AddTString(EXIB_ENC_Context* ctx, const char* str, uint32_t hash, uint32_t length);
-static EXIB_ENC_StringEntry* EXIB_ENC_FindTString(EXIB_ENC_Context* ctx, uint32_t hash);
-static int EXIB_ENC_StringInsertionIndex(EXIB_ENC_Context* ctx, uint32_t hash);
-static void EXIB_ENC_ExpandStringCache(EXIB_ENC_Context* ctx, int newCapacity);
+#define EXIB_ENC_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+static EXIB_ENC_StringEntry* EXIB_ENC_AddTString(EXIB_ENC_Context* ctx, const char* str, uint32_t hash, uint32_t length, uint32_t slot);
+static int EXIB_ENC_ExpandStringCache(EXIB_ENC_Context* ctx);
+static int EXIB_ENC_ExpandStringSlots(EXIB_ENC_Context* ctx);
+
+static inline int EXIB_ENC_IsDictionaryEntry(EXIB_ENC_Context* ctx, const EXIB_ENC_StringEntry* entry)
+{
+    const EXIB_Dictionary* dictionary = ctx->options.dictionary;
+    return dictionary && entry >= dictionary->entries && entry < dictionary->entries + dictionary->count;
+}
+
+// Eight bytes at a time. Never stored, so unlike EXIB_StringHashAndLength it doesn't need to be stable.
+uint32_t EXIB_ENC_HashString(const char* str, size_t length)
+{
+    uint64_t hash = length * EXIB_ENC_HASH_MULTIPLIER;
+    uint64_t word;
+    size_t i = 0;
+
+    for (; i + sizeof(word) <= length; i += sizeof(word))
+    {
+        memcpy(&word, str + i, sizeof(word));
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * EXIB_ENC_HASH_MULTIPLIER;
+    }
+
+    if (i < length)
+    {
+        word = 0;
+        memcpy(&word, str + i, length - i);
+        hash = (((hash << 5) | (hash >> 59)) ^ word) * EXIB_ENC_HASH_MULTIPLIER;
+    }
+
+    // The upper bits are mixed best, fold them into the lower ones that pick the slot.
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+int EXIB_ENC_InitializeStringCache(EXIB_ENC_Context* ctx, uint32_t capacity)
+{
+    uint32_t slots = 16;
+
+    if (capacity < 8)
+        capacity = 8;
+
+    // Keep the load factor at 50% or below.
+    while (slots < capacity * 2)
+        slots *= 2;
+
+    ctx->stringCache = EXIB_Alloc(capacity * sizeof(EXIB_ENC_StringEntry));
+    ctx->stringSlots = EXIB_Calloc(slots, sizeof(uint32_t));
+    ctx->stringCacheSize = 0;
+    ctx->stringCacheCapacity = capacity;
+    ctx->stringSlotMask = slots - 1;
+    ctx->stringGeneration = 1; // Struct types start out at 0, without any names.
+
+    if (!ctx->stringCache || !ctx->stringSlots)
+    {
+        EXIB_ENC_DestroyStringCache(ctx);
+        return 1;
+    }
+
+    return 0;
+}
+
+void EXIB_ENC_DestroyStringCache(EXIB_ENC_Context* ctx)
+{
+    if (ctx->stringCache)
+        EXIB_Free(ctx->stringCache);
+    if (ctx->stringSlots)
+        EXIB_Free(ctx->stringSlots);
+    if (ctx->internedNames)
+        EXIB_Free(ctx->internedNames);
+
+    ctx->stringCache = NULL;
+    ctx->stringSlots = NULL;
+    ctx->internedNames = NULL;
+    ctx->stringCacheSize = 0;
+    ctx->stringCacheCapacity = 0;
+    ctx->internedCount = 0;
+    ctx->internedCapacity = 0;
+}
 
 EXIB_ENC_StringEntry* EXIB_ENC_GetStringEntry(EXIB_ENC_Context* ctx, const char* str)
 {
-    uint32_t length;
-    uint32_t hash = EXIB_StringHashAndLength(str, &length);
+    uint32_t length = strlen(str);
+    uint32_t hash = EXIB_ENC_HashString(str, length);
+    uint32_t slot = hash & ctx->stringSlotMask;
 
-    EXIB_ENC_StringEntry* entry = EXIB_ENC_FindTString(ctx, hash);
-    if (!entry)
+    if (ctx->options.dictionary)
     {
-        entry = EXIB_ENC_AddTString(ctx, str, hash, length);
-        if (!entry)
-            return NULL;
+        const EXIB_ENC_StringEntry* shared = EXIB_FindDictionaryEntry(ctx->options.dictionary, str, hash, length);
+        if (shared)
+            return (EXIB_ENC_StringEntry*)shared;
     }
 
-    return entry;
+    while (ctx->stringSlots[slot] != 0)
+    {
+        EXIB_ENC_StringEntry* entry = &ctx->stringCache[ctx->stringSlots[slot] - 1];
+
+        if (entry->hash == hash
+            && entry->length == length
+            && memcmp(entry->buffer, str, length) == 0)
+            return entry;
+
+        slot = (slot + 1) & ctx->stringSlotMask;
+    }
+
+    return EXIB_ENC_AddTString(ctx, str, hash, length, slot);
 }
 
-static EXIB_ENC_StringEntry* EXIB_ENC_AddTString(EXIB_ENC_Context* ctx, const char* str, uint32_t hash, uint32_t length)
+void EXIB_ENC_ClearStringCache(EXIB_ENC_Context* ctx)
 {
-    EXIB_ENC_StringEntry* entry;
-    size_t entrySize = sizeof(EXIB_StringEntry) + length;
-    int i;
+    EXIB_ArenaReset(&ctx->nameArena);
+    memset(ctx->stringSlots, 0, (ctx->stringSlotMask + 1) * sizeof(uint32_t));
+    ctx->stringCacheSize = 0;
+    ctx->stringOffset = 0;
+    ++ctx->stringGeneration;
 
-    if (ctx->stringOffset >= (EXIB_INVALID_STRING - entrySize))
+    // Put interned names back at the start of the table, in the order they were interned.
+    // They fit, since they took up at most as much room before. The slots never need to grow either.
+    for (uint32_t i = 0; i < ctx->internedCount; ++i)
     {
-        ctx->lastError = EXIB_ENC_ERR_StringTableFull;
-        return NULL;
+        EXIB_ENC_InternedName* interned = &ctx->internedNames[i];
+        EXIB_ENC_StringEntry* entry = &ctx->stringCache[ctx->stringCacheSize];
+        uint32_t slot = interned->hash & ctx->stringSlotMask;
+
+        // Names from the dictionary aren't in the table to begin with.
+        if (interned->shared)
+            continue;
+
+        while (ctx->stringSlots[slot] != 0)
+            slot = (slot + 1) & ctx->stringSlotMask;
+
+        entry->hash = interned->hash;
+        entry->length = interned->length;
+        entry->offset = ctx->stringBase + ctx->stringOffset;
+        entry->buffer = (char*)interned->buffer;
+        interned->entry = ctx->stringCacheSize++;
+        ctx->stringSlots[slot] = ctx->stringCacheSize;
+
+        ctx->stringOffset += sizeof(EXIB_StringEntry) + interned->length;
     }
+}
+
+EXIB_ENC_Name EXIB_ENC_InternName(EXIB_ENC_Context* ctx, const char* name)
+{
+    EXIB_ENC_StringEntry* entry = EXIB_ENC_GetStringEntry(ctx, name);
+    const EXIB_ENC_StringEntry* shared;
+    EXIB_ENC_InternedName* interned;
+    uint32_t index;
+    char* buffer;
 
-    i = EXIB_ENC_StringInsertionIndex(ctx, hash);
+    if (!entry)
+        return EXIB_ENC_NO_NAME;
+
+    // Interning happens once per name at startup, a linear search is fine.
+    shared = EXIB_ENC_IsDictionaryEntry(ctx, entry) ? entry : NULL;
+    index = shared ? 0 : entry - ctx->stringCache;
+    for (uint32_t i = 0; i < ctx->internedCount; ++i)
+    {
+        EXIB_ENC_InternedName* other = &ctx->internedNames[i];
 
-    if ((ctx->stringCacheSize + 1) >= ctx->stringCacheCapacity)
-        EXIB_ENC_ExpandStringCache(ctx, ctx->stringCacheCapacity + 64);
+        if (other->shared == shared && (shared || other->entry == index))
+            return i;
+    }
 
-    if (i == ctx->stringCacheSize)
+    if (ctx->internedCount == ctx->internedCapacity)
     {
-        // Insert at the end of the list, no movement necessary.
-        entry = &ctx->stringCache[ctx->stringCacheSize++];
+        uint32_t newCapacity = ctx->internedCapacity ? ctx->internedCapacity * 2 : 32;
+        EXIB_ENC_InternedName* newNames = EXIB_Alloc(newCapacity * sizeof(EXIB_ENC_InternedName));
+
+        if (!newNames)
+        {
+            ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+            return EXIB_ENC_NO_NAME;
+        }
+
+        if (ctx->internedNames)
+        {
+            memcpy(newNames, ctx->internedNames, ctx->internedCount * sizeof(EXIB_ENC_InternedName));
+            EXIB_Free(ctx->internedNames);
+        }
+
+        ctx->internedNames = newNames;
+        ctx->internedCapacity = newCapacity;
     }
+
+    // The characters in the name arena don't survive a reset. Those of the dictionary do.
+    if (shared)
+        buffer = entry->buffer;
     else
     {
-        // Insert within the list, move the higher half up a slot.
-        memmove(&ctx->stringCache[i + 1], &ctx->stringCache[i],
-                sizeof(EXIB_ENC_StringEntry) * ((ctx->stringCacheSize++) - i));
-        entry = &ctx->stringCache[i];
+        buffer = EXIB_ArenaAlloc(&ctx->internArena, entry->length + 1, 1);
+        if (!buffer)
+        {
+            ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+            return EXIB_ENC_NO_NAME;
+        }
+        memcpy(buffer, entry->buffer, entry->length + 1);
+        entry->buffer = buffer;
     }
 
-    entry->hash = hash;
-    entry->length = length;
-    entry->offset = ctx->stringOffset;
-    entry->buffer = strdup(str);
+    interned = &ctx->internedNames[ctx->internedCount];
+    interned->shared = shared;
+    interned->entry = index;
+    interned->hash = entry->hash;
+    interned->length = entry->length;
+    interned->buffer = buffer;
 
-    ctx->stringOffset += entrySize;
-    ctx->lastError = EXIB_ENC_ERR_Success;
-    return entry;
+    return ctx->internedCount++;
 }
 
-static EXIB_ENC_StringEntry* EXIB_ENC_FindTString(EXIB_ENC_Context* ctx, uint32_t hash)
+int EXIB_ENC_GetInternedEntry(EXIB_ENC_Context* ctx, EXIB_ENC_Name name, EXIB_ENC_StringEntry** entryOut)
 {
-    int left = 0;
-    int right = ctx->stringCacheSize - 1;
-
-    while (left <= right)
+    if (name == EXIB_ENC_NO_NAME)
     {
-        int mid = (left + right) / 2;
-        EXIB_ENC_StringEntry* entry = &ctx->stringCache[mid];
+        *entryOut = NULL;
+        return 0;
+    }
 
-        if (hash == entry->hash)
-            return entry;
-        else if (hash < entry->hash)
-            right = mid - 1;
-        else
-            left = mid + 1;
+    if (name >= ctx->internedCount)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfBounds;
+        return 1;
     }
 
-    return NULL;
+    if (ctx->internedNames[name].shared)
+        *entryOut = (EXIB_ENC_StringEntry*)ctx->internedNames[name].shared;
+    else
+        *entryOut = &ctx->stringCache[ctx->internedNames[name].entry];
+    return 0;
 }
 
-static int EXIB_ENC_StringInsertionIndex(EXIB_ENC_Context* ctx, uint32_t hash)
+static EXIB_ENC_StringEntry* EXIB_ENC_AddTString(EXIB_ENC_Context* ctx, const char* str, uint32_t hash, uint32_t length, uint32_t slot)
 {
-    int left = 0;
-    int right = ctx->stringCacheSize - 1;
+    EXIB_ENC_StringEntry* entry;
+    size_t entrySize = sizeof(EXIB_StringEntry) + length;
+    char* buffer;
 
-    while (left <= right)
+    if (ctx->stringBase + ctx->stringOffset >= (EXIB_INVALID_STRING - entrySize))
     {
-        int mid = (left + right) / 2;
-        EXIB_ENC_StringEntry* entry = &ctx->stringCache[mid];
+        ctx->lastError = EXIB_ENC_ERR_StringTableFull;
+        return NULL;
+    }
 
-        if (hash < entry->hash)
-            right = mid - 1;
-        else
-            left = mid + 1;
+    if (ctx->stringCacheSize == ctx->stringCacheCapacity && EXIB_ENC_ExpandStringCache(ctx))
+        return NULL;
+
+    // The slot found by the lookup moves if the table has to grow.
+    if ((ctx->stringCacheSize + 1) * 2 > ctx->stringSlotMask + 1)
+    {
+        if (EXIB_ENC_ExpandStringSlots(ctx))
+            return NULL;
+
+        slot = hash & ctx->stringSlotMask;
+        while (ctx->stringSlots[slot] != 0)
+            slot = (slot + 1) & ctx->stringSlotMask;
     }
 
-    return left;
+    buffer = EXIB_ArenaAlloc(&ctx->nameArena, length + 1, 1);
+    if (!buffer)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return NULL;
+    }
+    memcpy(buffer, str, length + 1);
+
+    entry = &ctx->stringCache[ctx->stringCacheSize++];
+    entry->hash = hash;
+    entry->length = length;
+    entry->offset = ctx->stringBase + ctx->stringOffset;
+    entry->buffer = buffer;
+    ctx->stringSlots[slot] = ctx->stringCacheSize;
+
+    ctx->stringOffset += entrySize;
+    ctx->lastError = EXIB_ENC_ERR_Success;
+    return entry;
 }
 
-static void EXIB_ENC_ExpandStringCache(EXIB_ENC_Context* ctx, int newCapacity)
+static int EXIB_ENC_ExpandStringCache(EXIB_ENC_Context* ctx)
 {
-    EXIB_ENC_StringEntry* newCache = calloc(newCapacity, sizeof(EXIB_ENC_StringEntry));
+    uint32_t newCapacity = ctx->stringCacheCapacity * 2;
+    EXIB_ENC_StringEntry* newCache = EXIB_Alloc(newCapacity * sizeof(EXIB_ENC_StringEntry));
+
+    if (!newCache)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return 1;
+    }
 
     // Copy data into new cache.
     memcpy(newCache, ctx->stringCache, ctx->stringCacheSize * sizeof(EXIB_ENC_StringEntry));
 
     // Free old cache and update context.
-    free(ctx->stringCache);
+    EXIB_Free(ctx->stringCache);
     ctx->stringCache = newCache;
     ctx->stringCacheCapacity = newCapacity;
-}
\ No newline at end of file
+    return 0;
+}
+
+static int EXIB_ENC_ExpandStringSlots(EXIB_ENC_Context* ctx)
+{
+    uint32_t newMask = (ctx->stringSlotMask << 1) | 1;
+    uint32_t* newSlots = EXIB_Calloc(newMask + 1, sizeof(uint32_t));
+
+    if (!newSlots)
+    {
+        ctx->lastError = EXIB_ENC_ERR_OutOfMemory;
+        return 1;
+    }
+
+    // Entries keep their hash, so they can be reinserted without hashing them again.
+    for (uint32_t i = 0; i < ctx->stringCacheSize; ++i)
+    {
+        uint32_t slot = ctx->stringCache[i].hash & newMask;
+
+        while (newSlots[slot] != 0)
+            slot = (slot + 1) & newMask;
+
+        newSlots[slot] = i + 1;
+    }
+
+    EXIB_Free(ctx->stringSlots);
+    ctx->stringSlots = newSlots;
+    ctx->stringSlotMask = newMask;
+    return 0;
+}
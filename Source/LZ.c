@@ -0,0 +1,325 @@
+#include <string.h>
+#include "LZInternal.h"
+
+#define EXIB_LZ_MIN_MATCH 4
+#define EXIB_LZ_MAX_OFFSET 65535
+#define EXIB_LZ_HASH_BITS 12
+
+// The format ends with at least 5 literals, and the last match starts at least 12 bytes from the end.
+#define EXIB_LZ_LAST_LITERALS 5
+#define EXIB_LZ_MATCH_LIMIT 12
+
+// Positions without a match are skipped faster the longer the run of literals gets.
+#define EXIB_LZ_SKIP_SHIFT 6
+
+// Where there's room, the decompressor copies 8 bytes at a time and may overshoot the
+// end of a run by up to 7 bytes, which the next run overwrites.
+#define EXIB_LZ_WILD_COPY 8
+
+// Literals that fit into their token are copied as 16 bytes, matches that do as 24.
+#define EXIB_LZ_SHORT_LITERALS 16
+#define EXIB_LZ_SHORT_MATCH (14 + EXIB_LZ_MIN_MATCH)
+#define EXIB_LZ_SHORT_COPY 24
+
+static uint32_t EXIB_LZ_Read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint64_t EXIB_LZ_Read64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Hashes the five bytes at `p`, which finds longer matches than four would.
+static uint32_t EXIB_LZ_Hash(const uint8_t* p)
+{
+    return (uint32_t)(((EXIB_LZ_Read64(p) << 24) * 889523592379ULL) >> (64 - EXIB_LZ_HASH_BITS));
+}
+
+/**
+ * Count the bytes that match, eight at a time until the first difference.
+ * @param p Position being compressed.
+ * @param match Earlier position with the same data.
+ * @param limit Position the match may not extend past.
+ * @return Length of the match in bytes.
+ */
+static size_t EXIB_LZ_MatchLength(const uint8_t* p, const uint8_t* match, const uint8_t* limit)
+{
+    const uint8_t* start = p;
+
+    while (p + sizeof(uint64_t) <= limit)
+    {
+        uint64_t difference = EXIB_LZ_Read64(p) ^ EXIB_LZ_Read64(match);
+
+#if defined(__GNUC__)
+        // Loads are little-endian, so the lowest set bit is in the first byte that differs.
+        if (difference)
+            return (p - start) + (__builtin_ctzll(difference) >> 3);
+#else
+        if (difference)
+            break;
+#endif
+
+        p += sizeof(uint64_t);
+        match += sizeof(uint64_t);
+    }
+
+    while (p < limit && *p == *match)
+    {
+        ++p;
+        ++match;
+    }
+
+    return p - start;
+}
+
+// Lengths of 15 or more continue in the following bytes, 255 at a time.
+static uint8_t* EXIB_LZ_WriteLength(uint8_t* out, size_t length)
+{
+    for (length -= 15; length >= 255; length -= 255)
+        *out++ = 255;
+
+    *out++ = (uint8_t)length;
+    return out;
+}
+
+/**
+ * Write a run of literals, followed by a match unless this is the last sequence.
+ * @param out Output position.
+ * @param outEnd End of the output buffer.
+ * @param literals First literal.
+ * @param literalLength Number of literals.
+ * @param offset Distance back to the match.
+ * @param matchLength Length of the match, 0 for the last sequence.
+ * @return New output position, or NULL if the sequence doesn't fit.
+ */
+static uint8_t* EXIB_LZ_WriteSequence(uint8_t* out, const uint8_t* outEnd,
+                                      const uint8_t* literals, size_t literalLength,
+                                      size_t offset, size_t matchLength)
+{
+    size_t needed = 1 + literalLength + literalLength / 255 + 1;
+    uint8_t* token = out;
+
+    if (matchLength)
+        needed += 2 + matchLength / 255 + 1;
+
+    if ((size_t)(outEnd - out) < needed)
+        return NULL;
+
+    *token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+    out = literalLength < 15 ? out + 1 : EXIB_LZ_WriteLength(out + 1, literalLength);
+
+    memcpy(out, literals, literalLength);
+    out += literalLength;
+
+    if (matchLength)
+    {
+        matchLength -= EXIB_LZ_MIN_MATCH;
+        *out++ = (uint8_t)offset;
+        *out++ = (uint8_t)(offset >> 8);
+
+        *token |= matchLength < 15 ? matchLength : 15;
+        if (matchLength >= 15)
+            out = EXIB_LZ_WriteLength(out, matchLength);
+    }
+
+    return out;
+}
+
+size_t EXIB_LZ_Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity)
+{
+    uint32_t table[1 << EXIB_LZ_HASH_BITS];
+    const uint8_t* in = src;
+    const uint8_t* end = in + srcSize;
+    const uint8_t* anchor = in;
+    const uint8_t* p = in + 1;
+    uint8_t* out = dst;
+    uint8_t* outEnd = out + dstCapacity;
+
+    // Positions are relative to `in`, a stale entry only costs a failed comparison.
+    memset(table, 0, sizeof(table));
+
+    if (srcSize > EXIB_LZ_MATCH_LIMIT)
+    {
+        const uint8_t* searchLimit = end - EXIB_LZ_MATCH_LIMIT;
+        const uint8_t* matchLimit = end - EXIB_LZ_LAST_LITERALS;
+
+        while (p <= searchLimit)
+        {
+            uint32_t hash = EXIB_LZ_Hash(p);
+            const uint8_t* match = in + table[hash];
+            size_t length;
+
+            table[hash] = (uint32_t)(p - in);
+
+            if (match >= p
+                || p - match > EXIB_LZ_MAX_OFFSET
+                || EXIB_LZ_Read32(match) != EXIB_LZ_Read32(p))
+            {
+                p += 1 + ((p - anchor) >> EXIB_LZ_SKIP_SHIFT);
+                continue;
+            }
+
+            // The match might have started among the literals already.
+            while (p > anchor && match > in && p[-1] == match[-1])
+            {
+                --p;
+                --match;
+            }
+
+            length = EXIB_LZ_MIN_MATCH + EXIB_LZ_MatchLength(p + EXIB_LZ_MIN_MATCH,
+                                                             match + EXIB_LZ_MIN_MATCH,
+                                                             matchLimit);
+
+            out = EXIB_LZ_WriteSequence(out, outEnd, anchor, p - anchor, p - match, length);
+            if (!out)
+                return 0;
+
+            p += length;
+            anchor = p;
+
+            // Also index the position just before, so runs are picked up again straight away.
+            if (p <= searchLimit)
+                table[EXIB_LZ_Hash(p - 2)] = (uint32_t)(p - 2 - in);
+        }
+    }
+
+    out = EXIB_LZ_WriteSequence(out, outEnd, anchor, end - anchor, 0, 0);
+    if (!out)
+        return 0;
+
+    return out - (uint8_t*)dst;
+}
+
+static void EXIB_LZ_WildCopy(uint8_t* out, const uint8_t* in, size_t length)
+{
+    uint8_t* end = out + length;
+
+    do
+    {
+        memcpy(out, in, EXIB_LZ_WILD_COPY);
+        out += EXIB_LZ_WILD_COPY;
+        in += EXIB_LZ_WILD_COPY;
+    } while (out < end);
+}
+
+/**
+ * Read the rest of a length that continues past its token.
+ * @param in Input position, moved past the length.
+ * @param end End of the input.
+ * @param length Length from the token, receives the full length.
+ * @param maxLength Largest length that is valid.
+ * @return 0 on success, 1 if the input ends or the length is too large.
+ */
+static int EXIB_LZ_ReadLength(const uint8_t** in, const uint8_t* end, size_t* length, size_t maxLength)
+{
+    uint8_t byte;
+
+    do
+    {
+        if (*in >= end)
+            return 1;
+
+        byte = *(*in)++;
+        *length += byte;
+
+        if (*length > maxLength)
+            return 1;
+    } while (byte == 255);
+
+    return 0;
+}
+
+int EXIB_LZ_Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize)
+{
+    const uint8_t* in = src;
+    const uint8_t* end = in + srcSize;
+    uint8_t* out = dst;
+    uint8_t* outEnd = out + dstSize;
+
+    while (in < end)
+    {
+        uint8_t token = *in++;
+        size_t literalLength = token >> 4;
+        size_t matchLength = token & 15;
+        size_t offset;
+
+        // Most sequences are short, their literals are copied without looking at the length.
+        // With input left over, this can't be the last sequence either.
+        if (literalLength < 15
+            && (size_t)(end - in) >= EXIB_LZ_SHORT_LITERALS + 2
+            && (size_t)(outEnd - out) >= EXIB_LZ_SHORT_LITERALS + EXIB_LZ_SHORT_COPY)
+        {
+            memcpy(out, in, EXIB_LZ_SHORT_LITERALS);
+            in += literalLength;
+            out += literalLength;
+        }
+        else
+        {
+            if (literalLength == 15 && EXIB_LZ_ReadLength(&in, end, &literalLength, dstSize))
+                return 1;
+
+            if (literalLength > (size_t)(end - in) || literalLength > (size_t)(outEnd - out))
+                return 1;
+
+            if (literalLength + EXIB_LZ_WILD_COPY <= (size_t)(end - in)
+                && literalLength + EXIB_LZ_WILD_COPY <= (size_t)(outEnd - out))
+                EXIB_LZ_WildCopy(out, in, literalLength);
+            else
+                memcpy(out, in, literalLength);
+            in += literalLength;
+            out += literalLength;
+
+            // The last sequence has no match.
+            if (in == end)
+                break;
+
+            if (end - in < 2)
+                return 1;
+        }
+
+        offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        if (offset == 0 || offset > (size_t)(out - (uint8_t*)dst))
+            return 1;
+
+        if (matchLength == 15 && EXIB_LZ_ReadLength(&in, end, &matchLength, dstSize))
+            return 1;
+
+        matchLength += EXIB_LZ_MIN_MATCH;
+        if (matchLength > (size_t)(outEnd - out))
+            return 1;
+
+        // Matches closer than their length repeat the bytes they're copying.
+        if (offset >= EXIB_LZ_WILD_COPY
+            && matchLength <= EXIB_LZ_SHORT_MATCH
+            && (size_t)(outEnd - out) >= EXIB_LZ_SHORT_COPY)
+        {
+            // Same as a wild copy of a short match, unrolled so the length isn't branched on.
+            const uint8_t* match = out - offset;
+            memcpy(out, match, EXIB_LZ_WILD_COPY);
+            memcpy(out + 8, match + 8, EXIB_LZ_WILD_COPY);
+            memcpy(out + 16, match + 16, EXIB_LZ_WILD_COPY);
+        }
+        else if (offset >= EXIB_LZ_WILD_COPY && matchLength + EXIB_LZ_WILD_COPY <= (size_t)(outEnd - out))
+            EXIB_LZ_WildCopy(out, out - offset, matchLength);
+        else if (offset >= matchLength)
+            memcpy(out, out - offset, matchLength);
+        else
+        {
+            const uint8_t* match = out - offset;
+            for (size_t i = 0; i < matchLength; ++i)
+                out[i] = match[i];
+        }
+
+        out += matchLength;
+    }
+
+    return out != outEnd;
+}
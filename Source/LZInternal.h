@@ -0,0 +1,37 @@
+#ifndef _EXIB_LZ_INTERNAL_H
+#define _EXIB_LZ_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Byte-oriented LZ77 compressor used for blob table entries.
+ * The compressed data uses the LZ4 block format: a sequence of literals
+ * followed by a match of at least 4 bytes, up to 64 KiB back.
+ * It's built for speed rather than ratio, one hash probe per position.
+ */
+
+// Most bytes a single compressed byte decompresses to, reached by match lengths that continue 255 at a time.
+#define EXIB_LZ_MAX_EXPANSION 255
+
+/**
+ * Compress a buffer.
+ * @param src Data to compress.
+ * @param srcSize Size of data in bytes.
+ * @param dst Buffer that receives the compressed data.
+ * @param dstCapacity Size of `dst` in bytes.
+ * @return Size of the compressed data, or 0 if it doesn't fit into `dst`.
+ */
+size_t EXIB_LZ_Compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+
+/**
+ * Decompress a buffer. Malformed data is detected rather than read or written out of bounds.
+ * @param src Compressed data.
+ * @param srcSize Size of compressed data in bytes.
+ * @param dst Buffer that receives the decompressed data.
+ * @param dstSize Exact size of the decompressed data in bytes.
+ * @return 0 on success, 1 if the data is malformed or doesn't decompress to `dstSize` bytes.
+ */
+int EXIB_LZ_Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+
+#endif
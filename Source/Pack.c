@@ -0,0 +1,808 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <EXIB/EXIB.h>
+#include "PackInternal.h"
+
+/*
+ * Packed arrays store the elements of an array of integers in fewer bytes:
+ *
+ * - Delta encoding (optional) replaces each element by its difference to the previous one,
+ *   which turns timestamps and counters into small numbers.
+ * - VARINT zigzag-encodes each element and writes it as a LEB128 varint.
+ * - BITS subtracts the smallest element (the frame of reference) and writes the offsets
+ *   with as many bits as the largest one needs, LSB first and without gaps.
+ * - RLE writes runs of equal elements as a varint length and a zigzag varint.
+ *
+ * Decoding BITS is the hot path: groups of 8 elements always start on a byte boundary,
+ * so the SIMD kernels gather the bytes of each element into a 64-bit lane with a
+ * byte shuffle, and shift and mask the lanes in parallel. Varints are parsed one at a
+ * time, but the delta sums and the narrowing to the element type are vectorized too.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <smmintrin.h>
+    #include <immintrin.h>
+
+    #define EXIB_PACK_X86
+    #define EXIB_PACK_TARGET_SSE4 __attribute__((target("sse4.1")))
+    #define EXIB_PACK_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#define EXIB_PACK_HEADER_SIZE sizeof(EXIB_PackedArray)
+#define EXIB_PACK_BLOCK       256 // Elements decoded into lanes at a time.
+
+static inline int EXIB_PACK_IsInteger(EXIB_Type type)
+{
+    return type >= EXIB_TYPE_INT8 && type <= EXIB_TYPE_UINT64;
+}
+
+static inline uint64_t EXIB_PACK_Mask(int width)
+{
+    return width >= 64 ? UINT64_MAX : (((uint64_t)1 << width) - 1);
+}
+
+// Sign-extend the low `width` bits of a value.
+static inline int64_t EXIB_PACK_Extend(uint64_t value, int width)
+{
+    if (width >= 64)
+        return (int64_t)value;
+    return (int64_t)(value << (64 - width)) >> (64 - width);
+}
+
+// Element `i` of an array, sign-extended from the width of its type.
+static inline int64_t EXIB_PACK_Load(const uint8_t* elements, size_t i, int elementSize)
+{
+    switch (elementSize)
+    {
+    case 1: { int8_t  value; memcpy(&value, elements + i, 1); return value; }
+    case 2: { int16_t value; memcpy(&value, elements + i * 2, 2); return value; }
+    case 4: { int32_t value; memcpy(&value, elements + i * 4, 4); return value; }
+    default: { int64_t value; memcpy(&value, elements + i * 8, 8); return value; }
+    }
+}
+
+static inline uint64_t EXIB_PACK_ZigZag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline uint64_t EXIB_PACK_UnZigZag(uint64_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+static inline uint8_t* EXIB_PACK_WriteVarint(uint8_t* p, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+// Read a varint that must end before `end`. Returns NULL if it doesn't.
+static inline const uint8_t* EXIB_PACK_ReadVarint(const uint8_t* p, const uint8_t* end, uint64_t* value)
+{
+    if (p < end && *p < 0x80)
+    {
+        *value = *p;
+        return p + 1;
+    }
+
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        uint8_t byte = *p++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+#define EXIB_PACK_MAX_VARINT 10 // Bytes of the longest 64-bit varint.
+
+/*
+ * Read a varint with at least EXIB_PACK_MAX_VARINT bytes left. Varints of up to 8 bytes
+ * are read without branching on their length: the lowest clear continuation bit ends it,
+ * and the 7-bit groups before it are moved together with masks.
+ */
+static inline const uint8_t* EXIB_PACK_ReadVarintFast(const uint8_t* p, uint64_t* value)
+{
+    uint64_t word;
+    memcpy(&word, p, 8);
+
+    uint64_t stops = ~word & 0x8080808080808080ull;
+    if (!stops)
+        return EXIB_PACK_ReadVarint(p, p + EXIB_PACK_MAX_VARINT, value);
+
+    uint64_t x = word & (stops ^ (stops - 1));
+    *value = (x & 0x7F)
+           | ((x >> 1) & ((uint64_t)0x7F << 7))
+           | ((x >> 2) & ((uint64_t)0x7F << 14))
+           | ((x >> 3) & ((uint64_t)0x7F << 21))
+           | ((x >> 4) & ((uint64_t)0x7F << 28))
+           | ((x >> 5) & ((uint64_t)0x7F << 35))
+           | ((x >> 6) & ((uint64_t)0x7F << 42))
+           | ((x >> 7) & ((uint64_t)0x7F << 49));
+    return p + (__builtin_ctzll(stops) >> 3) + 1;
+}
+
+// Read `width` bits at a bit position, one byte at a time so nothing past them is touched.
+static inline uint64_t EXIB_PACK_ReadBits(const uint8_t* src, size_t bit, int width)
+{
+    uint64_t value = 0;
+    int done = 0;
+
+    while (done < width)
+    {
+        int shift = (int)(bit & 7);
+        int take = 8 - shift;
+        if (take > width - done)
+            take = width - done;
+
+        value |= (uint64_t)((src[bit >> 3] >> shift) & ((1u << take) - 1)) << done;
+        bit += take;
+        done += take;
+    }
+
+    return value;
+}
+
+/*
+ * Portable kernels.
+ */
+
+static void EXIB_PACK_UnpackBits_Scalar(const uint8_t* src, size_t first, size_t count, int width, uint64_t reference, uint64_t* lanes)
+{
+    uint64_t mask = EXIB_PACK_Mask(width);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t bit = (first + i) * width;
+        uint64_t word;
+        memcpy(&word, src + (bit >> 3), 8);
+        lanes[i] = ((word >> (bit & 7)) & mask) + reference;
+    }
+}
+
+static uint64_t EXIB_PACK_Store_Scalar(const uint64_t* lanes, size_t count, int delta, uint64_t previous, void* dst, int elementSize)
+{
+    uint8_t* out = dst;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value = delta ? previous + lanes[i] : lanes[i];
+        previous = value;
+
+        switch (elementSize)
+        {
+        case 1: out[i] = (uint8_t)value; break;
+        case 2: { uint16_t narrow = (uint16_t)value; memcpy(out + i * 2, &narrow, 2); break; }
+        case 4: { uint32_t narrow = (uint32_t)value; memcpy(out + i * 4, &narrow, 4); break; }
+        default: memcpy(out + i * 8, &value, 8); break;
+        }
+    }
+
+    return previous;
+}
+
+const EXIB_PACK_Kernels EXIB_PACK_Scalar = {
+    "Scalar",
+    EXIB_PACK_UnpackBits_Scalar,
+    EXIB_PACK_Store_Scalar
+};
+
+#ifdef EXIB_PACK_X86
+
+/*
+ * The bytes of a group of 8 elements are loaded as four 16-byte windows, at the bytes
+ * of elements 0, 2, 4 and 6. Each element's 8 bytes are shuffled out of the window of
+ * its pair, and then shifted by its bit position within the first of them.
+ */
+typedef struct _EXIB_PACK_Shuffle
+{
+    uint8_t  masks[4][16];  // Byte shuffle of each window.
+    uint64_t shifts[8];     // Bit shift of each element.
+    size_t   windows[4];    // Byte offset of each window in the group.
+} EXIB_PACK_Shuffle;
+
+static void EXIB_PACK_BuildShuffle(EXIB_PACK_Shuffle* shuffle, int width)
+{
+    for (int pair = 0; pair < 4; ++pair)
+        shuffle->windows[pair] = (size_t)(pair * 2 * width) >> 3;
+
+    for (int e = 0; e < 8; ++e)
+    {
+        size_t byte = (size_t)(e * width) >> 3;
+        size_t window = shuffle->windows[e / 2];
+
+        shuffle->shifts[e] = (uint64_t)((e * width) & 7);
+        for (int k = 0; k < 8; ++k)
+            shuffle->masks[e / 2][(e & 1) * 8 + k] = (uint8_t)(byte - window + k);
+    }
+}
+
+EXIB_PACK_TARGET_SSE4
+static void EXIB_PACK_UnpackBits_SSE4(const uint8_t* src, size_t first, size_t count, int width, uint64_t reference, uint64_t* lanes)
+{
+    EXIB_PACK_Shuffle shuffle;
+    EXIB_PACK_BuildShuffle(&shuffle, width);
+
+    __m128i masks[4], shiftsLow[4], shiftsHigh[4];
+    for (int pair = 0; pair < 4; ++pair)
+    {
+        masks[pair] = _mm_loadu_si128((const __m128i*)shuffle.masks[pair]);
+        shiftsLow[pair] = _mm_cvtsi64_si128((long long)shuffle.shifts[pair * 2]);
+        shiftsHigh[pair] = _mm_cvtsi64_si128((long long)shuffle.shifts[pair * 2 + 1]);
+    }
+
+    __m128i mask = _mm_set1_epi64x((long long)EXIB_PACK_Mask(width));
+    __m128i base = _mm_set1_epi64x((long long)reference);
+
+    // A group of 8 elements takes exactly `width` bytes.
+    const uint8_t* group = src + (first / 8) * width;
+    for (size_t i = 0; i < count; i += 8, group += width)
+    {
+        for (int pair = 0; pair < 4; ++pair)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(group + shuffle.windows[pair]));
+            bytes = _mm_shuffle_epi8(bytes, masks[pair]);
+            bytes = _mm_blend_epi16(_mm_srl_epi64(bytes, shiftsLow[pair]), _mm_srl_epi64(bytes, shiftsHigh[pair]), 0xF0);
+            bytes = _mm_add_epi64(_mm_and_si128(bytes, mask), base);
+            _mm_storeu_si128((__m128i*)(lanes + i + pair * 2), bytes);
+        }
+    }
+}
+
+EXIB_PACK_TARGET_SSE4
+static uint64_t EXIB_PACK_Store_SSE4(const uint64_t* lanes, size_t count, int delta, uint64_t previous, void* dst, int elementSize)
+{
+    uint8_t* out = dst;
+    __m128i carry = _mm_set1_epi64x((long long)previous);
+    __m128i narrow16 = _mm_setr_epi8(0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i narrow8 = _mm_setr_epi8(0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    size_t i = 0;
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(lanes + i));
+
+        if (delta)
+        {
+            v = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi64(v, carry);
+            carry = _mm_unpackhi_epi64(v, v);
+        }
+
+        switch (elementSize)
+        {
+        case 1:
+        {
+            uint16_t pair = (uint16_t)_mm_cvtsi128_si32(_mm_shuffle_epi8(v, narrow8));
+            memcpy(out + i, &pair, 2);
+            break;
+        }
+        case 2:
+        {
+            uint32_t pair = (uint32_t)_mm_cvtsi128_si32(_mm_shuffle_epi8(v, narrow16));
+            memcpy(out + i * 2, &pair, 4);
+            break;
+        }
+        case 4:
+            _mm_storel_epi64((__m128i*)(out + i * 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 2, 0)));
+            break;
+        default:
+            _mm_storeu_si128((__m128i*)(out + i * 8), v);
+            break;
+        }
+    }
+
+    if (i > 0)
+        previous = delta ? (uint64_t)_mm_cvtsi128_si64(carry) : lanes[i - 1];
+
+    return EXIB_PACK_Store_Scalar(lanes + i, count - i, delta, previous, out + i * elementSize, elementSize);
+}
+
+EXIB_PACK_TARGET_AVX2
+static void EXIB_PACK_UnpackBits_AVX2(const uint8_t* src, size_t first, size_t count, int width, uint64_t reference, uint64_t* lanes)
+{
+    EXIB_PACK_Shuffle shuffle;
+    EXIB_PACK_BuildShuffle(&shuffle, width);
+
+    __m256i masksLow = _mm256_loadu_si256((const __m256i*)shuffle.masks[0]);
+    __m256i masksHigh = _mm256_loadu_si256((const __m256i*)shuffle.masks[2]);
+    __m256i shiftsLow = _mm256_loadu_si256((const __m256i*)shuffle.shifts);
+    __m256i shiftsHigh = _mm256_loadu_si256((const __m256i*)(shuffle.shifts + 4));
+    __m256i mask = _mm256_set1_epi64x((long long)EXIB_PACK_Mask(width));
+    __m256i base = _mm256_set1_epi64x((long long)reference);
+
+    const uint8_t* group = src + (first / 8) * width;
+    for (size_t i = 0; i < count; i += 8, group += width)
+    {
+        __m256i low = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(group + shuffle.windows[0]))),
+                                              _mm_loadu_si128((const __m128i*)(group + shuffle.windows[1])), 1);
+        __m256i high = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(group + shuffle.windows[2]))),
+                                               _mm_loadu_si128((const __m128i*)(group + shuffle.windows[3])), 1);
+
+        low = _mm256_srlv_epi64(_mm256_shuffle_epi8(low, masksLow), shiftsLow);
+        high = _mm256_srlv_epi64(_mm256_shuffle_epi8(high, masksHigh), shiftsHigh);
+
+        _mm256_storeu_si256((__m256i*)(lanes + i), _mm256_add_epi64(_mm256_and_si256(low, mask), base));
+        _mm256_storeu_si256((__m256i*)(lanes + i + 4), _mm256_add_epi64(_mm256_and_si256(high, mask), base));
+    }
+}
+
+EXIB_PACK_TARGET_AVX2
+static uint64_t EXIB_PACK_Store_AVX2(const uint64_t* lanes, size_t count, int delta, uint64_t previous, void* dst, int elementSize)
+{
+    uint8_t* out = dst;
+    __m256i carry = _mm256_set1_epi64x((long long)previous);
+    __m256i zero = _mm256_setzero_si256();
+    // Moves the low 32 bits of each lane to the bottom of the register.
+    __m256i gather32 = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i gather128 = _mm256_setr_epi32(0, 4, 1, 2, 3, 5, 6, 7);
+    // Moves the low 2 bytes of each 64-bit lane to the bottom of its 128-bit half.
+    __m256i narrow16 = _mm256_setr_epi8(0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        0, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    // The upper half moves its bytes after those of the lower one, so the halves can be combined with an OR.
+    __m256i narrow8 = _mm256_setr_epi8(0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                       -1, -1, 0, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(lanes + i));
+
+        if (delta)
+        {
+            // [a, a+b, c, c+d], then add a+b to the upper half.
+            v = _mm256_add_epi64(v, _mm256_slli_si256(v, 8));
+            v = _mm256_add_epi64(v, _mm256_blend_epi32(zero, _mm256_permute4x64_epi64(v, _MM_SHUFFLE(1, 1, 1, 1)), 0xF0));
+            v = _mm256_add_epi64(v, carry);
+            carry = _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+
+        switch (elementSize)
+        {
+        case 1:
+        {
+            __m256i halves = _mm256_shuffle_epi8(v, narrow8);
+            __m128i bytes = _mm_or_si128(_mm256_castsi256_si128(halves), _mm256_extracti128_si256(halves, 1));
+            uint32_t quad = (uint32_t)_mm_cvtsi128_si32(bytes);
+            memcpy(out + i, &quad, 4);
+            break;
+        }
+        case 2:
+        {
+            __m128i words = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, narrow16), gather128));
+            _mm_storel_epi64((__m128i*)(out + i * 2), words);
+            break;
+        }
+        case 4:
+            _mm_storeu_si128((__m128i*)(out + i * 4), _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, gather32)));
+            break;
+        default:
+            _mm256_storeu_si256((__m256i*)(out + i * 8), v);
+            break;
+        }
+    }
+
+    if (i > 0)
+        previous = delta ? (uint64_t)_mm256_extract_epi64(carry, 0) : lanes[i - 1];
+
+    return EXIB_PACK_Store_Scalar(lanes + i, count - i, delta, previous, out + i * elementSize, elementSize);
+}
+
+const EXIB_PACK_Kernels EXIB_PACK_SSE4 = {
+    "SSE4.1",
+    EXIB_PACK_UnpackBits_SSE4,
+    EXIB_PACK_Store_SSE4
+};
+
+const EXIB_PACK_Kernels EXIB_PACK_AVX2 = {
+    "AVX2",
+    EXIB_PACK_UnpackBits_AVX2,
+    EXIB_PACK_Store_AVX2
+};
+
+int EXIB_PACK_SSE4Supported()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+
+int EXIB_PACK_AVX2Supported()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+const EXIB_PACK_Kernels EXIB_PACK_SSE4 = {
+    "Scalar",
+    EXIB_PACK_UnpackBits_Scalar,
+    EXIB_PACK_Store_Scalar
+};
+
+const EXIB_PACK_Kernels EXIB_PACK_AVX2 = {
+    "Scalar",
+    EXIB_PACK_UnpackBits_Scalar,
+    EXIB_PACK_Store_Scalar
+};
+
+int EXIB_PACK_SSE4Supported()
+{
+    return 0;
+}
+
+int EXIB_PACK_AVX2Supported()
+{
+    return 0;
+}
+
+#endif
+
+static _Atomic(const EXIB_PACK_Kernels*) s_PackKernels = NULL;
+
+const EXIB_PACK_Kernels* EXIB_PACK_GetKernels()
+{
+    const EXIB_PACK_Kernels* kernels = atomic_load(&s_PackKernels);
+
+    if (!kernels)
+    {
+        // Every thread picks the same ones, so a race is harmless.
+        if (EXIB_PACK_AVX2Supported())
+            kernels = &EXIB_PACK_AVX2;
+        else if (EXIB_PACK_SSE4Supported())
+            kernels = &EXIB_PACK_SSE4;
+        else
+            kernels = &EXIB_PACK_Scalar;
+        atomic_store(&s_PackKernels, kernels);
+    }
+
+    return kernels;
+}
+
+/*
+ * Encoding.
+ */
+
+size_t EXIB_PACK_Bound(EXIB_ArrayPacking packing, size_t count)
+{
+    switch (packing)
+    {
+    case EXIB_PACKING_VARINT: return EXIB_PACK_HEADER_SIZE + count * 10;
+    case EXIB_PACKING_BITS:   return EXIB_PACK_HEADER_SIZE + count * 8;
+    case EXIB_PACKING_RLE:    return EXIB_PACK_HEADER_SIZE + count * 11;
+    default:                  return 0;
+    }
+}
+
+// Element `i` as it is packed: sign-extended, or its difference to the previous one.
+static inline int64_t EXIB_PACK_Value(const uint8_t* elements, size_t i, int elementSize, int delta)
+{
+    int64_t value = EXIB_PACK_Load(elements, i, elementSize);
+
+    if (delta)
+    {
+        uint64_t difference = (uint64_t)value - (uint64_t)EXIB_PACK_Load(elements, i - 1, elementSize);
+        value = EXIB_PACK_Extend(difference, elementSize * 8);
+    }
+
+    return value;
+}
+
+static size_t EXIB_PACK_EncodeBits(const uint8_t* elements, size_t first, size_t count, int elementSize, int delta, EXIB_PackedArray* header, size_t capacity)
+{
+    int64_t min = INT64_MAX, max = INT64_MIN;
+
+    for (size_t i = first; i < count; ++i)
+    {
+        int64_t value = EXIB_PACK_Value(elements, i, elementSize, delta);
+        if (value < min)
+            min = value;
+        if (value > max)
+            max = value;
+    }
+
+    uint64_t range = first < count ? (uint64_t)max - (uint64_t)min : 0;
+    int width = range ? 64 - __builtin_clzll(range) : 0;
+    size_t dataSize = ((count - first) * width + 7) / 8;
+
+    if (EXIB_PACK_HEADER_SIZE + dataSize > capacity)
+        return 0;
+
+    header->bitWidth = (uint8_t)width;
+    header->reference = first < count ? (uint64_t)min : 0;
+
+    // Accumulate offsets into a 64-bit word and write it out whenever it fills up.
+    uint8_t* out = header->data;
+    uint64_t word = 0;
+    int bits = 0;
+
+    for (size_t i = first; i < count && width > 0; ++i)
+    {
+        uint64_t offset = (uint64_t)EXIB_PACK_Value(elements, i, elementSize, delta) - (uint64_t)min;
+
+        word |= offset << bits;
+        if (bits + width >= 64)
+        {
+            memcpy(out, &word, 8);
+            out += 8;
+
+            int spill = bits + width - 64;
+            word = spill ? offset >> (width - spill) : 0;
+            bits = spill;
+        }
+        else
+            bits += width;
+    }
+
+    memcpy(out, &word, (size_t)(bits + 7) / 8);
+    return EXIB_PACK_HEADER_SIZE + dataSize;
+}
+
+size_t EXIB_PACK_Encode(EXIB_Type type,
+                        const void* elements,
+                        size_t count,
+                        EXIB_ArrayPacking packing,
+                        int delta,
+                        void* dst,
+                        size_t capacity)
+{
+    if (!EXIB_PACK_IsInteger(type) || count > UINT32_MAX || capacity < EXIB_PACK_HEADER_SIZE)
+        return 0;
+
+    EXIB_PackedArray* header = dst;
+    memset(header, 0, EXIB_PACK_HEADER_SIZE);
+    header->elements = (uint32_t)count;
+    header->delta = delta ? 1 : 0;
+
+    int elementSize = EXIB_GetTypeSize(type);
+    const uint8_t* input = elements;
+
+    // With delta encoding, the first element is the base, and only the ones after it are packed.
+    size_t first = 0;
+    if (header->delta && count)
+    {
+        header->base = (uint64_t)EXIB_PACK_Load(input, 0, elementSize);
+        first = 1;
+    }
+
+    if (packing == EXIB_PACKING_BITS)
+        return EXIB_PACK_EncodeBits(input, first, count, elementSize, header->delta, header, capacity);
+
+    if (packing != EXIB_PACKING_VARINT && packing != EXIB_PACKING_RLE)
+        return 0;
+
+    // Varints are written straight into `dst` as long as a whole one fits, and
+    // through a scratch buffer near the end, where it might not.
+    uint8_t* p = header->data;
+    uint8_t* end = (uint8_t*)dst + capacity;
+    uint8_t scratch[20];
+
+    for (size_t i = first; i < count; )
+    {
+        int64_t value = EXIB_PACK_Value(input, i, elementSize, header->delta);
+        size_t run = 1;
+
+        if (packing == EXIB_PACKING_RLE)
+        {
+            while (i + run < count && EXIB_PACK_Value(input, i + run, elementSize, header->delta) == value)
+                run++;
+        }
+
+        uint8_t* target = end - p >= (ptrdiff_t)sizeof(scratch) ? p : scratch;
+        uint8_t* next = target;
+        if (packing == EXIB_PACKING_RLE)
+            next = EXIB_PACK_WriteVarint(next, run);
+        next = EXIB_PACK_WriteVarint(next, EXIB_PACK_ZigZag(value));
+
+        size_t written = (size_t)(next - target);
+        if (target == scratch)
+        {
+            if (written > (size_t)(end - p))
+                return 0;
+            memcpy(p, scratch, written);
+        }
+
+        p += written;
+        i += run;
+    }
+
+    return (size_t)(p - (uint8_t*)dst);
+}
+
+/*
+ * Decoding.
+ */
+
+static int EXIB_PACK_DecodeBits(const EXIB_PACK_Kernels* kernels, const EXIB_PackedArray* header, const uint8_t* data, size_t dataSize, uint8_t* out, size_t count, int elementSize)
+{
+    int width = header->bitWidth;
+    if (width > elementSize * 8 || dataSize != (count * width + 7) / 8)
+        return 1;
+
+    // Groups of 8 elements whose loads stay within the data can use the kernel.
+    size_t fastEnd = 0;
+    size_t reach = (size_t)((6 * width) >> 3) + 16;
+    if (width > 0 && width <= EXIB_PACK_MAX_FAST_WIDTH && dataSize >= reach)
+    {
+        size_t groups = (dataSize - reach) / width + 1;
+        fastEnd = groups * 8 < count ? groups * 8 : count & ~(size_t)7;
+    }
+
+    uint64_t lanes[EXIB_PACK_BLOCK];
+    uint64_t previous = header->base;
+
+    for (size_t start = 0; start < count; start += EXIB_PACK_BLOCK)
+    {
+        size_t n = count - start < EXIB_PACK_BLOCK ? count - start : EXIB_PACK_BLOCK;
+        size_t i = 0;
+
+        if (start < fastEnd)
+        {
+            i = fastEnd - start < n ? fastEnd - start : n;
+            kernels->unpackBits(data, start, i, width, header->reference, lanes);
+        }
+
+        for (; i < n; ++i)
+            lanes[i] = EXIB_PACK_ReadBits(data, (start + i) * width, width) + header->reference;
+
+        previous = kernels->store(lanes, n, header->delta, previous, out + start * elementSize, elementSize);
+    }
+
+    return 0;
+}
+
+// Fill `count` elements with the same value.
+static void EXIB_PACK_Fill(uint8_t* out, size_t count, uint64_t value, int elementSize)
+{
+    switch (elementSize)
+    {
+    case 1:
+        memset(out, (uint8_t)value, count);
+        break;
+    case 2:
+        for (size_t i = 0; i < count; ++i)
+            memcpy(out + i * 2, &value, 2);
+        break;
+    case 4:
+        for (size_t i = 0; i < count; ++i)
+            memcpy(out + i * 4, &value, 4);
+        break;
+    default:
+        for (size_t i = 0; i < count; ++i)
+            memcpy(out + i * 8, &value, 8);
+        break;
+    }
+}
+
+// Runs without delta encoding are written out directly.
+static int EXIB_PACK_DecodeRuns(const uint8_t* p, const uint8_t* end, uint8_t* out, size_t count, int elementSize)
+{
+    uint64_t run, value;
+
+    for (size_t i = 0; i < count; i += run)
+    {
+        if (!(p = EXIB_PACK_ReadVarint(p, end, &run)) || !(p = EXIB_PACK_ReadVarint(p, end, &value)))
+            return 1;
+        if (run == 0 || run > count - i)
+            return 1;
+
+        EXIB_PACK_Fill(out + i * elementSize, run, EXIB_PACK_UnZigZag(value), elementSize);
+    }
+
+    return p != end;
+}
+
+static int EXIB_PACK_DecodeVarints(const EXIB_PACK_Kernels* kernels, const EXIB_PackedArray* header, EXIB_ArrayPacking packing, const uint8_t* data, size_t dataSize, uint8_t* out, size_t count, int elementSize)
+{
+    const uint8_t* p = data;
+    const uint8_t* end = p + dataSize;
+    uint64_t lanes[EXIB_PACK_BLOCK];
+    uint64_t previous = header->base;
+    uint64_t run = 0, value = 0;
+
+    if (packing == EXIB_PACKING_RLE && !header->delta)
+        return EXIB_PACK_DecodeRuns(p, end, out, count, elementSize);
+
+    for (size_t start = 0; start < count; start += EXIB_PACK_BLOCK)
+    {
+        size_t n = count - start < EXIB_PACK_BLOCK ? count - start : EXIB_PACK_BLOCK;
+        size_t i = 0;
+
+        if (packing == EXIB_PACKING_VARINT)
+        {
+            // No varint can run past the end while a whole one fits, so those skip the bounds checks.
+            for (; i < n && end - p >= EXIB_PACK_MAX_VARINT; ++i)
+            {
+                if (!(p = EXIB_PACK_ReadVarintFast(p, &value)))
+                    return 1;
+                lanes[i] = EXIB_PACK_UnZigZag(value);
+            }
+
+            for (; i < n; ++i)
+            {
+                if (!(p = EXIB_PACK_ReadVarint(p, end, &value)))
+                    return 1;
+                lanes[i] = EXIB_PACK_UnZigZag(value);
+            }
+        }
+
+        while (i < n)
+        {
+            if (run == 0)
+            {
+                if (!(p = EXIB_PACK_ReadVarint(p, end, &run)) || !(p = EXIB_PACK_ReadVarint(p, end, &value)))
+                    return 1;
+                if (run == 0 || run > count - start - i)
+                    return 1;
+                value = EXIB_PACK_UnZigZag(value);
+            }
+
+            size_t take = run < n - i ? (size_t)run : n - i;
+            for (size_t k = 0; k < take; ++k)
+                lanes[i + k] = value;
+            i += take;
+            run -= take;
+        }
+
+        previous = kernels->store(lanes, n, header->delta, previous, out + start * elementSize, elementSize);
+    }
+
+    // Trailing bytes would be ignored by every reader, so they can only be corruption.
+    return p != end;
+}
+
+int EXIB_PACK_Decode(const EXIB_PACK_Kernels* kernels,
+                     EXIB_Type type,
+                     EXIB_ArrayPacking packing,
+                     const void* src,
+                     size_t srcSize,
+                     void* dst,
+                     size_t count)
+{
+    if (!EXIB_PACK_IsInteger(type) || srcSize < EXIB_PACK_HEADER_SIZE)
+        return 1;
+
+    // Packed arrays are aligned in a datum, but the datum itself might not be.
+    EXIB_PackedArray header;
+    memcpy(&header, src, EXIB_PACK_HEADER_SIZE);
+    if (header.elements != count || header.delta > 1 || header.reserved != 0 || (!header.delta && header.base != 0))
+        return 1;
+
+    int elementSize = EXIB_GetTypeSize(type);
+    const uint8_t* data = (const uint8_t*)src + EXIB_PACK_HEADER_SIZE;
+    size_t dataSize = srcSize - EXIB_PACK_HEADER_SIZE;
+    uint8_t* out = dst;
+
+    if (packing != EXIB_PACKING_BITS && packing != EXIB_PACKING_VARINT && packing != EXIB_PACKING_RLE)
+        return 1;
+
+    // The first element of a delta encoded array is the base, which the packed differences continue from.
+    if (header.delta && count)
+    {
+        EXIB_PACK_Store_Scalar(&header.base, 1, 0, 0, out, elementSize);
+        out += elementSize;
+        count--;
+    }
+
+    switch (packing)
+    {
+    case EXIB_PACKING_BITS:
+        return EXIB_PACK_DecodeBits(kernels, &header, data, dataSize, out, count, elementSize);
+    case EXIB_PACKING_VARINT:
+    case EXIB_PACKING_RLE:
+        return EXIB_PACK_DecodeVarints(kernels, &header, packing, data, dataSize, out, count, elementSize);
+    default:
+        return 1;
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef _EXIB_PACK_INTERNAL_H
+#define _EXIB_PACK_INTERNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <EXIB/EXIB.h>
+
+/*
+ * Codecs of packed integer arrays. Elements are treated as integers of the width
+ * of their type, sign-extended to 64 bits, and delta encoding wraps around at that
+ * width, so signed and unsigned types of the same size pack the same way.
+ *
+ * Unpacking runs in blocks: the packed data is decoded into 64-bit lanes, which a
+ * store kernel adds up (for delta encoding) and narrows into the output. The
+ * bit-unpacking and store kernels have SSE4.1 and AVX2 versions, picked at run time.
+ */
+
+/** Unpack kernels of one instruction set. */
+typedef struct _EXIB_PACK_Kernels
+{
+    const char* name;
+
+    /**
+     * Unpack bit-packed offsets and add the frame of reference to them.
+     * Reads up to (6 * width) / 8 + 16 bytes from the start of each group of 8 elements.
+     * Only valid for widths from 1 to EXIB_PACK_MAX_FAST_WIDTH.
+     * @param src Bit-packed data.
+     * @param first Index of the first element to unpack, a multiple of 8.
+     * @param count Number of elements, a multiple of 8.
+     * @param width Bits per offset.
+     * @param reference Frame of reference.
+     * @param lanes Receives the elements.
+     */
+    void (*unpackBits)(const uint8_t* src, size_t first, size_t count, int width, uint64_t reference, uint64_t* lanes);
+
+    /**
+     * Write elements in the width of their type, adding them up first for delta encoding.
+     * @param lanes Elements, or differences to the previous element if `delta` is set.
+     * @param count Number of elements.
+     * @param delta 1 to add up the elements.
+     * @param previous Element before the first one, for delta encoding.
+     * @param dst Receives the elements.
+     * @param elementSize Size of an element: 1, 2, 4 or 8.
+     * @return Last element, which continues the sum in the next block.
+     */
+    uint64_t (*store)(const uint64_t* lanes, size_t count, int delta, uint64_t previous, void* dst, int elementSize);
+} EXIB_PACK_Kernels;
+
+// Widest offsets that fit into a 64-bit load at any bit position, which the unpack kernels rely on.
+#define EXIB_PACK_MAX_FAST_WIDTH 57
+
+/** Portable kernels. */
+extern const EXIB_PACK_Kernels EXIB_PACK_Scalar;
+
+/** SSE4.1 kernels. Only valid if EXIB_PACK_SSE4Supported returns 1, the same as the portable ones on other architectures. */
+extern const EXIB_PACK_Kernels EXIB_PACK_SSE4;
+
+/** AVX2 kernels. Only valid if EXIB_PACK_AVX2Supported returns 1, the same as the portable ones on other architectures. */
+extern const EXIB_PACK_Kernels EXIB_PACK_AVX2;
+
+/** @return 1 if the CPU supports the SSE4.1 kernels. */
+int EXIB_PACK_SSE4Supported();
+
+/** @return 1 if the CPU supports the AVX2 kernels. */
+int EXIB_PACK_AVX2Supported();
+
+/** @return Fastest kernels the CPU supports. */
+const EXIB_PACK_Kernels* EXIB_PACK_GetKernels();
+
+/**
+ * Calculate the maximum packed size of an array.
+ * @param packing Packing of the array.
+ * @param count Number of elements.
+ * @return Size of the packed data in bytes, including the EXIB_PackedArray header.
+ */
+size_t EXIB_PACK_Bound(EXIB_ArrayPacking packing, size_t count);
+
+/**
+ * Pack an array of integers.
+ * @param type Type of the elements, one of the integer types.
+ * @param elements Elements to pack.
+ * @param count Number of elements.
+ * @param packing Packing to use, anything but EXIB_PACKING_NONE.
+ * @param delta 1 to pack the difference of each element to the previous one.
+ * @param dst Buffer that receives the EXIB_PackedArray header and the packed data.
+ * @param capacity Size of `dst` in bytes, see EXIB_PACK_Bound.
+ * @return Size of the packed data, or 0 if it doesn't fit into `dst`.
+ */
+size_t EXIB_PACK_Encode(EXIB_Type type,
+                        const void* elements,
+                        size_t count,
+                        EXIB_ArrayPacking packing,
+                        int delta,
+                        void* dst,
+                        size_t capacity);
+
+/**
+ * Unpack an array of integers. Malformed data is detected rather than read or written out of bounds.
+ * @param kernels Kernels to unpack with, see EXIB_PACK_GetKernels.
+ * @param type Type of the elements, one of the integer types.
+ * @param packing Packing of the array.
+ * @param src EXIB_PackedArray header and packed data.
+ * @param srcSize Size of `src` in bytes.
+ * @param dst Buffer that receives the elements.
+ * @param count Number of elements `dst` holds, which must be the number of elements in the header.
+ * @return 0 on success, 1 if the data is malformed or doesn't hold `count` elements.
+ */
+int EXIB_PACK_Decode(const EXIB_PACK_Kernels* kernels,
+                     EXIB_Type type,
+                     EXIB_ArrayPacking packing,
+                     const void* src,
+                     size_t srcSize,
+                     void* dst,
+                     size_t count);
+
+#endif
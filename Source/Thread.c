@@ -0,0 +1,188 @@
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include "AllocatorInternal.h"
+#include "ThreadInternal.h"
+
+#ifdef WIN32
+
+static DWORD WINAPI EXIB_ThreadMain(LPVOID parameter)
+{
+    EXIB_Thread* thread = parameter;
+    thread->fn(thread->arg);
+    return 0;
+}
+
+int EXIB_ThreadStart(EXIB_Thread* thread, EXIB_ThreadFn fn, void* arg)
+{
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, EXIB_ThreadMain, thread, 0, NULL);
+    return thread->handle == NULL;
+}
+
+void EXIB_ThreadJoin(EXIB_Thread* thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+void EXIB_ThreadYield()
+{
+    SwitchToThread();
+}
+
+static void EXIB_MutexInitialize(EXIB_Mutex* mutex) { InitializeSRWLock(mutex); }
+static void EXIB_MutexDestroy(EXIB_Mutex* mutex) { (void)mutex; }
+static void EXIB_MutexLock(EXIB_Mutex* mutex) { AcquireSRWLockExclusive(mutex); }
+static void EXIB_MutexUnlock(EXIB_Mutex* mutex) { ReleaseSRWLockExclusive(mutex); }
+
+static void EXIB_ConditionInitialize(EXIB_Condition* cond) { InitializeConditionVariable(cond); }
+static void EXIB_ConditionDestroy(EXIB_Condition* cond) { (void)cond; }
+static void EXIB_ConditionWait(EXIB_Condition* cond, EXIB_Mutex* mutex) { SleepConditionVariableSRW(cond, mutex, INFINITE, 0); }
+static void EXIB_ConditionWakeAll(EXIB_Condition* cond) { WakeAllConditionVariable(cond); }
+
+#else
+
+static void* EXIB_ThreadMain(void* parameter)
+{
+    EXIB_Thread* thread = parameter;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+int EXIB_ThreadStart(EXIB_Thread* thread, EXIB_ThreadFn fn, void* arg)
+{
+    thread->fn = fn;
+    thread->arg = arg;
+    return pthread_create(&thread->handle, NULL, EXIB_ThreadMain, thread) != 0;
+}
+
+void EXIB_ThreadJoin(EXIB_Thread* thread)
+{
+    pthread_join(thread->handle, NULL);
+}
+
+void EXIB_ThreadYield()
+{
+    sched_yield();
+}
+
+static void EXIB_MutexInitialize(EXIB_Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+static void EXIB_MutexDestroy(EXIB_Mutex* mutex) { pthread_mutex_destroy(mutex); }
+static void EXIB_MutexLock(EXIB_Mutex* mutex) { pthread_mutex_lock(mutex); }
+static void EXIB_MutexUnlock(EXIB_Mutex* mutex) { pthread_mutex_unlock(mutex); }
+
+static void EXIB_ConditionInitialize(EXIB_Condition* cond) { pthread_cond_init(cond, NULL); }
+static void EXIB_ConditionDestroy(EXIB_Condition* cond) { pthread_cond_destroy(cond); }
+static void EXIB_ConditionWait(EXIB_Condition* cond, EXIB_Mutex* mutex) { pthread_cond_wait(cond, mutex); }
+static void EXIB_ConditionWakeAll(EXIB_Condition* cond) { pthread_cond_broadcast(cond); }
+
+#endif
+
+static void EXIB_ThreadPoolMain(void* arg)
+{
+    EXIB_ThreadPoolWorker* worker = arg;
+    EXIB_ThreadPool* pool = worker->pool;
+
+    EXIB_MutexLock(&pool->mutex);
+    for (;;)
+    {
+        while (!pool->stop && worker->round == pool->round)
+            EXIB_ConditionWait(&pool->start, &pool->mutex);
+        if (pool->stop)
+            break;
+
+        worker->round = pool->round;
+        if (worker->index >= pool->jobCount)
+            continue;
+
+        EXIB_ThreadFn fn = pool->fn;
+        void* jobArg = pool->args[worker->index];
+
+        EXIB_MutexUnlock(&pool->mutex);
+        fn(jobArg);
+        EXIB_MutexLock(&pool->mutex);
+
+        if (--pool->pending == 0)
+            EXIB_ConditionWakeAll(&pool->done);
+    }
+    EXIB_MutexUnlock(&pool->mutex);
+}
+
+int EXIB_ThreadPoolStart(EXIB_ThreadPool* pool, int count, EXIB_ThreadFn fn, void* const* args)
+{
+    if (count > EXIB_THREAD_POOL_MAX)
+        count = EXIB_THREAD_POOL_MAX;
+    if (count <= 0)
+        return 0;
+
+    if (!pool->workers)
+    {
+        pool->workers = EXIB_Calloc(EXIB_THREAD_POOL_MAX, sizeof(EXIB_ThreadPoolWorker));
+        if (!pool->workers)
+            return 0;
+
+        EXIB_MutexInitialize(&pool->mutex);
+        EXIB_ConditionInitialize(&pool->start);
+        EXIB_ConditionInitialize(&pool->done);
+    }
+
+    EXIB_MutexLock(&pool->mutex);
+
+    // New workers wait for the round after the current one, which is this one.
+    while (pool->workerCount < count)
+    {
+        EXIB_ThreadPoolWorker* worker = &pool->workers[pool->workerCount];
+
+        worker->pool = pool;
+        worker->index = pool->workerCount;
+        worker->round = pool->round;
+        if (EXIB_ThreadStart(&worker->thread, EXIB_ThreadPoolMain, worker))
+            break;
+        ++pool->workerCount;
+    }
+
+    if (count > pool->workerCount)
+        count = pool->workerCount;
+
+    pool->fn = fn;
+    pool->args = args;
+    pool->jobCount = count;
+    pool->pending = count;
+    ++pool->round;
+    EXIB_ConditionWakeAll(&pool->start);
+
+    EXIB_MutexUnlock(&pool->mutex);
+    return count;
+}
+
+void EXIB_ThreadPoolWait(EXIB_ThreadPool* pool)
+{
+    if (!pool->workers)
+        return;
+
+    EXIB_MutexLock(&pool->mutex);
+    while (pool->pending > 0)
+        EXIB_ConditionWait(&pool->done, &pool->mutex);
+    EXIB_MutexUnlock(&pool->mutex);
+}
+
+void EXIB_ThreadPoolDestroy(EXIB_ThreadPool* pool)
+{
+    if (!pool->workers)
+        return;
+
+    EXIB_MutexLock(&pool->mutex);
+    pool->stop = 1;
+    EXIB_ConditionWakeAll(&pool->start);
+    EXIB_MutexUnlock(&pool->mutex);
+
+    for (int i = 0; i < pool->workerCount; ++i)
+        EXIB_ThreadJoin(&pool->workers[i].thread);
+
+    EXIB_ConditionDestroy(&pool->done);
+    EXIB_ConditionDestroy(&pool->start);
+    EXIB_MutexDestroy(&pool->mutex);
+    EXIB_Free(pool->workers);
+    memset(pool, 0, sizeof(EXIB_ThreadPool));
+}
@@ -0,0 +1,100 @@
+#ifndef _EXIB_THREAD_INTERNAL_H
+#define _EXIB_THREAD_INTERNAL_H
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*
+ * Minimal worker threads for the parallel paths of the library.
+ * Threads either run a single function and are joined, or wait in a pool
+ * that hands them one job per round until the pool is destroyed.
+ */
+
+// Most workers a thread pool starts.
+#define EXIB_THREAD_POOL_MAX 64
+
+typedef void (*EXIB_ThreadFn)(void* arg);
+
+#ifdef WIN32
+typedef SRWLOCK EXIB_Mutex;
+typedef CONDITION_VARIABLE EXIB_Condition;
+#else
+typedef pthread_mutex_t EXIB_Mutex;
+typedef pthread_cond_t EXIB_Condition;
+#endif
+
+typedef struct _EXIB_Thread
+{
+#ifdef WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    EXIB_ThreadFn fn;
+    void* arg;
+} EXIB_Thread;
+
+/**
+ * Start a thread that calls `fn(arg)`. The thread struct must stay valid until joined.
+ * @return 0 on success, 1 if the thread couldn't be created.
+ */
+int  EXIB_ThreadStart(EXIB_Thread* thread, EXIB_ThreadFn fn, void* arg);
+
+/** Wait for a started thread to finish. */
+void EXIB_ThreadJoin(EXIB_Thread* thread);
+
+/** Give up the rest of the time slice, for threads waiting on another one. */
+void EXIB_ThreadYield();
+
+struct _EXIB_ThreadPool;
+
+typedef struct _EXIB_ThreadPoolWorker
+{
+    EXIB_Thread thread;
+    struct _EXIB_ThreadPool* pool;
+    int index;
+    unsigned round; // Last round the worker has seen.
+} EXIB_ThreadPoolWorker;
+
+/**
+ * Workers that are started the first time they're needed, and wait for jobs
+ * until the pool is destroyed. A zeroed pool is valid and holds no threads.
+ */
+typedef struct _EXIB_ThreadPool
+{
+    EXIB_ThreadPoolWorker* workers; // EXIB_THREAD_POOL_MAX entries, allocated by the first round.
+    int workerCount; // Number of workers that have been started.
+    EXIB_Mutex mutex;
+    EXIB_Condition start; // Signalled when a round starts or the pool is destroyed.
+    EXIB_Condition done;  // Signalled when the last job of a round is done.
+    EXIB_ThreadFn fn;
+    void* const* args;
+    int jobCount; // Jobs of the current round, worker i runs fn(args[i]).
+    int pending;  // Jobs of the current round that haven't finished.
+    unsigned round;
+    int stop;
+} EXIB_ThreadPool;
+
+/**
+ * Start a round of jobs on the workers of a pool, starting more workers if needed.
+ * The previous round must have been waited for.
+ * @param pool Thread pool.
+ * @param count Number of jobs.
+ * @param fn Function each job calls.
+ * @param args Argument of each job, which must stay valid until the round is waited for.
+ * @return Number of jobs handed to workers, the first ones of `args`. Jobs that workers
+ *         couldn't be started for are left to the caller.
+ */
+int  EXIB_ThreadPoolStart(EXIB_ThreadPool* pool, int count, EXIB_ThreadFn fn, void* const* args);
+
+/** Wait for the jobs of the current round to finish. */
+void EXIB_ThreadPoolWait(EXIB_ThreadPool* pool);
+
+/** Stop and join the workers of a pool, and free it. The pool may be started again afterwards. */
+void EXIB_ThreadPoolDestroy(EXIB_ThreadPool* pool);
+
+#endif
@@ -16,6 +16,7 @@
 #endif
 
 static Benchmark* s_BenchmarkList = NULL;
+static Benchmark* s_CurrentBenchmark = NULL;
 
 uint64_t GetNanoTime()
 {
@@ -57,13 +58,32 @@ void AddBenchmark(const char* name,
     benchmark->iterations = iterations;
 }
 
+void AddSizedBenchmark(const char* name,
+                       benchmark_fn_t func,
+                       benchmark_fn_setup_t funcSetup,
+                       benchmark_fn_cleanup_t funcCleanup,
+                       size_t iterations,
+                       size_t size)
+{
+    AddBenchmark(name, func, funcSetup, funcCleanup, iterations);
+    s_BenchmarkList->size = size;
+}
+
+size_t GetBenchmarkSize()
+{
+    return s_CurrentBenchmark ? s_CurrentBenchmark->size : 0;
+}
+
 void RunBenchmark(Benchmark* benchmark)
 {
     uint64_t startNanos;
     uint64_t endNanos;
     uint64_t averageNanos;
-    void* parameter = benchmark->funcSetup 
-        ? benchmark->funcSetup() 
+    void* parameter;
+
+    s_CurrentBenchmark = benchmark;
+    parameter = benchmark->funcSetup
+        ? benchmark->funcSetup()
         : NULL;
 
     printf("TEST: \tBENCHMARK: Running %s.\n", benchmark->name);
@@ -83,21 +103,41 @@ void RunBenchmark(Benchmark* benchmark)
 
     averageNanos = (endNanos - startNanos) / benchmark->iterations;
 
-    printf("TEST: \tBENCHMARK: \t%lu ns/it\n", averageNanos);
+    if (benchmark->size)
+    {
+        double seconds = (endNanos - startNanos) / 1e9;
+        double megabytes = (benchmark->size * (double)benchmark->iterations) / (1024.0 * 1024.0);
+        printf("TEST: \tBENCHMARK: \t%lu ns/it, %.1f MiB/s\n", averageNanos, megabytes / seconds);
+    }
+    else
+        printf("TEST: \tBENCHMARK: \t%lu ns/it\n", averageNanos);
+
+    s_CurrentBenchmark = NULL;
 }
 
+extern void AddCommonBenchmarks();
 extern void AddEncoderBenchmarks();
 extern void AddDecoderBenchmarks();
+extern void AddAllocatorBenchmarks();
+#ifdef EXIB_TEST_EXGEN
+extern void AddGeneratorBenchmarks();
+#endif
 
-void RunBenchmarks()
+void RunBenchmarks(int large)
 {
+    AddCommonBenchmarks();
     AddEncoderBenchmarks();
     AddDecoderBenchmarks();
+    AddAllocatorBenchmarks();
+#ifdef EXIB_TEST_EXGEN
+    AddGeneratorBenchmarks();
+#endif
     
     Benchmark* benchmark = s_BenchmarkList;
     while (benchmark != NULL)
     {
-        RunBenchmark(benchmark);
+        if (large || benchmark->size <= EXIB_BENCHMARK_SMALL)
+            RunBenchmark(benchmark);
         benchmark = benchmark->next;
     }
 }
@@ -16,6 +16,7 @@ typedef struct _Benchmark
     benchmark_fn_t         func;
     
     size_t iterations;
+    size_t size; // Bytes processed per iteration, 0 if throughput doesn't apply.
 
     struct _Benchmark* next;
 } Benchmark;
@@ -25,6 +26,22 @@ void AddBenchmark(const char* name,
                   benchmark_fn_setup_t funcSetup,
                   benchmark_fn_cleanup_t funcCleanup,
                   size_t iterations);
-void RunBenchmarks();
+void AddSizedBenchmark(const char* name,
+                       benchmark_fn_t func,
+                       benchmark_fn_setup_t funcSetup,
+                       benchmark_fn_cleanup_t funcCleanup,
+                       size_t iterations,
+                       size_t size);
+
+/** Get the size of the benchmark currently being set up or run. */
+size_t GetBenchmarkSize();
+
+/**
+ * Run all benchmarks. Sized benchmarks above EXIB_BENCHMARK_SMALL are skipped
+ * unless `large` is set, which keeps the default run quick enough for CI.
+ */
+void RunBenchmarks(int large);
+
+#define EXIB_BENCHMARK_SMALL (16 * 1024 * 1024)
 
 #endif // _BENCHMARK_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <EXIB/EXIB.h>
+#include "AllocatorInternal.h"
+#include "Benchmark.h"
+
+#define ALLOC_OBJECT_SIZE 48 // Size of an encoder field.
+
+typedef struct _AllocBenchmark
+{
+    EXIB_MemoryPool pool;
+    size_t count;
+    void** objects;
+} AllocBenchmark;
+
+void* SetupAllocBenchmark()
+{
+    AllocBenchmark* benchmark = malloc(sizeof(AllocBenchmark));
+
+    EXIB_InitializePool(&benchmark->pool, ALLOC_OBJECT_SIZE);
+    benchmark->count = GetBenchmarkSize() / ALLOC_OBJECT_SIZE;
+    benchmark->objects = malloc(benchmark->count * sizeof(void*));
+    return benchmark;
+}
+
+void CleanupAllocBenchmark(void* parameter)
+{
+    AllocBenchmark* benchmark = parameter;
+
+    EXIB_DestroyPool(&benchmark->pool);
+    free(benchmark->objects);
+    free(benchmark);
+}
+
+void Benchmark_PoolAllocFree(void* parameter)
+{
+    AllocBenchmark* benchmark = parameter;
+
+    for (size_t i = 0; i < benchmark->count; ++i)
+        benchmark->objects[i] = EXIB_PoolAlloc(&benchmark->pool);
+
+    for (size_t i = 0; i < benchmark->count; ++i)
+        EXIB_PoolFree(&benchmark->pool, benchmark->objects[i]);
+}
+
+// Baseline to compare the pool against.
+void Benchmark_MallocFree(void* parameter)
+{
+    AllocBenchmark* benchmark = parameter;
+
+    for (size_t i = 0; i < benchmark->count; ++i)
+        benchmark->objects[i] = malloc(ALLOC_OBJECT_SIZE);
+
+    for (size_t i = 0; i < benchmark->count; ++i)
+        free(benchmark->objects[i]);
+}
+
+void AddAllocatorBenchmarks()
+{
+    static const char* poolNames[] = {
+        "Pool_AllocFree (10^3)",
+        "Pool_AllocFree (10^4)",
+        "Pool_AllocFree (10^5)",
+        "Pool_AllocFree (10^6)",
+        "Pool_AllocFree (10^7)"
+    };
+    static const char* mallocNames[] = {
+        "Malloc_AllocFree (10^3)",
+        "Malloc_AllocFree (10^4)",
+        "Malloc_AllocFree (10^5)",
+        "Malloc_AllocFree (10^6)",
+        "Malloc_AllocFree (10^7)"
+    };
+
+    // 10^3 to 10^7 allocations per iteration, sized by the number of bytes allocated.
+    for (int i = (int)(sizeof(poolNames) / sizeof(poolNames[0])) - 1; i >= 0; --i)
+    {
+        size_t count = 1000;
+        for (int j = 0; j < i; ++j)
+            count *= 10;
+
+        size_t iterations = 10000000 / count;
+
+        AddSizedBenchmark(mallocNames[i],
+            Benchmark_MallocFree,
+            SetupAllocBenchmark,
+            CleanupAllocBenchmark,
+            iterations,
+            count * ALLOC_OBJECT_SIZE);
+        AddSizedBenchmark(poolNames[i],
+            Benchmark_PoolAllocFree,
+            SetupAllocBenchmark,
+            CleanupAllocBenchmark,
+            iterations,
+            count * ALLOC_OBJECT_SIZE);
+    }
+}
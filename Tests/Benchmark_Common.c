@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <EXIB/EXIB.h>
+#include "CRC32CInternal.h"
+#include "LZInternal.h"
+#include "PackInternal.h"
+#include "Benchmark.h"
+
+typedef struct _CRCBenchmark
+{
+    uint8_t* buffer;
+    size_t size;
+} CRCBenchmark;
+
+void* SetupCRCBenchmark()
+{
+    CRCBenchmark* benchmark = malloc(sizeof(CRCBenchmark));
+
+    benchmark->size = GetBenchmarkSize();
+    benchmark->buffer = malloc(benchmark->size);
+    for (size_t i = 0; i < benchmark->size; ++i)
+        benchmark->buffer[i] = (uint8_t)(i * 131);
+
+    EXIB_CRC32C_Initialize();
+    return benchmark;
+}
+
+void CleanupCRCBenchmark(void* parameter)
+{
+    CRCBenchmark* benchmark = parameter;
+
+    free(benchmark->buffer);
+    free(benchmark);
+}
+
+// Keeps the compiler from dropping CRCs that are never used.
+static volatile uint32_t s_CRC;
+
+void Benchmark_CRC32C(void* parameter)
+{
+    CRCBenchmark* benchmark = parameter;
+    s_CRC = EXIB_CRC32C(0, benchmark->buffer, benchmark->size);
+}
+
+void Benchmark_CRC32C_Bytewise(void* parameter)
+{
+    CRCBenchmark* benchmark = parameter;
+    s_CRC = EXIB_CRC32C_Bytewise(0, benchmark->buffer, benchmark->size);
+}
+
+void Benchmark_CRC32C_Sliced(void* parameter)
+{
+    CRCBenchmark* benchmark = parameter;
+    s_CRC = EXIB_CRC32C_Sliced(0, benchmark->buffer, benchmark->size);
+}
+
+void Benchmark_CRC32C_Hardware(void* parameter)
+{
+    CRCBenchmark* benchmark = parameter;
+    s_CRC = EXIB_CRC32C_Hardware(0, benchmark->buffer, benchmark->size);
+}
+
+static void Benchmark_CRC32C_Parallel(CRCBenchmark* benchmark, int threads)
+{
+    s_CRC = EXIB_CRC32C_Parallel(0, benchmark->buffer, benchmark->size, threads);
+}
+
+void Benchmark_CRC32C_Parallel1(void* parameter) { Benchmark_CRC32C_Parallel(parameter, 1); }
+void Benchmark_CRC32C_Parallel2(void* parameter) { Benchmark_CRC32C_Parallel(parameter, 2); }
+void Benchmark_CRC32C_Parallel4(void* parameter) { Benchmark_CRC32C_Parallel(parameter, 4); }
+void Benchmark_CRC32C_Parallel8(void* parameter) { Benchmark_CRC32C_Parallel(parameter, 8); }
+
+// Scaling of the parallel checksum with the number of threads, on large buffers only.
+static void AddParallelBenchmarks()
+{
+    static const char* sizeNames[] = { "16 MiB", "256 MiB", "1 GiB" };
+    static const size_t sizes[] = { 16 * 1024 * 1024, 256 * 1024 * 1024, 1024 * 1024 * 1024 };
+    static const benchmark_fn_t functions[] = {
+        Benchmark_CRC32C_Parallel1, Benchmark_CRC32C_Parallel2,
+        Benchmark_CRC32C_Parallel4, Benchmark_CRC32C_Parallel8
+    };
+    static const int threads[] = { 1, 2, 4, 8 };
+    static char names[3][4][48];
+
+    for (int i = 2; i >= 0; --i)
+    {
+        size_t iterations = sizes[i] >= (256 * 1024 * 1024) ? 1 : 4;
+
+        for (int t = 3; t >= 0; --t)
+        {
+            snprintf(names[i][t], sizeof(names[i][t]), "CRC32C_Parallel (%s, %d threads)", sizeNames[i], threads[t]);
+            AddSizedBenchmark(names[i][t], functions[t],
+                SetupCRCBenchmark, CleanupCRCBenchmark, iterations, sizes[i]);
+        }
+    }
+}
+
+typedef struct _LZBenchmark
+{
+    uint8_t* data;
+    uint8_t* compressed;
+    uint8_t* decompressed;
+    size_t size;
+    size_t compressedSize;
+} LZBenchmark;
+
+void* SetupLZBenchmark()
+{
+    static const char* words[] = { "GET ", "POST ", "/index.html ", "200 ", "404 ", "ms ", "user=", "id=" };
+    LZBenchmark* benchmark = malloc(sizeof(LZBenchmark));
+    size_t capacity;
+
+    benchmark->size = GetBenchmarkSize();
+    benchmark->data = malloc(benchmark->size);
+    benchmark->decompressed = malloc(benchmark->size);
+
+    // Something like a log attachment: repeated words with numbers in between.
+    for (size_t i = 0; i < benchmark->size;)
+    {
+        const char* word = words[rand() % 8];
+        for (; *word && i < benchmark->size; ++word)
+            benchmark->data[i++] = *word;
+        if (i < benchmark->size)
+            benchmark->data[i++] = '0' + rand() % 10;
+    }
+
+    capacity = benchmark->size + benchmark->size / 255 + 16;
+    benchmark->compressed = malloc(capacity);
+    benchmark->compressedSize = EXIB_LZ_Compress(benchmark->data, benchmark->size, benchmark->compressed, capacity);
+    return benchmark;
+}
+
+void CleanupLZBenchmark(void* parameter)
+{
+    LZBenchmark* benchmark = parameter;
+
+    free(benchmark->data);
+    free(benchmark->compressed);
+    free(benchmark->decompressed);
+    free(benchmark);
+}
+
+void Benchmark_LZ_Compress(void* parameter)
+{
+    LZBenchmark* benchmark = parameter;
+    size_t capacity = benchmark->size + benchmark->size / 255 + 16;
+    benchmark->compressedSize = EXIB_LZ_Compress(benchmark->data, benchmark->size, benchmark->compressed, capacity);
+}
+
+void Benchmark_LZ_Decompress(void* parameter)
+{
+    LZBenchmark* benchmark = parameter;
+    EXIB_LZ_Decompress(benchmark->compressed, benchmark->compressedSize, benchmark->decompressed, benchmark->size);
+}
+
+// Throughput is measured against the uncompressed size either way.
+static void AddLZBenchmarks()
+{
+    static const char* sizeNames[] = { "64 KiB", "16 MiB" };
+    static const size_t sizes[] = { 64 * 1024, 16 * 1024 * 1024 };
+    static char names[2][2][48];
+
+    for (int i = 1; i >= 0; --i)
+    {
+        size_t iterations = (64 * 1024 * 1024) / sizes[i];
+
+        snprintf(names[0][i], sizeof(names[0][i]), "LZ_Compress (%s)", sizeNames[i]);
+        snprintf(names[1][i], sizeof(names[1][i]), "LZ_Decompress (%s)", sizeNames[i]);
+
+        AddSizedBenchmark(names[0][i], Benchmark_LZ_Compress,
+            SetupLZBenchmark, CleanupLZBenchmark, iterations, sizes[i]);
+        AddSizedBenchmark(names[1][i], Benchmark_LZ_Decompress,
+            SetupLZBenchmark, CleanupLZBenchmark, iterations, sizes[i]);
+    }
+}
+
+typedef struct _PackBenchmark
+{
+    EXIB_Type type;
+    EXIB_ArrayPacking packing;
+    int delta;
+    uint8_t* elements;
+    uint8_t* packed;
+    uint8_t* unpacked;
+    size_t count;
+    size_t packedSize;
+} PackBenchmark;
+
+typedef enum _PackData
+{
+    PACK_DATA_TIMESTAMPS, // Nanosecond timestamps of samples taken every millisecond, with some jitter.
+    PACK_DATA_COUNTERS,   // Packet counters, which grow by a few hundred at a time.
+    PACK_DATA_STATES      // States that change every few hundred samples.
+} PackData;
+
+static PackBenchmark* CreatePackBenchmark(PackData data, size_t size)
+{
+    static const EXIB_Type types[] = { EXIB_TYPE_INT64, EXIB_TYPE_UINT32, EXIB_TYPE_UINT8 };
+    static const EXIB_ArrayPacking packings[] = { EXIB_PACKING_BITS, EXIB_PACKING_VARINT, EXIB_PACKING_RLE };
+    PackBenchmark* benchmark = malloc(sizeof(PackBenchmark));
+    uint32_t counter = 0;
+
+    benchmark->type = types[data];
+    benchmark->packing = packings[data];
+    benchmark->delta = data != PACK_DATA_STATES;
+    benchmark->count = size / EXIB_GetTypeSize(benchmark->type);
+    benchmark->elements = malloc(size);
+    benchmark->unpacked = malloc(size);
+    benchmark->packed = malloc(EXIB_PACK_Bound(benchmark->packing, benchmark->count));
+
+    for (size_t i = 0; i < benchmark->count;)
+    {
+        if (data == PACK_DATA_TIMESTAMPS)
+            ((int64_t*)benchmark->elements)[i++] = 1700000000000000000ll + (int64_t)i * 1000000 + rand() % 1000;
+        else if (data == PACK_DATA_COUNTERS)
+            ((uint32_t*)benchmark->elements)[i++] = counter += rand() % 300;
+        else
+        {
+            size_t run = 1 + rand() % 500;
+            uint8_t state = (uint8_t)(rand() % 4);
+            for (; run > 0 && i < benchmark->count; --run)
+                benchmark->elements[i++] = state;
+        }
+    }
+
+    benchmark->packedSize = EXIB_PACK_Encode(benchmark->type, benchmark->elements, benchmark->count, benchmark->packing,
+                                             benchmark->delta, benchmark->packed, EXIB_PACK_Bound(benchmark->packing, benchmark->count));
+    return benchmark;
+}
+
+void* SetupPackTimestamps() { return CreatePackBenchmark(PACK_DATA_TIMESTAMPS, GetBenchmarkSize()); }
+void* SetupPackCounters() { return CreatePackBenchmark(PACK_DATA_COUNTERS, GetBenchmarkSize()); }
+void* SetupPackStates() { return CreatePackBenchmark(PACK_DATA_STATES, GetBenchmarkSize()); }
+
+void CleanupPackBenchmark(void* parameter)
+{
+    PackBenchmark* benchmark = parameter;
+
+    free(benchmark->elements);
+    free(benchmark->packed);
+    free(benchmark->unpacked);
+    free(benchmark);
+}
+
+void Benchmark_PACK_Encode(void* parameter)
+{
+    PackBenchmark* benchmark = parameter;
+    benchmark->packedSize = EXIB_PACK_Encode(benchmark->type, benchmark->elements, benchmark->count, benchmark->packing,
+                                             benchmark->delta, benchmark->packed, EXIB_PACK_Bound(benchmark->packing, benchmark->count));
+}
+
+static void Benchmark_PACK_Decode(PackBenchmark* benchmark, const EXIB_PACK_Kernels* kernels)
+{
+    EXIB_PACK_Decode(kernels, benchmark->type, benchmark->packing, benchmark->packed, benchmark->packedSize,
+                     benchmark->unpacked, benchmark->count);
+}
+
+void Benchmark_PACK_Decode_Scalar(void* parameter) { Benchmark_PACK_Decode(parameter, &EXIB_PACK_Scalar); }
+void Benchmark_PACK_Decode_SSE4(void* parameter) { Benchmark_PACK_Decode(parameter, &EXIB_PACK_SSE4); }
+void Benchmark_PACK_Decode_AVX2(void* parameter) { Benchmark_PACK_Decode(parameter, &EXIB_PACK_AVX2); }
+
+// What reading the raw layout costs: a copy of the elements.
+void Benchmark_PACK_Raw(void* parameter)
+{
+    PackBenchmark* benchmark = parameter;
+    memcpy(benchmark->unpacked, benchmark->elements, benchmark->count * EXIB_GetTypeSize(benchmark->type));
+}
+
+// Throughput is measured against the raw size, and the names include the size of the packed data relative to it.
+static void AddPackBenchmarks()
+{
+    static const char* dataNames[] = { "timestamps, delta + bits", "counters, delta + varint", "states, RLE" };
+    static const benchmark_fn_setup_t setups[] = { SetupPackTimestamps, SetupPackCounters, SetupPackStates };
+    static const benchmark_fn_t decoders[] = { Benchmark_PACK_Decode_Scalar, Benchmark_PACK_Decode_SSE4, Benchmark_PACK_Decode_AVX2 };
+    static const char* decoderNames[] = { "Scalar", "SSE4.1", "AVX2" };
+    static char names[3][5][80];
+    const size_t size = 1024 * 1024;
+    const size_t iterations = 256;
+
+    int supported[] = { 1, EXIB_PACK_SSE4Supported(), EXIB_PACK_AVX2Supported() };
+
+    for (int i = 2; i >= 0; --i)
+    {
+        // Pack the data once up front for its ratio.
+        PackBenchmark* sample = CreatePackBenchmark((PackData)i, size);
+        double ratio = (double)size / (double)sample->packedSize;
+        CleanupPackBenchmark(sample);
+
+        snprintf(names[i][0], sizeof(names[i][0]), "PACK_Raw (%s, 1 MiB)", dataNames[i]);
+        snprintf(names[i][1], sizeof(names[i][1]), "PACK_Encode (%s, 1 MiB, %.1fx smaller)", dataNames[i], ratio);
+        AddSizedBenchmark(names[i][0], Benchmark_PACK_Raw, setups[i], CleanupPackBenchmark, iterations, size);
+        AddSizedBenchmark(names[i][1], Benchmark_PACK_Encode, setups[i], CleanupPackBenchmark, iterations, size);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            if (!supported[k])
+                continue;
+
+            snprintf(names[i][2 + k], sizeof(names[i][2 + k]), "PACK_Decode (%s, 1 MiB, %s)", dataNames[i], decoderNames[k]);
+            AddSizedBenchmark(names[i][2 + k], decoders[k], setups[i], CleanupPackBenchmark, iterations, size);
+        }
+    }
+}
+
+void AddCommonBenchmarks()
+{
+    static const char* sizeNames[] = {
+        "64 B", "1 KiB", "64 KiB", "1 MiB", "16 MiB", "256 MiB", "1 GiB"
+    };
+    static const size_t sizes[] = {
+        64, 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 256 * 1024 * 1024, 1024 * 1024 * 1024
+    };
+    static char names[4][7][48];
+
+    EXIB_CRC32C_Initialize();
+    AddParallelBenchmarks();
+    AddLZBenchmarks();
+    AddPackBenchmarks();
+
+    // Sizes above 16 MiB only run with the large benchmarks.
+    for (int i = (int)(sizeof(sizes) / sizeof(sizes[0])) - 1; i >= 0; --i)
+    {
+        size_t iterations = (64 * 1024 * 1024) / sizes[i];
+        if (iterations == 0)
+            iterations = 1;
+
+        snprintf(names[0][i], sizeof(names[0][i]), "CRC32C_Bytewise (%s)", sizeNames[i]);
+        snprintf(names[1][i], sizeof(names[1][i]), "CRC32C_Sliced (%s)", sizeNames[i]);
+        snprintf(names[2][i], sizeof(names[2][i]), "CRC32C_Hardware (%s)", sizeNames[i]);
+        snprintf(names[3][i], sizeof(names[3][i]), "CRC32C (%s)", sizeNames[i]);
+
+        AddSizedBenchmark(names[0][i], Benchmark_CRC32C_Bytewise,
+            SetupCRCBenchmark, CleanupCRCBenchmark, iterations, sizes[i]);
+        AddSizedBenchmark(names[1][i], Benchmark_CRC32C_Sliced,
+            SetupCRCBenchmark, CleanupCRCBenchmark, iterations, sizes[i]);
+        if (EXIB_CRC32C_HardwareSupported())
+        {
+            AddSizedBenchmark(names[2][i], Benchmark_CRC32C_Hardware,
+                SetupCRCBenchmark, CleanupCRCBenchmark, iterations, sizes[i]);
+        }
+        AddSizedBenchmark(names[3][i], Benchmark_CRC32C,
+            SetupCRCBenchmark, CleanupCRCBenchmark, iterations, sizes[i]);
+    }
+}
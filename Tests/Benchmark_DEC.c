@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
 #include <EXIB/EXIB.h>
+#include <EXIB/Encoder.h>
 #include <EXIB/Decoder.h>
+#include <EXIB/Delta.h>
 #include "Benchmark.h"
 #include "Samples.h"
 
@@ -108,8 +112,239 @@ void Benchmark_DEC_ArrayNext(void* parameter)
 }
 
 
+#define BIND_FIELDS 16
+
+typedef struct
+{
+    EXIB_DEC_Context* ctx;
+    EXIB_DEC_Binding bindings[BIND_FIELDS];
+    char names[BIND_FIELDS][4];
+    uint32_t record[BIND_FIELDS];
+    void* datum;
+    size_t datumSize;
+} BindBenchmarkData;
+
+// A record of 16 fields, read in full by each iteration.
+void* SetupBindDecoder()
+{
+    BindBenchmarkData* data = EXIB_Calloc(1, sizeof(BindBenchmarkData));
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_Header* header;
+
+    for (int i = 0; i < BIND_FIELDS; ++i)
+    {
+        snprintf(data->names[i], sizeof(data->names[i]), "f%d", i);
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, data->names[i], EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = i });
+
+        data->bindings[i].name = data->names[i];
+        data->bindings[i].type = EXIB_TYPE_UINT32;
+        data->bindings[i].offset = i * sizeof(uint32_t);
+    }
+
+    header = EXIB_ENC_Encode(encoder);
+    data->datumSize = header->datumSize;
+    data->datum = EXIB_Alloc(data->datumSize);
+    memcpy(data->datum, header, data->datumSize);
+    EXIB_ENC_FreeContext(encoder);
+
+    data->ctx = EXIB_DEC_CreateBufferedContext(data->datum, data->datumSize, NULL);
+    return data;
+}
+
+void CleanupBindDecoder(void* parameter)
+{
+    BindBenchmarkData* data = parameter;
+    EXIB_DEC_FreeContext(data->ctx);
+    EXIB_Free(data->datum);
+    EXIB_Free(data);
+}
+
+void Benchmark_DEC_FindField_Record(void* parameter)
+{
+    BindBenchmarkData* data = parameter;
+    EXIB_DEC_FieldValue value;
+
+    for (int i = 0; i < BIND_FIELDS; ++i)
+    {
+        EXIB_DEC_FieldGet(data->ctx, EXIB_DEC_FindField(data->ctx, NULL, data->names[i]), &value);
+        memcpy(&data->record[i], value.value, sizeof(uint32_t));
+    }
+}
+
+void Benchmark_DEC_Bind(void* parameter)
+{
+    BindBenchmarkData* data = parameter;
+    EXIB_DEC_Bind(data->ctx, NULL, data->bindings, BIND_FIELDS, data->record);
+}
+
+typedef struct
+{
+    EXIB_DEC_Context* ctx;
+    EXIB_DEC_Field counter;
+    uint32_t value;
+    void* datum;
+    size_t datumSize;
+} PatchBenchmarkData;
+
+// A counter next to 1 MiB of samples.
+void* SetupPatchDecoder()
+{
+    PatchBenchmarkData* data = EXIB_Calloc(1, sizeof(PatchBenchmarkData));
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_Header* header;
+
+    EXIB_ENC_ArrayResize(EXIB_ENC_AddArray(encoder, NULL, "samples", EXIB_TYPE_DOUBLE), 128 * 1024);
+    EXIB_ENC_AddField(encoder, NULL, "counter", EXIB_TYPE_UINT32);
+
+    header = EXIB_ENC_Encode(encoder);
+    data->datumSize = header->datumSize;
+    data->datum = EXIB_Alloc(data->datumSize);
+    memcpy(data->datum, header, data->datumSize);
+    EXIB_ENC_FreeContext(encoder);
+
+    data->ctx = EXIB_DEC_CreateBufferedContext(data->datum, data->datumSize, NULL);
+    data->counter = EXIB_DEC_FindField(data->ctx, NULL, "counter");
+    return data;
+}
+
+void CleanupPatchDecoder(void* parameter)
+{
+    PatchBenchmarkData* data = parameter;
+    EXIB_DEC_FreeContext(data->ctx);
+    EXIB_Free(data->datum);
+    EXIB_Free(data);
+}
+
+void Benchmark_DEC_PatchField(void* parameter)
+{
+    PatchBenchmarkData* data = parameter;
+    EXIB_DEC_PatchField(data->ctx, data->counter, (EXIB_Value){ .uint32 = ++data->value });
+}
+
+// What patching replaces: writing the value and checksumming the whole datum again.
+void Benchmark_DEC_PatchField_Rechecksum(void* parameter)
+{
+    PatchBenchmarkData* data = parameter;
+    EXIB_Header* header = data->datum;
+    EXIB_DEC_FieldValue value;
+
+    ++data->value;
+    EXIB_DEC_FieldGet(data->ctx, data->counter, &value);
+    memcpy((void*)value.value, &data->value, sizeof(data->value));
+    header->checksum = 0;
+    header->checksum = EXIB_CRC32C(0, header, header->datumSize);
+}
+
+typedef struct
+{
+    EXIB_Header* base;
+    EXIB_Header* next;
+    EXIB_Header* out;
+    uint8_t* patch;
+    size_t patchSize;
+    size_t capacity;
+} DeltaBenchmarkData;
+
+#define DELTA_CHANNELS 8
+
+// Slowly-changing state: 8 channels of 4 readings and 64 samples, of which 4 values change.
+static EXIB_Header* EncodeDeltaState(int step)
+{
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    static const char* readings[] = { "voltage", "current", "temperature", "errors" };
+    char name[16];
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "sequence", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = step });
+    for (int i = 0; i < DELTA_CHANNELS; ++i)
+    {
+        snprintf(name, sizeof(name), "channel%d", i);
+        EXIB_ENC_Object* channel = EXIB_ENC_AddObject(encoder, NULL, name);
+        for (int r = 0; r < 4; ++r)
+        {
+            double value = 100.0 * i + r + ((i == 3 && r == 1) ? step * 0.5 : 0.0);
+            EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, channel, readings[r], EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = value });
+        }
+
+        EXIB_ENC_Array* samples = EXIB_ENC_AddArray(encoder, channel, "samples", EXIB_TYPE_INT16);
+        EXIB_ENC_ArrayResize(samples, 64);
+        for (int s = 0; s < 64; ++s)
+            EXIB_ENC_ArraySet(samples, s, (EXIB_Value){ .int16 = (int16_t)((i == 5 && s >= 10 && s < 12) ? step : s) });
+    }
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    EXIB_Header* datum = EXIB_Alloc(header->datumSize);
+    memcpy(datum, header, header->datumSize);
+    EXIB_ENC_FreeContext(encoder);
+    return datum;
+}
+
+void* SetupDelta()
+{
+    DeltaBenchmarkData* data = EXIB_Calloc(1, sizeof(DeltaBenchmarkData));
+
+    data->base = EncodeDeltaState(1);
+    data->next = EncodeDeltaState(2);
+    data->capacity = EXIB_DELTA_Bound(data->next);
+    data->patch = EXIB_Alloc(data->capacity);
+    data->patchSize = EXIB_DELTA_Encode(data->base, data->next, data->patch, data->capacity);
+    data->out = EXIB_Alloc(data->next->datumSize);
+    return data;
+}
+
+void CleanupDelta(void* parameter)
+{
+    DeltaBenchmarkData* data = parameter;
+    EXIB_Free(data->out);
+    EXIB_Free(data->patch);
+    EXIB_Free(data->next);
+    EXIB_Free(data->base);
+    EXIB_Free(data);
+}
+
+void Benchmark_DELTA_Encode(void* parameter)
+{
+    DeltaBenchmarkData* data = parameter;
+    EXIB_DELTA_Encode(data->base, data->next, data->patch, data->capacity);
+}
+
+void Benchmark_DELTA_Apply(void* parameter)
+{
+    DeltaBenchmarkData* data = parameter;
+    EXIB_DELTA_Apply(data->base, data->patch, data->patchSize, data->out, data->next->datumSize);
+}
+
 void AddDecoderBenchmarks()
 {
+    AddBenchmark("DELTA_Apply (8 channels, 4 values changed)",
+        Benchmark_DELTA_Apply,
+        SetupDelta,
+        CleanupDelta,
+        100000);
+    AddBenchmark("DELTA_Encode (8 channels, 4 values changed)",
+        Benchmark_DELTA_Encode,
+        SetupDelta,
+        CleanupDelta,
+        100000);
+    AddBenchmark("DEC_PatchField (Full Checksum, 1 MiB datum)",
+        Benchmark_DEC_PatchField_Rechecksum,
+        SetupPatchDecoder,
+        CleanupPatchDecoder,
+        1000);
+    AddBenchmark("DEC_PatchField (1 MiB datum)",
+        Benchmark_DEC_PatchField,
+        SetupPatchDecoder,
+        CleanupPatchDecoder,
+        100000);
+    AddBenchmark("DEC_Bind (16 fields)",
+        Benchmark_DEC_Bind,
+        SetupBindDecoder,
+        CleanupBindDecoder,
+        100000);
+    AddBenchmark("DEC_FindField (16 fields)",
+        Benchmark_DEC_FindField_Record,
+        SetupBindDecoder,
+        CleanupBindDecoder,
+        100000);
     AddBenchmark("DEC_ResetContext",
         Benchmark_DEC_ResetContext,
         SetupDecoder,
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <EXIB/EXIB.h>
 #include <EXIB/Encoder.h>
 #include "Benchmark.h"
@@ -34,8 +35,566 @@ void Benchmark_ENC_AddField_Random(void* parameter)
     EXIB_ENC_AddField(ctx, NULL, name, EXIB_TYPE_INT32);
 }
 
+#define NESTED_DEPTH 8
+
+// Chain of nested objects, each holding a few fields and an equal share of the data.
+void* SetupNestedEncoder()
+{
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(NULL);
+    EXIB_ENC_Object* object = NULL;
+    size_t elements = GetBenchmarkSize() / (NESTED_DEPTH * sizeof(double));
+
+    for (int i = 0; i < NESTED_DEPTH; ++i)
+    {
+        object = EXIB_ENC_AddObject(ctx, object, "nested");
+
+        EXIB_ENC_Field* id = EXIB_ENC_AddField(ctx, object, "id", EXIB_TYPE_UINT8);
+        EXIB_ENC_SetValue(id, (EXIB_Value){ .uint8 = i });
+
+        EXIB_ENC_Array* samples = EXIB_ENC_AddArray(ctx, object, "samples", EXIB_TYPE_DOUBLE);
+        EXIB_ENC_ArrayResize(samples, elements);
+        double* data = EXIB_ENC_ArrayGetData(samples);
+        for (size_t j = 0; j < elements; ++j)
+            data[j] = (double)j;
+
+        EXIB_ENC_Field* timestamp = EXIB_ENC_AddField(ctx, object, "timestamp", EXIB_TYPE_UINT64);
+        EXIB_ENC_SetValue(timestamp, (EXIB_Value){ .uint64 = 0x123456789ULL });
+    }
+
+    return ctx;
+}
+
+void Benchmark_ENC_Encode(void* parameter)
+{
+    EXIB_ENC_Encode(parameter);
+}
+
+#define WIDE_CHILDREN 64
+
+// Root with many large children, like per-channel arrays and per-shard objects.
+void* SetupWideEncoder()
+{
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(NULL);
+    size_t elements = GetBenchmarkSize() / (WIDE_CHILDREN * sizeof(double));
+
+    for (int i = 0; i < WIDE_CHILDREN; ++i)
+    {
+        EXIB_ENC_Object* shard = (i % 2) ? EXIB_ENC_AddObject(ctx, NULL, "shard") : NULL;
+        EXIB_ENC_Array* samples = EXIB_ENC_AddArray(ctx, shard, "samples", EXIB_TYPE_DOUBLE);
+
+        EXIB_ENC_ArrayResize(samples, elements);
+        double* data = EXIB_ENC_ArrayGetData(samples);
+        for (size_t j = 0; j < elements; ++j)
+            data[j] = (double)j;
+    }
+
+    // The first encode allocates the buffer, so it isn't part of the measurement.
+    EXIB_ENC_Encode(ctx);
+    return ctx;
+}
+
+static void Benchmark_ENC_EncodeParallel(void* parameter, int threads)
+{
+    EXIB_ENC_EncodeParallel(parameter, threads);
+}
+
+void Benchmark_ENC_EncodeParallel1(void* parameter) { Benchmark_ENC_EncodeParallel(parameter, 1); }
+void Benchmark_ENC_EncodeParallel2(void* parameter) { Benchmark_ENC_EncodeParallel(parameter, 2); }
+void Benchmark_ENC_EncodeParallel4(void* parameter) { Benchmark_ENC_EncodeParallel(parameter, 4); }
+void Benchmark_ENC_EncodeParallel8(void* parameter) { Benchmark_ENC_EncodeParallel(parameter, 8); }
+
+// Scaling of the parallel encoder with the number of threads, checksum included.
+static void AddParallelEncodeBenchmarks()
+{
+    static const char* sizeNames[] = { "16 MiB", "256 MiB" };
+    static const size_t sizes[] = { 16 * 1024 * 1024, 256 * 1024 * 1024 };
+    static const benchmark_fn_t functions[] = {
+        Benchmark_ENC_EncodeParallel1, Benchmark_ENC_EncodeParallel2,
+        Benchmark_ENC_EncodeParallel4, Benchmark_ENC_EncodeParallel8
+    };
+    static const int threads[] = { 1, 2, 4, 8 };
+    static char names[2][4][48];
+
+    for (int i = 1; i >= 0; --i)
+    {
+        size_t iterations = (256 * 1024 * 1024) / sizes[i];
+
+        for (int t = 3; t >= 0; --t)
+        {
+            snprintf(names[i][t], sizeof(names[i][t]), "ENC_EncodeParallel (%s, %d threads)", sizeNames[i], threads[t]);
+            AddSizedBenchmark(names[i][t], functions[t],
+                SetupWideEncoder, CleanupEncoder, iterations, sizes[i]);
+        }
+    }
+}
+
+#define TELEMETRY_RECORDS 256
+
+// Telemetry frame of small records, built as a tree from scratch every time.
+void Benchmark_ENC_Telemetry_Tree(void* parameter)
+{
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(NULL);
+    EXIB_ENC_Array* records = EXIB_ENC_AddArray(ctx, NULL, "records", EXIB_TYPE_OBJECT);
+
+    for (int i = 0; i < TELEMETRY_RECORDS; ++i)
+    {
+        EXIB_ENC_Object* record = EXIB_ENC_ArrayAddObject(ctx, records);
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "timestamp", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "x", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "y", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "z", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "status", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 1 });
+    }
+
+    EXIB_ENC_Encode(ctx);
+    EXIB_ENC_FreeContext(ctx);
+}
+
+// Same frame written with the stream writer, reusing the context.
+void Benchmark_ENC_Telemetry_Stream(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_BeginStream(ctx);
+    EXIB_ENC_BeginArray(ctx, "records", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < TELEMETRY_RECORDS; ++i)
+    {
+        EXIB_ENC_BeginObject(ctx, NULL);
+        EXIB_ENC_WriteUInt64(ctx, "timestamp", i);
+        EXIB_ENC_WriteFloat(ctx, "x", i);
+        EXIB_ENC_WriteFloat(ctx, "y", i);
+        EXIB_ENC_WriteFloat(ctx, "z", i);
+        EXIB_ENC_WriteUInt8(ctx, "status", 1);
+        EXIB_ENC_EndObject(ctx);
+    }
+    EXIB_ENC_EndArray(ctx);
+    EXIB_ENC_EndStream(ctx);
+}
+
+static size_t s_Allocations = 0;
+
+static void* CountingMalloc(size_t n)
+{
+    ++s_Allocations;
+    return malloc(n);
+}
+
+// Telemetry frame built into a context that is reset for every message.
+void Benchmark_ENC_Telemetry_Reset(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 1);
+
+    EXIB_ENC_Array* records = EXIB_ENC_AddArray(ctx, NULL, "records", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < TELEMETRY_RECORDS; ++i)
+    {
+        EXIB_ENC_Object* record = EXIB_ENC_ArrayAddObject(ctx, records);
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "timestamp", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "x", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "y", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "z", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, record, "status", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 1 });
+    }
+
+    EXIB_ENC_Encode(ctx);
+}
+
+typedef struct _TelemetryRecord
+{
+    uint64_t timestamp;
+    float x, y, z;
+    uint8_t status;
+} TelemetryRecord;
+
+typedef struct _TelemetryFrame
+{
+    TelemetryRecord records[TELEMETRY_RECORDS];
+} TelemetryFrame;
+
+static const EXIB_ENC_Binding s_RecordBindings[] = {
+    { "timestamp", EXIB_TYPE_UINT64, offsetof(TelemetryRecord, timestamp) },
+    { "x", EXIB_TYPE_FLOAT, offsetof(TelemetryRecord, x) },
+    { "y", EXIB_TYPE_FLOAT, offsetof(TelemetryRecord, y) },
+    { "z", EXIB_TYPE_FLOAT, offsetof(TelemetryRecord, z) },
+    { "status", EXIB_TYPE_UINT8, offsetof(TelemetryRecord, status) }
+};
+
+static const EXIB_ENC_Binding s_FrameBindings[] = {
+    { "records", EXIB_TYPE_ARRAY, offsetof(TelemetryFrame, records), EXIB_TYPE_OBJECT,
+      TELEMETRY_RECORDS, sizeof(TelemetryRecord), s_RecordBindings, 5 }
+};
+
+static TelemetryFrame s_TelemetryFrame;
+
+// Same records as a struct, in an object of its own, added to a context that is reset for every message.
+void Benchmark_ENC_Telemetry_Struct(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 1);
+
+    for (int i = 0; i < TELEMETRY_RECORDS; ++i)
+    {
+        TelemetryRecord* record = &s_TelemetryFrame.records[i];
+        record->timestamp = i;
+        record->x = record->y = record->z = i;
+        record->status = 1;
+    }
+
+    EXIB_ENC_AddStruct(ctx, NULL, "frame", s_FrameBindings, 1, &s_TelemetryFrame);
+    EXIB_ENC_Encode(ctx);
+}
+
+// Warm the context up, then count every allocation the benchmark makes.
+void* SetupResetEncoder()
+{
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(NULL);
+    Benchmark_ENC_Telemetry_Reset(ctx);
+
+    s_Allocations = 0;
+    EXIB_SetAllocator(CountingMalloc, free);
+    return ctx;
+}
+
+void CleanupResetEncoder(void* parameter)
+{
+    EXIB_SetAllocator(malloc, free);
+    printf("TEST: \tBENCHMARK: \t%zu allocations in steady state\n", s_Allocations);
+    EXIB_ENC_FreeContext(parameter);
+}
+
+static EXIB_Dictionary* s_MessageDictionary = NULL;
+
+// A single record per datum, in a context that doesn't keep its names across messages.
+void Benchmark_ENC_SmallMessage(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 0);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "timestamp", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = 1234 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "x", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = 1 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "y", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = 2 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "z", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = 3 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "status", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 1 });
+    EXIB_ENC_Encode(ctx);
+}
+
+// Same message, with its names in a dictionary instead of every datum's string table.
+void* SetupDictionaryEncoder()
+{
+    static const char* names[] = { "timestamp", "x", "y", "z", "status" };
+    EXIB_ENC_Options options;
+
+    s_MessageDictionary = EXIB_CreateDictionary(1, names, sizeof(names) / sizeof(names[0]));
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.dictionary = s_MessageDictionary;
+    return EXIB_ENC_CreateContext(&options);
+}
+
+void CleanupMessageEncoder(void* parameter)
+{
+    printf("TEST: \tBENCHMARK: \t%zu bytes per datum\n", EXIB_ENC_MeasureSize(parameter));
+    EXIB_ENC_FreeContext(parameter);
+
+    if (s_MessageDictionary)
+        EXIB_FreeDictionary(s_MessageDictionary);
+    s_MessageDictionary = NULL;
+}
+
+#define DISTINCT_NAMES 10000
+
+// Five character names, just small enough for 10k of them to fit into the string table.
+static char s_DistinctNames[DISTINCT_NAMES][8];
+
+void* SetupNamesEncoder()
+{
+    for (int i = 0; i < DISTINCT_NAMES; ++i)
+        snprintf(s_DistinctNames[i], sizeof(s_DistinctNames[i]), "n%04d", i);
+
+    return EXIB_ENC_CreateContext(NULL);
+}
+
+// Intern 10k names into an empty string cache.
+void Benchmark_ENC_AddField_Distinct(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 0);
+    for (int i = 0; i < DISTINCT_NAMES; ++i)
+        EXIB_ENC_AddField(ctx, NULL, s_DistinctNames[i], EXIB_TYPE_INT32);
+}
+
+// Look up 10k names that are already cached.
+void Benchmark_ENC_AddField_Cached(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 1);
+    for (int i = 0; i < DISTINCT_NAMES; ++i)
+        EXIB_ENC_AddField(ctx, NULL, s_DistinctNames[i], EXIB_TYPE_INT32);
+}
+
+static EXIB_ENC_Name s_InternedNames[DISTINCT_NAMES];
+
+void* SetupInternedEncoder()
+{
+    EXIB_ENC_Context* ctx = SetupNamesEncoder();
+
+    for (int i = 0; i < DISTINCT_NAMES; ++i)
+        s_InternedNames[i] = EXIB_ENC_InternName(ctx, s_DistinctNames[i]);
+
+    return ctx;
+}
+
+// Add fields with 10k interned names, which needs neither a hash nor a lookup.
+void Benchmark_ENC_AddField_Interned(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    EXIB_ENC_ResetContext(ctx, 0);
+    for (int i = 0; i < DISTINCT_NAMES; ++i)
+        EXIB_ENC_AddFieldInterned(ctx, NULL, s_InternedNames[i], EXIB_TYPE_INT32);
+}
+
+typedef struct _AppendBenchmark
+{
+    EXIB_ENC_Context* ctx;
+    size_t count;
+    float* samples;
+    void* output; // Only used by the encode benchmarks.
+    size_t capacity;
+} AppendBenchmark;
+
+void* SetupAppendBenchmark()
+{
+    AppendBenchmark* benchmark = malloc(sizeof(AppendBenchmark));
+
+    benchmark->ctx = EXIB_ENC_CreateContext(NULL);
+    benchmark->count = GetBenchmarkSize() / sizeof(float);
+    benchmark->samples = malloc(benchmark->count * sizeof(float));
+    benchmark->output = NULL;
+    for (size_t i = 0; i < benchmark->count; ++i)
+        benchmark->samples[i] = (float)i * 0.5f;
+
+    return benchmark;
+}
+
+void CleanupAppendBenchmark(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+
+    EXIB_ENC_FreeContext(benchmark->ctx);
+    free(benchmark->samples);
+    free(benchmark->output);
+    free(benchmark);
+}
+
+// Append floats one by one, growing the array as it fills up.
+void Benchmark_ENC_ArrayAppend(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    EXIB_ENC_Array* array;
+
+    EXIB_ENC_ResetContext(benchmark->ctx, 1);
+    array = EXIB_ENC_AddArray(benchmark->ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    for (size_t i = 0; i < benchmark->count; ++i)
+        EXIB_ENC_ArrayAppend(array, (EXIB_Value){ .float32 = benchmark->samples[i] });
+}
+
+// Append all floats with a single copy.
+void Benchmark_ENC_ArrayAppendN(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    EXIB_ENC_Array* array;
+
+    EXIB_ENC_ResetContext(benchmark->ctx, 1);
+    array = EXIB_ENC_AddArray(benchmark->ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    EXIB_ENC_ArrayAppendN(array, benchmark->samples, benchmark->count);
+}
+
+// Adds a buffer to encode into, big enough for the samples and the rest of the datum.
+void* SetupEncodeArrayBenchmark()
+{
+    AppendBenchmark* benchmark = SetupAppendBenchmark();
+
+    benchmark->capacity = benchmark->count * sizeof(float) + 4096;
+    benchmark->output = malloc(benchmark->capacity);
+
+    // Fault the output pages in, so the first iteration isn't any slower.
+    memset(benchmark->output, 0, benchmark->capacity);
+    return benchmark;
+}
+
+// Reference caller-owned floats and encode them, which copies them exactly once.
+void Benchmark_ENC_Encode_External(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    EXIB_ENC_Array* array;
+
+    EXIB_ENC_ResetContext(benchmark->ctx, 1);
+    array = EXIB_ENC_AddArray(benchmark->ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    EXIB_ENC_ArraySetExternal(array, benchmark->samples, benchmark->count, NULL);
+    EXIB_ENC_EncodeInto(benchmark->ctx, benchmark->output, benchmark->capacity);
+}
+
+// Copy the floats into the array first, then encode them.
+void Benchmark_ENC_Encode_Copied(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    EXIB_ENC_Array* array;
+
+    EXIB_ENC_ResetContext(benchmark->ctx, 1);
+    array = EXIB_ENC_AddArray(benchmark->ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    EXIB_ENC_ArrayAssign(array, benchmark->samples, benchmark->count);
+    EXIB_ENC_EncodeInto(benchmark->ctx, benchmark->output, benchmark->capacity);
+}
+
+// Encode the floats to segments that reference them, which copies nothing.
+void Benchmark_ENC_EncodeIOV(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    EXIB_ENC_Array* array;
+    struct iovec iov[4];
+    int count = 4;
+
+    EXIB_ENC_ResetContext(benchmark->ctx, 1);
+    array = EXIB_ENC_AddArray(benchmark->ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    EXIB_ENC_ArraySetExternal(array, benchmark->samples, benchmark->count, NULL);
+    EXIB_ENC_EncodeIOV(benchmark->ctx, iov, &count);
+}
+
+// The fastest the samples could possibly be encoded.
+void Benchmark_Memcpy(void* parameter)
+{
+    AppendBenchmark* benchmark = parameter;
+    memcpy(benchmark->output, benchmark->samples, benchmark->count * sizeof(float));
+}
+
 void AddEncoderBenchmarks()
 {
+    AddParallelEncodeBenchmarks();
+
+    AddSizedBenchmark("Memcpy (16 MiB)",
+        Benchmark_Memcpy,
+        SetupEncodeArrayBenchmark,
+        CleanupAppendBenchmark,
+        16,
+        EXIB_BENCHMARK_SMALL);
+    AddSizedBenchmark("ENC_Encode_Copied (16 MiB floats)",
+        Benchmark_ENC_Encode_Copied,
+        SetupEncodeArrayBenchmark,
+        CleanupAppendBenchmark,
+        16,
+        EXIB_BENCHMARK_SMALL);
+    AddSizedBenchmark("ENC_EncodeIOV (16 MiB floats)",
+        Benchmark_ENC_EncodeIOV,
+        SetupEncodeArrayBenchmark,
+        CleanupAppendBenchmark,
+        16,
+        EXIB_BENCHMARK_SMALL);
+    AddSizedBenchmark("ENC_Encode_External (16 MiB floats)",
+        Benchmark_ENC_Encode_External,
+        SetupEncodeArrayBenchmark,
+        CleanupAppendBenchmark,
+        16,
+        EXIB_BENCHMARK_SMALL);
+
+    static const char* appendNames[] = {
+        "ENC_ArrayAppend (10^6 floats)",
+        "ENC_ArrayAppend (10^7 floats)"
+    };
+    static const char* appendNNames[] = {
+        "ENC_ArrayAppendN (10^6 floats)",
+        "ENC_ArrayAppendN (10^7 floats)"
+    };
+
+    // 10^7 floats is beyond EXIB_BENCHMARK_SMALL, so it only runs with the large benchmarks.
+    for (int i = 1; i >= 0; --i)
+    {
+        size_t count = (i == 0) ? 1000000 : 10000000;
+
+        AddSizedBenchmark(appendNNames[i],
+            Benchmark_ENC_ArrayAppendN,
+            SetupAppendBenchmark,
+            CleanupAppendBenchmark,
+            40000000 / count,
+            count * sizeof(float));
+        AddSizedBenchmark(appendNames[i],
+            Benchmark_ENC_ArrayAppend,
+            SetupAppendBenchmark,
+            CleanupAppendBenchmark,
+            40000000 / count,
+            count * sizeof(float));
+    }
+
+    static const char* nestedNames[] = {
+        "ENC_Encode_Nested (1 MiB)",
+        "ENC_Encode_Nested (4 MiB)",
+        "ENC_Encode_Nested (16 MiB)",
+        "ENC_Encode_Nested (64 MiB)",
+        "ENC_Encode_Nested (256 MiB)",
+        "ENC_Encode_Nested (1 GiB)"
+    };
+
+    // Throughput should stay flat from 1 MiB to 1 GiB if encoding is linear.
+    for (int i = (int)(sizeof(nestedNames) / sizeof(nestedNames[0])) - 1; i >= 0; --i)
+    {
+        size_t size = (1024 * 1024) << (2 * i);
+        size_t iterations = (64 * 1024 * 1024) / size;
+        AddSizedBenchmark(nestedNames[i],
+            Benchmark_ENC_Encode,
+            SetupNestedEncoder,
+            CleanupEncoder,
+            iterations ? iterations : 1,
+            size);
+    }
+
+    AddBenchmark("ENC_Telemetry_Struct",
+        Benchmark_ENC_Telemetry_Struct,
+        SetupEncoder,
+        CleanupEncoder,
+        1024);
+    AddBenchmark("ENC_Telemetry_Tree",
+        Benchmark_ENC_Telemetry_Tree,
+        NULL,
+        NULL,
+        1024);
+    AddBenchmark("ENC_Telemetry_Stream",
+        Benchmark_ENC_Telemetry_Stream,
+        SetupEncoder,
+        CleanupEncoder,
+        1024);
+    AddBenchmark("ENC_Telemetry_Reset",
+        Benchmark_ENC_Telemetry_Reset,
+        SetupResetEncoder,
+        CleanupResetEncoder,
+        1024);
+    AddBenchmark("ENC_SmallMessage",
+        Benchmark_ENC_SmallMessage,
+        SetupEncoder,
+        CleanupMessageEncoder,
+        100000);
+    AddBenchmark("ENC_SmallMessage (Dictionary)",
+        Benchmark_ENC_SmallMessage,
+        SetupDictionaryEncoder,
+        CleanupMessageEncoder,
+        100000);
+    AddBenchmark("ENC_AddField_Distinct (10k names)",
+        Benchmark_ENC_AddField_Distinct,
+        SetupNamesEncoder,
+        CleanupEncoder,
+        64);
+    AddBenchmark("ENC_AddField_Cached (10k names)",
+        Benchmark_ENC_AddField_Cached,
+        SetupNamesEncoder,
+        CleanupEncoder,
+        64);
+    AddBenchmark("ENC_AddField_Interned (10k names)",
+        Benchmark_ENC_AddField_Interned,
+        SetupInternedEncoder,
+        CleanupEncoder,
+        64);
     AddBenchmark("ENC_AddField_Duplicate",
         Benchmark_ENC_AddField_Duplicate,
         SetupEncoder,
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <EXIB/Encoder.h>
+#include <EXIB/Decoder.h>
+#include "Benchmark.h"
+#include "Telemetry.h" // Generated by exgen from Telemetry.exit.
+
+typedef struct _GeneratorBenchmark
+{
+    EXIB_ENC_Context* encoder;
+    EXIB_DEC_Context* decoder;
+    Telemetry telemetry;
+    uint64_t buffer[(Telemetry_DATUM_SIZE + 7) / 8];
+} GeneratorBenchmark;
+
+void* SetupGeneratorBenchmark()
+{
+    GeneratorBenchmark* benchmark = calloc(1, sizeof(GeneratorBenchmark));
+    EXIB_ENC_Options options;
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.datumName = "telemetry";
+    benchmark->encoder = EXIB_ENC_CreateContext(&options);
+    benchmark->decoder = EXIB_DEC_CreateContext(NULL);
+
+    benchmark->telemetry.id = 7;
+    benchmark->telemetry.time = 1.5;
+    benchmark->telemetry.battery.voltage = 3.7f;
+    Telemetry_Encode(&benchmark->telemetry, benchmark->buffer, sizeof(benchmark->buffer));
+    return benchmark;
+}
+
+void CleanupGeneratorBenchmark(void* parameter)
+{
+    GeneratorBenchmark* benchmark = parameter;
+
+    EXIB_ENC_FreeContext(benchmark->encoder);
+    EXIB_DEC_FreeContext(benchmark->decoder);
+    free(benchmark);
+}
+
+// The same datum as the generated encoder, built field by field.
+void Benchmark_GEN_EncodeGeneric(void* parameter)
+{
+    GeneratorBenchmark* benchmark = parameter;
+    EXIB_ENC_Context* ctx = benchmark->encoder;
+    const Telemetry* telemetry = &benchmark->telemetry;
+
+    EXIB_ENC_ResetContext(ctx, 1);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = telemetry->id });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "flags", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = telemetry->flags });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "time", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = telemetry->time });
+    EXIB_ENC_ArrayAssign(EXIB_ENC_AddArray(ctx, NULL, "samples", EXIB_TYPE_INT16), telemetry->samples, 5);
+
+    EXIB_ENC_Object* battery = EXIB_ENC_AddObject(ctx, NULL, "battery");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, battery, "voltage", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = telemetry->battery.voltage });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, battery, "charge", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = telemetry->battery.charge });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "error-count", EXIB_TYPE_UINT16), (EXIB_Value){ .uint16 = telemetry->error_count });
+
+    EXIB_ENC_EncodeInto(ctx, benchmark->buffer, sizeof(benchmark->buffer));
+}
+
+void Benchmark_GEN_Encode(void* parameter)
+{
+    GeneratorBenchmark* benchmark = parameter;
+    Telemetry_Encode(&benchmark->telemetry, benchmark->buffer, sizeof(benchmark->buffer));
+}
+
+// Read every field by name, like the generated decoder does when the layout doesn't match.
+void Benchmark_GEN_DecodeGeneric(void* parameter)
+{
+    GeneratorBenchmark* benchmark = parameter;
+    EXIB_DEC_Context* ctx = benchmark->decoder;
+    Telemetry* telemetry = &benchmark->telemetry;
+    EXIB_DEC_Object battery;
+    EXIB_DEC_FieldValue value;
+    EXIB_DEC_Array array;
+
+    EXIB_DEC_ResetContext(ctx, benchmark->buffer, Telemetry_DATUM_SIZE);
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, NULL, "id"), &value);
+    memcpy(&telemetry->id, value.value, sizeof(telemetry->id));
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, NULL, "flags"), &value);
+    memcpy(&telemetry->flags, value.value, sizeof(telemetry->flags));
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, NULL, "time"), &value);
+    memcpy(&telemetry->time, value.value, sizeof(telemetry->time));
+    EXIB_DEC_ArrayFromField(ctx, EXIB_DEC_FindField(ctx, NULL, "samples"), &array);
+    memcpy(telemetry->samples, EXIB_DEC_ArrayBegin(ctx, &array, NULL), sizeof(telemetry->samples));
+
+    EXIB_DEC_FindObject(ctx, NULL, "battery", &battery);
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, &battery, "voltage"), &value);
+    memcpy(&telemetry->battery.voltage, value.value, sizeof(telemetry->battery.voltage));
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, &battery, "charge"), &value);
+    memcpy(&telemetry->battery.charge, value.value, sizeof(telemetry->battery.charge));
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, NULL, "error-count"), &value);
+    memcpy(&telemetry->error_count, value.value, sizeof(telemetry->error_count));
+}
+
+void Benchmark_GEN_Decode(void* parameter)
+{
+    GeneratorBenchmark* benchmark = parameter;
+    Telemetry_Decode(benchmark->buffer, Telemetry_DATUM_SIZE, &benchmark->telemetry);
+}
+
+void AddGeneratorBenchmarks()
+{
+    AddBenchmark("GEN_Decode (Generic)",
+        Benchmark_GEN_DecodeGeneric,
+        SetupGeneratorBenchmark,
+        CleanupGeneratorBenchmark,
+        100000);
+    AddBenchmark("GEN_Decode (Generated)",
+        Benchmark_GEN_Decode,
+        SetupGeneratorBenchmark,
+        CleanupGeneratorBenchmark,
+        100000);
+    AddBenchmark("GEN_Encode (Generic)",
+        Benchmark_GEN_EncodeGeneric,
+        SetupGeneratorBenchmark,
+        CleanupGeneratorBenchmark,
+        100000);
+    AddBenchmark("GEN_Encode (Generated)",
+        Benchmark_GEN_Encode,
+        SetupGeneratorBenchmark,
+        CleanupGeneratorBenchmark,
+        100000);
+}
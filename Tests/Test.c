@@ -24,7 +24,13 @@ int CompareDatum(EXIB_Header* header, const uint8_t* sample, size_t sampleSize)
 
 int Test_Benchmark()
 {
-    RunBenchmarks();
+    RunBenchmarks(0);
+    return 0;
+}
+
+int Test_BenchmarkLarge()
+{
+    RunBenchmarks(1);
     return 0;
 }
 
@@ -111,8 +117,14 @@ int main(int argc, const char** argv)
         PrintHelp();
 
     AddTest("Benchmark", Test_Benchmark, NULL, NULL);
+    AddTest("BenchmarkLarge", Test_BenchmarkLarge, NULL, NULL);
+    AddCommonTests();
     AddEncoderTests();
     AddDecoderTests();
+    AddAllocatorTests();
+#ifdef EXIB_TEST_EXGEN
+    AddGeneratorTests();
+#endif
 
     return RunTestByName(argv[1]);
 }
@@ -9,6 +9,7 @@
 #include <EXIB/EXIB.h>
 #include <EXIB/Encoder.h>
 #include <EXIB/Decoder.h>
+#include <EXIB/Delta.h>
 
 typedef void*(*test_setup_fn_t)();
 typedef void(*test_cleanup_fn_t)(void*);
@@ -34,5 +35,9 @@ int CompareDatum(EXIB_Header* header, const uint8_t* sample, size_t sampleSize);
 void AddCommonTests();
 void AddEncoderTests();
 void AddDecoderTests();
+void AddAllocatorTests();
+#ifdef EXIB_TEST_EXGEN
+void AddGeneratorTests();
+#endif
 
 #endif // _TEST_H
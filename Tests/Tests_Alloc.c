@@ -0,0 +1,146 @@
+#include "Test.h"
+#include "AllocatorInternal.h"
+
+static size_t s_LiveAllocations = 0;
+
+static void* CountingMalloc(size_t n)
+{
+    ++s_LiveAllocations;
+    return malloc(n);
+}
+
+static void CountingFree(void* ptr)
+{
+    --s_LiveAllocations;
+    free(ptr);
+}
+
+static size_t s_AllocationsLeft = 0;
+
+static void* FailingMalloc(size_t n)
+{
+    if (s_AllocationsLeft == 0)
+        return NULL;
+    --s_AllocationsLeft;
+    return malloc(n);
+}
+
+static int Test_EXIB_Calloc()
+{
+    int result = 0;
+
+    EXIB_SetAllocator(FailingMalloc, free);
+
+    s_AllocationsLeft = 0;
+    if (EXIB_Calloc(16, 4) != NULL || EXIB_Calloc(SIZE_MAX / 2, 4) != NULL)
+        result = 1;
+
+    // Every allocation of a context can fail, which must return NULL rather than crash.
+    EXIB_ENC_Context* ctx = NULL;
+    for (size_t i = 0; i < 64 && !ctx && result == 0; ++i)
+    {
+        s_AllocationsLeft = i;
+        ctx = EXIB_ENC_CreateContext(NULL);
+    }
+
+    if (!ctx)
+        result = 1;
+    else
+        EXIB_ENC_FreeContext(ctx);
+
+    EXIB_SetAllocator(malloc, free);
+
+    uint32_t* zeroed = EXIB_Calloc(sizeof(uint32_t), 64);
+    for (size_t i = 0; i < 64 && result == 0; ++i)
+    {
+        if (zeroed[i] != 0)
+            result = 1;
+    }
+    EXIB_Free(zeroed);
+
+    return result;
+}
+
+static int Test_EXIB_PoolAlloc()
+{
+    const size_t count = 10000;
+    EXIB_MemoryPool pool;
+    uint32_t** objects = malloc(count * sizeof(uint32_t*));
+    int result = 0;
+
+    EXIB_InitializePool(&pool, sizeof(uint32_t));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        objects[i] = EXIB_PoolAlloc(&pool);
+        *objects[i] = (uint32_t)i;
+    }
+
+    // Free every other object and allocate them again, which must not disturb the rest.
+    for (size_t i = 0; i < count; i += 2)
+        EXIB_PoolFree(&pool, objects[i]);
+
+    s_LiveAllocations = 0;
+    EXIB_SetAllocator(CountingMalloc, CountingFree);
+    for (size_t i = 0; i < count; i += 2)
+    {
+        objects[i] = EXIB_PoolAlloc(&pool);
+        *objects[i] = (uint32_t)i;
+    }
+    EXIB_SetAllocator(malloc, free);
+
+    if (s_LiveAllocations != 0)
+        result = 1;
+
+    for (size_t i = 0; i < count && result == 0; ++i)
+    {
+        if (*objects[i] != i)
+            result = 1;
+    }
+
+    EXIB_DestroyPool(&pool);
+    free(objects);
+    return result;
+}
+
+static int Test_EXIB_PoolFree()
+{
+    const size_t count = 100000;
+    EXIB_MemoryPool pool;
+    void** objects = malloc(count * sizeof(void*));
+
+    s_LiveAllocations = 0;
+    EXIB_SetAllocator(CountingMalloc, CountingFree);
+    EXIB_InitializePool(&pool, 48);
+
+    for (size_t i = 0; i < count; ++i)
+        objects[i] = EXIB_PoolAlloc(&pool);
+
+    // Geometric growth keeps the number of blocks low.
+    size_t blocks = pool.blockCount;
+
+    for (size_t i = 0; i < count; ++i)
+        EXIB_PoolFree(&pool, objects[count - i - 1]);
+
+    // Only a single spare block and the block list may be left.
+    size_t live = s_LiveAllocations;
+
+    EXIB_DestroyPool(&pool);
+    EXIB_SetAllocator(malloc, free);
+    free(objects);
+
+    if (blocks > 16 || live != 2 || s_LiveAllocations != 0)
+    {
+        printf("TEST: \tERROR: %zu blocks, %zu allocations left after freeing all objects.\n", blocks, live);
+        return 1;
+    }
+
+    return 0;
+}
+
+void AddAllocatorTests()
+{
+    AddTest("EXIB_Calloc", Test_EXIB_Calloc, NULL, NULL);
+    AddTest("EXIB_PoolAlloc", Test_EXIB_PoolAlloc, NULL, NULL);
+    AddTest("EXIB_PoolFree", Test_EXIB_PoolFree, NULL, NULL);
+}
@@ -0,0 +1,421 @@
+#include "Test.h"
+#include "CRC32CInternal.h"
+#include "LZInternal.h"
+#include "PackInternal.h"
+
+static int Test_EXIB_CRC32C()
+{
+    // Check value of CRC-32C from the Castagnoli paper.
+    if (EXIB_CRC32C(0, "123456789", 9) != 0xE3069283)
+        return 1;
+
+    // Continuing a CRC must give the same result as calculating it in one go.
+    if (EXIB_CRC32C(EXIB_CRC32C(0, "1234", 4), "56789", 5) != 0xE3069283)
+        return 1;
+
+    return 0;
+}
+
+static int Test_EXIB_CRC32C_Implementations()
+{
+    // Long enough for both interleaved loops of the hardware implementation.
+    const size_t size = 3 * 8192 * 2 + 3 * 256 + 100;
+    uint8_t* buffer = malloc(size + 8);
+    int result = 0;
+
+    for (size_t i = 0; i < size + 8; ++i)
+        buffer[i] = (uint8_t)rand();
+
+    EXIB_CRC32C_Initialize();
+
+    // Every length up to a few short blocks, at every alignment.
+    for (size_t offset = 0; offset < 8 && result == 0; ++offset)
+    {
+        for (size_t length = 0; length <= 3 * 256 + 64 && result == 0; ++length)
+        {
+            uint32_t expected = EXIB_CRC32C_Bytewise(0x12345678, buffer + offset, length);
+
+            if (EXIB_CRC32C_Sliced(0x12345678, buffer + offset, length) != expected
+                || EXIB_CRC32C(0x12345678, buffer + offset, length) != expected)
+                result = 1;
+
+            if (EXIB_CRC32C_HardwareSupported()
+                && EXIB_CRC32C_Hardware(0x12345678, buffer + offset, length) != expected)
+                result = 1;
+        }
+
+        uint32_t expected = EXIB_CRC32C_Bytewise(0, buffer + offset, size);
+        if (EXIB_CRC32C_Sliced(0, buffer + offset, size) != expected
+            || EXIB_CRC32C(0, buffer + offset, size) != expected)
+            result = 1;
+    }
+
+    free(buffer);
+    return result;
+}
+
+static int Test_EXIB_CRC32C_Combine()
+{
+    const char* check = "123456789";
+
+    // Every split of the check string.
+    for (size_t split = 0; split <= 9; ++split)
+    {
+        uint32_t crc1 = EXIB_CRC32C(0, check, split);
+        uint32_t crc2 = EXIB_CRC32C(0, check + split, 9 - split);
+
+        if (EXIB_CRC32C_Combine(crc1, crc2, 9 - split) != 0xE3069283)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int Test_EXIB_CRC32C_Patch()
+{
+    const size_t size = 1024 * 1024 + 3;
+    uint8_t* buffer = malloc(size);
+    uint8_t* old = malloc(size);
+    int result = 0;
+
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = (uint8_t)rand();
+    uint32_t crc = EXIB_CRC32C(0, buffer, size);
+
+    // Changes at both ends, in the middle, and longer than the chunk the flipped bits are checksummed in.
+    static const size_t offsets[] = { 0, 1, 4096, 500000, 1024 * 1024 - 200, 1024 * 1024 + 2 };
+    static const size_t lengths[] = { 8, 1, 4, 200, 200, 1 };
+    for (int i = 0; i < 6 && result == 0; ++i)
+    {
+        memcpy(old, buffer + offsets[i], lengths[i]);
+        for (size_t j = 0; j < lengths[i]; ++j)
+            buffer[offsets[i] + j] = (uint8_t)rand();
+
+        crc = EXIB_CRC32C_Patch(crc, size, offsets[i], old, buffer + offsets[i], lengths[i]);
+        if (crc != EXIB_CRC32C(0, buffer, size))
+            result = 1;
+    }
+
+    // Bytes outside the buffer leave the checksum alone.
+    if (EXIB_CRC32C_Patch(crc, size, size - 1, old, buffer, 2) != crc)
+        result = 1;
+
+    free(buffer);
+    free(old);
+    return result;
+}
+
+static int Test_EXIB_CRC32C_Parallel()
+{
+    // Not a multiple of any thread count, so the last segment is longer than the others.
+    const size_t size = 5 * 1024 * 1024 + 77;
+    uint8_t* buffer = malloc(size);
+    int result = 0;
+
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = (uint8_t)rand();
+
+    uint32_t expected = EXIB_CRC32C(0x12345678, buffer, size);
+    for (int threads = 0; threads <= 9 && result == 0; ++threads)
+    {
+        if (EXIB_CRC32C_Parallel(0x12345678, buffer, size, threads) != expected)
+            result = 1;
+    }
+
+    // Too small to split at all.
+    if (EXIB_CRC32C_Parallel(0, buffer, 1000, 8) != EXIB_CRC32C(0, buffer, 1000))
+        result = 1;
+
+    free(buffer);
+    return result;
+}
+
+// Compress and decompress a buffer, and make sure it comes out the same.
+static int CheckLZRoundTrip(const uint8_t* data, size_t size)
+{
+    size_t capacity = size + size / 255 + 16;
+    uint8_t* compressed = malloc(capacity);
+    uint8_t* decompressed = malloc(size + 1);
+    size_t compressedSize = EXIB_LZ_Compress(data, size, compressed, capacity);
+    int result = 0;
+
+    if (compressedSize == 0
+        || EXIB_LZ_Decompress(compressed, compressedSize, decompressed, size)
+        || memcmp(data, decompressed, size) != 0)
+        result = 1;
+
+    // The size has to be exact.
+    if (EXIB_LZ_Decompress(compressed, compressedSize, decompressed, size + 1) == 0
+        || (size > 0 && EXIB_LZ_Decompress(compressed, compressedSize, decompressed, size - 1) == 0))
+        result = 1;
+
+    free(compressed);
+    free(decompressed);
+    return result;
+}
+
+static int Test_EXIB_LZ()
+{
+    const size_t size = 300000;
+    uint8_t* buffer = malloc(size);
+    int result = 0;
+
+    // Short inputs are all literals.
+    for (size_t i = 0; i < 64; ++i)
+        buffer[i] = (uint8_t)rand();
+    for (size_t length = 0; length <= 64 && result == 0; ++length)
+        result = CheckLZRoundTrip(buffer, length);
+
+    // Runs of one byte overlap their own match, long enough for several length bytes.
+    memset(buffer, 'a', size);
+    if (result == 0)
+        result = CheckLZRoundTrip(buffer, size);
+
+    // Text-like data, with matches of every distance up to past the 64 KiB window.
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = "the quick brown fox "[rand() % 20] + (i / 70000);
+    if (result == 0)
+        result = CheckLZRoundTrip(buffer, size);
+
+    // Random data doesn't compress, and has to fit into the buffer it's given.
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = (uint8_t)rand();
+    if (result == 0)
+        result = CheckLZRoundTrip(buffer, size) || EXIB_LZ_Compress(buffer, size, buffer, size / 2) != 0;
+
+    free(buffer);
+    return result;
+}
+
+static int Test_EXIB_LZ_Malformed()
+{
+    uint8_t data[256];
+    uint8_t compressed[512];
+    uint8_t out[256];
+
+    memset(data, 'x', sizeof(data));
+    size_t size = EXIB_LZ_Compress(data, sizeof(data), compressed, sizeof(compressed));
+    if (size == 0 || size >= sizeof(data))
+        return 1;
+
+    // Every truncation must be detected.
+    for (size_t length = 0; length < size; ++length)
+    {
+        if (EXIB_LZ_Decompress(compressed, length, out, sizeof(out)) == 0)
+            return 1;
+    }
+
+    // A match that reaches back before the start of the data.
+    const uint8_t badOffset[] = { 0x10, 'x', 0x02, 0x00, 0x00 };
+    if (EXIB_LZ_Decompress(badOffset, sizeof(badOffset), out, 5) == 0)
+        return 1;
+
+    // A literal length that runs past the input.
+    const uint8_t badLength[] = { 0xF0, 0xFF, 0xFF };
+    if (EXIB_LZ_Decompress(badLength, sizeof(badLength), out, sizeof(out)) == 0)
+        return 1;
+
+    return 0;
+}
+
+// Kernels the CPU supports, NULL-terminated.
+static int GetPackKernels(const EXIB_PACK_Kernels** kernels)
+{
+    int count = 0;
+
+    kernels[count++] = &EXIB_PACK_Scalar;
+    if (EXIB_PACK_SSE4Supported())
+        kernels[count++] = &EXIB_PACK_SSE4;
+    if (EXIB_PACK_AVX2Supported())
+        kernels[count++] = &EXIB_PACK_AVX2;
+    kernels[count] = NULL;
+
+    return count;
+}
+
+// Pack an array, and make sure every kernel unpacks it back into the same elements.
+static int CheckPackRoundTrip(EXIB_Type type, const void* elements, size_t count, EXIB_ArrayPacking packing, int delta)
+{
+    const EXIB_PACK_Kernels* kernels[4];
+    size_t elementSize = EXIB_GetTypeSize(type);
+    size_t capacity = EXIB_PACK_Bound(packing, count);
+    uint8_t* packed = malloc(capacity);
+    uint8_t* unpacked = malloc(count * elementSize + 1);
+    int result = 0;
+
+    size_t size = EXIB_PACK_Encode(type, elements, count, packing, delta, packed, capacity);
+    if (size < sizeof(EXIB_PackedArray) || size > capacity)
+        result = 1;
+
+    // Decode from a buffer of the exact size, so reading past the end shows up under ASan.
+    uint8_t* exact = malloc(size ? size : 1);
+    memcpy(exact, packed, size);
+
+    for (int i = 0; result == 0 && i < GetPackKernels(kernels); ++i)
+    {
+        memset(unpacked, 0xCC, count * elementSize);
+        if (EXIB_PACK_Decode(kernels[i], type, packing, exact, size, unpacked, count)
+            || memcmp(unpacked, elements, count * elementSize) != 0)
+            result = 1;
+
+        // The element count has to match.
+        if (EXIB_PACK_Decode(kernels[i], type, packing, exact, size, unpacked, count + 1) == 0)
+            result = 1;
+    }
+
+    free(exact);
+    free(packed);
+    free(unpacked);
+    return result;
+}
+
+// Store the low bytes of a 64-bit value as an element.
+static void SetPackElement(uint8_t* elements, size_t i, size_t elementSize, uint64_t value)
+{
+    memcpy(elements + i * elementSize, &value, elementSize);
+}
+
+static int Test_EXIB_PACK()
+{
+    const size_t sizes[] = { 0, 1, 7, 8, 9, 63, 255, 256, 257, 1000, 4099 };
+    const size_t maxCount = 4099;
+    uint8_t* elements = malloc(maxCount * 8);
+    int result = 0;
+
+    for (EXIB_Type type = EXIB_TYPE_INT8; type <= EXIB_TYPE_UINT64 && result == 0; ++type)
+    {
+        size_t elementSize = EXIB_GetTypeSize(type);
+        int typeBits = (int)elementSize * 8;
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && result == 0; ++s)
+        {
+            size_t count = sizes[s];
+
+            for (int pattern = 0; pattern < 5 && result == 0; ++pattern)
+            {
+                uint64_t value = 0x7FFFFFFFFFFFFF00ull;
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    switch (pattern)
+                    {
+                    case 0: value = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand(); break; // Full range.
+                    case 1: value += 1000 + rand() % 16; break; // Timestamps, which wrap around in narrow types.
+                    case 2: value = (uint64_t)(int64_t)(rand() % 64 - 32); break; // Small signed values.
+                    case 3: value = (i / 37) * 3; break; // Runs.
+                    default: value = (i & 1) ? (uint64_t)INT64_MIN : (uint64_t)INT64_MAX; break; // Extremes.
+                    }
+                    SetPackElement(elements, i, elementSize, value);
+                }
+
+                for (EXIB_ArrayPacking packing = EXIB_PACKING_VARINT; packing <= EXIB_PACKING_RLE && result == 0; ++packing)
+                {
+                    result = CheckPackRoundTrip(type, elements, count, packing, 0)
+                          || CheckPackRoundTrip(type, elements, count, packing, 1);
+                }
+            }
+        }
+
+        // Offsets of every width, including the ones too wide for the kernels.
+        for (int width = 0; width <= typeBits && result == 0; ++width)
+        {
+            uint64_t mask = width == 64 ? UINT64_MAX : (((uint64_t)1 << width) - 1);
+
+            for (size_t i = 0; i < 1000; ++i)
+                SetPackElement(elements, i, elementSize, (((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand()) & mask);
+            if (width > 0)
+                SetPackElement(elements, 500, elementSize, mask);
+
+            result = CheckPackRoundTrip(type, elements, 1000, EXIB_PACKING_BITS, 0);
+        }
+    }
+
+    free(elements);
+    return result;
+}
+
+static int Test_EXIB_PACK_Malformed()
+{
+    const size_t count = 300;
+    uint32_t elements[300];
+    uint32_t out[300];
+    uint8_t packed[sizeof(EXIB_PackedArray) + 300 * 11];
+
+    for (size_t i = 0; i < count; ++i)
+        elements[i] = (uint32_t)(i * 1000 + rand() % 100);
+
+    for (EXIB_ArrayPacking packing = EXIB_PACKING_VARINT; packing <= EXIB_PACKING_RLE; ++packing)
+    {
+        size_t size = EXIB_PACK_Encode(EXIB_TYPE_UINT32, elements, count, packing, 1, packed, sizeof(packed));
+        if (size == 0)
+            return 1;
+
+        // Every truncation must be detected, from a buffer of the truncated size.
+        for (size_t length = 0; length < size; ++length)
+        {
+            uint8_t* truncated = malloc(length ? length : 1);
+            memcpy(truncated, packed, length);
+            int failed = EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, packing, truncated, length, out, count);
+            free(truncated);
+            if (!failed)
+                return 1;
+        }
+
+        // Trailing data, and a packing that doesn't match.
+        if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, packing, packed, size + 1, out, count) == 0
+            || EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_NONE, packed, size, out, count) == 0)
+            return 1;
+    }
+
+    EXIB_PackedArray header = { .elements = 4 };
+    uint8_t bad[64];
+
+    // An offset wider than the element type.
+    header.bitWidth = 33;
+    memset(bad, 0, sizeof(bad));
+    memcpy(bad, &header, sizeof(header));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_BITS, bad, sizeof(header) + 17, out, 4) == 0)
+        return 1;
+
+    // Unknown delta and reserved bits.
+    header.bitWidth = 8;
+    header.delta = 2;
+    memcpy(bad, &header, sizeof(header));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_BITS, bad, sizeof(header) + 4, out, 4) == 0)
+        return 1;
+    header.delta = 0;
+    header.reserved = 1;
+    memcpy(bad, &header, sizeof(header));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_BITS, bad, sizeof(header) + 4, out, 4) == 0)
+        return 1;
+
+    // A run longer than the array, an empty run, and a varint that never ends.
+    header.reserved = 0;
+    memcpy(bad, &header, sizeof(header));
+    const uint8_t longRun[] = { 5, 2 };
+    const uint8_t emptyRun[] = { 0, 2, 4, 2 };
+    memcpy(bad + sizeof(header), longRun, sizeof(longRun));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_RLE, bad, sizeof(header) + sizeof(longRun), out, 4) == 0)
+        return 1;
+    memcpy(bad + sizeof(header), emptyRun, sizeof(emptyRun));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_RLE, bad, sizeof(header) + sizeof(emptyRun), out, 4) == 0)
+        return 1;
+    memset(bad + sizeof(header), 0xFF, sizeof(bad) - sizeof(header));
+    if (EXIB_PACK_Decode(EXIB_PACK_GetKernels(), EXIB_TYPE_UINT32, EXIB_PACKING_VARINT, bad, sizeof(bad), out, 4) == 0)
+        return 1;
+
+    return 0;
+}
+
+void AddCommonTests()
+{
+    AddTest("EXIB_CRC32C", Test_EXIB_CRC32C, NULL, NULL);
+    AddTest("EXIB_CRC32C_Implementations", Test_EXIB_CRC32C_Implementations, NULL, NULL);
+    AddTest("EXIB_CRC32C_Combine", Test_EXIB_CRC32C_Combine, NULL, NULL);
+    AddTest("EXIB_CRC32C_Patch", Test_EXIB_CRC32C_Patch, NULL, NULL);
+    AddTest("EXIB_CRC32C_Parallel", Test_EXIB_CRC32C_Parallel, NULL, NULL);
+    AddTest("EXIB_LZ", Test_EXIB_LZ, NULL, NULL);
+    AddTest("EXIB_LZ_Malformed", Test_EXIB_LZ_Malformed, NULL, NULL);
+    AddTest("EXIB_PACK", Test_EXIB_PACK, NULL, NULL);
+    AddTest("EXIB_PACK_Malformed", Test_EXIB_PACK_Malformed, NULL, NULL);
+}
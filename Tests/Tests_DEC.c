@@ -133,6 +133,635 @@ static int Test_EXIB_DEC_FindObject_NumbersAndObjects()
     return 0;
 }
 
+// Decode a datum with a large array, verifying its checksum on 4 threads.
+static int Test_EXIB_DEC_ParallelChecksum()
+{
+    const size_t count = 1024 * 1024;
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(encoder, NULL, "values", EXIB_TYPE_UINT32);
+    EXIB_DEC_Options options;
+    int result = 0;
+
+    EXIB_ENC_ArrayResize(array, count);
+    uint32_t* values = EXIB_ENC_ArrayGetData(array);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = (uint32_t)(i * 2654435761u);
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    if (!header)
+    {
+        EXIB_ENC_FreeContext(encoder);
+        return 1;
+    }
+
+    EXIB_DEC_GetDefaultOptions(&options);
+    options.checksumThreads = 4;
+    options.parallelChecksumSize = 0;
+
+    EXIB_DEC_Context* ctx = EXIB_DEC_CreateBufferedContext(header, header->datumSize, &options);
+    if (EXIB_DEC_GetLastError(ctx) != EXIB_DEC_ERR_Success)
+        result = 1;
+
+    // A flipped bit in the last segment must still be caught.
+    ((uint8_t*)header)[header->datumSize - 100] ^= 1;
+    if (EXIB_DEC_ResetContext(ctx, header, header->datumSize) == EXIB_DEC_ERR_Success)
+        result = 1;
+
+    EXIB_DEC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(encoder);
+    return result;
+}
+
+// Decode `header` with the given checksum mode.
+static EXIB_DEC_Error DecodeWithChecksumMode(EXIB_Header* header, size_t size, EXIB_DEC_ChecksumMode mode)
+{
+    EXIB_DEC_Options options;
+
+    EXIB_DEC_GetDefaultOptions(&options);
+    options.checksumMode = mode;
+
+    EXIB_DEC_Context* ctx = EXIB_DEC_CreateBufferedContext(header, size, &options);
+    EXIB_DEC_Error error = EXIB_DEC_GetLastError(ctx);
+    EXIB_DEC_FreeContext(ctx);
+    return error;
+}
+
+static int Test_EXIB_DEC_ChecksumMode()
+{
+    EXIB_ENC_Options encoderOptions;
+    uint8_t unchecked[256];
+    uint8_t corrupted[256];
+    int result = 0;
+
+    EXIB_ENC_GetDefaultOptions(&encoderOptions);
+    encoderOptions.noChecksum = 1;
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(&encoderOptions);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "a", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 42 });
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    size_t size = header->datumSize;
+    memcpy(unchecked, header, size);
+
+    // A datum with a checksum that doesn't match.
+    memcpy(corrupted, Sample_Numbers, sizeof(Sample_Numbers));
+    ((EXIB_Header*)corrupted)->checksum ^= 1;
+
+    // Datums without a checksum are only accepted if the decoder was told to trust them.
+    if (DecodeWithChecksumMode((EXIB_Header*)unchecked, size, EXIB_DEC_CHECKSUM_REQUIRED) != EXIB_DEC_ERR_BadChecksum
+        || DecodeWithChecksumMode((EXIB_Header*)unchecked, size, EXIB_DEC_CHECKSUM_IF_PRESENT) != EXIB_DEC_ERR_Success
+        || DecodeWithChecksumMode((EXIB_Header*)unchecked, size, EXIB_DEC_CHECKSUM_NONE) != EXIB_DEC_ERR_Success)
+        result = 1;
+
+    // Checksums that are present are still verified, unless they are ignored entirely.
+    if (DecodeWithChecksumMode((EXIB_Header*)corrupted, sizeof(Sample_Numbers), EXIB_DEC_CHECKSUM_REQUIRED) != EXIB_DEC_ERR_BadChecksum
+        || DecodeWithChecksumMode((EXIB_Header*)corrupted, sizeof(Sample_Numbers), EXIB_DEC_CHECKSUM_IF_PRESENT) != EXIB_DEC_ERR_BadChecksum
+        || DecodeWithChecksumMode((EXIB_Header*)corrupted, sizeof(Sample_Numbers), EXIB_DEC_CHECKSUM_NONE) != EXIB_DEC_ERR_Success)
+        result = 1;
+
+    // Bounds are validated regardless.
+    if (DecodeWithChecksumMode((EXIB_Header*)unchecked, size - 1, EXIB_DEC_CHECKSUM_NONE) == EXIB_DEC_ERR_Success)
+        result = 1;
+
+    EXIB_ENC_FreeContext(encoder);
+    return result;
+}
+
+// Decode `header` with the given dictionaries registered.
+static EXIB_DEC_Context* DecodeWithDictionaries(EXIB_Header* header, const EXIB_Dictionary** dictionaries, int count)
+{
+    EXIB_DEC_Options options;
+
+    EXIB_DEC_GetDefaultOptions(&options);
+    options.dictionaries = dictionaries;
+    options.dictionaryCount = count;
+
+    return EXIB_DEC_CreateBufferedContext(header, header->datumSize, &options);
+}
+
+static int Test_EXIB_DEC_Dictionary()
+{
+    static const char* names[] = { "timestamp", "x", "y", "z", "status" };
+    static const char* otherNames[] = { "status", "timestamp" };
+    EXIB_Dictionary* dictionary = EXIB_CreateDictionary(3, names, 5);
+    EXIB_Dictionary* other = EXIB_CreateDictionary(4, otherNames, 2);
+    const EXIB_Dictionary* registered[] = { other, dictionary };
+    EXIB_ENC_Options encoderOptions;
+    uint64_t datum[32]; // Aligned like the encode buffer, for the 64-bit value.
+    int result = 0;
+
+    EXIB_ENC_GetDefaultOptions(&encoderOptions);
+    encoderOptions.dictionary = dictionary;
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(&encoderOptions);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "timestamp", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = 1234 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "extra", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 5 });
+    EXIB_ENC_Object* y = EXIB_ENC_AddObject(encoder, NULL, "y");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, y, "z", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 42 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, y, "inner", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 43 });
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    memcpy(datum, header, header->datumSize);
+    header = (EXIB_Header*)datum;
+
+    // Names from the dictionary and the string table resolve alike, at any depth.
+    EXIB_DEC_Context* ctx = DecodeWithDictionaries(header, registered, 2);
+    EXIB_DEC_FieldValue value;
+    EXIB_DEC_Object object;
+    EXIB_DEC_TString name;
+
+    if (CheckDecoderContext(ctx))
+    {
+        EXIB_ENC_FreeContext(encoder);
+        EXIB_FreeDictionary(dictionary);
+        EXIB_FreeDictionary(other);
+        return 1;
+    }
+
+    EXIB_DEC_Field timestamp = EXIB_DEC_FindField(ctx, NULL, "timestamp");
+    name = EXIB_DEC_FieldGetName(ctx, timestamp);
+    if (name == EXIB_DEC_INVALID_STRING
+        || name->length != 9
+        || memcmp(name->string, "timestamp", 9) != 0
+        || EXIB_DEC_FieldGet(ctx, timestamp, &value) != EXIB_TYPE_UINT64
+        || value.value->uint64 != 1234
+        || EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, NULL, "extra"), &value) != EXIB_TYPE_UINT8
+        || *(uint8_t*)value.value != 5
+        || EXIB_DEC_FindObject(ctx, NULL, "y", &object) != EXIB_DEC_ERR_Success
+        || EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, &object, "z"), &value) != EXIB_TYPE_UINT32
+        || value.value->uint32 != 42
+        || EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, &object, "inner"), &value) != EXIB_TYPE_UINT32
+        || value.value->uint32 != 43
+        || EXIB_DEC_FindField(ctx, NULL, "status") != EXIB_DEC_INVALID_FIELD)
+        result = 1;
+
+    // A name offset within the dictionary that runs past its end doesn't resolve.
+    // The table is 23 bytes long, and ends with the characters of "status".
+    exib_string_t lastByte = 22;
+    memcpy((uint8_t*)timestamp + 1, &lastByte, sizeof(lastByte));
+    if (EXIB_DEC_FieldGetName(ctx, timestamp) != EXIB_DEC_INVALID_STRING
+        || EXIB_DEC_FindField(ctx, NULL, "timestamp") != EXIB_DEC_INVALID_FIELD)
+        result = 1;
+    EXIB_DEC_FreeContext(ctx);
+
+    // Datums that use a dictionary the decoder doesn't have are rejected.
+    memcpy(datum, EXIB_ENC_Encode(encoder), header->datumSize);
+    ctx = DecodeWithDictionaries(header, registered, 1);
+    if (EXIB_DEC_GetLastError(ctx) != EXIB_DEC_ERR_UnknownDictionary)
+        result = 1;
+    EXIB_DEC_FreeContext(ctx);
+
+    ctx = DecodeWithDictionaries(header, NULL, 0);
+    if (EXIB_DEC_GetLastError(ctx) != EXIB_DEC_ERR_UnknownDictionary)
+        result = 1;
+    EXIB_DEC_FreeContext(ctx);
+
+    EXIB_ENC_FreeContext(encoder);
+    EXIB_FreeDictionary(dictionary);
+    EXIB_FreeDictionary(other);
+    return result;
+}
+
+static int CheckBlob(EXIB_DEC_Context* ctx, EXIB_DEC_Object* parent, const char* name,
+                     const void* expected, size_t expectedSize)
+{
+    EXIB_DEC_Field field = EXIB_DEC_FindField(ctx, parent, name);
+    const void* data;
+    size_t size;
+
+    if (EXIB_DEC_GetBlob(ctx, field, &data, &size) != EXIB_DEC_ERR_Success)
+        return 1;
+
+    return size != expectedSize
+        || ((uintptr_t)data - (uintptr_t)EXIB_DEC_GetRootObject(ctx)->field) % EXIB_BLOB_ALIGNMENT != 0
+        || memcmp(data, expected, size) != 0;
+}
+
+static int Test_EXIB_DEC_GetBlob()
+{
+    const size_t largeSize = 100003;
+    uint8_t* large = malloc(largeSize);
+    uint8_t* datum = NULL;
+    int result = 0;
+
+    for (size_t i = 0; i < largeSize; ++i)
+        large[i] = (uint8_t)(i * 13);
+
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "a", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 42 });
+    EXIB_ENC_AddBlob(encoder, NULL, "small", "blob", 5);
+    EXIB_ENC_AddBlob(encoder, NULL, "empty", NULL, 0);
+    EXIB_ENC_AddBlob(encoder, EXIB_ENC_AddObject(encoder, NULL, "object"), "large", large, largeSize);
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    size_t size = header->datumSize;
+    datum = malloc(size);
+    memcpy(datum, header, size);
+
+    EXIB_DEC_Context* ctx = EXIB_DEC_CreateBufferedContext(datum, size, NULL);
+    if (CheckDecoderContext(ctx))
+    {
+        EXIB_ENC_FreeContext(encoder);
+        free(large);
+        free(datum);
+        return 1;
+    }
+
+    EXIB_DEC_Object object;
+    if (CheckBlob(ctx, NULL, "small", "blob", 5)
+        || CheckBlob(ctx, NULL, "empty", "", 0)
+        || EXIB_DEC_FindObject(ctx, NULL, "object", &object) != EXIB_DEC_ERR_Success
+        || CheckBlob(ctx, &object, "large", large, largeSize))
+        result = 1;
+
+    // Only blob fields have blobs.
+    const void* data;
+    if (EXIB_DEC_GetBlob(ctx, EXIB_DEC_FindField(ctx, NULL, "a"), &data, &size) != EXIB_DEC_ERR_BlobExpected)
+        result = 1;
+
+    // Point the small blob at an entry that doesn't exist.
+    EXIB_DEC_Field small = EXIB_DEC_FindField(ctx, NULL, "small");
+    EXIB_DEC_FieldValue value;
+    EXIB_DEC_FieldGet(ctx, small, &value);
+    value.value->uint8 = 200;
+    if (EXIB_DEC_GetBlob(ctx, small, &data, &size) != EXIB_DEC_ERR_InvalidBlob)
+        result = 1;
+
+    EXIB_DEC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(encoder);
+    free(large);
+    free(datum);
+    return result;
+}
+
+// Find the entry of a blob in an encoded datum.
+static EXIB_BlobEntry* FindBlobEntry(EXIB_Header* header, uint32_t index)
+{
+    EXIB_ExtHeader* extHeader = (EXIB_ExtHeader*)(header + 1);
+    EXIB_BlobDirectory* directory = (EXIB_BlobDirectory*)((uint8_t*)header + extHeader->blobOffset);
+    return (EXIB_BlobEntry*)((uint8_t*)directory + directory->offsets[index]);
+}
+
+static size_t s_LargestAllocation = 0;
+
+static void* LargestMalloc(size_t n)
+{
+    if (n > s_LargestAllocation)
+        s_LargestAllocation = n;
+    return malloc(n);
+}
+
+static int Test_EXIB_DEC_GetBlob_Compressed()
+{
+    const size_t textSize = 200000;
+    char* text = malloc(textSize);
+    uint8_t* noise = malloc(4096);
+    uint8_t* zeros = calloc(1, textSize);
+    int result = 0;
+
+    // Words repeat, like the lines of a log.
+    const char* words[] = { "lorem ", "ipsum ", "dolor ", "sit ", "amet ", "error ", "warning ", "info " };
+    for (size_t i = 0; i < textSize;)
+    {
+        const char* word = words[rand() % 8];
+        for (; *word && i < textSize; ++word)
+            text[i++] = *word;
+    }
+    for (size_t i = 0; i < 4096; ++i)
+        noise[i] = (uint8_t)rand();
+
+    EXIB_ENC_Options options;
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.blobCompressThreshold = 1024;
+
+    // Above the threshold, below it, opted out, opted in and incompressible.
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(&options);
+    EXIB_ENC_AddBlob(encoder, NULL, "text", text, textSize);
+    EXIB_ENC_AddBlob(encoder, NULL, "short", text, 1000);
+    EXIB_ENC_AddBlobWithMode(encoder, NULL, "stored", text, 2000, EXIB_ENC_BLOB_STORE);
+    EXIB_ENC_AddBlobWithMode(encoder, NULL, "forced", text, 1000, EXIB_ENC_BLOB_COMPRESS);
+    EXIB_ENC_AddBlob(encoder, NULL, "noise", noise, 4096);
+    EXIB_ENC_AddBlob(encoder, NULL, "zeros", zeros, textSize);
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    size_t size = header->datumSize;
+    uint8_t* datum = malloc(size);
+    memcpy(datum, header, size);
+
+    if (size > textSize / 2
+        || FindBlobEntry(header, 0)->flags != EXIB_BLOB_COMPRESSED
+        || FindBlobEntry(header, 1)->flags != 0
+        || FindBlobEntry(header, 2)->flags != 0
+        || FindBlobEntry(header, 3)->flags != EXIB_BLOB_COMPRESSED
+        || FindBlobEntry(header, 4)->flags != 0)
+        result = 1;
+
+    EXIB_DEC_Context* ctx = EXIB_DEC_CreateBufferedContext(datum, size, NULL);
+    if (CheckDecoderContext(ctx))
+        result = 1;
+
+    if (result == 0
+        && (CheckBlob(ctx, NULL, "text", text, textSize)
+            || CheckBlob(ctx, NULL, "short", text, 1000)
+            || CheckBlob(ctx, NULL, "stored", text, 2000)
+            || CheckBlob(ctx, NULL, "forced", text, 1000)
+            || CheckBlob(ctx, NULL, "noise", noise, 4096)
+            || CheckBlob(ctx, NULL, "zeros", zeros, textSize)))
+        result = 1;
+
+    // Decompressed once, then served from the cache.
+    const void* first;
+    const void* second;
+    EXIB_DEC_Field field = EXIB_DEC_FindField(ctx, NULL, "text");
+    if (result == 0
+        && (EXIB_DEC_GetBlob(ctx, field, &first, &size) != EXIB_DEC_ERR_Success
+            || EXIB_DEC_GetBlob(ctx, field, &second, &size) != EXIB_DEC_ERR_Success
+            || first != second))
+        result = 1;
+
+    // Data that decompresses to something else than its checksum, with a datum checksum that matches.
+    EXIB_BlobEntry* entry = FindBlobEntry((EXIB_Header*)datum, 3);
+    entry->checksum ^= 1;
+    ((EXIB_Header*)datum)->checksum = 0;
+    ((EXIB_Header*)datum)->checksum = EXIB_CRC32C(0, datum, ((EXIB_Header*)datum)->datumSize);
+    if (result == 0
+        && (EXIB_DEC_ResetContext(ctx, datum, ((EXIB_Header*)datum)->datumSize) != EXIB_DEC_ERR_Success
+            || EXIB_DEC_GetBlob(ctx, EXIB_DEC_FindField(ctx, NULL, "forced"), &first, &size) != EXIB_DEC_ERR_InvalidBlob))
+        result = 1;
+
+    // Compressed data that's cut short.
+    entry->checksum ^= 1;
+    entry->storedSize -= 1;
+    ((EXIB_Header*)datum)->checksum = 0;
+    ((EXIB_Header*)datum)->checksum = EXIB_CRC32C(0, datum, ((EXIB_Header*)datum)->datumSize);
+    if (result == 0
+        && (EXIB_DEC_ResetContext(ctx, datum, ((EXIB_Header*)datum)->datumSize) != EXIB_DEC_ERR_Success
+            || EXIB_DEC_GetBlob(ctx, EXIB_DEC_FindField(ctx, NULL, "forced"), &first, &size) != EXIB_DEC_ERR_InvalidBlob))
+        result = 1;
+
+    // A size that the compressed data can't decompress to is rejected before it's allocated.
+    entry->storedSize += 1;
+    entry->realSize = UINT32_MAX;
+    ((EXIB_Header*)datum)->checksum = 0;
+    ((EXIB_Header*)datum)->checksum = EXIB_CRC32C(0, datum, ((EXIB_Header*)datum)->datumSize);
+    s_LargestAllocation = 0;
+    EXIB_SetAllocator(LargestMalloc, free);
+    if (result == 0
+        && (EXIB_DEC_ResetContext(ctx, datum, ((EXIB_Header*)datum)->datumSize) != EXIB_DEC_ERR_Success
+            || EXIB_DEC_GetBlob(ctx, EXIB_DEC_FindField(ctx, NULL, "forced"), &first, &size) != EXIB_DEC_ERR_InvalidBlob
+            || s_LargestAllocation > textSize))
+        result = 1;
+    EXIB_SetAllocator(malloc, free);
+
+    EXIB_DEC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(encoder);
+    free(text);
+    free(noise);
+    free(zeros);
+    free(datum);
+    return result;
+}
+
+typedef struct _BoundRecord
+{
+    uint32_t id;
+    float x;
+    uint8_t count;
+    int32_t negative;
+    uint16_t unsignedNegative;
+    int32_t ratio;
+    double big;
+    int16_t missing;
+    uint8_t nestedId;
+} BoundRecord;
+
+// Fill a struct from fields of other types, out of order, with some missing or out of range.
+static int Test_EXIB_DEC_Bind()
+{
+    static const EXIB_DEC_Binding bindings[] = {
+        { "id", EXIB_TYPE_UINT32, offsetof(BoundRecord, id), { .uint32 = 0 } },
+        { "x", EXIB_TYPE_FLOAT, offsetof(BoundRecord, x), { .float32 = 0 } },
+        { "count", EXIB_TYPE_UINT8, offsetof(BoundRecord, count), { .uint8 = 255 } },
+        { "missing", EXIB_TYPE_INT16, offsetof(BoundRecord, missing), { .int16 = -42 } },
+        { "negative", EXIB_TYPE_INT32, offsetof(BoundRecord, negative), { .int32 = 0 } },
+        { "negative", EXIB_TYPE_UINT16, offsetof(BoundRecord, unsignedNegative), { .uint16 = 7 } },
+        { "ratio", EXIB_TYPE_INT32, offsetof(BoundRecord, ratio), { .int32 = 0 } },
+        { "big", EXIB_TYPE_DOUBLE, offsetof(BoundRecord, big), { .float64 = 0 } }
+    };
+    static const EXIB_DEC_Binding nestedBindings[] = {
+        { "id", EXIB_TYPE_UINT8, offsetof(BoundRecord, nestedId), { .uint8 = 0 } }
+    };
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_DEC_Context* ctx;
+    EXIB_DEC_Object nested;
+    BoundRecord record;
+    int result = 0;
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "x", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = 1.5 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "id", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 7 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "count", EXIB_TYPE_INT64), (EXIB_Value){ .int64 = 300 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "negative", EXIB_TYPE_INT8), (EXIB_Value){ .int8 = -5 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "ratio", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = -2.9 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "big", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = UINT64_C(1) << 40 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, EXIB_ENC_AddObject(encoder, NULL, "nested"), "unrelated", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 1 });
+    EXIB_ENC_Object* object = EXIB_ENC_AddObject(encoder, NULL, "nested2");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, object, "id", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 200 });
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    ctx = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    if (CheckDecoderContext(ctx))
+    {
+        EXIB_ENC_FreeContext(encoder);
+        return 1;
+    }
+
+    // "negative" matches both of its bindings, but only fits into the signed one.
+    memset(&record, 0xCC, sizeof(record));
+    if (EXIB_DEC_Bind(ctx, NULL, bindings, sizeof(bindings) / sizeof(bindings[0]), &record) != 5)
+        result |= 1;
+
+    if (record.id != 7 || record.x != 1.5f || record.count != 255 || record.missing != -42
+        || record.negative != -5 || record.unsignedNegative != 7 || record.ratio != -2
+        || record.big != (double)(UINT64_C(1) << 40))
+        result |= 2;
+
+    // Nested objects are bound on their own, and the root's "id" doesn't leak into them.
+    if (EXIB_DEC_FindObject(ctx, NULL, "nested2", &nested) != EXIB_DEC_ERR_Success
+        || EXIB_DEC_Bind(ctx, &nested, nestedBindings, 1, &record) != 1
+        || record.nestedId != 200)
+        result |= 4;
+
+    EXIB_DEC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(encoder);
+    return result;
+}
+
+static int Test_EXIB_DEC_PatchField()
+{
+    EXIB_ENC_Context* encoder = EXIB_ENC_CreateContext(NULL);
+    EXIB_DEC_FieldValue value;
+    EXIB_DEC_Object object;
+    int result = 0;
+
+    // Large enough that checksumming all of it again would show.
+    EXIB_ENC_ArrayResize(EXIB_ENC_AddArray(encoder, NULL, "samples", EXIB_TYPE_DOUBLE), 100000);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, NULL, "sequence", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 1 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(encoder, EXIB_ENC_AddObject(encoder, NULL, "status"), "voltage", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = 3.3 });
+
+    EXIB_Header* header = EXIB_ENC_Encode(encoder);
+    EXIB_DEC_Context* ctx = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    if (CheckDecoderContext(ctx))
+    {
+        EXIB_ENC_FreeContext(encoder);
+        return 1;
+    }
+
+    // Each patch leaves a datum that checks out, and reads back the new value.
+    EXIB_DEC_Field sequence = EXIB_DEC_FindField(ctx, NULL, "sequence");
+    for (uint32_t i = 2; i < 10 && result == 0; ++i)
+    {
+        if (EXIB_DEC_PatchField(ctx, sequence, (EXIB_Value){ .uint32 = i })
+            || EXIB_CheckHeader(header, header->datumSize)
+            || EXIB_DEC_FieldGet(ctx, sequence, &value) != EXIB_TYPE_UINT32
+            || memcmp(value.value, &i, sizeof(i)) != 0)
+            result |= 1;
+    }
+
+    // The same, with the value located by the caller.
+    EXIB_DEC_FindObject(ctx, NULL, "status", &object);
+    EXIB_DEC_FieldGet(ctx, EXIB_DEC_FindField(ctx, &object, "voltage"), &value);
+    if (EXIB_ENC_PatchValue(header, (void*)value.value, EXIB_TYPE_DOUBLE, (EXIB_Value){ .float64 = 3.1 })
+        || EXIB_CheckHeader(header, header->datumSize)
+        || memcmp(value.value, &(double){ 3.1 }, sizeof(double)) != 0)
+        result |= 2;
+
+    // Only values can be patched.
+    if (EXIB_DEC_PatchField(ctx, EXIB_DEC_FindField(ctx, NULL, "samples"), (EXIB_Value){ .uint32 = 0 }) == 0
+        || EXIB_DEC_GetLastError(ctx) != EXIB_DEC_ERR_ValueExpected
+        || EXIB_ENC_PatchValue(header, (void*)value.value, EXIB_TYPE_OBJECT, (EXIB_Value){ .uint32 = 0 }) == 0
+        || EXIB_ENC_PatchValue(header, header, EXIB_TYPE_UINT32, (EXIB_Value){ .uint32 = 0 }) == 0
+        || EXIB_CheckHeader(header, header->datumSize))
+        result |= 4;
+
+    EXIB_DEC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(encoder);
+    return result;
+}
+
+// Encode a telemetry datum into a buffer of its own, with one sample changed.
+static EXIB_Header* EncodeTelemetry(int noChecksum, uint32_t sequence, double voltage, size_t samples, size_t changed)
+{
+    EXIB_ENC_Options options;
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.noChecksum = noChecksum;
+
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(&options);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "sequence", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = sequence });
+    EXIB_ENC_Object* status = EXIB_ENC_AddObject(ctx, NULL, "status");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, status, "voltage", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = voltage });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, status, "state", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 2 });
+    EXIB_ENC_AddString(ctx, NULL, "unit", EXIB_TYPE_UINT8, "V");
+
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "samples", EXIB_TYPE_DOUBLE);
+    EXIB_ENC_ArrayResize(array, samples);
+    for (size_t i = 0; i < samples; ++i)
+        EXIB_ENC_ArraySet(array, i, (EXIB_Value){ .float64 = (i == changed) ? -1.0 : (double)i });
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    EXIB_Header* datum = malloc(header->datumSize);
+    memcpy(datum, header, header->datumSize);
+    EXIB_ENC_FreeContext(ctx);
+    return datum;
+}
+
+// Encode a patch from base to next, and check that applying it to a copy of the base gives next.
+static size_t CheckDelta(const EXIB_Header* base, const EXIB_Header* next)
+{
+    size_t bound = EXIB_DELTA_Bound(next);
+    size_t capacity = (base->datumSize > next->datumSize) ? base->datumSize : next->datumSize;
+    uint8_t* patch = malloc(bound);
+    uint8_t* out = malloc(capacity);
+    size_t size = EXIB_DELTA_Encode(base, next, patch, bound);
+
+    // Into a buffer of its own, and in place.
+    if (size == 0
+        || EXIB_DELTA_Apply(base, patch, size, out, next->datumSize)
+        || memcmp(out, next, next->datumSize) != 0
+        || (memcpy(out, base, base->datumSize), EXIB_DELTA_Apply((EXIB_Header*)out, patch, size, out, capacity))
+        || memcmp(out, next, next->datumSize) != 0)
+        size = 0;
+
+    // The patch must not fit a smaller buffer.
+    if (size != 0 && EXIB_DELTA_Encode(base, next, patch, size - 1) != 0)
+        size = 0;
+
+    free(out);
+    free(patch);
+    return size;
+}
+
+static int Test_EXIB_DELTA()
+{
+    EXIB_Header* base = EncodeTelemetry(0, 1, 3.3, 1000, 10);
+    EXIB_Header* next = EncodeTelemetry(0, 2, 3.1, 1000, 11);
+    EXIB_Header* grown = EncodeTelemetry(0, 3, 3.1, 1003, 11);
+    EXIB_Header* unchecked = EncodeTelemetry(1, 2, 3.1, 1000, 11);
+    EXIB_Header* large = EncodeTelemetry(0, 1, 3.3, 100000, 10);
+    EXIB_Header* largeNext = EncodeTelemetry(0, 2, 3.1, 100000, 99999);
+    int result = 0;
+
+    // Only the changed values are sent: a sequence number, a voltage and two samples.
+    size_t size = CheckDelta(base, next);
+    if (size == 0 || size > sizeof(EXIB_DeltaHeader) + 4 * 2 + 4 + 8 + 2 * 8)
+        result |= 1;
+
+    // Identical datums, changed sizes both ways, and datums without a checksum.
+    if (CheckDelta(next, next) != sizeof(EXIB_DeltaHeader)
+        || CheckDelta(next, grown) == 0
+        || CheckDelta(grown, next) == 0
+        || CheckDelta(next, unchecked) == 0
+        || CheckDelta(unchecked, base) == 0)
+        result |= 2;
+
+    // Large enough that the checksum is patched, rather than calculated again.
+    if (CheckDelta(large, largeNext) == 0)
+        result |= 2;
+
+    size_t bound = EXIB_DELTA_Bound(next);
+    uint8_t* patch = malloc(bound);
+    EXIB_Header* out = malloc(next->datumSize);
+    size = EXIB_DELTA_Encode(base, next, patch, bound);
+
+    // A patch only applies to its base, and leaves the base alone when it doesn't.
+    memcpy(out, next, next->datumSize);
+    if (EXIB_DELTA_Apply(out, patch, size, out, next->datumSize) == 0
+        || memcmp(out, next, next->datumSize) != 0)
+        result |= 4;
+
+    // Corrupt patches are rejected before anything is written.
+    for (size_t i = 0; i < size && !(result & 8); ++i)
+    {
+        memcpy(out, base, base->datumSize);
+        patch[i] ^= 0x40;
+        if (EXIB_DELTA_Apply(out, patch, size, out, next->datumSize) == 0
+            || memcmp(out, base, base->datumSize) != 0)
+            result |= 8;
+        patch[i] ^= 0x40;
+    }
+
+    if (EXIB_DELTA_Apply(base, patch, size - 1, out, next->datumSize) == 0
+        || EXIB_DELTA_Apply(base, patch, size, out, next->datumSize - 1) == 0)
+        result |= 16;
+
+    free(out);
+    free(patch);
+    free(largeNext);
+    free(large);
+    free(unchecked);
+    free(grown);
+    free(next);
+    free(base);
+    return result;
+}
+
 void AddDecoderTests()
 {
     AddTest("EXIB_DEC_CreateContext",
@@ -145,6 +774,22 @@ void AddDecoderTests()
             Test_EXIB_DEC_FindField_Numbers, NULL, NULL);
     AddTest("EXIB_DEC_FindField_NumbersAndObjects",
             Test_EXIB_DEC_FindField_NumbersAndObjects, NULL, NULL);
+    AddTest("EXIB_DEC_ParallelChecksum",
+            Test_EXIB_DEC_ParallelChecksum, NULL, NULL);
+    AddTest("EXIB_DEC_ChecksumMode",
+            Test_EXIB_DEC_ChecksumMode, NULL, NULL);
+    AddTest("EXIB_DEC_Dictionary",
+            Test_EXIB_DEC_Dictionary, NULL, NULL);
+    AddTest("EXIB_DEC_GetBlob",
+            Test_EXIB_DEC_GetBlob, NULL, NULL);
+    AddTest("EXIB_DEC_GetBlob_Compressed",
+            Test_EXIB_DEC_GetBlob_Compressed, NULL, NULL);
     AddTest("EXIB_DEC_FindObject_NumbersAndObjects",
             Test_EXIB_DEC_FindObject_NumbersAndObjects, NULL, NULL);
+    AddTest("EXIB_DEC_Bind",
+            Test_EXIB_DEC_Bind, NULL, NULL);
+    AddTest("EXIB_DEC_PatchField",
+            Test_EXIB_DEC_PatchField, NULL, NULL);
+    AddTest("EXIB_DELTA",
+            Test_EXIB_DELTA, NULL, NULL);
 }
\ No newline at end of file
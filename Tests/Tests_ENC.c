@@ -1,5 +1,6 @@
 #include "Test.h"
 #include "Samples.h"
+#include "ThreadInternal.h"
 
 static int CheckEncoderContext(EXIB_ENC_Context* ctx)
 {
@@ -69,9 +70,9 @@ static int Test_EXIB_ENC_Encode_EmptyRoot(void* parameter)
     return 0;
 }
 
-static int Test_EXIB_ENC_Encode_Numbers(void* parameter)
+// Build the tree described by Sample_Numbers.
+static void AddNumbers(EXIB_ENC_Context* ctx)
 {
-    EXIB_ENC_Context* ctx = parameter;
     EXIB_ENC_Field* a = EXIB_ENC_AddField(ctx, NULL, "a", EXIB_TYPE_UINT32);
     EXIB_ENC_Field* b = EXIB_ENC_AddField(ctx, NULL, "b", EXIB_TYPE_UINT32);
     EXIB_ENC_Field* c = EXIB_ENC_AddField(ctx, NULL, "c", EXIB_TYPE_UINT16);
@@ -79,6 +80,12 @@ static int Test_EXIB_ENC_Encode_Numbers(void* parameter)
     EXIB_ENC_SetValue(a, (EXIB_Value){ .uint32 = 0xdeadbeef });
     EXIB_ENC_SetValue(b, (EXIB_Value){ .uint32 = 0xcafebabe });
     EXIB_ENC_SetValue(c, (EXIB_Value){ .uint16 = 0xc001 });
+}
+
+static int Test_EXIB_ENC_Encode_Numbers(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    AddNumbers(ctx);
 
     EXIB_Header* header = EXIB_ENC_Encode(ctx);
     if (EXIB_CheckHeader(header, header->datumSize))
@@ -193,22 +200,1479 @@ int Test_EXIB_ENC_Encode_ArrayOfArrays(void* parameter)
     return 0;
 }
 
-void AddEncoderTests()
+static int Test_EXIB_ENC_MeasureSize(void* parameter)
 {
-    AddTest("EXIB_ENC_CreateContext", Test_EXIB_ENC_CreateContext, NULL, NULL);
-    AddTest("EXIB_ENC_Encode_EmptyRoot", Test_EXIB_ENC_Encode_EmptyRoot,
-            SetupGenericEncoderContext,
-            CleanupGenericEncoderContext);
-    AddTest("EXIB_ENC_Encode_Numbers", Test_EXIB_ENC_Encode_Numbers,
-            SetupGenericEncoderContext,
-            CleanupGenericEncoderContext);
-    AddTest("EXIB_ENC_Encode_NumbersAndObjects", Test_EXIB_ENC_Encode_NumbersAndObjects,
-            SetupGenericEncoderContext,
-            CleanupGenericEncoderContext);
-    AddTest("EXIB_ENC_Encode_Array", Test_EXIB_ENC_Encode_Array,
-            SetupGenericEncoderContext,
-            CleanupGenericEncoderContext);
-    AddTest("EXIB_ENC_Encode_ArrayOfArrays", Test_EXIB_ENC_Encode_ArrayOfArrays,
+    EXIB_ENC_Context* ctx = parameter;
+    AddNumbers(ctx);
+
+    size_t size = EXIB_ENC_MeasureSize(ctx);
+    if (size != sizeof(Sample_Numbers))
+    {
+        printf("TEST: \tERROR: Measured %zu bytes, expected %zu.\n", size, sizeof(Sample_Numbers));
+        return 1;
+    }
+
+    return 0;
+}
+
+static int Test_EXIB_ENC_EncodeInto(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    uint8_t buffer[sizeof(Sample_Numbers)];
+    AddNumbers(ctx);
+
+    // Must refuse to overrun a buffer that's one byte short.
+    if (EXIB_ENC_EncodeInto(ctx, buffer, sizeof(buffer) - 1) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_BufferTooSmall)
+        return 1;
+
+    // Fill with junk, nothing of it may leak into the datum.
+    memset(buffer, 0xCC, sizeof(buffer));
+    EXIB_Header* header = EXIB_ENC_EncodeInto(ctx, buffer, sizeof(buffer));
+    if (header != (EXIB_Header*)buffer)
+        return 1;
+
+    if (CompareDatum(header, Sample_Numbers, sizeof(Sample_Numbers)))
+        return 1;
+
+    return 0;
+}
+
+static int Test_EXIB_ENC_Encode_LargeArray(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const size_t count = 256 * 1024;
+
+    // 1 MiB of data, far beyond any initial buffer size.
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "array", EXIB_TYPE_UINT32);
+    EXIB_ENC_ArrayResize(array, count);
+    uint32_t* data = EXIB_ENC_ArrayGetData(array);
+    for (size_t i = 0; i < count; ++i)
+        data[i] = (uint32_t)i * 2654435761U;
+
+    size_t size = EXIB_ENC_MeasureSize(ctx);
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header || header->datumSize != size)
+        return 1;
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    if (EXIB_DEC_GetLastError(dec) != EXIB_DEC_ERR_Success)
+    {
+        EXIB_DEC_FreeContext(dec);
+        return 1;
+    }
+
+    EXIB_DEC_Array decArray;
+    EXIB_DEC_Field field = EXIB_DEC_FindField(dec, NULL, "array");
+    if (!EXIB_DEC_ArrayFromField(dec, field, &decArray)
+        || EXIB_DEC_ArrayGetLength(&decArray) != count
+        || memcmp(decArray.data, data, count * sizeof(uint32_t)) != 0)
+    {
+        EXIB_DEC_FreeContext(dec);
+        return 1;
+    }
+
+    EXIB_DEC_FreeContext(dec);
+    return 0;
+}
+
+static int Test_EXIB_ENC_ArrayAppend(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const size_t count = 10000;
+    uint16_t data[10000];
+
+    for (size_t i = 0; i < count; ++i)
+        data[i] = (uint16_t)(i * 7);
+
+    // Half one by one, half in bulk.
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "array", EXIB_TYPE_UINT16);
+    for (size_t i = 0; i < count / 2; ++i)
+    {
+        if (!EXIB_ENC_ArrayAppend(array, (EXIB_Value){ .uint16 = data[i] }))
+            return 1;
+    }
+    if (EXIB_ENC_ArrayAppendN(array, &data[count / 2], count / 2) != (uint16_t*)EXIB_ENC_ArrayGetData(array) + count / 2
+        || EXIB_ENC_ArrayGetSize(array) != count
+        || memcmp(EXIB_ENC_ArrayGetData(array), data, sizeof(data)) != 0)
+        return 1;
+
+    EXIB_ENC_Array* assigned = EXIB_ENC_AddArray(ctx, NULL, "assigned", EXIB_TYPE_UINT16);
+    EXIB_ENC_ArrayAppendN(assigned, data, 100);
+    if (EXIB_ENC_ArrayAssign(assigned, &data[100], 3)
+        || EXIB_ENC_ArrayGetSize(assigned) != 3
+        || memcmp(EXIB_ENC_ArrayGetData(assigned), &data[100], 3 * sizeof(uint16_t)) != 0)
+        return 1;
+
+    // Arrays of objects have no element buffer to copy into.
+    EXIB_ENC_Array* objects = EXIB_ENC_AddArray(ctx, NULL, "objects", EXIB_TYPE_OBJECT);
+    if (EXIB_ENC_ArrayAppendN(objects, data, 1) != NULL)
+        return 1;
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header)
+        return 1;
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    EXIB_DEC_Array decArray;
+    EXIB_DEC_Field field = EXIB_DEC_FindField(dec, NULL, "array");
+    int result = !EXIB_DEC_ArrayFromField(dec, field, &decArray)
+        || EXIB_DEC_ArrayGetLength(&decArray) != count
+        || memcmp(decArray.data, data, sizeof(data)) != 0;
+
+    EXIB_DEC_FreeContext(dec);
+    return result;
+}
+
+static int s_Released = 0;
+
+static void CountRelease(void* data)
+{
+    ++s_Released;
+}
+
+static int Test_EXIB_ENC_ArraySetExternal(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    static float samples[64 * 1024];
+    float first;
+
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+        samples[i] = (float)i * 0.25f;
+    first = samples[0];
+
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "samples", EXIB_TYPE_FLOAT);
+    EXIB_ENC_Array* changed = EXIB_ENC_AddArray(ctx, NULL, "changed", EXIB_TYPE_FLOAT);
+    s_Released = 0;
+    if (EXIB_ENC_ArraySetExternal(array, samples, 64 * 1024, CountRelease)
+        || EXIB_ENC_ArraySetExternal(array, samples, 64 * 1024, CountRelease)
+        || EXIB_ENC_ArraySetExternal(changed, samples, 16, CountRelease)
+        || EXIB_ENC_ArrayGetData(array) != samples
+        || s_Released != 0)
+        return 1;
+
+    // Writing to an external array copies it, leaving the caller's elements alone.
+    if (!EXIB_ENC_ArraySet(changed, 0, (EXIB_Value){ .float32 = -1.0f })
+        || EXIB_ENC_ArrayGetData(changed) == samples
+        || samples[0] != first
+        || s_Released != 1)
+        return 1;
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header)
+        return 1;
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    EXIB_DEC_Array decArray;
+    EXIB_DEC_Field field = EXIB_DEC_FindField(dec, NULL, "samples");
+    int result = !EXIB_DEC_ArrayFromField(dec, field, &decArray)
+        || EXIB_DEC_ArrayGetLength(&decArray) != 64 * 1024
+        || memcmp(decArray.data, samples, sizeof(samples)) != 0;
+    EXIB_DEC_FreeContext(dec);
+
+    // The rest is released by the reset.
+    EXIB_ENC_ResetContext(ctx, 1);
+    if (result || s_Released != 2)
+        return 1;
+
+    return 0;
+}
+
+static int Test_EXIB_ENC_Encode_NestedLarge(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const size_t count = 12000;
+    const int depth = 4;
+    EXIB_ENC_Object* object = NULL;
+
+    // Every level is larger than 64 KiB and needs a Size32, which
+    // must not shift the aligned data of the levels within it.
+    for (int i = 0; i < depth; ++i)
+    {
+        object = EXIB_ENC_AddObject(ctx, object, "object");
+        EXIB_ENC_AddField(ctx, object, "flag", EXIB_TYPE_UINT8);
+
+        EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, object, "array", EXIB_TYPE_DOUBLE);
+        EXIB_ENC_ArrayResize(array, count);
+        double* data = EXIB_ENC_ArrayGetData(array);
+        for (size_t j = 0; j < count; ++j)
+            data[j] = (double)(i * count + j);
+    }
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header || EXIB_CheckHeader(header, header->datumSize))
+        return 1;
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    EXIB_DEC_Object decObject = *EXIB_DEC_GetRootObject(dec);
+    int result = 0;
+
+    for (int i = 0; i < depth && result == 0; ++i)
+    {
+        EXIB_DEC_Array decArray;
+
+        if (EXIB_DEC_FindObject(dec, &decObject, "object", &decObject) != EXIB_DEC_ERR_Success
+            || !decObject.objectPrefix.size)
+        {
+            result = 1;
+            break;
+        }
+
+        EXIB_DEC_Field field = EXIB_DEC_FindField(dec, &decObject, "array");
+        if (!EXIB_DEC_ArrayFromField(dec, field, &decArray)
+            || EXIB_DEC_ArrayGetLength(&decArray) != count
+            || ((uintptr_t)decArray.data - (uintptr_t)header) % sizeof(double) != 0)
+        {
+            result = 1;
+            break;
+        }
+
+        const double* data = (const double*)decArray.data;
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (data[j] != (double)(i * count + j))
+            {
+                result = 1;
+                break;
+            }
+        }
+    }
+
+    EXIB_DEC_FreeContext(dec);
+    return result;
+}
+
+static int Test_EXIB_ENC_Encode_ManyNames(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const int count = 10000;
+    char name[16];
+
+    // Every name is added twice, the second time has to hit the cache.
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            snprintf(name, sizeof(name), "f%d", i);
+            EXIB_ENC_Field* field = EXIB_ENC_AddField(ctx, NULL, name, EXIB_TYPE_UINT32);
+            if (!field || strcmp(EXIB_ENC_GetName(field), name) != 0)
+                return 1;
+            EXIB_ENC_SetValue(field, (EXIB_Value){ .uint32 = i });
+        }
+    }
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header)
+        return 1;
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL);
+    if (EXIB_DEC_GetLastError(dec) != EXIB_DEC_ERR_Success)
+    {
+        EXIB_DEC_FreeContext(dec);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i += 37)
+    {
+        EXIB_DEC_FieldValue value;
+
+        snprintf(name, sizeof(name), "f%d", i);
+        EXIB_DEC_Field field = EXIB_DEC_FindField(dec, NULL, name);
+        if (EXIB_DEC_FieldGet(dec, field, &value) != EXIB_TYPE_UINT32
+            || value.value->uint32 != (uint32_t)i)
+        {
+            EXIB_DEC_FreeContext(dec);
+            return 1;
+        }
+    }
+
+    EXIB_DEC_FreeContext(dec);
+    return 0;
+}
+
+// Adds the same fields as AddInternedFields, by name.
+static void AddNamedFields(EXIB_ENC_Context* ctx, int round)
+{
+    EXIB_ENC_Object* object = EXIB_ENC_AddObject(ctx, NULL, "alpha");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, object, "beta", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = round });
+    EXIB_ENC_AddString(ctx, object, "gamma", EXIB_TYPE_UINT8, "text");
+    EXIB_ENC_ArrayAppend(EXIB_ENC_AddArray(ctx, NULL, "beta", EXIB_TYPE_INT32), (EXIB_Value){ .int32 = -round });
+    EXIB_ENC_AddField(ctx, NULL, NULL, EXIB_TYPE_NULL);
+}
+
+static int AddInternedFields(EXIB_ENC_Context* ctx, EXIB_ENC_Name* names, int round)
+{
+    EXIB_ENC_Object* object = EXIB_ENC_AddObjectInterned(ctx, NULL, names[0]);
+    EXIB_ENC_Field* field = EXIB_ENC_AddFieldInterned(ctx, object, names[1], EXIB_TYPE_UINT8);
+    EXIB_ENC_String* string = EXIB_ENC_AddStringInterned(ctx, object, names[2], EXIB_TYPE_UINT8, "text");
+    EXIB_ENC_Array* array = EXIB_ENC_AddArrayInterned(ctx, NULL, names[1], EXIB_TYPE_INT32);
+
+    if (!object || !field || !string || !array
+        || !EXIB_ENC_AddFieldInterned(ctx, NULL, EXIB_ENC_NO_NAME, EXIB_TYPE_NULL))
+        return 1;
+
+    EXIB_ENC_SetValue(field, (EXIB_Value){ .uint8 = round });
+    EXIB_ENC_ArrayAppend(array, (EXIB_Value){ .int32 = -round });
+    return strcmp(EXIB_ENC_GetName(field), "beta") != 0;
+}
+
+// Encode the interned fields and the named fields after both kinds of reset, which must give the same datums.
+static int CompareInternedFields(EXIB_ENC_Context* ctx, EXIB_ENC_Context* reference, EXIB_ENC_Name* names)
+{
+    for (int round = 0; round < 4; ++round)
+    {
+        EXIB_ENC_ResetContext(ctx, round & 1);
+        EXIB_ENC_ResetContext(reference, 0);
+
+        if (AddInternedFields(ctx, names, round))
+            return 1;
+        AddNamedFields(reference, round);
+
+        EXIB_Header* header = EXIB_ENC_Encode(ctx);
+        EXIB_Header* expected = EXIB_ENC_Encode(reference);
+        if (!header || !expected
+            || header->datumSize != expected->datumSize
+            || memcmp(header, expected, header->datumSize) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int Test_EXIB_ENC_InternName(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    EXIB_ENC_Name names[3];
+
+    // Some other name comes first, so the interned ones move when the cache is cleared.
+    EXIB_ENC_AddField(ctx, NULL, "other", EXIB_TYPE_NULL);
+    names[0] = EXIB_ENC_InternName(ctx, "alpha");
+    names[1] = EXIB_ENC_InternName(ctx, "beta");
+    names[2] = EXIB_ENC_InternName(ctx, "gamma");
+    if (names[0] == EXIB_ENC_NO_NAME
+        || EXIB_ENC_InternName(ctx, "beta") != names[1]
+        || EXIB_ENC_AddFieldInterned(ctx, NULL, names[2] + 1, EXIB_TYPE_NULL) != NULL)
+        return 1;
+
+    EXIB_ENC_Context* reference = EXIB_ENC_CreateContext(NULL);
+    int result = CompareInternedFields(ctx, reference, names);
+    EXIB_ENC_FreeContext(reference);
+
+    return result;
+}
+
+static int Test_EXIB_ENC_Stream_Numbers(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    if (EXIB_ENC_BeginStream(ctx)
+        || EXIB_ENC_WriteUInt32(ctx, "a", 0xdeadbeef)
+        || EXIB_ENC_WriteUInt32(ctx, "b", 0xcafebabe)
+        || EXIB_ENC_WriteUInt16(ctx, "c", 0xc001))
+        return 1;
+
+    // Objects must be closed before the stream can end.
+    if (EXIB_ENC_EndObject(ctx) == 0 || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_StreamState)
+        return 1;
+
+    EXIB_Header* header = EXIB_ENC_EndStream(ctx);
+    if (!header || EXIB_CheckHeader(header, header->datumSize))
+    {
+        puts("TEST: \tERROR: Invalid header!");
+        return 1;
+    }
+
+    DumpDatum(header, "EXIB_ENC_Stream_Numbers.exib");
+
+    if (CompareDatum(header, Sample_Numbers, sizeof(Sample_Numbers)))
+        return 1;
+
+    return 0;
+}
+
+#define STREAM_DEPTH   3
+#define STREAM_DOUBLES 3000
+#define STREAM_OBJECTS 5000
+#define STREAM_ARRAYS  3
+#define STREAM_SHORTS  40000
+
+// Build a tree that needs Size32s at every level, in the same order StreamLarge writes it.
+static void AddLarge(EXIB_ENC_Context* ctx, double* doubles, uint16_t* shorts)
+{
+    EXIB_ENC_Object* object = NULL;
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 7 });
+    for (int i = 0; i < STREAM_DEPTH; ++i)
+    {
+        object = EXIB_ENC_AddObject(ctx, object, "object");
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, object, "flag", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = i });
+
+        EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, object, "values", EXIB_TYPE_DOUBLE);
+        EXIB_ENC_ArrayResize(array, STREAM_DOUBLES);
+        memcpy(EXIB_ENC_ArrayGetData(array), doubles, STREAM_DOUBLES * sizeof(double));
+    }
+
+    EXIB_ENC_Array* list = EXIB_ENC_AddArray(ctx, NULL, "list", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < STREAM_OBJECTS; ++i)
+    {
+        EXIB_ENC_Object* element = EXIB_ENC_ArrayAddObject(ctx, list);
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, element, "x", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = i });
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, element, "y", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = i });
+    }
+
+    EXIB_ENC_Array* arrays = EXIB_ENC_AddArray(ctx, NULL, "arrays", EXIB_TYPE_ARRAY);
+    for (int i = 0; i < STREAM_ARRAYS; ++i)
+    {
+        EXIB_ENC_Array* array = EXIB_ENC_ArrayAddArray(ctx, arrays, EXIB_TYPE_UINT16);
+        EXIB_ENC_ArrayResize(array, STREAM_SHORTS);
+        memcpy(EXIB_ENC_ArrayGetData(array), shorts, STREAM_SHORTS * sizeof(uint16_t));
+    }
+
+    EXIB_ENC_AddString(ctx, NULL, "name", EXIB_TYPE_UINT8, "streamed");
+}
+
+static int StreamLarge(EXIB_ENC_Context* ctx, double* doubles, uint16_t* shorts)
+{
+    int result = EXIB_ENC_BeginStream(ctx);
+
+    result |= EXIB_ENC_WriteUInt8(ctx, "id", 7);
+    for (int i = 0; i < STREAM_DEPTH; ++i)
+    {
+        result |= EXIB_ENC_BeginObject(ctx, "object");
+        result |= EXIB_ENC_WriteUInt8(ctx, "flag", i);
+        result |= EXIB_ENC_WriteArray(ctx, "values", EXIB_TYPE_DOUBLE, doubles, STREAM_DOUBLES);
+    }
+    for (int i = 0; i < STREAM_DEPTH; ++i)
+        result |= EXIB_ENC_EndObject(ctx);
+
+    result |= EXIB_ENC_BeginArray(ctx, "list", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < STREAM_OBJECTS; ++i)
+    {
+        result |= EXIB_ENC_BeginObject(ctx, NULL);
+        result |= EXIB_ENC_WriteUInt8(ctx, "x", i);
+        result |= EXIB_ENC_WriteDouble(ctx, "y", i);
+        result |= EXIB_ENC_EndObject(ctx);
+    }
+    result |= EXIB_ENC_EndArray(ctx);
+
+    result |= EXIB_ENC_BeginArray(ctx, "arrays", EXIB_TYPE_ARRAY);
+    for (int i = 0; i < STREAM_ARRAYS; ++i)
+        result |= EXIB_ENC_WriteArray(ctx, NULL, EXIB_TYPE_UINT16, shorts, STREAM_SHORTS);
+    result |= EXIB_ENC_EndArray(ctx);
+
+    result |= EXIB_ENC_WriteString(ctx, "name", EXIB_TYPE_UINT8, "streamed");
+    return result;
+}
+
+static int Test_EXIB_ENC_Stream_Large(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    EXIB_ENC_Context* treeCtx = EXIB_ENC_CreateContext(NULL);
+    double* doubles = malloc(STREAM_DOUBLES * sizeof(double));
+    uint16_t* shorts = malloc(STREAM_SHORTS * sizeof(uint16_t));
+    int result = 1;
+
+    for (int i = 0; i < STREAM_DOUBLES; ++i)
+        doubles[i] = i * 0.25;
+    for (int i = 0; i < STREAM_SHORTS; ++i)
+        shorts[i] = (uint16_t)(i * 31);
+
+    // Promoting aggregates to Size32 while streaming must produce the same datum as the tree encoder.
+    AddLarge(treeCtx, doubles, shorts);
+    EXIB_Header* expected = EXIB_ENC_Encode(treeCtx);
+    EXIB_ObjectPrefix rootPrefix = { .byte = expected ? ((uint8_t*)(expected + 1))[1] : 0 };
+
+    if (expected && rootPrefix.size && StreamLarge(ctx, doubles, shorts) == 0)
+    {
+        EXIB_Header* header = EXIB_ENC_EndStream(ctx);
+
+        if (header && !EXIB_CheckHeader(header, header->datumSize))
+        {
+            DumpDatum(header, "EXIB_ENC_Stream_Large.exib");
+            result = CompareDatum(header, (const uint8_t*)expected, expected->datumSize);
+        }
+    }
+
+    free(doubles);
+    free(shorts);
+    EXIB_ENC_FreeContext(treeCtx);
+    return result;
+}
+
+// Sink that collects the datum in memory.
+typedef struct _MemorySink
+{
+    uint8_t* data;
+    size_t size;
+    size_t position;
+    size_t writes;
+} MemorySink;
+
+static int MemorySinkWrite(void* user, const void* data, size_t size)
+{
+    MemorySink* sink = user;
+
+    if (sink->position + size > sink->size)
+    {
+        sink->data = realloc(sink->data, sink->position + size);
+        sink->size = sink->position + size;
+    }
+
+    memcpy(sink->data + sink->position, data, size);
+    sink->position += size;
+    ++sink->writes;
+    return 0;
+}
+
+// Every way of encoding must fail with EXIB_ENC_ERR_InvalidElement.
+static int CheckInvalidElement(EXIB_ENC_Context* ctx)
+{
+    uint8_t buffer[256];
+    MemorySink sink = { 0 };
+    struct iovec iov[16];
+    int segments = 16;
+    int result = 0;
+
+    if (EXIB_ENC_MeasureSize(ctx) != 0
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement
+        || EXIB_ENC_Encode(ctx) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement
+        || EXIB_ENC_EncodeInto(ctx, buffer, sizeof(buffer)) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement
+        || EXIB_ENC_EncodeParallel(ctx, 4) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement
+        || EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, NULL, &sink) == 0
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement
+        || EXIB_ENC_EncodeIOV(ctx, iov, &segments) == 0
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidElement)
+        result = 1;
+
+    free(sink.data);
+    return result;
+}
+
+static int Test_EXIB_ENC_InvalidElement(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+
+    // A field added to an array of objects, which only holds objects.
+    EXIB_ENC_Array* objects = EXIB_ENC_AddArray(ctx, NULL, "objects", EXIB_TYPE_OBJECT);
+    EXIB_ENC_ArrayAddObject(ctx, objects);
+    EXIB_ENC_AddField(ctx, (EXIB_ENC_Object*)objects, "field", EXIB_TYPE_UINT32);
+    if (CheckInvalidElement(ctx))
+        return 1;
+
+    // A field added to an array of values, which holds no fields at all.
+    EXIB_ENC_ResetContext(ctx, 0);
+    EXIB_ENC_Array* values = EXIB_ENC_AddArray(ctx, NULL, "values", EXIB_TYPE_UINT32);
+    EXIB_ENC_AddField(ctx, (EXIB_ENC_Object*)values, "field", EXIB_TYPE_UINT32);
+    if (CheckInvalidElement(ctx))
+        return 1;
+
+    // The context can be used again once the tree is fixed.
+    EXIB_ENC_ResetContext(ctx, 0);
+    AddNumbers(ctx);
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header || CompareDatum(header, Sample_Numbers, sizeof(Sample_Numbers)))
+        return 1;
+
+    return 0;
+}
+
+static int MemorySinkSeek(void* user, size_t offset)
+{
+    MemorySink* sink = user;
+    sink->position = offset;
+    return 0;
+}
+
+static int Test_EXIB_ENC_EncodeToSink(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    MemorySink seekable = { 0 };
+    MemorySink pipe = { 0 };
+    int result = 0;
+
+    // Larger than a chunk, so that it takes more than one write.
+    AddNumbers(ctx);
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "array", EXIB_TYPE_UINT32);
+    EXIB_ENC_ArrayResize(array, 100000);
+    uint32_t* data = EXIB_ENC_ArrayGetData(array);
+    for (size_t i = 0; i < 100000; ++i)
+        data[i] = (uint32_t)i;
+    EXIB_ENC_AddString(ctx, NULL, "name", EXIB_TYPE_UINT8, "sink");
+
+    if (EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, MemorySinkSeek, &seekable)
+        || EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, NULL, &pipe))
+        result = 1;
+
+    EXIB_Header* expected = EXIB_ENC_Encode(ctx);
+    if (result == 0
+        && (seekable.writes < 2
+            || seekable.position != expected->datumSize
+            || CompareDatum(expected, seekable.data, seekable.size)
+            || CompareDatum(expected, pipe.data, pipe.size)))
+        result = 1;
+
+    free(seekable.data);
+    free(pipe.data);
+    return result;
+}
+
+// Encode to segments and check that they add up to the same datum as EXIB_ENC_Encode.
+static int CheckEncodeIOV(EXIB_ENC_Context* ctx, const void* payload, MemorySink* gathered)
+{
+    struct iovec iov[256];
+    int count = 1;
+    int referenced = 0;
+
+    // Too few segments reports how many are needed.
+    if (EXIB_ENC_EncodeIOV(ctx, iov, &count) == 0
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_BufferTooSmall
+        || count <= 1 || count > 256)
+        return 1;
+
+    count = 256;
+    if (EXIB_ENC_EncodeIOV(ctx, iov, &count))
+        return 1;
+
+    // Large arrays are referenced, not copied.
+    for (int i = 0; i < count; ++i)
+    {
+        referenced |= iov[i].iov_base == payload;
+        MemorySinkWrite(gathered, iov[i].iov_base, iov[i].iov_len);
+    }
+
+    EXIB_Header* expected = EXIB_ENC_Encode(ctx);
+    return !referenced || CompareDatum(expected, gathered->data, gathered->size);
+}
+
+static int Test_EXIB_ENC_EncodeIOV(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    double* doubles = malloc(STREAM_DOUBLES * sizeof(double));
+    uint16_t* shorts = malloc(STREAM_SHORTS * sizeof(uint16_t));
+    MemorySink gathered = { 0 };
+
+    for (int i = 0; i < STREAM_DOUBLES; ++i)
+        doubles[i] = i * 0.5;
+    for (int i = 0; i < STREAM_SHORTS; ++i)
+        shorts[i] = (uint16_t)(i * 17);
+
+    AddNumbers(ctx);
+    AddLarge(ctx, doubles, shorts);
+    EXIB_ENC_Array* external = EXIB_ENC_AddArray(ctx, NULL, "external", EXIB_TYPE_DOUBLE);
+    EXIB_ENC_ArraySetExternal(external, doubles, STREAM_DOUBLES, NULL);
+
+    int result = CheckEncodeIOV(ctx, doubles, &gathered);
+
+    free(gathered.data);
+    free(doubles);
+    free(shorts);
+    return result;
+}
+
+static int Test_EXIB_ENC_NoChecksum()
+{
+    EXIB_ENC_Options options;
+    MemorySink pipe = { 0 };
+    MemorySink gathered = { 0 };
+    struct iovec iov[8];
+    int count = 8;
+    int result = 0;
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.noChecksum = 1;
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(&options);
+
+    AddNumbers(ctx);
+    EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "array", EXIB_TYPE_UINT32);
+    EXIB_ENC_ArrayResize(array, 100000);
+
+    // Every path flags the datum the same way and leaves the checksum at 0.
+    EXIB_Header* expected = EXIB_ENC_Encode(ctx);
+    if (!expected
+        || !(expected->flags & EXIB_HEADER_NO_CHECKSUM)
+        || expected->checksum != 0
+        || EXIB_CheckHeaderFields(expected, expected->datumSize))
+        result = 1;
+
+    if (result == 0
+        && (EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, NULL, &pipe)
+            || CompareDatum(expected, pipe.data, pipe.size)))
+        result = 1;
+
+    if (result == 0 && EXIB_ENC_EncodeIOV(ctx, iov, &count) == 0)
+    {
+        for (int i = 0; i < count; ++i)
+            MemorySinkWrite(&gathered, iov[i].iov_base, iov[i].iov_len);
+
+        result = CompareDatum(EXIB_ENC_Encode(ctx), gathered.data, gathered.size);
+    }
+    else
+        result = 1;
+
+    free(pipe.data);
+    free(gathered.data);
+    EXIB_ENC_FreeContext(ctx);
+    return result;
+}
+
+// Encode the same datum with every output path, which must all agree.
+static int CheckEncodePaths(EXIB_ENC_Context* ctx)
+{
+    MemorySink seekable = { 0 };
+    MemorySink pipe = { 0 };
+    MemorySink gathered = { 0 };
+    struct iovec iov[16];
+    int count = 16;
+    int result = 0;
+
+    if (EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, MemorySinkSeek, &seekable)
+        || EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, NULL, &pipe)
+        || EXIB_ENC_EncodeIOV(ctx, iov, &count))
+        result = 1;
+
+    for (int i = 0; i < count && result == 0; ++i)
+        MemorySinkWrite(&gathered, iov[i].iov_base, iov[i].iov_len);
+
+    EXIB_Header* expected = EXIB_ENC_Encode(ctx);
+    if (result == 0
+        && (!expected
+            || EXIB_CheckHeader(expected, expected->datumSize)
+            || CompareDatum(expected, seekable.data, seekable.size)
+            || CompareDatum(expected, pipe.data, pipe.size)
+            || CompareDatum(expected, gathered.data, gathered.size)))
+        result = 1;
+
+    free(seekable.data);
+    free(pipe.data);
+    free(gathered.data);
+    return result;
+}
+
+static int Test_EXIB_ENC_AddBlob(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const size_t largeSize = 100000;
+    uint8_t* large = malloc(largeSize);
+    int result = 0;
+
+    for (size_t i = 0; i < largeSize; ++i)
+        large[i] = (uint8_t)(i * 7);
+
+    AddNumbers(ctx);
+    EXIB_ENC_Field* small = EXIB_ENC_AddBlob(ctx, NULL, "small", "blob", 4);
+    EXIB_ENC_Object* object = EXIB_ENC_AddObject(ctx, NULL, "object");
+    EXIB_ENC_Field* big = EXIB_ENC_AddBlob(ctx, object, "large", large, largeSize);
+
+    // The blob is copied, so the caller's buffer can go away.
+    large[0] = 0xFF;
+    free(large);
+
+    if (!small || !big)
+        result = 1;
+
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (result == 0
+        && (!header
+            || !(header->flags & EXIB_HEADER_EXT)
+            || header->extendedSize != sizeof(EXIB_ExtHeader)
+            || header->datumSize < largeSize
+            || EXIB_ENC_MeasureSize(ctx) != header->datumSize))
+        result = 1;
+
+    if (result == 0)
+    {
+        DumpDatum(header, "EXIB_ENC_AddBlob.exib");
+        result = CheckEncodePaths(ctx);
+    }
+
+    // A datum has room for 256 blobs.
+    for (int i = 2; i < EXIB_MAX_BLOBS && result == 0; ++i)
+        result = EXIB_ENC_AddBlob(ctx, NULL, NULL, &i, sizeof(i)) == NULL;
+
+    if (result == 0
+        && (EXIB_ENC_AddBlob(ctx, NULL, NULL, "full", 4) != NULL
+            || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_BlobTableFull))
+        result = 1;
+
+    if (result == 0)
+        result = CheckEncodePaths(ctx);
+
+    // Without blobs, there's no extended header after a reset.
+    EXIB_ENC_ResetContext(ctx, 0);
+    AddNumbers(ctx);
+    header = EXIB_ENC_Encode(ctx);
+    if (result == 0 && (!header || header->flags & EXIB_HEADER_EXT || header->extendedSize != 0))
+        result = 1;
+
+    return result;
+}
+
+// Large children of every kind, at offsets that need padding, with small fields in between.
+static void AddParallelDatum(EXIB_ENC_Context* ctx, uint8_t* blob, size_t blobSize)
+{
+    for (int i = 0; i < 24; ++i)
+    {
+        EXIB_ENC_Field* id = EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT8);
+        EXIB_ENC_SetValue(id, (EXIB_Value){ .uint8 = i });
+
+        EXIB_ENC_Array* samples = EXIB_ENC_AddArray(ctx, NULL, "samples", (i % 2) ? EXIB_TYPE_DOUBLE : EXIB_TYPE_UINT16);
+        EXIB_ENC_ArrayResize(samples, 20000 + i * 997);
+        EXIB_ENC_ArraySet(samples, i, (EXIB_Value){ .uint16 = 0xABCD });
+    }
+
+    EXIB_ENC_Object* shard = EXIB_ENC_AddObject(ctx, NULL, "shard");
+    for (int i = 0; i < 20000; ++i)
+        EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, shard, NULL, EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = i });
+
+    EXIB_ENC_Array* channels = EXIB_ENC_AddArray(ctx, NULL, "channels", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < 8; ++i)
+    {
+        EXIB_ENC_Object* channel = EXIB_ENC_ArrayAddObject(ctx, channels);
+        EXIB_ENC_Array* data = EXIB_ENC_AddArray(ctx, channel, "data", EXIB_TYPE_INT32);
+        EXIB_ENC_ArrayResize(data, 100000);
+        EXIB_ENC_ArraySet(data, 99999, (EXIB_Value){ .int32 = -i });
+    }
+
+    EXIB_ENC_AddBlob(ctx, NULL, "small", "blob", 4);
+    EXIB_ENC_AddBlob(ctx, NULL, "large", blob, blobSize);
+}
+
+static int Test_EXIB_ENC_EncodeParallel(void* parameter)
+{
+    const size_t blobSize = 3 * 1024 * 1024 + 5;
+    uint8_t* blob = malloc(blobSize);
+    uint8_t* expected = NULL;
+    int result = 0;
+
+    for (size_t i = 0; i < blobSize; ++i)
+        blob[i] = (uint8_t)rand();
+
+    for (int noChecksum = 0; noChecksum <= 1 && result == 0; ++noChecksum)
+    {
+        EXIB_ENC_Options options;
+        EXIB_ENC_GetDefaultOptions(&options);
+        options.noChecksum = noChecksum;
+
+        EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(&options);
+        AddParallelDatum(ctx, blob, blobSize);
+
+        EXIB_Header* header = EXIB_ENC_Encode(ctx);
+        size_t size = header->datumSize;
+        expected = malloc(size);
+        memcpy(expected, header, size);
+
+        // Each time into a buffer that still holds the previous datum, so nothing can be left out.
+        static const int threads[] = { 1, 2, 3, 4, 7, 8, 64, 1000 };
+        for (int i = 0; i < 8 && result == 0; ++i)
+        {
+            memset(header, 0xEE, size);
+            header = EXIB_ENC_EncodeParallel(ctx, threads[i]);
+            if (!header
+                || CompareDatum(header, expected, size)
+                || (!noChecksum && EXIB_CheckHeader(header, size)))
+                result = 1;
+        }
+
+        free(expected);
+        EXIB_ENC_FreeContext(ctx);
+    }
+
+    // Small datums are encoded on the calling thread.
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(NULL);
+    AddNumbers(ctx);
+    EXIB_Header* header = EXIB_ENC_EncodeParallel(ctx, 4);
+    if (result == 0 && (!header || CompareDatum(header, Sample_Numbers, sizeof(Sample_Numbers))))
+        result = 1;
+
+    EXIB_ENC_FreeContext(ctx);
+    free(blob);
+    return result;
+}
+
+static const char* s_DictionaryNames[] = { "timestamp", "x", "y", "z", "status", "x" };
+
+// Record whose names are all in the dictionary, except for "extra".
+static void AddDictionaryRecord(EXIB_ENC_Context* ctx, EXIB_ENC_Name status)
+{
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "timestamp", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = 1234 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "x", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = 1.0f });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "extra", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 5 });
+    EXIB_ENC_SetValue(EXIB_ENC_AddFieldInterned(ctx, NULL, status, EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = 1 });
+}
+
+typedef struct _DictionaryWorker
+{
+    EXIB_Thread thread;
+    const EXIB_Dictionary* dictionary;
+    const EXIB_Header* expected;
+    int started;
+    int result;
+} DictionaryWorker;
+
+// Encode the record with a context of the worker's own.
+static void DictionaryWorkerMain(void* arg)
+{
+    DictionaryWorker* worker = arg;
+    EXIB_ENC_Options options;
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.dictionary = worker->dictionary;
+
+    EXIB_ENC_Context* ctx = EXIB_ENC_CreateContext(&options);
+    worker->result = 0;
+    for (int i = 0; i < 1000 && worker->result == 0; ++i)
+    {
+        EXIB_ENC_ResetContext(ctx, 0);
+        AddDictionaryRecord(ctx, EXIB_ENC_InternName(ctx, "status"));
+        worker->result = CompareDatum(EXIB_ENC_Encode(ctx), (const uint8_t*)worker->expected, worker->expected->datumSize);
+    }
+    EXIB_ENC_FreeContext(ctx);
+}
+
+static int Test_EXIB_ENC_Dictionary(void* parameter)
+{
+    char longName[300];
+    EXIB_Dictionary* dictionary = EXIB_CreateDictionary(7, s_DictionaryNames, 6);
+    EXIB_ENC_Options options;
+    EXIB_ENC_Context* plain = EXIB_ENC_CreateContext(NULL);
+    EXIB_ENC_Context* ctx;
+    DictionaryWorker workers[4];
+    int result = 0;
+
+    memset(longName, 'n', sizeof(longName) - 1);
+    longName[sizeof(longName) - 1] = '\0';
+    const char* invalid[] = { "timestamp", longName };
+
+    // Duplicates are only added once, and every name must fit into a string table entry.
+    if (!dictionary
+        || EXIB_GetDictionaryId(dictionary) != 7
+        || EXIB_GetDictionarySize(dictionary) != 5
+        || EXIB_CreateDictionary(0, s_DictionaryNames, 6) != NULL
+        || EXIB_CreateDictionary(8, invalid, 2) != NULL)
+    {
+        EXIB_ENC_FreeContext(plain);
+        return 1;
+    }
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.dictionary = dictionary;
+    ctx = EXIB_ENC_CreateContext(&options);
+
+    EXIB_ENC_Name status = EXIB_ENC_InternName(ctx, "status");
+    if (status == EXIB_ENC_NO_NAME || EXIB_ENC_InternName(ctx, "status") != status)
+        result = 1;
+
+    AddDictionaryRecord(plain, EXIB_ENC_InternName(plain, "status"));
+    AddDictionaryRecord(ctx, status);
+
+    // Only "extra" is left in the string table.
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    EXIB_Header* plainHeader = EXIB_ENC_Encode(plain);
+    if (result == 0
+        && (!header
+            || !(header->flags & EXIB_HEADER_EXT)
+            || ((EXIB_ExtHeader*)(header + 1))->dictionary != 7
+            || header->stringSize != sizeof(EXIB_StringEntry) + strlen("extra")
+            || header->datumSize >= plainHeader->datumSize
+            || EXIB_ENC_MeasureSize(ctx) != header->datumSize))
+        result = 1;
+
+    uint8_t* expected = malloc(header->datumSize);
+    memcpy(expected, header, header->datumSize);
+
+    if (result == 0)
+    {
+        DumpDatum(header, "EXIB_ENC_Dictionary.exib");
+        result = CheckEncodePaths(ctx);
+    }
+
+    // Interned names of the dictionary survive a reset without taking up the table.
+    EXIB_ENC_ResetContext(ctx, 0);
+    AddDictionaryRecord(ctx, status);
+    if (result == 0)
+        result = CompareDatum(EXIB_ENC_Encode(ctx), expected, ((EXIB_Header*)expected)->datumSize);
+
+    // The stream writer uses the same offsets.
+    if (result == 0
+        && (EXIB_ENC_BeginStream(ctx)
+            || EXIB_ENC_WriteUInt64(ctx, "timestamp", 1234)
+            || EXIB_ENC_WriteFloat(ctx, "x", 1.0f)
+            || EXIB_ENC_WriteUInt8(ctx, "extra", 5)
+            || EXIB_ENC_WriteUInt8(ctx, "status", 1)
+            || CompareDatum(EXIB_ENC_EndStream(ctx), expected, ((EXIB_Header*)expected)->datumSize)))
+        result = 1;
+
+    // Contexts on several threads share the dictionary.
+    for (int i = 0; i < 4; ++i)
+    {
+        workers[i].dictionary = dictionary;
+        workers[i].expected = (EXIB_Header*)expected;
+        workers[i].started = !EXIB_ThreadStart(&workers[i].thread, DictionaryWorkerMain, &workers[i]);
+        if (!workers[i].started)
+            DictionaryWorkerMain(&workers[i]);
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (workers[i].started)
+            EXIB_ThreadJoin(&workers[i].thread);
+        result |= workers[i].result;
+    }
+
+    free(expected);
+    EXIB_ENC_FreeContext(ctx);
+    EXIB_ENC_FreeContext(plain);
+    EXIB_FreeDictionary(dictionary);
+    return result;
+}
+
+static int Test_EXIB_ENC_EncodeToFD(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    FILE* file = tmpfile();
+    int result = 1;
+
+    if (!file)
+        return 1;
+
+    AddNumbers(ctx);
+
+    // Datums start at the current position of the file.
+    fputs("prefix", file);
+    fflush(file);
+
+    if (EXIB_ENC_EncodeToFD(ctx, fileno(file)) == 0)
+    {
+        uint8_t buffer[sizeof(Sample_Numbers) + 7];
+        size_t size;
+
+        fseek(file, 0, SEEK_SET);
+        size = fread(buffer, 1, sizeof(buffer), file);
+        result = size != sizeof(Sample_Numbers) + 6
+            || memcmp(buffer, "prefix", 6) != 0
+            || memcmp(buffer + 6, Sample_Numbers, sizeof(Sample_Numbers)) != 0;
+    }
+
+    fclose(file);
+    return result;
+}
+
+static size_t s_Allocations = 0;
+
+static void* CountingMalloc(size_t n)
+{
+    ++s_Allocations;
+    return malloc(n);
+}
+
+static int Test_EXIB_ENC_ResetContext(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    EXIB_Header* header;
+    int result = 0;
+
+    // Rebuilding the same datum after a reset must not allocate anything.
+    for (int i = 0; i < 3 && result == 0; ++i)
+    {
+        if (i == 2)
+        {
+            s_Allocations = 0;
+            EXIB_SetAllocator(CountingMalloc, free);
+        }
+
+        EXIB_ENC_ResetContext(ctx, 1);
+        AddNumbers(ctx);
+        EXIB_ENC_AddObject(ctx, NULL, "object");
+        EXIB_ENC_AddString(ctx, NULL, "string", EXIB_TYPE_UINT8, "reset");
+
+        EXIB_ENC_Array* array = EXIB_ENC_AddArray(ctx, NULL, "array", EXIB_TYPE_DOUBLE);
+        EXIB_ENC_ArrayResize(array, 10000);
+
+        header = EXIB_ENC_Encode(ctx);
+        if (!header || EXIB_CheckHeader(header, header->datumSize))
+            result = 1;
+    }
+
+    EXIB_SetAllocator(malloc, free);
+    if (result || s_Allocations != 0)
+    {
+        printf("TEST: \tERROR: %zu allocations after reset.\n", s_Allocations);
+        return 1;
+    }
+
+    // Without the string cache, offsets start over.
+    EXIB_ENC_ResetContext(ctx, 0);
+    AddNumbers(ctx);
+
+    header = EXIB_ENC_Encode(ctx);
+    if (!header || CompareDatum(header, Sample_Numbers, sizeof(Sample_Numbers)))
+        return 1;
+
+    return 0;
+}
+
+#define SENSOR_SAMPLES 100000
+
+typedef struct _BoundPoint
+{
+    float x;
+    float y;
+} BoundPoint;
+
+typedef struct _BoundSensor
+{
+    uint8_t id;
+    double reading;
+    int16_t history[5];
+    BoundPoint position;
+    BoundPoint path[3];
+    uint32_t samples[SENSOR_SAMPLES]; // Larger than a sink chunk and a parallel task.
+    int64_t count;
+} BoundSensor;
+
+static const EXIB_ENC_Binding s_PointBindings[] = {
+    { "x", EXIB_TYPE_FLOAT, offsetof(BoundPoint, x) },
+    { "y", EXIB_TYPE_FLOAT, offsetof(BoundPoint, y) }
+};
+
+static const EXIB_ENC_Binding s_SensorBindings[] = {
+    { "id", EXIB_TYPE_UINT8, offsetof(BoundSensor, id) },
+    { "reading", EXIB_TYPE_DOUBLE, offsetof(BoundSensor, reading) },
+    { "history", EXIB_TYPE_ARRAY, offsetof(BoundSensor, history), EXIB_TYPE_INT16, 5 },
+    { "position", EXIB_TYPE_OBJECT, offsetof(BoundSensor, position), .members = s_PointBindings, .memberCount = 2 },
+    { "path", EXIB_TYPE_ARRAY, offsetof(BoundSensor, path), EXIB_TYPE_OBJECT, 3, sizeof(BoundPoint), s_PointBindings, 2 },
+    { "samples", EXIB_TYPE_ARRAY, offsetof(BoundSensor, samples), EXIB_TYPE_UINT32, SENSOR_SAMPLES },
+    { "count", EXIB_TYPE_INT64, offsetof(BoundSensor, count) }
+};
+
+static const EXIB_ENC_Binding s_StopBindings[] = {
+    { "unused", EXIB_TYPE_UINT32, 0 }
+};
+
+static const EXIB_ENC_Binding s_RouteBindings[] = {
+    { "id", EXIB_TYPE_UINT8, offsetof(BoundSensor, id) },
+    { "stops", EXIB_TYPE_ARRAY, 0, EXIB_TYPE_OBJECT, 0, sizeof(uint32_t), s_StopBindings, 1 }
+};
+
+static const EXIB_ENC_Binding s_LoopBindings[] = {
+    { "loop", EXIB_TYPE_OBJECT, 0, .members = s_LoopBindings, .memberCount = 1 }
+};
+
+static void AddPoint(EXIB_ENC_Context* ctx, EXIB_ENC_Object* parent, const BoundPoint* point)
+{
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, parent, "x", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = point->x });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, parent, "y", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = point->y });
+}
+
+// Add the members of a sensor field by field, like EXIB_ENC_AddStruct does with s_SensorBindings.
+static EXIB_ENC_Object* AddSensorFields(EXIB_ENC_Context* ctx, const char* name, const BoundSensor* sensor)
+{
+    EXIB_ENC_Object* object = EXIB_ENC_AddObject(ctx, NULL, name);
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, object, "id", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = sensor->id });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, object, "reading", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = sensor->reading });
+    EXIB_ENC_ArrayAssign(EXIB_ENC_AddArray(ctx, object, "history", EXIB_TYPE_INT16), sensor->history, 5);
+    AddPoint(ctx, EXIB_ENC_AddObject(ctx, object, "position"), &sensor->position);
+
+    EXIB_ENC_Array* path = EXIB_ENC_AddArray(ctx, object, "path", EXIB_TYPE_OBJECT);
+    for (int i = 0; i < 3; ++i)
+        AddPoint(ctx, EXIB_ENC_ArrayAddObject(ctx, path), &sensor->path[i]);
+
+    EXIB_ENC_ArrayAssign(EXIB_ENC_AddArray(ctx, object, "samples", EXIB_TYPE_UINT32), sensor->samples, SENSOR_SAMPLES);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, object, "count", EXIB_TYPE_INT64), (EXIB_Value){ .int64 = sensor->count });
+    return object;
+}
+
+static void FillSensor(BoundSensor* sensor, int seed)
+{
+    sensor->id = (uint8_t)seed;
+    sensor->reading = seed * 0.5;
+    for (int i = 0; i < 5; ++i)
+        sensor->history[i] = (int16_t)(seed - i * 1000);
+    sensor->position = (BoundPoint){ seed * 1.5f, -seed * 1.5f };
+    for (int i = 0; i < 3; ++i)
+        sensor->path[i] = (BoundPoint){ (float)i, (float)seed };
+    for (int i = 0; i < SENSOR_SAMPLES; ++i)
+        sensor->samples[i] = (uint32_t)(i * seed);
+    sensor->count = -(int64_t)seed << 40;
+}
+
+static int Test_EXIB_ENC_AddStruct(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    EXIB_ENC_Context* treeCtx = EXIB_ENC_CreateContext(NULL);
+    BoundSensor* sensors = malloc(2 * sizeof(BoundSensor));
+    int result = 0;
+
+    FillSensor(&sensors[0], 3);
+    FillSensor(&sensors[1], 7);
+
+    // Members are laid out when the table is compiled, so the struct has to come out right at any alignment.
+    for (int padding = 0; padding < 8 && result == 0; ++padding)
+    {
+        EXIB_ENC_ResetContext(ctx, 0);
+        EXIB_ENC_ResetContext(treeCtx, 0);
+
+        for (int i = 0; i < padding; ++i)
+        {
+            EXIB_ENC_AddField(ctx, NULL, "pad", EXIB_TYPE_UINT8);
+            EXIB_ENC_AddField(treeCtx, NULL, "pad", EXIB_TYPE_UINT8);
+        }
+
+        EXIB_ENC_Object* first = EXIB_ENC_AddStruct(ctx, NULL, "first", s_SensorBindings, 7, &sensors[0]);
+        EXIB_ENC_Object* second = EXIB_ENC_AddStruct(ctx, NULL, "second", s_SensorBindings, 7, &sensors[0]);
+        if (!first || !second)
+        {
+            result = 1;
+            break;
+        }
+
+        // Fields added to a struct come after its members.
+        EXIB_ENC_StructSetData(second, &sensors[1]);
+        EXIB_ENC_AddField(ctx, second, "extra", EXIB_TYPE_UINT16);
+
+        AddSensorFields(treeCtx, "first", &sensors[0]);
+        EXIB_ENC_AddField(treeCtx, AddSensorFields(treeCtx, "second", &sensors[1]), "extra", EXIB_TYPE_UINT16);
+
+        EXIB_Header* expected = EXIB_ENC_Encode(treeCtx);
+        EXIB_Header* header = EXIB_ENC_Encode(ctx);
+        if (!expected || !header || CompareDatum(header, (const uint8_t*)expected, expected->datumSize))
+            result = 1;
+        else if (CheckEncodePaths(ctx))
+            result = 1;
+        else if (!(header = EXIB_ENC_EncodeParallel(ctx, 4)) || CompareDatum(header, (const uint8_t*)expected, expected->datumSize))
+            result = 1;
+    }
+
+    // Names only reachable through an array without elements aren't written, like with an empty array.
+    EXIB_ENC_ResetContext(ctx, 0);
+    EXIB_ENC_ResetContext(treeCtx, 0);
+    if (!EXIB_ENC_AddStruct(ctx, NULL, "route", s_RouteBindings, 2, &sensors[0]))
+        result = 1;
+
+    EXIB_ENC_Object* route = EXIB_ENC_AddObject(treeCtx, NULL, "route");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(treeCtx, route, "id", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = sensors[0].id });
+    EXIB_ENC_AddArray(treeCtx, route, "stops", EXIB_TYPE_OBJECT);
+
+    EXIB_Header* expected = EXIB_ENC_Encode(treeCtx);
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (result == 0 && (!expected || !header || CompareDatum(header, (const uint8_t*)expected, expected->datumSize)))
+        result = 1;
+
+    // Tables that don't describe a struct are rejected.
+    EXIB_ENC_Binding invalid = { "invalid", EXIB_TYPE_NULL, 0 };
+    if (EXIB_ENC_AddStruct(ctx, NULL, NULL, &invalid, 1, sensors) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidBinding)
+        result = 1;
+    if (EXIB_ENC_AddStruct(ctx, NULL, NULL, s_LoopBindings, 1, sensors) != NULL
+        || EXIB_ENC_GetLastError(ctx) != EXIB_ENC_ERR_InvalidBinding)
+        result = 1;
+
+    free(sensors);
+    EXIB_ENC_FreeContext(treeCtx);
+    return result;
+}
+
+// Decode an array with EXIB_DEC_ArrayDecodeInto and compare it with the elements it was encoded from.
+static int CheckPackedArray(EXIB_DEC_Context* dec, const char* name, int packed, const void* elements, size_t count, size_t elementSize)
+{
+    EXIB_DEC_Field field = EXIB_DEC_FindField(dec, NULL, name);
+    EXIB_DEC_Array array;
+    uint8_t* out = malloc(count * elementSize + 1);
+    int result = 0;
+
+    if (field == EXIB_DEC_INVALID_FIELD
+        || !EXIB_DEC_ArrayFromField(dec, field, &array)
+        || EXIB_DEC_ArrayIsPacked(&array) != packed
+        || (size_t)EXIB_DEC_ArrayGetLength(&array) != count
+        || EXIB_DEC_ArrayDecodeInto(dec, &array, out, count) != EXIB_DEC_ERR_Success
+        || memcmp(out, elements, count * elementSize) != 0)
+        result = 1;
+
+    // Packed elements can't be pointed to, and the output buffer has to hold all of them.
+    if (result == 0 && packed
+        && (EXIB_DEC_ArrayBegin(dec, &array, NULL) != NULL
+            || EXIB_DEC_GetLastError(dec) != EXIB_DEC_ERR_PackedArray
+            || EXIB_DEC_ArrayDecodeInto(dec, &array, out, count - 1) != EXIB_DEC_ERR_BufferTooSmall))
+        result = 1;
+
+    free(out);
+    return result;
+}
+
+static int Test_EXIB_ENC_ArraySetPacking(void* parameter)
+{
+    EXIB_ENC_Context* ctx = parameter;
+    const size_t count = 200000;
+    MemorySink pipe = { 0 };
+    MemorySink gathered = { 0 };
+    struct iovec iov[64];
+    int segments = 64;
+    int result = 0;
+
+    // Timestamps, counters and states, which pack well, and noise, which doesn't.
+    EXIB_ENC_Array* timestamps = EXIB_ENC_AddArray(ctx, NULL, "timestamps", EXIB_TYPE_INT64);
+    EXIB_ENC_Array* counters = EXIB_ENC_AddArray(ctx, NULL, "counters", EXIB_TYPE_UINT32);
+    EXIB_ENC_Array* states = EXIB_ENC_AddArray(ctx, NULL, "states", EXIB_TYPE_UINT8);
+    EXIB_ENC_Array* noise = EXIB_ENC_AddArray(ctx, NULL, "noise", EXIB_TYPE_UINT16);
+    EXIB_ENC_Array* samples = EXIB_ENC_AddArray(ctx, NULL, "samples", EXIB_TYPE_DOUBLE);
+    EXIB_ENC_ArrayResize(timestamps, count);
+    EXIB_ENC_ArrayResize(counters, count);
+    EXIB_ENC_ArrayResize(states, count);
+    EXIB_ENC_ArrayResize(noise, count);
+    EXIB_ENC_ArrayResize(samples, count);
+
+    int64_t* t = EXIB_ENC_ArrayGetData(timestamps);
+    uint32_t* c = EXIB_ENC_ArrayGetData(counters);
+    uint8_t* st = EXIB_ENC_ArrayGetData(states);
+    uint16_t* n = EXIB_ENC_ArrayGetData(noise);
+    double* d = EXIB_ENC_ArrayGetData(samples);
+    for (size_t i = 0; i < count; ++i)
+    {
+        t[i] = 1700000000000000000ll + (int64_t)i * 1000000 + rand() % 16;
+        c[i] = (uint32_t)(i * 3 + (i % 7 == 0 ? rand() % 1000 : 0));
+        st[i] = (uint8_t)(i / 5000);
+        n[i] = (uint16_t)rand();
+        d[i] = i * 0.25;
+    }
+
+    if (EXIB_ENC_ArraySetPacking(timestamps, EXIB_PACKING_BITS, 1)
+        || EXIB_ENC_ArraySetPacking(counters, EXIB_PACKING_VARINT, 1)
+        || EXIB_ENC_ArraySetPacking(states, EXIB_PACKING_RLE, 0)
+        || EXIB_ENC_ArraySetPacking(noise, EXIB_PACKING_BITS, 0)
+        || EXIB_ENC_ArraySetPacking(samples, EXIB_PACKING_BITS, 0) == 0)
+        return 1;
+
+    // Noise and samples stay as they are, and the rest takes less than 3 bytes per element.
+    EXIB_Header* header = EXIB_ENC_Encode(ctx);
+    if (!header || header->datumSize > count * (2 + 8 + 3) || EXIB_CheckHeader(header, header->datumSize))
+        return 1;
+
+    uint8_t* expected = malloc(header->datumSize);
+    size_t size = header->datumSize;
+    memcpy(expected, header, size);
+
+    EXIB_DEC_Context* dec = EXIB_DEC_CreateBufferedContext(expected, size, NULL);
+    if (EXIB_DEC_GetLastError(dec) != EXIB_DEC_ERR_Success
+        || CheckPackedArray(dec, "timestamps", 1, t, count, 8)
+        || CheckPackedArray(dec, "counters", 1, c, count, 4)
+        || CheckPackedArray(dec, "states", 1, st, count, 1)
+        || CheckPackedArray(dec, "noise", 0, n, count, 2)
+        || CheckPackedArray(dec, "samples", 0, d, count, 8))
+        result = 1;
+    EXIB_DEC_FreeContext(dec);
+
+    // Every way of encoding writes the same packed datum.
+    if (result == 0
+        && (EXIB_ENC_EncodeToSink(ctx, MemorySinkWrite, NULL, &pipe)
+            || CompareDatum((EXIB_Header*)expected, pipe.data, pipe.size)))
+        result = 1;
+
+    if (result == 0 && EXIB_ENC_EncodeIOV(ctx, iov, &segments) == 0)
+    {
+        for (int i = 0; i < segments; ++i)
+            MemorySinkWrite(&gathered, iov[i].iov_base, iov[i].iov_len);
+        result = CompareDatum((EXIB_Header*)expected, gathered.data, gathered.size);
+    }
+    else
+        result = 1;
+
+    header = EXIB_ENC_EncodeParallel(ctx, 4);
+    if (result == 0 && (!header || CompareDatum(header, expected, size)))
+        result = 1;
+
+    // Elements are packed again each time, and stored as they are once packing doesn't pay off.
+    for (size_t i = 0; i < count; ++i)
+        t[i] = (int64_t)(((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ (uint64_t)rand());
+    header = EXIB_ENC_Encode(ctx);
+    dec = header ? EXIB_DEC_CreateBufferedContext(header, header->datumSize, NULL) : NULL;
+    if (result == 0 && (!dec || CheckPackedArray(dec, "timestamps", 0, t, count, 8)))
+        result = 1;
+    if (dec)
+        EXIB_DEC_FreeContext(dec);
+
+    free(expected);
+    free(pipe.data);
+    free(gathered.data);
+    return result;
+}
+
+void AddEncoderTests()
+{
+    AddTest("EXIB_ENC_CreateContext", Test_EXIB_ENC_CreateContext, NULL, NULL);
+    AddTest("EXIB_ENC_Encode_EmptyRoot", Test_EXIB_ENC_Encode_EmptyRoot,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_Numbers", Test_EXIB_ENC_Encode_Numbers,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_NumbersAndObjects", Test_EXIB_ENC_Encode_NumbersAndObjects,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_Array", Test_EXIB_ENC_Encode_Array,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_ArrayOfArrays", Test_EXIB_ENC_Encode_ArrayOfArrays,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_MeasureSize", Test_EXIB_ENC_MeasureSize,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_EncodeInto", Test_EXIB_ENC_EncodeInto,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_InvalidElement", Test_EXIB_ENC_InvalidElement,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_LargeArray", Test_EXIB_ENC_Encode_LargeArray,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_ArrayAppend", Test_EXIB_ENC_ArrayAppend,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_ArraySetExternal", Test_EXIB_ENC_ArraySetExternal,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_NestedLarge", Test_EXIB_ENC_Encode_NestedLarge,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Encode_ManyNames", Test_EXIB_ENC_Encode_ManyNames,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_InternName", Test_EXIB_ENC_InternName,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_ResetContext", Test_EXIB_ENC_ResetContext,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_EncodeToSink", Test_EXIB_ENC_EncodeToSink,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_EncodeIOV", Test_EXIB_ENC_EncodeIOV,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_NoChecksum", Test_EXIB_ENC_NoChecksum, NULL, NULL);
+    AddTest("EXIB_ENC_EncodeParallel", Test_EXIB_ENC_EncodeParallel, NULL, NULL);
+    AddTest("EXIB_ENC_AddBlob", Test_EXIB_ENC_AddBlob,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Dictionary", Test_EXIB_ENC_Dictionary, NULL, NULL);
+    AddTest("EXIB_ENC_EncodeToFD", Test_EXIB_ENC_EncodeToFD,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Stream_Numbers", Test_EXIB_ENC_Stream_Numbers,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_Stream_Large", Test_EXIB_ENC_Stream_Large,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_AddStruct", Test_EXIB_ENC_AddStruct,
+            SetupGenericEncoderContext,
+            CleanupGenericEncoderContext);
+    AddTest("EXIB_ENC_ArraySetPacking", Test_EXIB_ENC_ArraySetPacking,
             SetupGenericEncoderContext,
             CleanupGenericEncoderContext);
 }
\ No newline at end of file
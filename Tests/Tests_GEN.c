@@ -0,0 +1,115 @@
+#include "Test.h"
+#include "Telemetry.h" // Generated by exgen from Telemetry.exit.
+
+static const Telemetry s_Telemetry = {
+    .id = 7,
+    .flags = 1,
+    .time = 1.5,
+    .samples = { 1, -2, 3, -4, 5 },
+    .battery = { .voltage = 3.7f, .charge = 90 },
+    .error_count = 3
+};
+
+// Add the fields of Telemetry.exit to an encoder, in declaration order or with the objects first.
+static void AddTelemetry(EXIB_ENC_Context* ctx, const Telemetry* telemetry, int reorder)
+{
+    EXIB_ENC_Object* battery = reorder ? EXIB_ENC_AddObject(ctx, NULL, "battery") : NULL;
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = telemetry->id });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "flags", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = telemetry->flags });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "time", EXIB_TYPE_DOUBLE), (EXIB_Value){ .float64 = telemetry->time });
+    EXIB_ENC_ArrayAssign(EXIB_ENC_AddArray(ctx, NULL, "samples", EXIB_TYPE_INT16), telemetry->samples, 5);
+
+    if (!reorder)
+        battery = EXIB_ENC_AddObject(ctx, NULL, "battery");
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, battery, "voltage", EXIB_TYPE_FLOAT), (EXIB_Value){ .float32 = telemetry->battery.voltage });
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, battery, "charge", EXIB_TYPE_UINT8), (EXIB_Value){ .uint8 = telemetry->battery.charge });
+
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "error-count", EXIB_TYPE_UINT16), (EXIB_Value){ .uint16 = telemetry->error_count });
+}
+
+static EXIB_ENC_Context* CreateTelemetryEncoder()
+{
+    EXIB_ENC_Options options;
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.datumName = "telemetry";
+    return EXIB_ENC_CreateContext(&options);
+}
+
+static int Test_EXGEN_Encode()
+{
+    uint8_t buffer[Telemetry_DATUM_SIZE];
+    EXIB_ENC_Context* ctx = CreateTelemetryEncoder();
+    int result = 0;
+
+    // The generated encoder produces exactly what the encoder would.
+    AddTelemetry(ctx, &s_Telemetry, 0);
+    if (Telemetry_Encode(&s_Telemetry, buffer, sizeof(buffer)) != Telemetry_DATUM_SIZE
+        || CompareDatum(EXIB_ENC_Encode(ctx), buffer, sizeof(buffer))
+        || EXIB_CheckHeader((EXIB_Header*)buffer, sizeof(buffer)))
+        result = 1;
+
+    if (Telemetry_Encode(&s_Telemetry, buffer, sizeof(buffer) - 1) != 0)
+        result = 1;
+
+    EXIB_ENC_FreeContext(ctx);
+    return result;
+}
+
+static int Test_EXGEN_Decode()
+{
+    uint64_t buffer[(Telemetry_DATUM_SIZE + 64) / 8];
+    EXIB_ENC_Context* ctx = CreateTelemetryEncoder();
+    EXIB_Header* header;
+    Telemetry decoded;
+    int result = 0;
+
+    // Datums with the generated layout are read at fixed offsets.
+    memset(&decoded, 0, sizeof(decoded));
+    Telemetry_Encode(&s_Telemetry, buffer, sizeof(buffer));
+    if (Telemetry_Decode(buffer, Telemetry_DATUM_SIZE, &decoded) || memcmp(&decoded, &s_Telemetry, sizeof(decoded)) != 0)
+        result |= 1;
+
+    // A bad checksum is rejected like by the decoder, and so is a datum that doesn't fit.
+    ((uint8_t*)buffer)[Telemetry_DATUM_SIZE - 1] ^= 1;
+    if (Telemetry_Decode(buffer, Telemetry_DATUM_SIZE, &decoded) == 0)
+        result |= 2;
+    if (Telemetry_Decode(buffer, Telemetry_DATUM_SIZE - 1, &decoded) == 0)
+        result |= 4;
+
+    // Datums with the same fields in another order take the slow path.
+    memset(&decoded, 0, sizeof(decoded));
+    AddTelemetry(ctx, &s_Telemetry, 1);
+    header = EXIB_ENC_Encode(ctx);
+    if (Telemetry_Decode(header, header->datumSize, &decoded) || memcmp(&decoded, &s_Telemetry, sizeof(decoded)) != 0)
+        result |= 8;
+
+    // So do datums with more fields, which are ignored.
+    EXIB_ENC_AddField(ctx, NULL, "extra", EXIB_TYPE_INT8);
+    header = EXIB_ENC_Encode(ctx);
+    if (Telemetry_Decode(header, header->datumSize, &decoded))
+        result |= 16;
+
+    // Missing fields, or fields of the wrong type, don't match the schema.
+    EXIB_ENC_ResetContext(ctx, 0);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT32), (EXIB_Value){ .uint32 = 7 });
+    header = EXIB_ENC_Encode(ctx);
+    if (Telemetry_Decode(header, header->datumSize, &decoded) == 0)
+        result |= 32;
+
+    EXIB_ENC_ResetContext(ctx, 0);
+    EXIB_ENC_SetValue(EXIB_ENC_AddField(ctx, NULL, "id", EXIB_TYPE_UINT64), (EXIB_Value){ .uint64 = 7 });
+    header = EXIB_ENC_Encode(ctx);
+    if (Telemetry_Decode(header, header->datumSize, &decoded) == 0)
+        result |= 64;
+
+    EXIB_ENC_FreeContext(ctx);
+    return result;
+}
+
+void AddGeneratorTests()
+{
+    AddTest("EXGEN_Encode", Test_EXGEN_Encode, NULL, NULL);
+    AddTest("EXGEN_Decode", Test_EXGEN_Decode, NULL, NULL);
+}
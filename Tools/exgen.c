@@ -0,0 +1,886 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <EXIB/Encoder.h>
+#include <EXIB/Decoder.h>
+
+/*
+ * exgen turns an EXIT schema into C code that encodes and decodes one fixed-shape datum.
+ *
+ * The datum is laid out once, here, by the real encoder. Every field has the same size
+ * and offset in each datum of the schema, so all the generated encoder has to do is copy
+ * the structural bytes (header, prefixes, names, padding and string table) from a template,
+ * copy the values to their offsets, and checksum the datum. The generated decoder compares
+ * the structural bytes to the template and copies the values out of their offsets.
+ * Datums with a different layout, for instance from an encoder that added the fields in
+ * another order, are decoded with EXIB_DEC_FindField instead.
+ *
+ * Usage: exgen <schema.exit> <output>
+ * Writes <output>.h and <output>.c. The struct and functions are named after the file name of <output>.
+ */
+
+#define EXGEN_MAX_NAME 255
+
+static const char* s_TypeNames[16] = {
+    NULL, "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64", "f32", "f64", NULL, NULL, NULL, NULL, NULL
+};
+
+static const char* s_CTypes[16] = {
+    NULL, "int8_t", "uint8_t", "int16_t", "uint16_t", "int32_t", "uint32_t", "int64_t", "uint64_t", "float", "double", NULL, NULL, NULL, NULL, NULL
+};
+
+static const char* s_TypeEnums[16] = {
+    NULL, "EXIB_TYPE_INT8", "EXIB_TYPE_UINT8", "EXIB_TYPE_INT16", "EXIB_TYPE_UINT16", "EXIB_TYPE_INT32", "EXIB_TYPE_UINT32",
+    "EXIB_TYPE_INT64", "EXIB_TYPE_UINT64", "EXIB_TYPE_FLOAT", "EXIB_TYPE_DOUBLE", NULL, NULL, NULL, NULL, NULL
+};
+
+// Field of the schema.
+typedef struct _EXGEN_Node
+{
+    char name[EXGEN_MAX_NAME + 1];  // Name of the field in the datum.
+    char ident[EXGEN_MAX_NAME + 2]; // Name of the struct member, with room for a leading or trailing underscore.
+    EXIB_Type type;        // EXIB_TYPE_OBJECT, EXIB_TYPE_ARRAY or the type of a value.
+    EXIB_Type elementType; // Type of the elements of an array.
+    size_t length;         // Number of elements of an array.
+    size_t offset;         // Datum offset of the value, or of the first element of an array.
+    struct _EXGEN_Node* children;
+    struct _EXGEN_Node* next;
+} EXGEN_Node;
+
+typedef struct _EXGEN_Parser
+{
+    const char* path;
+    const char* text;
+    const char* pos;
+    int line;
+    char datumName[EXGEN_MAX_NAME + 1]; // From the %name directive, empty if the root is unnamed.
+} EXGEN_Parser;
+
+static void EXGEN_Fail(EXGEN_Parser* parser, const char* message)
+{
+    fprintf(stderr, "%s:%d: error: %s\n", parser->path, parser->line, message);
+    exit(EXIT_FAILURE);
+}
+
+// Join three strings into a new one, which the caller frees.
+static char* EXGEN_Concat(const char* a, const char* b, const char* c)
+{
+    size_t size = strlen(a) + strlen(b) + strlen(c) + 1;
+    char* result = malloc(size);
+
+    if (!result)
+    {
+        fprintf(stderr, "error: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(result, size, "%s%s%s", a, b, c);
+    return result;
+}
+
+static void EXGEN_SkipSpace(EXGEN_Parser* parser)
+{
+    for (;;)
+    {
+        if (*parser->pos == '\n')
+            ++parser->line;
+
+        if (isspace((unsigned char)*parser->pos))
+            ++parser->pos;
+        else if (parser->pos[0] == '/' && parser->pos[1] == '/')
+        {
+            while (*parser->pos && *parser->pos != '\n')
+                ++parser->pos;
+        }
+        else
+            return;
+    }
+}
+
+static int EXGEN_Accept(EXGEN_Parser* parser, char c)
+{
+    EXGEN_SkipSpace(parser);
+    if (*parser->pos != c)
+        return 0;
+
+    ++parser->pos;
+    return 1;
+}
+
+static void EXGEN_Expect(EXGEN_Parser* parser, char c)
+{
+    char message[32];
+
+    if (!EXGEN_Accept(parser, c))
+    {
+        snprintf(message, sizeof(message), "expected '%c'", c);
+        EXGEN_Fail(parser, message);
+    }
+}
+
+static void EXGEN_ParseString(EXGEN_Parser* parser, char* out)
+{
+    size_t length = 0;
+
+    EXGEN_Expect(parser, '"');
+    while (*parser->pos != '"')
+    {
+        if (*parser->pos == 0 || *parser->pos == '\n')
+            EXGEN_Fail(parser, "unterminated string");
+        if (*parser->pos == '\\')
+            EXGEN_Fail(parser, "escape sequences aren't supported in names");
+        if (length == EXGEN_MAX_NAME)
+            EXGEN_Fail(parser, "names can't be longer than 255 characters");
+
+        out[length++] = *parser->pos++;
+    }
+
+    out[length] = 0;
+    ++parser->pos;
+}
+
+// Skip a number, and return 1 if it has a fraction or exponent.
+static int EXGEN_SkipNumber(EXGEN_Parser* parser)
+{
+    const char* start;
+    char* end;
+    int isReal = 0;
+
+    EXGEN_SkipSpace(parser);
+    start = parser->pos;
+    strtod(start, &end);
+    if (end == start)
+        EXGEN_Fail(parser, "expected a number");
+
+    for (const char* c = start; c != end; ++c)
+    {
+        if (*c == '.' || *c == 'e' || *c == 'E')
+            isReal = 1;
+    }
+
+    parser->pos = end;
+    return isReal;
+}
+
+static EXIB_Type EXGEN_ParseTypeName(EXGEN_Parser* parser, const char* typeName)
+{
+    for (int type = 0; type < 16; ++type)
+    {
+        if (s_TypeNames[type] && strcmp(s_TypeNames[type], typeName) == 0)
+            return type;
+    }
+
+    EXGEN_Fail(parser, "unknown type");
+    return EXIB_TYPE_NULL;
+}
+
+// Keywords of C and C++, which can't name a struct member or a type.
+static const char* s_Keywords[] = {
+    "_Alignas", "_Alignof", "_Atomic", "_BitInt", "_Bool", "_Complex", "_Decimal128", "_Decimal32", "_Decimal64",
+    "_Generic", "_Imaginary", "_Noreturn", "_Pragma", "_Static_assert", "_Thread_local",
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+    "char", "char16_t", "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield", "compl", "concept",
+    "const", "const_cast", "consteval", "constexpr", "constinit", "continue", "decltype", "default", "delete",
+    "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false", "float", "for",
+    "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+    "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast",
+    "requires", "restrict", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast",
+    "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+    "typename", "typeof", "typeof_unqual", "union", "unsigned", "using", "virtual", "void", "volatile",
+    "wchar_t", "while", "xor", "xor_eq"
+};
+
+// Turn a field name into a struct member name.
+static void EXGEN_MakeIdentifier(const char* name, char* out)
+{
+    size_t length = 0;
+
+    if (!isalpha((unsigned char)name[0]) && name[0] != '_')
+        out[length++] = '_';
+
+    for (const char* c = name; *c; ++c)
+        out[length++] = isalnum((unsigned char)*c) ? *c : '_';
+
+    out[length] = 0;
+
+    // Keywords start with a letter or an underscore, so they never got the leading underscore.
+    for (size_t i = 0; i < sizeof(s_Keywords) / sizeof(s_Keywords[0]); ++i)
+    {
+        if (strcmp(out, s_Keywords[i]) == 0)
+        {
+            out[length++] = '_';
+            out[length] = 0;
+            break;
+        }
+    }
+}
+
+static EXGEN_Node* EXGEN_ParseObject(EXGEN_Parser* parser);
+
+/**
+ * Parse a field, whose value only serves as an example. Objects are parsed as
+ * nested structs, and arrays have as many elements as the example has.
+ * @param parser Parser, positioned at the name of the field.
+ * @return Field.
+ */
+static EXGEN_Node* EXGEN_ParseField(EXGEN_Parser* parser)
+{
+    EXGEN_Node* node = calloc(1, sizeof(EXGEN_Node));
+    char key[EXGEN_MAX_NAME + 1];
+    char* typeName;
+
+    EXGEN_ParseString(parser, key);
+    EXGEN_Expect(parser, ':');
+
+    // The type follows the last colon, so names can't have one.
+    typeName = strrchr(key, ':');
+    if (typeName)
+        *typeName++ = 0;
+
+    if (key[0] == 0)
+        EXGEN_Fail(parser, "fields of a schema must be named");
+
+    strcpy(node->name, key);
+    EXGEN_MakeIdentifier(node->name, node->ident);
+
+    EXGEN_SkipSpace(parser);
+    if (*parser->pos == '{')
+    {
+        if (typeName)
+            EXGEN_Fail(parser, "objects can't have a type");
+
+        EXGEN_Node* object = EXGEN_ParseObject(parser);
+        node->type = EXIB_TYPE_OBJECT;
+        node->children = object->children;
+        free(object);
+    }
+    else if (*parser->pos == '[')
+    {
+        size_t length = strlen(typeName ? typeName : "");
+
+        if (length < 3 || typeName[0] != '[' || typeName[length - 1] != ']')
+            EXGEN_Fail(parser, "arrays need an element type, like \"name:[u8]\"");
+
+        typeName[length - 1] = 0;
+        node->type = EXIB_TYPE_ARRAY;
+        node->elementType = EXGEN_ParseTypeName(parser, typeName + 1);
+
+        EXGEN_Expect(parser, '[');
+        if (!EXGEN_Accept(parser, ']'))
+        {
+            do
+            {
+                EXGEN_SkipNumber(parser);
+                ++node->length;
+            } while (EXGEN_Accept(parser, ','));
+
+            EXGEN_Expect(parser, ']');
+        }
+
+        if (node->length == 0)
+            EXGEN_Fail(parser, "arrays must have at least one element, which fixes their length");
+    }
+    else
+    {
+        int isReal = EXGEN_SkipNumber(parser);
+
+        // Untyped numbers get the widest type, like in EXIT.
+        if (typeName)
+            node->type = EXGEN_ParseTypeName(parser, typeName);
+        else
+            node->type = isReal ? EXIB_TYPE_DOUBLE : EXIB_TYPE_INT64;
+    }
+
+    return node;
+}
+
+static EXGEN_Node* EXGEN_ParseObject(EXGEN_Parser* parser)
+{
+    EXGEN_Node* object = calloc(1, sizeof(EXGEN_Node));
+    EXGEN_Node** tail = &object->children;
+
+    object->type = EXIB_TYPE_OBJECT;
+    EXGEN_Expect(parser, '{');
+
+    while (!EXGEN_Accept(parser, '}'))
+    {
+        EXGEN_Node* field = EXGEN_ParseField(parser);
+
+        for (EXGEN_Node* sibling = object->children; sibling != NULL; sibling = sibling->next)
+        {
+            if (strcmp(sibling->ident, field->ident) == 0)
+                EXGEN_Fail(parser, "fields of an object must have distinct names");
+        }
+
+        *tail = field;
+        tail = &field->next;
+
+        // Commas between fields are optional, as in the example in EXIT.md.
+        EXGEN_Accept(parser, ',');
+    }
+
+    return object;
+}
+
+static EXGEN_Node* EXGEN_ParseSchema(EXGEN_Parser* parser)
+{
+    EXGEN_Node* root;
+
+    EXGEN_SkipSpace(parser);
+    if (EXGEN_Accept(parser, '%'))
+    {
+        if (strncmp(parser->pos, "name", 4) != 0)
+            EXGEN_Fail(parser, "unknown directive");
+
+        parser->pos += 4;
+        EXGEN_Expect(parser, '(');
+        EXGEN_SkipSpace(parser);
+        EXGEN_ParseString(parser, parser->datumName);
+        EXGEN_Expect(parser, ')');
+    }
+
+    root = EXGEN_ParseObject(parser);
+
+    EXGEN_SkipSpace(parser);
+    if (*parser->pos != 0)
+        EXGEN_Fail(parser, "unexpected text after the root object");
+
+    return root;
+}
+
+static void EXGEN_AddToEncoder(EXIB_ENC_Context* enc, EXIB_ENC_Object* parent, EXGEN_Node* node)
+{
+    static const uint64_t zeros[64];
+
+    for (EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+            EXGEN_AddToEncoder(enc, EXIB_ENC_AddObject(enc, parent, child->name), child);
+        else if (child->type == EXIB_TYPE_ARRAY)
+        {
+            EXIB_ENC_Array* array = EXIB_ENC_AddArray(enc, parent, child->name, child->elementType);
+
+            for (size_t i = 0; i < child->length; i += 64)
+                EXIB_ENC_ArrayAppendN(array, zeros, (child->length - i < 64) ? child->length - i : 64);
+        }
+        else
+            EXIB_ENC_AddField(enc, parent, child->name, child->type);
+    }
+}
+
+// Find the datum offsets of the values, by decoding the laid out datum.
+static void EXGEN_LocateValues(EXIB_DEC_Context* dec, EXIB_DEC_Object* object, EXGEN_Node* node, const uint8_t* datum)
+{
+    EXIB_DEC_Field field = EXIB_DEC_INVALID_FIELD;
+
+    for (EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        field = EXIB_DEC_NextField(dec, object, field);
+
+        if (child->type == EXIB_TYPE_OBJECT)
+        {
+            EXIB_DEC_Object childObject;
+            EXIB_DEC_ObjectFromField(dec, field, &childObject);
+            EXGEN_LocateValues(dec, &childObject, child, datum);
+        }
+        else if (child->type == EXIB_TYPE_ARRAY)
+        {
+            EXIB_DEC_Array array;
+            EXIB_DEC_ArrayFromField(dec, field, &array);
+            child->offset = (const uint8_t*)EXIB_DEC_ArrayBegin(dec, &array, NULL) - datum;
+        }
+        else
+        {
+            EXIB_DEC_FieldValue value;
+            EXIB_DEC_FieldGet(dec, field, &value);
+            child->offset = (const uint8_t*)value.value - datum;
+        }
+    }
+}
+
+/**
+ * Lay out the datum of a schema.
+ * @param root Root object of the schema. Receives the offsets of the values.
+ * @param datumName Name of the root object, or NULL.
+ * @param sizeOut Receives the size of the datum.
+ * @return Datum, with every value set to 0 and without a checksum.
+ */
+static uint8_t* EXGEN_Layout(EXGEN_Node* root, const char* datumName, size_t* sizeOut)
+{
+    EXIB_ENC_Options options;
+    EXIB_ENC_Context* enc;
+    EXIB_DEC_Context* dec;
+    EXIB_Header* header;
+    uint8_t* datum;
+
+    EXIB_ENC_GetDefaultOptions(&options);
+    options.datumName = datumName;
+    enc = EXIB_ENC_CreateContext(&options);
+
+    EXGEN_AddToEncoder(enc, NULL, root);
+    header = EXIB_ENC_Encode(enc);
+    if (!header)
+    {
+        fprintf(stderr, "error: the schema can't be encoded (encoder error %d)\n", EXIB_ENC_GetLastError(enc));
+        exit(EXIT_FAILURE);
+    }
+
+    *sizeOut = header->datumSize;
+    datum = malloc(header->datumSize);
+    memcpy(datum, header, header->datumSize);
+    EXIB_ENC_FreeContext(enc);
+
+    dec = EXIB_DEC_CreateBufferedContext(datum, *sizeOut, NULL);
+    if (EXIB_DEC_GetLastError(dec) != EXIB_DEC_ERR_Success)
+    {
+        fprintf(stderr, "error: the datum of the schema doesn't decode: %s\n", EXIB_DEC_GetLastErrorName(dec));
+        exit(EXIT_FAILURE);
+    }
+
+    EXGEN_LocateValues(dec, EXIB_DEC_GetRootObject(dec), root, datum);
+    EXIB_DEC_FreeContext(dec);
+
+    // The template is checksummed with the values it gets.
+    ((EXIB_Header*)datum)->checksum = 0;
+    return datum;
+}
+
+static size_t EXGEN_ValueSize(const EXGEN_Node* node)
+{
+    if (node->type == EXIB_TYPE_ARRAY)
+        return node->length * EXIB_GetTypeSize(node->elementType);
+    return EXIB_GetTypeSize(node->type);
+}
+
+static void EXGEN_EmitStructs(FILE* out, const char* typeName, const EXGEN_Node* node)
+{
+    // Nested structs are declared first, named after the path to them.
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+        {
+            char* childType = EXGEN_Concat(typeName, "_", child->ident);
+            EXGEN_EmitStructs(out, childType, child);
+            free(childType);
+        }
+    }
+
+    fprintf(out, "typedef struct _%s\n{\n", typeName);
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+            fprintf(out, "    %s_%s %s;\n", typeName, child->ident, child->ident);
+        else if (child->type == EXIB_TYPE_ARRAY)
+            fprintf(out, "    %s %s[%zu];\n", s_CTypes[child->elementType], child->ident, child->length);
+        else
+            fprintf(out, "    %s %s;\n", s_CTypes[child->type], child->ident);
+    }
+
+    // C doesn't allow empty structs.
+    if (!node->children)
+        fprintf(out, "    uint8_t unused;\n");
+
+    fprintf(out, "} %s;\n\n", typeName);
+}
+
+static void EXGEN_EmitHeader(FILE* out, const char* typeName, const char* guard, const EXGEN_Node* root, size_t datumSize)
+{
+    fprintf(out, "// Generated by exgen, do not edit.\n");
+    fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    fprintf(out, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+
+    EXGEN_EmitStructs(out, typeName, root);
+
+    fprintf(out, "/** Size of every datum encoded by %s_Encode. */\n", typeName);
+    fprintf(out, "#define %s_DATUM_SIZE %zu\n\n", typeName, datumSize);
+
+    fprintf(out, "    /**\n");
+    fprintf(out, "     * Encode a datum, the same one that EXIB_ENC_Encode would produce.\n");
+    fprintf(out, "     * @param in Values to encode.\n");
+    fprintf(out, "     * @param buffer Buffer that will receive the datum.\n");
+    fprintf(out, "     * @param capacity Size of buffer in bytes.\n");
+    fprintf(out, "     * @return Size of the datum, or 0 if the buffer is too small.\n");
+    fprintf(out, "     */\n");
+    fprintf(out, "    size_t %s_Encode(const %s* in, void* buffer, size_t capacity);\n\n", typeName, typeName);
+
+    fprintf(out, "    /**\n");
+    fprintf(out, "     * Decode a datum. Datums laid out like the ones %s_Encode produces are read\n", typeName);
+    fprintf(out, "     * at fixed offsets, others are searched for fields with the right names and types.\n");
+    fprintf(out, "     * @param datum Datum to decode.\n");
+    fprintf(out, "     * @param size Size of the buffer containing the datum.\n");
+    fprintf(out, "     * @param out Receives the values.\n");
+    fprintf(out, "     * @return 0 on success, 1 if the datum is invalid or doesn't match the schema.\n");
+    fprintf(out, "     */\n");
+    fprintf(out, "    int %s_Decode(const void* datum, size_t size, %s* out);\n\n", typeName, typeName);
+
+    fprintf(out, "#ifdef __cplusplus\n}\n#endif\n\n#endif\n");
+}
+
+static void EXGEN_EmitValueCopies(FILE* out, const EXGEN_Node* node, const char* path, int encode)
+{
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+        {
+            char* childPath = EXGEN_Concat(path, child->ident, ".");
+            EXGEN_EmitValueCopies(out, child, childPath, encode);
+            free(childPath);
+        }
+        else if (encode)
+            fprintf(out, "    memcpy(&out[%zu], %s%s%s, %zu);\n", child->offset, child->type == EXIB_TYPE_ARRAY ? "" : "&", path, child->ident, EXGEN_ValueSize(child));
+        else
+            fprintf(out, "    memcpy(%s%s%s, &in[%zu], %zu);\n", child->type == EXIB_TYPE_ARRAY ? "" : "&", path, child->ident, child->offset, EXGEN_ValueSize(child));
+    }
+}
+
+typedef struct _EXGEN_Range
+{
+    size_t offset;
+    size_t size;
+} EXGEN_Range;
+
+static void EXGEN_CollectValues(const EXGEN_Node* node, EXGEN_Range* ranges, size_t* count)
+{
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+            EXGEN_CollectValues(child, ranges, count);
+        else
+        {
+            ranges[*count].offset = child->offset;
+            ranges[(*count)++].size = EXGEN_ValueSize(child);
+        }
+    }
+}
+
+static size_t EXGEN_CountValues(const EXGEN_Node* node)
+{
+    size_t count = 0;
+
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+        count += (child->type == EXIB_TYPE_OBJECT) ? EXGEN_CountValues(child) : 1;
+
+    return count;
+}
+
+// Emit a comparison of every byte that isn't a value or the checksum with the template.
+static void EXGEN_EmitStructureCheck(FILE* out, const char* typeName, const EXGEN_Node* root)
+{
+    size_t count = 0;
+    size_t start = 0;
+    EXGEN_Range* ranges = malloc((EXGEN_CountValues(root) + 1) * sizeof(EXGEN_Range));
+
+    ranges[count].offset = offsetof(EXIB_Header, checksum);
+    ranges[count++].size = sizeof(uint32_t);
+    EXGEN_CollectValues(root, ranges, &count);
+
+    // Values are laid out in the order the fields are declared in.
+    fprintf(out, "    if (size < %s_DATUM_SIZE", typeName);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (ranges[i].offset > start)
+            fprintf(out, "\n        || memcmp(&in[%zu], &s_%s_Template[%zu], %zu) != 0", start, typeName, start, ranges[i].offset - start);
+        start = ranges[i].offset + ranges[i].size;
+    }
+    fprintf(out, "\n        || memcmp(&in[%zu], &s_%s_Template[%zu], %s_DATUM_SIZE - %zu) != 0)\n", start, typeName, start, typeName, start);
+
+    free(ranges);
+}
+
+/**
+ * Emit the lookups of the fields of an object by name.
+ * @param objects Number of object variables emitted so far.
+ */
+static void EXGEN_EmitFallback(FILE* out, const char* typeName, const EXGEN_Node* node, const char* path, const char* object, size_t* objects)
+{
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+        {
+            // Each nested object gets its own variable, so they stay valid while their children are read.
+            // They're numbered, because names built from the path could repeat or get arbitrarily long.
+            char childObject[32];
+            char* childPath = EXGEN_Concat(path, child->ident, ".");
+
+            snprintf(childObject, sizeof(childObject), "object%zu", ++*objects);
+            fprintf(out, "    EXIB_DEC_Object %s;\n", childObject);
+            fprintf(out, "    if (EXIB_DEC_FindObject(ctx, &%s, \"%s\", &%s) != EXIB_DEC_ERR_Success)\n        return 1;\n", object, child->name, childObject);
+
+            EXGEN_EmitFallback(out, typeName, child, childPath, childObject, objects);
+            free(childPath);
+        }
+        else if (child->type == EXIB_TYPE_ARRAY)
+        {
+            fprintf(out, "    if (%s_GetArray(ctx, &%s, \"%s\", %s, %s%s, %zu))\n        return 1;\n",
+                    typeName, object, child->name, s_TypeEnums[child->elementType], path, child->ident, child->length);
+        }
+        else
+        {
+            fprintf(out, "    if (%s_GetValue(ctx, &%s, \"%s\", %s, &%s%s))\n        return 1;\n",
+                    typeName, object, child->name, s_TypeEnums[child->type], path, child->ident);
+        }
+    }
+}
+
+// Check whether a schema has arrays, or values that aren't arrays.
+static int EXGEN_HasFields(const EXGEN_Node* node, int arrays)
+{
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT ? EXGEN_HasFields(child, arrays) : (child->type == EXIB_TYPE_ARRAY) == arrays)
+            return 1;
+    }
+
+    return 0;
+}
+
+static void EXGEN_EmitSource(FILE* out, const char* typeName, const char* headerName, const EXGEN_Node* root, const uint8_t* datum, size_t datumSize)
+{
+    size_t objects = 0;
+
+    fprintf(out, "// Generated by exgen, do not edit.\n");
+    fprintf(out, "#include <string.h>\n#include <EXIB/EXIB.h>\n#include <EXIB/Decoder.h>\n#include \"%s\"\n\n", headerName);
+
+    // The template is in the byte order of the machine exgen ran on, like the datums of its encoder.
+    fprintf(out, "// Datum with every value set to 0, and without a checksum.\n");
+    fprintf(out, "static const uint8_t s_%s_Template[%s_DATUM_SIZE] = {", typeName, typeName);
+    for (size_t i = 0; i < datumSize; ++i)
+        fprintf(out, "%s0x%02X%s", (i % 12) ? " " : "\n    ", datum[i], (i + 1 < datumSize) ? "," : "");
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "size_t %s_Encode(const %s* in, void* buffer, size_t capacity)\n{\n", typeName, typeName);
+    fprintf(out, "    uint8_t* out = buffer;\n    uint32_t checksum;\n\n");
+    fprintf(out, "    if (capacity < %s_DATUM_SIZE)\n        return 0;\n\n", typeName);
+    fprintf(out, "    memcpy(out, s_%s_Template, %s_DATUM_SIZE);\n", typeName, typeName);
+    EXGEN_EmitValueCopies(out, root, "in->", 1);
+    fprintf(out, "\n    checksum = EXIB_CRC32C(0, out, %s_DATUM_SIZE);\n", typeName);
+    fprintf(out, "    memcpy(&out[%zu], &checksum, sizeof(checksum));\n", offsetof(EXIB_Header, checksum));
+    fprintf(out, "    return %s_DATUM_SIZE;\n}\n\n", typeName);
+
+    // Helpers are only emitted if they're used, so the generated code compiles without warnings.
+    if (EXGEN_HasFields(root, 0))
+    {
+        fprintf(out, "static int %s_GetValue(EXIB_DEC_Context* ctx, EXIB_DEC_Object* object, const char* name, EXIB_Type type, void* out)\n{\n", typeName);
+        fprintf(out, "    EXIB_DEC_Field field = EXIB_DEC_FindField(ctx, object, name);\n");
+        fprintf(out, "    EXIB_DEC_FieldValue value;\n\n");
+        fprintf(out, "    if (field == EXIB_DEC_INVALID_FIELD || EXIB_DEC_FieldGet(ctx, field, &value) != type)\n        return 1;\n\n");
+        fprintf(out, "    memcpy(out, value.value, EXIB_GetTypeSize(type));\n    return 0;\n}\n\n");
+    }
+
+    if (EXGEN_HasFields(root, 1))
+    {
+        fprintf(out, "static int %s_GetArray(EXIB_DEC_Context* ctx, EXIB_DEC_Object* object, const char* name, EXIB_Type type, void* out, size_t length)\n{\n", typeName);
+        fprintf(out, "    EXIB_DEC_Field field = EXIB_DEC_FindField(ctx, object, name);\n");
+        fprintf(out, "    EXIB_DEC_Array array;\n\n");
+        fprintf(out, "    if (field == EXIB_DEC_INVALID_FIELD || !EXIB_DEC_ArrayFromField(ctx, field, &array) || EXIB_DEC_ArrayGetType(&array) != type)\n        return 1;\n\n");
+        fprintf(out, "    if ((size_t)EXIB_DEC_ArrayGetLength(&array) != length)\n        return 1;\n\n");
+        fprintf(out, "    // Also unpacks arrays that were encoded packed.\n");
+        fprintf(out, "    return EXIB_DEC_ArrayDecodeInto(ctx, &array, out, length) != EXIB_DEC_ERR_Success;\n}\n\n");
+    }
+
+    fprintf(out, "static int %s_DecodeFields(EXIB_DEC_Context* ctx, %s* out)\n{\n", typeName, typeName);
+    fprintf(out, "    EXIB_DEC_Object root = *EXIB_DEC_GetRootObject(ctx);\n\n");
+    EXGEN_EmitFallback(out, typeName, root, "out->", "root", &objects);
+    if (!root->children)
+        fprintf(out, "    (void)root;\n");
+    fprintf(out, "\n    return 0;\n}\n\n");
+
+    fprintf(out, "int %s_Decode(const void* datum, size_t size, %s* out)\n{\n", typeName, typeName);
+    fprintf(out, "    const uint8_t* in = datum;\n    EXIB_DEC_Context* ctx;\n    int result;\n\n");
+    fprintf(out, "    // Datums with another layout are decoded field by field.\n");
+    EXGEN_EmitStructureCheck(out, typeName, root);
+    fprintf(out, "    {\n");
+    fprintf(out, "        ctx = EXIB_DEC_CreateBufferedContext(datum, size, NULL);\n");
+    fprintf(out, "        result = (EXIB_DEC_GetLastError(ctx) != EXIB_DEC_ERR_Success) || %s_DecodeFields(ctx, out);\n", typeName);
+    fprintf(out, "        EXIB_DEC_FreeContext(ctx);\n");
+    fprintf(out, "        return result;\n    }\n\n");
+    fprintf(out, "    if (EXIB_CheckHeader(datum, size))\n        return 1;\n\n");
+    EXGEN_EmitValueCopies(out, root, "out->", 0);
+    fprintf(out, "    return 0;\n}\n");
+}
+
+static char* EXGEN_ReadFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    char* text;
+    long size;
+
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    text = malloc(size + 1);
+    if (fread(text, 1, size, file) != (size_t)size)
+    {
+        free(text);
+        fclose(file);
+        return NULL;
+    }
+
+    text[size] = 0;
+    fclose(file);
+    return text;
+}
+
+static FILE* EXGEN_OpenOutput(const char* output, const char* extension)
+{
+    char* path = EXGEN_Concat(output, extension, "");
+    FILE* file = fopen(path, "w");
+
+    if (!file)
+    {
+        fprintf(stderr, "error: can't write %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    free(path);
+    return file;
+}
+
+/**
+ * Collect the names of the nested structs, which are the path to them joined with underscores.
+ * @param names Receives the names, which the caller frees.
+ * @param count Number of names in names so far.
+ */
+static void EXGEN_CollectTypeNames(const char* typeName, const EXGEN_Node* node, char** names, size_t* count)
+{
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+        {
+            char* childType = EXGEN_Concat(typeName, "_", child->ident);
+            names[(*count)++] = childType;
+            EXGEN_CollectTypeNames(childType, child, names, count);
+        }
+    }
+}
+
+static size_t EXGEN_CountObjects(const EXGEN_Node* node)
+{
+    size_t count = 0;
+
+    for (const EXGEN_Node* child = node->children; child != NULL; child = child->next)
+    {
+        if (child->type == EXIB_TYPE_OBJECT)
+            count += 1 + EXGEN_CountObjects(child);
+    }
+
+    return count;
+}
+
+/**
+ * Check that the names of the nested structs are distinct, and don't clash with the generated functions.
+ * Fields of different objects can join to the same name, like "a_b" and "b" in "a".
+ * @return 0 if they're distinct, 1 otherwise.
+ */
+static int EXGEN_CheckTypeNames(const char* typeName, const EXGEN_Node* root)
+{
+    static const char* s_Suffixes[] = { "_Encode", "_Decode", "_DecodeFields", "_GetValue", "_GetArray", "_DATUM_SIZE" };
+    const size_t suffixCount = sizeof(s_Suffixes) / sizeof(s_Suffixes[0]);
+    char** names = malloc((EXGEN_CountObjects(root) + suffixCount) * sizeof(char*));
+    size_t count = 0;
+    int result = 0;
+
+    for (size_t i = 0; i < suffixCount; ++i)
+        names[count++] = EXGEN_Concat(typeName, s_Suffixes[i], "");
+    EXGEN_CollectTypeNames(typeName, root, names, &count);
+
+    for (size_t i = suffixCount; i < count && !result; ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (strcmp(names[i], names[j]) == 0)
+            {
+                fprintf(stderr, "error: more than one struct or function would be named %s\n", names[i]);
+                result = 1;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+        free(names[i]);
+    free(names);
+    return result;
+}
+
+static void EXGEN_FreeNodes(EXGEN_Node* node)
+{
+    while (node)
+    {
+        EXGEN_Node* next = node->next;
+        EXGEN_FreeNodes(node->children);
+        free(node);
+        node = next;
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    EXGEN_Parser parser = { 0 };
+    char typeName[EXGEN_MAX_NAME + 2];
+    char guard[EXGEN_MAX_NAME + 16];
+    char headerName[EXGEN_MAX_NAME + 3];
+    const char* baseName;
+    EXGEN_Node* root;
+    uint8_t* datum;
+    size_t datumSize;
+    FILE* out;
+
+    if (argc != 3)
+    {
+        puts("Usage: exgen <schema.exit> <output>");
+        puts("Writes <output>.h and <output>.c, named after the file name of <output>.");
+        return EXIT_FAILURE;
+    }
+
+    parser.path = argv[1];
+    parser.line = 1;
+    parser.text = parser.pos = EXGEN_ReadFile(argv[1]);
+    if (!parser.text)
+    {
+        fprintf(stderr, "error: can't read %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    baseName = strrchr(argv[2], '/') ? strrchr(argv[2], '/') + 1 : argv[2];
+    if (strlen(baseName) == 0 || strlen(baseName) > EXGEN_MAX_NAME)
+    {
+        fprintf(stderr, "error: bad output name %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    EXGEN_MakeIdentifier(baseName, typeName);
+    snprintf(headerName, sizeof(headerName), "%s.h", baseName);
+    snprintf(guard, sizeof(guard), "_%s_GENERATED_H", typeName);
+    for (char* c = guard; *c; ++c)
+        *c = toupper((unsigned char)*c);
+
+    root = EXGEN_ParseSchema(&parser);
+    if (EXGEN_CheckTypeNames(typeName, root))
+    {
+        EXGEN_FreeNodes(root);
+        free((char*)parser.text);
+        return EXIT_FAILURE;
+    }
+
+    datum = EXGEN_Layout(root, parser.datumName[0] ? parser.datumName : NULL, &datumSize);
+
+    out = EXGEN_OpenOutput(argv[2], ".h");
+    EXGEN_EmitHeader(out, typeName, guard, root, datumSize);
+    fclose(out);
+
+    out = EXGEN_OpenOutput(argv[2], ".c");
+    EXGEN_EmitSource(out, typeName, headerName, root, datum, datumSize);
+    fclose(out);
+
+    EXGEN_FreeNodes(root);
+    free(datum);
+    free((char*)parser.text);
+    return EXIT_SUCCESS;
+}